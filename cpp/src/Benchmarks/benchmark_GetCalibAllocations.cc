@@ -0,0 +1,104 @@
+//
+// Counts heap allocations and time of typed GetCalib calls on a SQLite file
+//
+//    CCDB_bn_getcalib [sqlite://path/to/ccdb.sqlite] [namepath=/test/test_vars/test_table] [repeats=100000]
+//
+// The assignment is cached after the first call, so the numbers show what filling the
+// output container costs. "strings then convert" is how typed GetCalib worked before:
+// a vector<vector<string>> is filled first and then converted to doubles.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+#include "CCDB/SQLiteCalibration.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Helpers/StopWatch.h"
+
+using namespace std;
+using namespace ccdb;
+
+static std::atomic<uint64_t> gAllocationsCount(0);
+
+void* operator new(size_t size)
+{
+    gAllocationsCount++;
+    void* memory = malloc(size ? size : 1);
+    if(!memory) throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+
+template<typename Function>
+void Measure(const string& title, int repeats, Function function)
+{
+    StopWatch stopwatch;
+    uint64_t allocationsBefore = gAllocationsCount;
+    for(int i = 0; i < repeats; i++) function();
+    double timeUs = stopwatch.ElapsedUs() / static_cast<double>(repeats);
+    double allocations = (gAllocationsCount - allocationsBefore) / static_cast<double>(repeats);
+    cout << title << ": " << timeUs << " us, " << allocations << " allocations per call" << endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const char* home = getenv("CCDB_HOME");
+    string connectionString = argc > 1 && argv[1][0] ? argv[1] : string("sqlite://") + (home ? home : ".") + "/sql/ccdb.sqlite";
+    string namepath = argc > 2 ? argv[2] : "/test/test_vars/test_table";
+    int repeats = argc > 3 ? atoi(argv[3]) : 100000;
+
+    SQLiteCalibration calib(100);
+    if(!calib.Connect(connectionString)) {
+        cout << "Can't connect to " << connectionString << endl;
+        return 1;
+    }
+    calib.EnableCache(true);
+
+    // Warm up: the assignment goes to the cache
+    vector<vector<double>> table;
+    if(!calib.GetCalib(table, namepath)) {
+        cout << "No data for " << namepath << endl;
+        return 1;
+    }
+    cout << namepath << ": " << table.size() << " rows x " << (table.empty() ? 0 : table[0].size()) << " columns" << endl;
+
+    double sum = 0;     // keeps results used
+    Measure("strings then convert      ", repeats, [&]() {
+        vector<vector<string>> rawValues;
+        calib.GetCalib(rawValues, namepath);
+        vector<vector<double>> values(rawValues.size());
+        for(size_t row = 0; row < rawValues.size(); row++) {
+            for(const auto& cell: rawValues[row]) values[row].push_back(StringUtils::ParseDouble(cell));
+        }
+        sum += values[0][0];
+    });
+
+    Measure("GetCalib(vector<vector<double>>&)", repeats, [&]() {
+        vector<vector<double>> values;
+        calib.GetCalib(values, namepath);
+        sum += values[0][0];
+    });
+
+    Measure("GetCalibTable<double>     ", repeats, [&]() {
+        auto values = calib.GetCalibTable<double>(namepath);
+        sum += values[0][0];
+    });
+
+    Measure("reused output container   ", repeats, [&]() {
+        calib.GetCalib(table, namepath);
+        sum += table[0][0];
+    });
+
+    cout << "(checksum " << sum << ")" << endl;
+    return 0;
+}
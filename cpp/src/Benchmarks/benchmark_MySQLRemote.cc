@@ -0,0 +1,95 @@
+//
+// Measures how CCDB MySQL access behaves when the server is far away (WAN jobs at remote sites)
+//
+// Run it against a local server with artificial latency added on the loopback interface:
+//
+//    sudo tc qdisc add dev lo root netem delay 25ms          # 50 ms round trip
+//    CCDB_bn_mysql_remote "mysql://ccdb_user@127.0.0.1/ccdb" 30000 default
+//    CCDB_bn_mysql_remote "mysql://ccdb_user@127.0.0.1/ccdb?compress=true" 30000 default
+//    sudo tc qdisc del dev lo root
+//
+// (or put a delaying TCP proxy in front of the server if tc is not available).
+// The benchmark compares one GetAssignmentShort per table with one GetLatestAssignments call
+// and prints the number of round trips saved and the time per request.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include "CCDB/Providers/MySQLDataProvider.h"
+#include "CCDB/Model/Assignment.h"
+#include "CCDB/Model/ConstantsTypeTable.h"
+#include "CCDB/Helpers/StopWatch.h"
+
+using namespace std;
+using namespace ccdb;
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2) {
+        cout << "Usage: " << argv[0] << " <mysql connection string> [run=30000] [variation=default] [repeats=5]" << endl;
+        return 1;
+    }
+
+    string connectionString = argv[1];
+    int run = argc > 2 ? atoi(argv[2]) : 30000;
+    string variation = argc > 3 ? argv[3] : "default";
+    int repeats = argc > 4 ? atoi(argv[4]) : 5;
+
+    StopWatch stopwatch;
+    MySQLDataProvider provider;
+
+    stopwatch.Restart();
+    provider.Connect(connectionString);
+    provider.LoadDirectories();
+    cout << "Connect and load directories: " << stopwatch.ElapsedMs() << " ms" << endl;
+
+    vector<string> paths;
+    for(auto table: provider.GetAllConstantsTypeTables(false)) {
+        paths.push_back(table->GetFullPath());
+    }
+    cout << "Type tables: " << paths.size() << endl;
+
+    // Warm up caches of variations and prepared statements
+    for(auto assignment: provider.GetLatestAssignments(run, 0, variation, false)) {
+        delete assignment;
+    }
+
+    // One query per table
+    size_t bytes = 0;
+    size_t found = 0;
+    stopwatch.Restart();
+    for(int i = 0; i < repeats; i++) {
+        bytes = found = 0;
+        for(const auto& path: paths) {
+            Assignment* assignment = provider.GetAssignmentShort(run, path, 0, variation, false);
+            if(!assignment) continue;
+            found++;
+            bytes += assignment->GetRawData().size();
+            delete assignment;
+        }
+    }
+    double perTableTime = stopwatch.ElapsedUs() / 1000.0 / repeats;
+    cout << "Query per table:      " << perTableTime << " ms, assignments " << found << ", vault bytes " << bytes << endl;
+
+    // Bulk request
+    stopwatch.Restart();
+    for(int i = 0; i < repeats; i++) {
+        bytes = found = 0;
+        for(auto assignment: provider.GetLatestAssignments(run, 0, variation, false)) {
+            found++;
+            bytes += assignment->GetRawData().size();
+            delete assignment;
+        }
+    }
+    double bulkTime = stopwatch.ElapsedUs() / 1000.0 / repeats;
+    cout << "GetLatestAssignments: " << bulkTime << " ms, assignments " << found << ", vault bytes " << bytes << endl;
+
+    if(bulkTime > 0) cout << "Speedup: " << perTableTime / bulkTime << endl;
+
+    auto stats = provider.GetPoolStats();
+    cout << "Connections opened: " << stats.ConnectionsOpened << ", reconnects: " << stats.Reconnects << endl;
+    return 0;
+}
@@ -2,9 +2,15 @@
 #include <assert.h>
 #include <iostream>
 #include <memory>
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <chrono>
 
 #include "CCDB/Calibration.h"
+#include "CCDB/CalibrationOptions.h"
 #include "CCDB/Providers/DataProvider.h"
+#include "CCDB/Providers/EpochCalculator.h"
 #include "CCDB/Helpers/PathUtils.h"
 #include "CCDB/Helpers/TimeProvider.h"
 #include "CCDB/Helpers/PerfLog.h"
@@ -14,6 +20,62 @@ using namespace std;
 namespace ccdb
 {
 
+namespace
+{
+    void ParseCell(const string& cell, string& value) { value = cell; }
+    void ParseCell(const string& cell, double& value) { value = StringUtils::ParseDouble(cell); }
+    void ParseCell(const string& cell, int& value) { value = StringUtils::ParseInt(cell); }
+
+    /** Values of the assignment as they are split from the vault once. Valid while the assignment is */
+    const vector<string>& GetCells(const Assignment* assignment)
+    {
+        static const vector<string> noCells;
+        const VaultData* vault = assignment->GetVault().get();      // no shared_ptr copy, see PrepareForFork
+        return vault ? vault->GetValues() : noCells;
+    }
+
+    /** A request string parsed to the parts of the cache key. Parts that are not given are left for defaults */
+    struct ResolvedRequest
+    {
+        InternedString Path;            /// Absolute path
+        bool WasParsedRunNumber;
+        int RunNumber;
+        bool WasParsedVariation;
+        InternedString Variation;
+        bool WasParsedTime;
+        time_t Time;
+    };
+
+    /** More different requests than that are not a working set of a job. The memo is started over */
+    const size_t cMaxResolvedRequests = 1024;
+
+    /** Parses the request once per thread. Jobs ask the same few request strings again and again */
+    ResolvedRequest GetResolvedRequest(const string& namepath)
+    {
+        static thread_local unordered_map<string, ResolvedRequest> resolvedRequests;
+
+        auto found = resolvedRequests.find(namepath);
+        if(found != resolvedRequests.end()) return found->second;
+
+        RequestParseView view = PathUtils::ParseRequestView(namepath);
+        string path = view.Path.ToString();
+        PathUtils::MakeAbsolute(path);
+
+        ResolvedRequest request;
+        request.Path = InternedString(path);
+        request.WasParsedRunNumber = view.WasParsedRunNumber;
+        request.RunNumber = view.RunNumber;
+        request.WasParsedVariation = view.WasParsedVariation;
+        if(view.WasParsedVariation) request.Variation = InternedString(view.Variation.ToString());
+        request.WasParsedTime = view.WasParsedTime;
+        request.Time = view.Time;
+
+        if(resolvedRequests.size() >= cMaxResolvedRequests) resolvedRequests.clear();
+        resolvedRequests.emplace(namepath, request);
+        return request;
+    }
+}
+
 //______________________________________________________________________________
 Calibration::Calibration()
 {
@@ -23,15 +85,20 @@ Calibration::Calibration()
     mProviderIsLocked = false; //by default we assume that we own the provider
     mDefaultRun = 0;
 	mDefaultTime = 0;
-    mDefaultVariation = "default";
+    mDefaultVariation = InternedString("default");
     mIsAutoReconnect = true;
     mLastActivityTime=0;
-
-#ifdef CCDB_CACHE_ON
-    mIsCacheEnabled = true;
-#else
-    mIsCacheEnabled = false;
-#endif
+    mChangeCheckInterval = 0;
+    mLastChangeCheckTime = 0;
+    mIsChangeCheckStarted = false;
+    mLastAssignmentId = 0;
+    mNextListenerId = 1;
+    mCacheHits = 0;
+    mCacheMisses = 0;
+
+    // Defaults, CCDB_CACHE_ON and other build flags are taken into account there
+    mOptions.reset(new CalibrationOptions(CalibrationOptions::FromEnvironment()));
+    ApplyOptions();
 }
 
 
@@ -41,19 +108,24 @@ Calibration::Calibration(int defaultRun, string defaultVariation/*="default"*/,
     //Constructor 
 
 	mDefaultRun = defaultRun;
-	mDefaultVariation = defaultVariation;
+	mDefaultVariation = InternedString(defaultVariation);
 	mDefaultTime = defaultTime;
 
     mProvider = nullptr;
     mProviderIsLocked = false;      // by default we assume that we own the provider
     mIsAutoReconnect = true;
     mLastActivityTime=0;
-
-#ifdef CCDB_CACHE_ON
-    mIsCacheEnabled = true;
-#else
-    mIsCacheEnabled = false;
-#endif
+    mChangeCheckInterval = 0;
+    mLastChangeCheckTime = 0;
+    mIsChangeCheckStarted = false;
+    mLastAssignmentId = 0;
+    mNextListenerId = 1;
+    mCacheHits = 0;
+    mCacheMisses = 0;
+
+    // Defaults, CCDB_CACHE_ON and other build flags are taken into account there
+    mOptions.reset(new CalibrationOptions(CalibrationOptions::FromEnvironment()));
+    ApplyOptions();
 }
 
 
@@ -61,6 +133,10 @@ Calibration::Calibration(int defaultRun, string defaultVariation/*="default"*/,
 Calibration::~Calibration()
 {
     //Destructor
+    if(mIsMetricsEnabled) WriteMetrics(std::cout);
+
+    // Asynchronous requests use the provider, so they are finished before it is deleted
+    for(auto& request: mRequests) request.second.wait();
     if(!mProviderIsLocked && mProvider!=nullptr) delete mProvider;
 }
 
@@ -77,6 +153,149 @@ void Calibration::UseProvider( DataProvider * provider, bool lockProvider/*=true
 }
 
 
+//______________________________________________________________________________
+template<typename T>
+bool Calibration::GetMappedCalib(vector< map<string, T> > &values, const string & namepath)
+{
+    auto assignment = GetAssignment(namepath, true);
+    if(!assignment) return false;
+
+    const vector<string>& cells = GetCells(assignment);
+    const vector<string>& columnNames = assignment->GetTypeTable()->GetColumnNames();
+    size_t rowsNum = columnNames.empty() ? 0 : cells.size() / columnNames.size();
+    if(rowsNum == 0) {
+        throw std::logic_error("Calibration::GetCalib( vector< map<string, T> >&, const string&). Data has no rows. Zero rows are not supposed to be.");
+    }
+
+    //values are parsed right into the output rows
+    values.clear();
+    values.resize(rowsNum);
+    auto cell = cells.begin();
+    for(auto& row: values) {
+        for(const auto& name: columnNames) ParseCell(*cell++, row.emplace(name, T()).first->second);
+    }
+    return true;
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+bool Calibration::GetTableCalib(vector< vector<T> > &values, const string & namepath)
+{
+    auto assignment = GetAssignment(namepath, false);
+    if(!assignment) return false;
+
+    const vector<string>& cells = GetCells(assignment);
+    size_t columnsNum = assignment->GetTypeTable()->GetColumnsCount();
+    size_t rowsNum = columnsNum ? cells.size() / columnsNum : 0;
+
+    //values are parsed right into the output rows, each row is allocated once
+    values.clear();
+    values.resize(rowsNum);
+    auto cell = cells.begin();
+    for(auto& row: values) {
+        row.resize(columnsNum);
+        for(auto& value: row) ParseCell(*cell++, value);
+    }
+    return true;
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+bool Calibration::GetRowCalib(map<string, T> &values, const string & namepath)
+{
+    auto assignment = GetAssignment(namepath, true);
+    if(!assignment) return false;
+
+    const vector<string>& cells = GetCells(assignment);
+    size_t columnsNum = assignment->GetTypeTable()->GetColumnsCount();
+    size_t rowsNum = columnsNum ? cells.size() / columnsNum : 0;
+    if(rowsNum == 0) {
+        throw std::logic_error("Calibration::GetCalib( map<string, T>&, const string&). Data has no rows. Zero rows are not supposed to be.");
+    }
+
+	values.clear();
+
+	// This method is used to return a 1-D array of values (in the form of a
+	// map<string, string>). The data may be stored in either column-wise (1 
+	// row with many columns) or row-wise (1 column with many rows). We wish
+	// to support either so we must check which format it is in. If it is
+	// stored row-wise, then we'll need to make up the column names so that
+	// the map being returned is properly ordered.
+	// 5/25/2014  D. Lawrence
+	if(rowsNum>1 && columnsNum>1){
+		throw std::logic_error("Calibration::GetCalib( map<string, T>&, const string&). Appears to be a table (both dimensions are > 1).");
+	}
+
+	if(rowsNum>1){
+		// ---- ROW-WISE ----
+
+		// Loop over rows, generating a column name for each and filling "values"
+		for(unsigned int i=0; i<rowsNum; i++){
+			char colName[16];
+			sprintf(colName, "v%04d", i); // TODO this will be a problem for more than 10k values!
+			ParseCell(cells[i], values[colName]);
+		}
+	}else{
+		// ---- COLUMN-WISE ----
+		const vector<string>& columnNames = assignment->GetTypeTable()->GetColumnNames();
+		assert(columnsNum == columnNames.size());
+		for (size_t i=0; i<columnsNum; i++) ParseCell(cells[i], values[columnNames[i]]);
+	}
+    return true;
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+bool Calibration::GetVectorCalib(vector<T> &values, const string & namepath)
+{
+    auto assignment = GetAssignment(namepath, true);
+    if(!assignment) return false;
+
+    //check data and check that the user will get what he ment...
+    const vector<string>& cells = GetCells(assignment);
+    if(cells.empty())
+        throw std::logic_error("Calibration::GetCalib(vector<T> &, const string &). Data has no rows. Zero rows are not supposed to be.");
+
+    if(cells.size() != static_cast<size_t>(assignment->GetTypeTable()->GetColumnsCount()))
+        throw std::logic_error("Calibration::GetCalib(vector<T> &, const string &). logic_error: Calling of single row vector<dataType> version of GetCalib method on dataset that has more than one rows. Use GetCalib vector<vector<dataType> > instead.");
+
+    values.resize(cells.size());
+    for(size_t i = 0; i < cells.size(); i++) ParseCell(cells[i], values[i]);
+    return true;
+}
+
+
+//______________________________________________________________________________
+template<typename T>
+std::vector<T> Calibration::GetCalibVector(const string & namepath)
+{
+    std::vector<T> values;
+    GetCalib(values, namepath);         // stays empty if namepath is not found
+    return values;
+}
+
+template std::vector<string> Calibration::GetCalibVector<string>(const string &);
+template std::vector<double> Calibration::GetCalibVector<double>(const string &);
+template std::vector<int> Calibration::GetCalibVector<int>(const string &);
+
+
+//______________________________________________________________________________
+template<typename T>
+std::vector<std::vector<T>> Calibration::GetCalibTable(const string & namepath)
+{
+    std::vector<std::vector<T>> values;
+    GetCalib(values, namepath);         // stays empty if namepath is not found
+    return values;
+}
+
+template std::vector<std::vector<string>> Calibration::GetCalibTable<string>(const string &);
+template std::vector<std::vector<double>> Calibration::GetCalibTable<double>(const string &);
+template std::vector<std::vector<int>> Calibration::GetCalibTable<int>(const string &);
+
+
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< map<string, string> > &values, const string & namepath )
 {
@@ -108,9 +327,7 @@ bool Calibration::GetCalib( vector< map<string, string> > &values, const string
     }
 
     //Get data
-    
-    assert(values.empty());
-    
+    values.clear();
     assignment->GetMappedData(values);
     
     //check data, get columns 
@@ -124,78 +341,14 @@ bool Calibration::GetCalib( vector< map<string, string> > &values, const string
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< map<string, double> > &values, const string & namepath )
 {
-    //read values
-
-    //TODO right now the function works through copy. 
-    //one needs to find out, maybe it needs to be reimplemented
-    
-    vector<map<string, string> > rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-    	throw;
-    }
-
-    assert(values.empty());
-    
-    int rowsNum = rawValues.size();
-    int columnsNum = rawValues[0].size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int rowIter = 0; rowIter < rowsNum; rowIter++)
-    {
-        map<string, string>::iterator iter;
-        for ( iter=rawValues[rowIter].begin() ; iter != rawValues[rowIter].end(); iter++ )
-        {
-            double tmpVal = StringUtils::ParseDouble(iter->second);
-            values[rowIter][iter->first] = tmpVal;
-        }
-    }
-
-    return true;
+    return GetMappedCalib(values, namepath);
 }
 
 
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< map<string, int> > &values, const string & namepath )
 {
-    //TODO right now the function works through copy. 
-    //one needs to find out, maybe it needs to be reimplemented
-
-    vector<map<string, string> > rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    assert(values.empty());
-
-    int rowsNum = rawValues.size();
-    int columnsNum = rawValues[0].size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int rowIter = 0; rowIter < rowsNum; rowIter++)
-    {
-        map<string, string>::iterator iter;
-        for ( iter=rawValues[rowIter].begin() ; iter != rawValues[rowIter].end(); iter++ )
-        {
-            int intlVal = StringUtils::ParseInt(iter->second);
-            values[rowIter][iter->first] = intlVal;
-        }
-    }
-
-    return true;
+    return GetMappedCalib(values, namepath);
 }
 
 
@@ -212,86 +365,21 @@ bool Calibration::GetCalib( vector< vector<string> > &values, const string & nam
      * @return true if constants were found and filled. false if namepath was not found. raises std::logic_error if any other error acured.
      */
     
-    auto assignment = GetAssignment(namepath, false);
-    
-    if(!assignment)
-    {
-        return false;
-    }
-   
-    assignment->GetData(values);
-    
-    return true;
+    return GetTableCalib(values, namepath);
 }
 
 
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< vector<double> > &values, const string & namepath )
 {
-    //TODO right now the function works through copy. One has to check, maybe it needs to be reimplemented
-
-    vector< vector<string> > rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    assert(values.empty());
-
-    int rowsNum = rawValues.size();
-    int columnsNum = rawValues[0].size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int rowIter = 0; rowIter < rowsNum; rowIter++)
-    {   
-        for (int columnsIter = 0; columnsIter < columnsNum; columnsIter++)
-        {
-            double tmpVal = StringUtils::ParseDouble(rawValues[rowIter][columnsIter]);
-            values[rowIter].push_back(tmpVal);
-        }
-    }
-
-    return true;
+    return GetTableCalib(values, namepath);
 }
 
 
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector< vector<int> > &values, const string & namepath )
 {
-    vector< vector<string> > rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    assert(values.empty());
-
-    int rowsNum = rawValues.size();
-    int columnsNum = rawValues[0].size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int rowIter = 0; rowIter < rowsNum; rowIter++)
-    {   
-        for (int columnsIter = 0; columnsIter < columnsNum; columnsIter++)
-        {
-            int tmpVal = StringUtils::ParseInt(rawValues[rowIter][columnsIter]);
-            values[rowIter].push_back(tmpVal);
-        }
-    }
-
-    return true;
+    return GetTableCalib(values, namepath);
 }
 
 
@@ -307,129 +395,21 @@ bool Calibration::GetCalib( map<string, string> &values, const string & namepath
      * @parameter [in]  namepath - data path
      * @return true if constants were found and filled. false if namepath was not found. raises std::logic_error if any other error acured.
      */
-
-
-    auto assignment = GetAssignment(namepath, true);
-    
-    if(assignment == NULL)
-    {
-        //TODO possibly exception throwing?
-        return false;
-    }
-
-    //Get data
-    vector< vector<string> > rawTableValues;
-    assignment->GetData(rawTableValues);
-
-    //check data a little...
-    if(rawTableValues.size() == 0)
-    {
-        throw std::logic_error("Calibration::GetCalib( map<string, string>&, const string&). Data has no rows. Zero rows are not supposed to be.");
-    }
-	
-	//VALUES VALIDATION
-	assert(values.empty());
-
-	// This method is used to return a 1-D array of values (in the form of a
-	// map<string, string>). The data may be stored in either column-wise (1 
-	// row with many columns) or row-wise (1 column with many rows). We wish
-	// to support either so we must check which format it is in. If it is
-	// stored row-wise, then we'll need to make up the column names so that
-	// the map being returned is properly ordered.
-	// 5/25/2014  D. Lawrence
-	
-	// Make sure at least one dimension is exactly 1. (Assume all inner vectors
-	// are the same size as the zeroth one.)
-	int rowsNum = rawTableValues.size();
-	int columnsNum = rawTableValues[0].size();
-	if(rowsNum>1 && columnsNum>1){
-		throw std::logic_error("Calibration::GetCalib( map<string, string>&, const string&). Appears to be a table (both dimensions are > 1).");
-	}
-	
-	if(rowsNum>1){
-		// ---- ROW-WISE ----
-		
-		// Loop over rows, generating a column name for each and filling "values"
-		for(unsigned int i=0; i<rowsNum; i++){
-			char colName[16];
-			sprintf(colName, "v%04d", i); // TODO this will be a problem for more than 10k values!
-			values[colName] = rawTableValues[i][0];
-		}
-		
-	}else{
-		// ---- COLUMN-WISE ----
-
-		//now we take only first row of table
-		vector<string> rawValues = rawTableValues[0];
-
-		//get columns names
-		vector<string> columnNames = assignment->GetTypeTable()->GetColumnNames();
-		assert(columnsNum == columnNames.size());
-
-		//compose values
-		for (int i=0; i<columnsNum; i++) values[columnNames[i]] = rawValues[i];
-	}
-
-    //finishing
-    return true;
+    return GetRowCalib(values, namepath);
 }
 
 
 //______________________________________________________________________________
 bool Calibration::GetCalib( map<string, double> &values, const string & namepath )
 {
-    map<string, string> rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    assert(values.empty());
-    
-    //compose values
-    map<string, string>::iterator iter;
-    for ( iter=rawValues.begin() ; iter != rawValues.end(); iter++ )
-    {
-        double tmpVal = StringUtils::ParseDouble(iter->second);
-        values[iter->first] = tmpVal;
-    }
-
-    return true;
+    return GetRowCalib(values, namepath);
 }
 
 
 //______________________________________________________________________________
 bool Calibration::GetCalib( map<string, int> &values, const string & namepath )
 {
-    //TODO right now the function works through copy. 
-    //one needs to find out, maybe it needs to be reimplemented
-
-
-    map<string, string> rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    assert(values.empty());
-
-    //compose values
-    map<string, string>::iterator iter;
-    for ( iter=rawValues.begin() ; iter != rawValues.end(); iter++ )
-    {
-        int tmpVal = StringUtils::ParseInt(iter->second);
-        values[iter->first] = tmpVal;
-    }
-
-    return true;
+    return GetRowCalib(values, namepath);
 }
 
 
@@ -444,79 +424,21 @@ bool Calibration::GetCalib( vector<string> &values, const string & namepath )
      * @parameter [in]  namepath - data path
      * @return true if constants were found and filled. false if namepath was not found. raises std::logic_error if any other error acured.
      */
-
-	
-    
-	auto assignment = GetAssignment(namepath, true);
-    
-    if(assignment == nullptr) return false; //TODO possibly exception throwing?
-
-    //Get data
-    values.clear();
-    assignment->GetVectorData(values);
-   
-    //check data and check that the user will get what he ment...
-    if(values.size() == 0)
-        throw std::logic_error("Calibration::GetCalib(vector<string> &, const string &). Data has no rows. Zero rows are not supposed to be.");
-
-    if(values.size() != assignment->GetTypeTable()->GetColumnsCount())
-        throw std::logic_error("Calibration::GetCalib(vector<string> &, const string &). logic_error: Calling of single row vector<dataType> version of GetCalib method on dataset that has more than one rows. Use GetCalib vector<vector<dataType> > instead.");
-
-    return true;
+    return GetVectorCalib(values, namepath);
 }
 
 
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector<double> &values, const string & namepath )
 {
-    vector<string> rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-    
-    int columnsNum = rawValues.size(); //rawTableValues[0] - size was checked in GetCalib    
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int columnsIter = 0; columnsIter < columnsNum; columnsIter++)
-    {
-        double tmpVal = StringUtils::ParseDouble(rawValues[columnsIter]);
-        values[columnsIter] = tmpVal;
-    }
-    return true;
+    return GetVectorCalib(values, namepath);
 }
 
 
 //______________________________________________________________________________
 bool Calibration::GetCalib( vector<int> &values, const string & namepath )
 {
-    vector<string> rawValues;
-    try
-    {
-        if(!GetCalib(rawValues, namepath)) return false;
-    }
-    catch (std::exception &)
-    {
-        throw;
-    }
-
-    int columnsNum = rawValues.size(); //rawTableValues[0] - size was checked in GetCalib
-
-    values.resize(rawValues.size());
-
-    //compose values
-    for (int columnsIter = 0; columnsIter < columnsNum; columnsIter++)
-    {
-        int tmpVal = StringUtils::ParseInt(rawValues[columnsIter]);
-        values[columnsIter] = tmpVal;
-    }
-    return true;
+    return GetVectorCalib(values, namepath);
 }
 
 //______________________________________________________________________________
@@ -577,6 +499,21 @@ string Calibration::GetConnectionString() const
 }
 
 
+//______________________________________________________________________________
+Calibration::CacheKey Calibration::ResolveRequest(const string& namepath) const
+{
+    ResolvedRequest request = GetResolvedRequest(namepath);
+
+    CacheKey key;
+    key.Path = request.Path;
+    key.Run = request.WasParsedRunNumber ? request.RunNumber : mDefaultRun;
+    key.Variation = request.WasParsedVariation ? request.Variation : mDefaultVariation;
+    key.Time = request.WasParsedTime ? request.Time : mDefaultTime;
+    if(key.Time < 0) key.Time = 0;
+    return key;
+}
+
+
 //______________________________________________________________________________
 Assignment* Calibration::GetAssignment(const string& namepath, bool loadColumns /*=true*/)
 {
@@ -589,44 +526,137 @@ Assignment* Calibration::GetAssignment(const string& namepath, bool loadColumns
      * @return   DAssignment *
      */
 
-    auto pl = PerfLog("Calibration::GetAssignment=>" + namepath );
-    static std::map<std::string, Assignment*> cache;
+    auto pl = PerfLog("Calibration::GetAssignment=>", namepath);
 
 	UpdateActivityTime();
 
-    RequestParseResult result = PathUtils::ParseRequest(namepath);
-    string variation = (result.WasParsedVariation ? result.Variation : mDefaultVariation);
-    int run  = (result.WasParsedRunNumber ? result.RunNumber : mDefaultRun);
-
+    CacheKey cache_key = ResolveRequest(namepath);
 
-
-    auto time = result.WasParsedTime ? result.Time: mDefaultTime;
-
-    CheckConnection();  // Check if is connected and reconnect if needed (and allowed)
+    CheckForChangesIfNeeded();
 	
     //Lock();Unlock();
-    std::lock_guard<std::mutex> lock(mReadMutex);
+    std::unique_lock<std::mutex> lock(mReadMutex);
 
     // Check if we have this value in the cache
-    string cache_key = namepath + ":" + to_string(run) + ":" + variation + ":" + to_string(time);
-    if(mIsCacheEnabled)
+    Assignment* assigment;
+    if(FindCached(cache_key, assigment)) return assigment;
+    if(mIsCacheEnabled && WaitForRequest(cache_key, lock, assigment)) return assigment;
+
+    // Cached requests don't need a connection, so a forked worker connects on its first cache miss
+    if(!IsConnected())
     {
-        if (  cache.find(cache_key) != cache.end() ) {
-            return cache[cache_key];
-        }
+        lock.unlock();
+        CheckConnection();  // Check if is connected and reconnect if needed (and allowed)
+        lock.lock();
+        if(FindCached(cache_key, assigment)) return assigment;     // got by other thread meanwhile
     }
 
-    Assignment* assigment;
+    if(mIsCacheEnabled) mCacheMisses++;
+    {
+        std::lock_guard<std::mutex> providerLock(mProviderMutex);
+        assigment = (mProvider->GetAssignmentShort(cache_key.Run, cache_key.Path, cache_key.Time, cache_key.Variation, loadColumns));
+    }
 
-    if(time < 0) time = 0;
+    if(mIsCacheEnabled) AddToCache(cache_key, assigment);
 
-    assigment = (mProvider->GetAssignmentShort(run, PathUtils::MakeAbsolute(result.Path), time, variation, loadColumns));
+    return assigment;
+}
 
-    if(mIsCacheEnabled) {
-        cache[cache_key] = assigment;
+
+//______________________________________________________________________________
+std::future<Assignment*> Calibration::GetAssignmentAsync(const string& namepath, bool loadColumns /*=true*/)
+{
+    UpdateActivityTime();
+
+    CacheKey cache_key = ResolveRequest(namepath);
+
+    CheckForChangesIfNeeded();
+
+    std::unique_lock<std::mutex> lock(mReadMutex);
+    AddFinishedRequestsToCache();
+
+    // Cached values are ready right away
+    Assignment* cached;
+    bool isCached = FindCached(cache_key, cached);
+    if(!isCached && !IsConnected())
+    {
+        lock.unlock();
+        CheckConnection();  // Check if is connected and reconnect if needed (and allowed)
+        lock.lock();
+        isCached = FindCached(cache_key, cached);
+    }
+    if(isCached)
+    {
+        std::promise<Assignment*> ready;
+        ready.set_value(cached);
+        return ready.get_future();
     }
 
-    return assigment;
+    // The same request is running already
+    auto running = mRequests.find(cache_key);
+    if(mIsCacheEnabled && running != mRequests.end())
+    {
+        mCacheHits++;
+        std::shared_future<Assignment*> sharedRequest = running->second;
+        return std::async(std::launch::deferred, [sharedRequest]() { return sharedRequest.get(); });
+    }
+
+    if(mIsCacheEnabled) mCacheMisses++;
+    std::future<Assignment*> request;
+    {
+        std::lock_guard<std::mutex> providerLock(mProviderMutex);
+        request = mProvider->GetAssignmentShortAsync(cache_key.Run, cache_key.Path, cache_key.Time, cache_key.Variation, loadColumns);
+    }
+    if(!mIsCacheEnabled) return request;
+
+    // The result goes to the cache on the next request, whether the future is got or dropped.
+    // The returned future doesn't refer to the Calibration and all requests of the key get the same assignment
+    std::shared_future<Assignment*> sharedRequest = request.share();
+    mRequests[cache_key] = sharedRequest;
+    return std::async(std::launch::deferred, [sharedRequest]() { return sharedRequest.get(); });
+}
+
+
+//______________________________________________________________________________
+void Calibration::AddFinishedRequestsToCache()
+{
+    for(auto iter = mRequests.begin(); iter != mRequests.end(); )
+    {
+        if(iter->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++iter;
+            continue;
+        }
+
+        try
+        {
+            Assignment* assignment = iter->second.get();
+            if(mCache.find(iter->first) == mCache.end()) AddToCache(iter->first, assignment);
+        }
+        catch (...)
+        {
+            // The error is given by the future of the request, nothing is cached
+        }
+        iter = mRequests.erase(iter);
+    }
+}
+
+
+//______________________________________________________________________________
+bool Calibration::WaitForRequest(const CacheKey& key, std::unique_lock<std::mutex>& lock, Assignment*& assignment)
+{
+    auto running = mRequests.find(key);
+    if(running == mRequests.end()) return false;
+
+    std::shared_future<Assignment*> request = running->second;
+    lock.unlock();
+    request.wait();
+    lock.lock();
+    AddFinishedRequestsToCache();
+
+    mCacheHits++;
+    assignment = request.get();
+    return true;
 }
 
 
@@ -643,6 +673,7 @@ void Calibration::GetListOfNamepaths( vector<string> &namepaths )
 
     vector<ConstantsTypeTable*> tables;
     std::lock_guard<std::mutex> lock(mReadMutex);
+    std::lock_guard<std::mutex> providerLock(mProviderMutex);
     tables = mProvider->GetAllConstantsTypeTables(/*loadColumns*/ false);
 
     for (auto &table : tables) {
@@ -650,7 +681,6 @@ void Calibration::GetListOfNamepaths( vector<string> &namepaths )
         // without '/' in the beginning of each string,
         // while GetFullPath() returns strings that start with '/'
         namepaths.push_back(table->GetFullPath().substr(1));
-        delete table;
     }
 }
 
@@ -717,5 +747,476 @@ void Calibration::UpdateActivityTime()
     /** @brief if true the caching is using */
     bool Calibration::IsCacheEnabled() { return mIsCacheEnabled;}
 
+
+//______________________________________________________________________________
+void Calibration::ShareVault(Assignment* assignment)
+{
+    if(!assignment || !assignment->GetVault()) return;
+
+    auto vault = ShareVault(assignment->GetVault());
+    if(vault != assignment->GetVault()) assignment->SetVault(std::move(vault));
+}
+
+
+//______________________________________________________________________________
+std::shared_ptr<const VaultData> Calibration::ShareVault(std::shared_ptr<const VaultData> vault)
+{
+    auto range = mVaults.equal_range(vault->GetHash());
+    for(auto iter = range.first; iter != range.second; ) {
+        auto known = iter->second.lock();
+        if(!known) {
+            iter = mVaults.erase(iter);     // all assignments with this vault are gone
+            continue;
+        }
+        if(known == vault || known->HasSameData(*vault)) return known;
+        ++iter;                             // hash collision, different blobs
+    }
+
+    if(mCacheMemoryPolicy != cKeepAllData && vault->HasRawData()) {
+        vault = VaultData::CopyWithoutRawData(*vault);
+    }
+    mVaults.emplace(vault->GetHash(), vault);
+    return vault;
+}
+
+
+//______________________________________________________________________________
+AssignmentIdentity Calibration::GetAssignmentIdentity(const string& namepath)
+{
+    bool isCacheEnabled = mIsCacheEnabled;
+    Assignment* assignment = GetAssignment(namepath, false);
+    if(!assignment) return AssignmentIdentity();
+
+    AssignmentIdentity identity = assignment->GetIdentity();
+    if(!isCacheEnabled) delete assignment;      // nobody else has it
+    return identity;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::ChangedBetween(const string& namepath, int runA, int runB)
+{
+    UpdateActivityTime();
+
+    CacheKey keyA = ResolveRequest(namepath);
+    CacheKey keyB = keyA;
+    keyA.Run = runA;
+    keyB.Run = runB;
+
+    CheckForChangesIfNeeded();
+    if(!IsConnected()) CheckConnection();
+
+    std::lock_guard<std::mutex> lock(mReadMutex);
+    return !FindIdentity(keyA).HasSameData(FindIdentity(keyB));
+}
+
+
+//______________________________________________________________________________
+std::vector<CalibrationRunSpan> Calibration::GetCalibOverRuns(const string& namepath, int runMin, int runMax)
+{
+    UpdateActivityTime();
+
+    CacheKey key = ResolveRequest(namepath);
+    if(!IsConnected()) CheckConnection();
+
+    std::vector<CalibrationRunSpan> spans;
+    {
+        // Cached requests of other threads don't wait for the scan
+        std::lock_guard<std::mutex> providerLock(mProviderMutex);
+        EpochCalculator calculator(*mProvider, {key.Path}, key.Variation, key.Time, runMin, runMax);
+        const AssignmentHistory& history = calculator.GetHistory(0);
+
+        // Only vaults of the assignments that win some runs are read, each once
+        std::map<dbkey_t, std::shared_ptr<const VaultData>> vaults;
+        for(const auto& epoch: calculator.GetEpochs(runMin, runMax)) {
+            const AssignmentHistoryEntry* entry = history.Find(epoch.RunMin, key.Time);
+            if(!entry) continue;
+
+            std::shared_ptr<const VaultData>& vault = vaults[entry->ConstantSetId];
+            if(!vault) vault = mProvider->GetConstantSetVault(entry->ConstantSetId);
+            if(!vault) continue;        // the constant set was deleted after the assignments were read
+
+            CalibrationRunSpan span;
+            span.RunMin = epoch.RunMin;
+            span.RunMax = epoch.RunMax;
+            span.Vault = vault;
+            span.Identity.AssignmentId = entry->AssignmentId;
+            spans.push_back(std::move(span));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mReadMutex);
+    for(auto& span: spans) {
+        span.Vault = ShareVault(span.Vault);
+        span.Identity.VaultHash = span.Vault->GetHash();
+    }
+    return spans;
+}
+
+
+//______________________________________________________________________________
+AssignmentIdentity Calibration::FindIdentity(const CacheKey& key)
+{
+    // Peek into the cache, it is not a hit of GetCalib
+    if(mIsCacheEnabled) {
+        auto cached = mCache.find(key);
+        if(cached != mCache.end() && cached->second) return cached->second->GetIdentity();
+    }
+
+    auto found = mIdentities.find(key);
+    if(found != mIdentities.end()) return found->second;
+
+    AssignmentIdentity identity;
+    {
+        std::lock_guard<std::mutex> providerLock(mProviderMutex);
+        identity = mProvider->GetAssignmentIdentity(key.Run, key.Path, key.Time, key.Variation);
+    }
+    mIdentities.emplace(key, identity);
+    return identity;
+}
+
+
+//______________________________________________________________________________
+bool Calibration::FindCached(const CacheKey& key, Assignment*& assignment)
+{
+    if(!mIsCacheEnabled) return false;
+    auto cached = mCache.find(key);
+    if(cached == mCache.end()) return false;
+
+    // Not found requests are asked again when their time has passed
+    if(!cached->second && mNegativeCacheTtl >= 0) {
+        auto missTime = mMissTimes.find(key);
+        time_t now = TimeProvider::GetUnixTimeStamp(ClockSources::Monotonic);
+        if(missTime == mMissTimes.end() || now - missTime->second >= mNegativeCacheTtl) {
+            mCache.erase(cached);
+            if(missTime != mMissTimes.end()) mMissTimes.erase(missTime);
+            return false;
+        }
+    }
+
+    mCacheHits++;
+    assignment = cached->second;
+    return true;
+}
+
+
+//______________________________________________________________________________
+void Calibration::AddToCache(const CacheKey& key, Assignment* assignment)
+{
+    if(assignment) {
+        ShareVault(assignment);
+        assignment->SetKeepMappedRows(mCacheMemoryPolicy != cDropRawAndMappedData);
+    }
+    else if(mNegativeCacheTtl > 0) {
+        mMissTimes[key] = TimeProvider::GetUnixTimeStamp(ClockSources::Monotonic);
+    }
+    else if(mNegativeCacheTtl == 0) {
+        return;
+    }
+    mCache[key] = assignment;
 }
 
+
+//______________________________________________________________________________
+void Calibration::RetireAssignment(Assignment* assignment)
+{
+    // Users may still hold it, so it is kept until the Calibration is destroyed
+    if(assignment) mRetiredAssignments.emplace_back(assignment);
+}
+
+
+//______________________________________________________________________________
+void Calibration::PrepareForFork()
+{
+    {
+        std::lock_guard<std::mutex> lock(mReadMutex);
+        for(auto& entry: mCache) {
+            if(!entry.second) continue;
+            if(entry.second->GetVault()) entry.second->GetVault()->GetValues();     // split here, not in every child
+            entry.second->SetKeepMappedRows(false);
+        }
+    }
+
+    // Database handles can't be used by two processes
+    if(!mProviderIsLocked && IsConnected()) Disconnect();
+}
+
+
+//______________________________________________________________________________
+void Calibration::AfterForkChild()
+{
+    if(IsConnected()) {
+        throw std::logic_error("Calibration::AfterForkChild => The connection belongs to the parent process. "
+                               "PrepareForFork should be called right before fork and the provider must not be locked");
+    }
+    UpdateActivityTime();
+}
+
+
+//______________________________________________________________________________
+void Calibration::SetOptions(const CalibrationOptions& options)
+{
+    {
+        std::lock_guard<std::mutex> lock(mReadMutex);
+        *mOptions = options;
+    }
+    ApplyOptions();
+}
+
+
+//______________________________________________________________________________
+CalibrationOptions Calibration::GetOptions()
+{
+    std::lock_guard<std::mutex> lock(mReadMutex);
+
+    // These could be changed by their own setters
+    CalibrationOptions options = *mOptions;
+    options.IsCacheEnabled = mIsCacheEnabled;
+    options.CacheMemoryPolicy = mCacheMemoryPolicy;
+    options.ChangeCheckInterval = mChangeCheckInterval;
+    options.IsTracingEnabled = PerfLog::IsEnabled();
+    return options;
+}
+
+
+//______________________________________________________________________________
+void Calibration::ApplyOptions()
+{
+    std::lock_guard<std::mutex> lock(mReadMutex);
+    mIsCacheEnabled = mOptions->IsCacheEnabled || mOptions->IsPreloadEnabled;     // preload is for the cache
+    mCacheMemoryPolicy = mOptions->CacheMemoryPolicy;
+    mNegativeCacheTtl = mOptions->NegativeCacheTtl;
+    mIsPreloadEnabled = mOptions->IsPreloadEnabled;
+    mChangeCheckInterval = mOptions->ChangeCheckInterval;
+    mIsMetricsEnabled = mOptions->IsMetricsEnabled;
+    PerfLog::SetEnabled(mOptions->IsTracingEnabled);
+}
+
+
+//______________________________________________________________________________
+std::string Calibration::ApplyConnectionOptions(const std::string& connectionString)
+{
+    std::string query;
+    std::string result = CalibrationOptions::SplitConnectionString(connectionString, query);
+    if(query.empty()) return result;
+
+    CalibrationOptions options = GetOptions();
+    options.SetFromQuery(query);
+    SetOptions(options);
+    return result;
+}
+
+
+//______________________________________________________________________________
+size_t Calibration::Preload()
+{
+    EnableCache(true);
+
+    vector<string> namepaths;
+    GetListOfNamepaths(namepaths);
+
+    vector<std::future<Assignment*>> requests;
+    requests.reserve(namepaths.size());
+    for(const auto& namepath: namepaths) requests.push_back(GetAssignmentAsync("/" + namepath));
+
+    size_t count = 0;
+    for(auto& request: requests) {
+        if(request.get()) count++;
+    }
+    return count;
+}
+
+
+//______________________________________________________________________________
+void Calibration::WriteMetrics(std::ostream& stream)
+{
+    MemoryUsage usage = GetCacheMemoryUsage();
+    size_t vaults = GetCachedVaultsCount();
+
+    std::lock_guard<std::mutex> lock(mReadMutex);
+    stream << "CCDB_METRICS:{\"cache_entries\":" << mCache.size() << ","
+           << "\"cache_hits\":" << mCacheHits << ","
+           << "\"cache_misses\":" << mCacheMisses << ","
+           << "\"vaults\":" << vaults << ","
+           << "\"raw_bytes\":" << usage.RawBytes << ","
+           << "\"split_bytes\":" << usage.SplitBytes << ","
+           << "\"mapped_bytes\":" << usage.MappedBytes << ","
+           << "\"object_bytes\":" << usage.ObjectBytes << "}" << std::endl;
+}
+
+
+//______________________________________________________________________________
+void Calibration::SetCacheMemoryPolicy(CacheMemoryPolicies policy)
+{
+    std::lock_guard<std::mutex> lock(mReadMutex);
+    mCacheMemoryPolicy = policy;
+}
+
+
+//______________________________________________________________________________
+Calibration::CacheMemoryPolicies Calibration::GetCacheMemoryPolicy()
+{
+    std::lock_guard<std::mutex> lock(mReadMutex);
+    return mCacheMemoryPolicy;
+}
+
+
+//______________________________________________________________________________
+MemoryUsage Calibration::GetCacheMemoryUsage()
+{
+    MemoryUsage total;
+    for(const auto& table: GetCacheMemoryUsageByTable()) total += table.second;
+    return total;
+}
+
+
+//______________________________________________________________________________
+std::map<std::string, MemoryUsage> Calibration::GetCacheMemoryUsageByTable()
+{
+    std::lock_guard<std::mutex> lock(mReadMutex);
+
+    std::map<std::string, MemoryUsage> usageByTable;
+    std::set<const VaultData*> countedVaults;
+    for(const auto& entry: mCache) {
+        if(!entry.second) continue;     // not found requests are cached too
+
+        MemoryUsage& usage = usageByTable[entry.first.Path];
+        usage += entry.second->GetMemoryUsage(/*includeVault*/ false);
+        auto vault = entry.second->GetVault();
+        if(vault && countedVaults.insert(vault.get()).second) usage += vault->GetMemoryUsage();
+    }
+    return usageByTable;
+}
+
+
+//______________________________________________________________________________
+size_t Calibration::GetCachedVaultsCount()
+{
+    std::lock_guard<std::mutex> lock(mReadMutex);
+    size_t count = 0;
+    for(const auto& vault: mVaults) {
+        if(!vault.second.expired()) count++;
+    }
+    return count;
+}
+
+
+//______________________________________________________________________________
+void Calibration::CheckForChangesIfNeeded()
+{
+    if(mChangeCheckInterval <= 0) return;
+
+    time_t now = TimeProvider::GetUnixTimeStamp(ClockSources::Monotonic);
+    {
+        std::lock_guard<std::mutex> lock(mReadMutex);
+        if(mIsChangeCheckStarted && now - mLastChangeCheckTime < mChangeCheckInterval) return;
+    }
+    CheckConnection();
+    CheckForChanges();
+}
+
+
+//______________________________________________________________________________
+size_t Calibration::CheckForChanges()
+{
+    std::vector<AssignmentChange> changes;
+    size_t removedCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(mReadMutex);
+        std::lock_guard<std::mutex> providerLock(mProviderMutex);
+        mLastChangeCheckTime = TimeProvider::GetUnixTimeStamp(ClockSources::Monotonic);
+
+        // The quick check is always done, so the provider remembers the current state
+        bool isChanged = mProvider->IsChangedSinceLastCheck();
+        if(mIsChangeCheckStarted && !isChanged) return 0;
+
+        dbkey_t lastAssignmentId = mProvider->GetLastAssignmentId();
+        if(!mIsChangeCheckStarted) {
+            mLastAssignmentId = lastAssignmentId;
+            mIsChangeCheckStarted = true;
+            return 0;
+        }
+        if(lastAssignmentId == mLastAssignmentId) return 0;
+
+        // Finished asynchronous requests are checked as cached ones
+        AddFinishedRequestsToCache();
+
+        if(lastAssignmentId < mLastAssignmentId) {
+            // Assignments were deleted. It is not known which, so nothing cached could be trusted
+            removedCount = mCache.size();
+            for(auto& entry: mCache) RetireAssignment(entry.second);
+            mCache.clear();
+            mMissTimes.clear();
+            mIdentities.clear();
+            mLastAssignmentId = lastAssignmentId;
+        }
+        else {
+            changes = mProvider->GetAssignmentsAfter(mLastAssignmentId);
+            mLastAssignmentId = changes.empty() ? lastAssignmentId : changes.back().AssignmentId;
+            if(!changes.empty()) mIdentities.clear();
+
+            // Variation and its parents for each cached variation name
+            std::map<InternedString, std::vector<string>> variationChains;
+            for(auto iter = mCache.begin(); iter != mCache.end(); ) {
+                const CacheKey& entry = iter->first;
+                auto chain = variationChains.find(entry.Variation);
+                if(chain == variationChains.end()) {
+                    std::vector<string> names;
+                    for(Variation* variation = mProvider->GetVariation(entry.Variation); variation; variation = variation->GetParent()) {
+                        names.push_back(variation->GetName());
+                    }
+                    chain = variationChains.emplace(entry.Variation, names).first;
+                }
+
+                bool isOutdated = false;
+                for(const auto& change: changes) {
+                    if(change.TablePath != entry.Path.str() || change.RunMin > entry.Run || change.RunMax < entry.Run) continue;
+                    if(entry.Time > 0 && change.Created > entry.Time) continue;
+                    if(std::find(chain->second.begin(), chain->second.end(), change.Variation) == chain->second.end()) continue;
+                    isOutdated = true;
+                    break;
+                }
+
+                if(isOutdated) {
+                    RetireAssignment(iter->second);
+                    mMissTimes.erase(iter->first);
+                    iter = mCache.erase(iter);
+                    removedCount++;
+                }
+                else {
+                    ++iter;
+                }
+            }
+        }
+    }
+
+    // Listeners may request constants, so no Calibration locks are held here
+    std::vector<ChangeListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(mListenersMutex);
+        for(const auto& listener: mChangeListeners) listeners.push_back(listener.second);
+    }
+    for(const auto& listener: listeners) listener(changes);
+
+    return removedCount;
+}
+
+
+//______________________________________________________________________________
+int Calibration::AddChangeListener(ChangeListener listener)
+{
+    std::lock_guard<std::mutex> lock(mListenersMutex);
+    int listenerId = mNextListenerId++;
+    mChangeListeners[listenerId] = std::move(listener);
+    return listenerId;
+}
+
+
+//______________________________________________________________________________
+void Calibration::RemoveChangeListener(int listenerId)
+{
+    std::lock_guard<std::mutex> lock(mListenersMutex);
+    mChangeListeners.erase(listenerId);
+}
+
+}
@@ -7,9 +7,13 @@
 #include <time.h>
 #include <memory>
 #include <mutex>
+#include <future>
+#include <functional>
 
 #include "Globals.h"
 #include "Providers/DataProvider.h"
+#include "Helpers/StringPool.h"
+#include "Helpers/MemoryUsage.h"
 
 #define ERRMSG_INVALID_CONNECT_USAGE "Invalid DMySQLCalibration usage. Using DMySQLCalibration::Connect method with provider == NULL and ProviderIsLocked==true." 
 #define ERRMSG_CONNECTED_TO_ANOTHER "The connection is open to another source. DCalibration is already connected using another connection string" 
@@ -18,10 +22,28 @@
 
 namespace ccdb
 {
+    struct CalibrationOptions;
+
+    /** @brief Constants of one assignment for runs RunMin..RunMax, @see Calibration::GetCalibOverRuns */
+    struct CalibrationRunSpan
+    {
+        int RunMin = 0;
+        int RunMax = 0;
+        AssignmentIdentity Identity;                /// Assignment id and vault hash
+        std::shared_ptr<const VaultData> Vault;     /// Values row by row. Spans with equal constants share the vault
+    };
 
     class Calibration {
 
     public:
+        /** @brief What cached assignments keep besides their values, @see SetCacheMemoryPolicy */
+        enum CacheMemoryPolicies
+        {
+            cKeepAllData,           /// Blobs, split values and mapped rows (default)
+            cDropRawData,           /// Split values and mapped rows. Blobs are made from values if asked
+            cDropRawAndMappedData   /// Only split values. GetValue by column name looks up the column index
+        };
+
         Calibration(); ///< Default constructor
 
         /** @brief Ctor takes default run number and default variation
@@ -50,6 +72,9 @@ namespace ccdb
          * @see SQLiteCalibration
          * sqlite://<path to sqlite file>
          *
+         * Options could be added to the end: sqlite://<path to sqlite file>?cache=on&preload=on
+         * @see CalibrationOptions
+         *
          * @param connectionString the Connection String
          * @return true if connected
          */
@@ -178,6 +203,26 @@ namespace ccdb
         virtual bool GetCalib(double &value, const string & namepath);
         virtual bool GetCalib(int &value, const string & namepath);
 
+        /** @brief Get constants by namepath as one row that is returned by value
+         *
+         * The same as GetCalib(vector<T>&, namepath) but the vector is moved to the caller.
+         * T is string, double or int.
+         *
+         * @parameter [in]  namepath - data path
+         * @return values or empty vector if namepath was not found. Found data never has zero values
+         */
+        template<typename T> std::vector<T> GetCalibVector(const string & namepath);
+
+        /** @brief Get constants by namepath as a table of rows that is returned by value
+         *
+         * The same as GetCalib(vector<vector<T>>&, namepath) but the table is moved to the caller.
+         * T is string, double or int.
+         *
+         * @parameter [in]  namepath - data path
+         * @return rows or empty vector if namepath was not found
+         */
+        template<typename T> std::vector<std::vector<T>> GetCalibTable(const string & namepath);
+
         /** @brief gets connection string which is used for current provider
         *@return mConnectionString
         */
@@ -255,6 +300,59 @@ namespace ccdb
         */
         virtual Assignment* GetAssignment(const string& namepath, bool loadColumns = true);
 
+        /** @brief Starts getting the assignment and returns right away
+        *
+        * Start many requests and then wait for them. With MySQL the requests run at the same time,
+        * so e.g. 300 tables at a run boundary take a few round trips instead of 300.
+        * Cached assignments are returned as ready futures. With the cache on the result is cached by the next request,
+        * even if the future is dropped, and the assignment belongs to the cache as GetAssignment ones do.
+        * The future doesn't refer to the Calibration.
+        *
+        * @remark the function is thread safe
+        *
+        * @parameter [in] namepath -  full namepath is /path/to/data:run:variation:time but usually it is only /path/to/data
+        * @return   future of Assignment*. NULL if not found. future::get() rethrows request errors
+        */
+        virtual std::future<Assignment*> GetAssignmentAsync(const string& namepath, bool loadColumns = true);
+
+        /** @brief Identity of the assignment for the request: assignment id and hash of its constants
+         *
+         * Keep it with what is built from the constants and rebuild only when it changes:
+         *    if(identity != calib->GetAssignmentIdentity("/path")) rebuild...
+         * The assignment is got as GetAssignment does, so it is cached if the cache is on.
+         * @remark the function is thread safe
+         * @return the identity. AssignmentId is 0 if there is no assignment
+         */
+        AssignmentIdentity GetAssignmentIdentity(const string& namepath);
+
+        /** @brief true if the constants of the request are different for runA and runB
+         *
+         * The run of namepath (if any) is replaced by runA and runB, variation and time are taken as usual.
+         * Cached assignments are compared by their vault hashes. Otherwise the provider is asked for
+         * assignment and constant set ids only, the constants are not read. The answers are remembered
+         * till changes in the database are found (@see CheckForChanges).
+         * Different assignments with the same constant set are not a change. Different assignments
+         * with equal constants are a change unless both are cached (only then their hashes are known).
+         * @remark the function is thread safe
+         */
+        bool ChangedBetween(const string& namepath, int runA, int runB);
+
+        /** @brief Constants of the table for every run of runMin..runMax with all distinct assignments read at once
+         *
+         * For trending and validation over many runs, instead of GetCalib for each run.
+         * The run of namepath (if any) is not used, variation and time are taken as usual and resolved
+         * as GetAssignmentShort does, including parent variations. Ids and run ranges of the table assignments
+         * are read with one query per variation level (@see AssignmentHistory), then only the constants of the
+         * assignments that win some runs. Spans are ordered by runs, runs without
+         * constants are not covered by any span. Adjacent spans have different assignments. The same assignment
+         * may win in several spans. Equal constants share one VaultData, also with cached assignments.
+         * Cached requests of other threads are not blocked while the assignments are read.
+         *
+         * @remark the function is thread safe
+         * @exception std::logic_error if runMin is greater than runMax
+         */
+        std::vector<CalibrationRunSpan> GetCalibOverRuns(const string& namepath, int runMin, int runMax);
+
         /** @brief if true the data will be cached
          *
          * @param value true - enable cache, false - disable
@@ -267,6 +365,102 @@ namespace ccdb
         /** @brief if true the caching is using */
         bool IsCacheEnabled();
 
+        /** @brief Number of distinct vaults held by cached assignments
+         *
+         * Cached assignments with identical vaults (the same constants for different runs or tables requests)
+         * share one VaultData, so the data is parsed and kept in memory once
+         */
+        size_t GetCachedVaultsCount();
+
+        /** @brief Gets the cache ready to be shared with processes forked after the call
+         *
+         * Splits values of cached assignments and releases their mapped rows, so reading cached constants
+         * doesn't write to the cache memory and forked children keep sharing its pages with the parent.
+         * Then disconnects, database handles can't be used by two processes. Cached requests don't need
+         * a connection, the first request that is not in the cache connects again (in the parent too).
+         *
+         * Call it when no other thread uses the calibration: fork copies neither threads nor held locks.
+         * A locked provider (@see UseProvider) is not disconnected, its owner does it.
+         */
+        void PrepareForFork();
+
+        /** @brief Call in a child process right after fork. Throws logic_error if a connection was inherited */
+        void AfterForkChild();
+
+        /** @brief Sets what cached assignments keep. Less memory costs more CPU for some requests
+         *
+         * Applied to assignments when they are put to the cache, so it should be set before constants are requested.
+         * Typed and string GetCalib results are the same with any policy.
+         */
+        void SetCacheMemoryPolicy(CacheMemoryPolicies policy);
+        CacheMemoryPolicies GetCacheMemoryPolicy();
+
+        /** @brief Bytes held by cached assignments and their vaults. A vault shared by assignments is counted once
+         *
+         * @remark the function is thread safe
+         */
+        MemoryUsage GetCacheMemoryUsage();
+
+        /** @brief GetCacheMemoryUsage by absolute type table path. A shared vault is counted for the first table that has it */
+        std::map<std::string, MemoryUsage> GetCacheMemoryUsageByTable();
+
+        /** @brief Applies options, see CalibrationOptions. Connection options (sqlite_mode, pool sizes) are used by the next Connect
+         *
+         * Calibration starts with CalibrationOptions::FromEnvironment(). Options in the connection string
+         * (sqlite://ccdb.sqlite?cache=on) are applied by Connect over them.
+         */
+        void SetOptions(const CalibrationOptions& options);
+
+        /** @brief Current options */
+        CalibrationOptions GetOptions();
+
+        /** @brief Loads constants of all type tables for the default run, variation and time to the cache
+         *
+         * Requests run asynchronously, with MySQL they take a few round trips. Turns the cache on.
+         * Called by Connect with 'preload' option.
+         * @return number of found assignments
+         */
+        size_t Preload();
+
+        /** @brief Writes CCDB_METRICS:{...} line with cache counters and memory. Written on destruction with 'metrics' option */
+        void WriteMetrics(std::ostream& stream);
+
+        /** @brief Function called when new assignments are found. Empty list means that assignments were deleted */
+        typedef std::function<void(const std::vector<AssignmentChange>&)> ChangeListener;
+
+        /** @brief Checks the database for new assignments not often than once in 'seconds'. 0 - never (default)
+         *
+         * Lets long running processes keep the cache enabled and still get constants that calibrators add.
+         * The check is done by GetAssignment calls when the interval has passed, see CheckForChanges.
+         * Should be set before constants are requested: the changes are looked for since the first check.
+         */
+        void SetChangeCheckInterval(int seconds) { mChangeCheckInterval = seconds; }
+        int GetChangeCheckInterval() const { return mChangeCheckInterval; }
+
+        /** @brief Finds assignments added since the previous check and removes cached assignments they outdate
+         *
+         * A cached request is outdated by an added assignment of the same type table, which run range has
+         * the request run, which variation is the request variation or one of its parents and which is created
+         * before the request time (if the time is given). Other cached assignments stay in the cache.
+         * If the newest assignments were deleted, the whole cache is dropped.
+         * Removed assignments are kept until the Calibration is destroyed, so pointers users have stay valid.
+         *
+         * Change listeners are called after that, without Calibration locks held.
+         * The first call only remembers the state of the database.
+         *
+         * @remark the function is thread safe
+         * @return number of removed cache entries
+         */
+        size_t CheckForChanges();
+
+        /** @brief Adds function to call when CheckForChanges finds changes
+         * @return id for RemoveChangeListener
+         */
+        int AddChangeListener(ChangeListener listener);
+
+        /** @brief Removes function added by AddChangeListener */
+        void RemoveChangeListener(int listenerId);
+
     protected:
 
         /**@brief Try to auto-reconnect if possible
@@ -289,20 +483,108 @@ namespace ccdb
          */
         void UpdateActivityTime();
 
+        /** @brief GetCalib implementations that parse vault values right into the output containers */
+        template<typename T> bool GetMappedCalib(vector< map<string, T> > &values, const string & namepath);
+        template<typename T> bool GetTableCalib(vector< vector<T> > &values, const string & namepath);
+        template<typename T> bool GetRowCalib(map<string, T> &values, const string & namepath);
+        template<typename T> bool GetVectorCalib(vector<T> &values, const string & namepath);
+
+        /** @brief Makes assignment use already known VaultData with the same blob. mReadMutex must be locked
+         *
+         * With cDropRawData or cDropRawAndMappedData policy new vaults are kept without blobs
+         */
+        void ShareVault(Assignment* assignment);
+
+        /** @brief The known VaultData with the same blob or the vault itself, which becomes known. mReadMutex must be locked */
+        std::shared_ptr<const VaultData> ShareVault(std::shared_ptr<const VaultData> vault);
+
+        /** @brief Applies "?name=value" options of the connection string and returns the string without them. Connect calls it */
+        std::string ApplyConnectionOptions(const std::string& connectionString);
+
+        /** @brief Calls CheckForChanges if checks are enabled and the interval has passed. mReadMutex must not be locked */
+        void CheckForChangesIfNeeded();
+
+        /** @brief The request a cached assignment was got by. Strings are interned, so keys are compared without string compares */
+        struct CacheKey
+        {
+            InternedString Path;         /// Absolute type table path
+            int Run;
+            InternedString Variation;
+            time_t Time;
+
+            bool operator<(const CacheKey& rhs) const {
+                if(Path != rhs.Path) return Path < rhs.Path;
+                if(Run != rhs.Run) return Run < rhs.Run;
+                if(Variation != rhs.Variation) return Variation < rhs.Variation;
+                return Time < rhs.Time;
+            }
+        };
+
+        /** @brief The cache key of the request with default run, variation and time where they are not given
+         *
+         * Parsed requests are remembered for each thread (@see ResolvedRequest in Calibration.cc),
+         * so a repeated request string is not parsed again
+         */
+        CacheKey ResolveRequest(const std::string& namepath) const;
+
+        /** @brief true and the cached assignment if the cache is enabled and has the request. mReadMutex must be locked */
+        bool FindCached(const CacheKey& key, Assignment*& assignment);
+
+        /** @brief Shares the vault, applies the memory policy and puts the assignment to the cache. mReadMutex must be locked */
+        void AddToCache(const CacheKey& key, Assignment* assignment);
+
+        /** @brief Keeps an assignment removed from the cache until destruction. NULL is ignored. mReadMutex must be locked */
+        void RetireAssignment(Assignment* assignment);
+
+        /** @brief Identity from the cache or from the provider. mReadMutex must be locked, the provider connected */
+        AssignmentIdentity FindIdentity(const CacheKey& key);
+
+        /** @brief Puts results of finished GetAssignmentAsync requests to the cache. mReadMutex must be locked */
+        void AddFinishedRequestsToCache();
+
+        /** @brief If GetAssignmentAsync request of the key is running, waits for it with the lock released and caches the result
+         *
+         * @return true and the assignment if there was a request. Rethrows its error
+         */
+        bool WaitForRequest(const CacheKey& key, std::unique_lock<std::mutex>& lock, Assignment*& assignment);
+
         DataProvider *mProvider;         /// Underlaid DataProvider object
         bool mProviderIsLocked;          /// If provider
         int mDefaultRun;                 /// Default run number
-        string mDefaultVariation;        /// Default variation
+        InternedString mDefaultVariation;    /// Default variation
         time_t mDefaultTime;             /// Set default time
         time_t mLastActivityTime;        /// Time of the last request
         bool mIsAutoReconnect;           /// Try to auto-reconnect if possible
         bool mIsCacheEnabled;            /// If true the data is cached
+        CacheMemoryPolicies mCacheMemoryPolicy;  /// What cached assignments keep
+        int mNegativeCacheTtl;           /// Seconds not found requests stay cached. -1 - forever, 0 - not cached
+        bool mIsPreloadEnabled;          /// Connect calls Preload
+        bool mIsMetricsEnabled;          /// Destructor writes metrics
+        std::unique_ptr<CalibrationOptions> mOptions;   /// Options. The ones above and the cache are applied from them
 
         std::mutex mReadMutex;
+        std::mutex mProviderMutex;       /// Serializes requests to the provider. Locked after mReadMutex if both are needed
+        std::map<CacheKey, Assignment*> mCache;          /// Cached assignments by the request
+        std::map<CacheKey, time_t> mMissTimes;           /// Monotonic time not found requests were cached at
+        std::map<CacheKey, AssignmentIdentity> mIdentities;  /// Identities got from the provider, @see ChangedBetween
+        std::map<CacheKey, std::shared_future<Assignment*>> mRequests;  /// GetAssignmentAsync requests not cached yet
+        std::vector<std::unique_ptr<Assignment>> mRetiredAssignments;   /// Removed from the cache by CheckForChanges, users may hold them
+        uint64_t mCacheHits;             /// Requests found in the cache
+        uint64_t mCacheMisses;           /// Requests that went to the provider with the cache on
+        std::multimap<uint64_t, std::weak_ptr<const VaultData>> mVaults;    /// Vaults of cached assignments by VaultData::GetHash
+
+        int mChangeCheckInterval;        /// Seconds between checks for new assignments. 0 - no checks
+        time_t mLastChangeCheckTime;     /// Monotonic time of the last check
+        bool mIsChangeCheckStarted;      /// mLastAssignmentId is known
+        dbkey_t mLastAssignmentId;       /// The newest assignment on the last check
+        std::mutex mListenersMutex;
+        std::map<int, ChangeListener> mChangeListeners;
+        int mNextListenerId;
     private:
         Calibration(const Calibration& rhs);
         Calibration& operator=(const Calibration& rhs);
         void CheckConnection(); /// Check if is connected and reconnect if needed (and allowed)
+        void ApplyOptions();    /// Sets fields by mOptions
     };
 }
 
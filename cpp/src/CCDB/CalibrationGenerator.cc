@@ -74,7 +74,8 @@ namespace ccdb
 
 
     //______________________________________________________________________________
-    CalibrationGenerator::CalibrationGenerator()
+    CalibrationGenerator::CalibrationGenerator():
+        mOptions(CalibrationOptions::FromEnvironment())
     {
         mMaxInactiveTime = 0; //Disable inactive check
         mInactivityCheckInterval = 100;
@@ -132,6 +133,7 @@ namespace ccdb
 
         //now we create calibration
         Calibration * calib = CreateCalibration(isMySql, run, variation, time);
+        calib->SetOptions(mOptions);
 
         //Connect!
         if(!calib->Connect(connectionString))
@@ -176,10 +178,15 @@ namespace ccdb
          //so if user asks DCalibration which is already exists a new DCalibration
          //will not be created once again but already created DCalibration is returned;
 
-        //right now our hash will be just a summ of strings
+        //Options of the connection string are taken as the Calibration gets them: over the generator options.
+        //So the order and the spelling of options don't make another Calibration
+        string query;
+        string address = CalibrationOptions::SplitConnectionString(connectionString, query);
+        CalibrationOptions options = mOptions;
+        options.SetFromQuery(query);
 
         ostringstream strstrm;
-        strstrm<<connectionString<<run<<variation<<time;
+        strstrm<<address<<'\n'<<options.ToQuery()<<'\n'<<run<<'\n'<<variation<<'\n'<<time;
         return strstrm.str();
     }
 
@@ -213,6 +220,26 @@ namespace ccdb
         }
     }
 
+
+    //______________________________________________________________________________
+    void CalibrationGenerator::PrepareForFork(const std::vector<std::string>& namepaths)
+    {
+        for(auto calib: mCalibrations)
+        {
+            calib->EnableCache(true);
+            for(const auto& namepath: namepaths) calib->GetAssignment(namepath);
+            calib->PrepareForFork();
+        }
+    }
+
+
+    //______________________________________________________________________________
+    void CalibrationGenerator::AfterForkChild()
+    {
+        for(auto calib: mCalibrations) calib->AfterForkChild();
+    }
+
+
     std::string CalibrationGenerator::GetConnectionErrorMessage( Calibration * calib )
     {
         DataProvider* provider = calib->GetProvider();
@@ -7,6 +7,7 @@
 #include <time.h>
 
 #include "CCDB/Calibration.h"
+#include "CCDB/CalibrationOptions.h"
 
 namespace ccdb
 {
@@ -55,6 +56,7 @@ public:
      * The hash is used for storing Calibrations in calibrations hash table
      * so if user asks DCalibration which is already exists a new DCalibration 
      * will not be created once again but already created DCalibration is returned;
+     * Options of the connection string are compared by their values, see CalibrationOptions::ToQuery
      * 
      * @parameter [in] connectionString - Connection string to the data source
      * @parameter [in] int run - run number
@@ -97,6 +99,30 @@ public:
      */
     void SetInactivityCheckInterval(time_t val) { mInactivityCheckInterval = val; }
 
+
+    /** @brief Options for Calibrations made after the call. CalibrationOptions::FromEnvironment() by default
+     *
+     *  Options in connection strings are applied over them
+     */
+    const CalibrationOptions& GetOptions() const { return mOptions; }
+    void SetOptions(const CalibrationOptions& options) { mOptions = options; }
+
+
+    /** @brief Loads constants to the caches of made Calibrations and gets them ready for fork
+     *
+     * For frameworks that initialize once and then fork workers. The caches are enabled, filled
+     * with the requests and prepared by @see Calibration::PrepareForFork, so workers share the
+     * loaded constants with the parent and need no database to read them.
+     * Call it right before fork, when no other thread uses the Calibrations.
+     *
+     * @parameter [in] namepaths - requests to load to every Calibration, like in GetCalib
+     */
+    void PrepareForFork(const std::vector<std::string>& namepaths = std::vector<std::string>());
+
+
+    /** @brief Call in a child process right after fork. @see Calibration::AfterForkChild */
+    void AfterForkChild();
+
 private:	
 
     //@parameter [in] connectionString - Connection string to the data source
@@ -111,6 +137,7 @@ private:
 	time_t mMaxInactiveTime;                                    ///Max inactive time for calibration secs
     time_t mLastInactivityCheckTime;                            ///Last time of inactivity check from Unix epoch
     time_t mInactivityCheckInterval;                            ///Interval to check inactivity secs
+    CalibrationOptions mOptions;                                ///Options for made Calibrations
 };
 }
 
@@ -0,0 +1,164 @@
+#include <stdexcept>
+#include <cstdlib>
+#include <cerrno>
+#include <algorithm>
+#include <cctype>
+
+#include "CCDB/CalibrationOptions.h"
+#include "CCDB/Helpers/StringUtils.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+namespace
+{
+    const char* const cOptionNames[] = {
+        "cache", "cache_policy", "negative_cache_ttl", "preload", "change_check_interval",
+        "sqlite_mode", "pool_size", "async_pool_size", "trace", "metrics"
+    };
+
+    bool ParseSwitch(const string& name, const string& value)
+    {
+        if(value == "on" || value == "true" || value == "1" || value == "yes") return true;
+        if(value == "off" || value == "false" || value == "0" || value == "no") return false;
+        throw std::logic_error("CalibrationOptions => '" + value + "' is not on or off value of '" + name + "' option");
+    }
+
+    long ParseNumber(const string& name, const string& value, long minimum)
+    {
+        char* end = nullptr;
+        errno = 0;
+        long number = strtol(value.c_str(), &end, 10);
+        if(value.empty() || *end != '\0' || errno != 0 || number < minimum) {
+            throw std::logic_error("CalibrationOptions => '" + value + "' is not a valid number for '" + name + "' option");
+        }
+        return number;
+    }
+}
+
+
+//______________________________________________________________________________
+CalibrationOptions::CalibrationOptions()
+{
+#ifdef CCDB_CACHE_ON
+    IsCacheEnabled = true;
+#else
+    IsCacheEnabled = false;
+#endif
+
+#ifdef CCDB_PERFLOG_ON
+    IsTracingEnabled = true;
+#else
+    IsTracingEnabled = false;
+#endif
+
+    CacheMemoryPolicy = Calibration::cKeepAllData;
+    NegativeCacheTtl = -1;
+    IsPreloadEnabled = false;
+    ChangeCheckInterval = 0;
+    IsSQLiteImmutable = false;
+    PoolSize = 0;
+    AsyncPoolSize = 0;
+    IsMetricsEnabled = false;
+}
+
+
+//______________________________________________________________________________
+CalibrationOptions CalibrationOptions::FromEnvironment()
+{
+    CalibrationOptions options;
+    for(auto name: cOptionNames) {
+        string variable(string("CCDB_") + name);
+        std::transform(variable.begin(), variable.end(), variable.begin(), ::toupper);
+        const char* value = getenv(variable.c_str());
+        if(!value) continue;
+        try {
+            options.Set(name, value);
+        }
+        catch (std::logic_error& error) {
+            throw std::logic_error("CalibrationOptions => Environment variable " + variable + "='" + value + "' is wrong: " + error.what());
+        }
+    }
+    return options;
+}
+
+
+//______________________________________________________________________________
+void CalibrationOptions::Set(const std::string& name, const std::string& value)
+{
+    if(name == "cache") IsCacheEnabled = ParseSwitch(name, value);
+    else if(name == "cache_policy") {
+        if(value == "keep_all") CacheMemoryPolicy = Calibration::cKeepAllData;
+        else if(value == "drop_raw") CacheMemoryPolicy = Calibration::cDropRawData;
+        else if(value == "drop_raw_and_mapped") CacheMemoryPolicy = Calibration::cDropRawAndMappedData;
+        else throw std::logic_error("CalibrationOptions => Unknown cache_policy '" + value + "'. keep_all, drop_raw or drop_raw_and_mapped are known");
+    }
+    else if(name == "negative_cache_ttl") NegativeCacheTtl = static_cast<int>(ParseNumber(name, value, -1));
+    else if(name == "preload") IsPreloadEnabled = ParseSwitch(name, value);
+    else if(name == "change_check_interval") ChangeCheckInterval = static_cast<int>(ParseNumber(name, value, 0));
+    else if(name == "sqlite_mode") {
+        if(value == "readonly") IsSQLiteImmutable = false;
+        else if(value == "immutable") IsSQLiteImmutable = true;
+        else throw std::logic_error("CalibrationOptions => Unknown sqlite_mode '" + value + "'. readonly or immutable are known");
+    }
+    else if(name == "pool_size") PoolSize = static_cast<size_t>(ParseNumber(name, value, 0));
+    else if(name == "async_pool_size") AsyncPoolSize = static_cast<size_t>(ParseNumber(name, value, 0));
+    else if(name == "trace") IsTracingEnabled = ParseSwitch(name, value);
+    else if(name == "metrics") IsMetricsEnabled = ParseSwitch(name, value);
+    else throw std::logic_error("CalibrationOptions => Unknown option '" + name + "'");
+}
+
+
+//______________________________________________________________________________
+void CalibrationOptions::SetFromQuery(const std::string& query)
+{
+    for(const auto& pair: StringUtils::Split(query, "&")) {
+        if(pair.empty()) continue;
+        size_t equalPos = pair.find('=');
+        if(equalPos == string::npos) {
+            throw std::logic_error("CalibrationOptions => '" + pair + "' is not name=value option");
+        }
+        Set(pair.substr(0, equalPos), pair.substr(equalPos + 1));
+    }
+}
+
+
+//______________________________________________________________________________
+std::string CalibrationOptions::ToQuery() const
+{
+    const char* policy = "keep_all";
+    if(CacheMemoryPolicy == Calibration::cDropRawData) policy = "drop_raw";
+    else if(CacheMemoryPolicy == Calibration::cDropRawAndMappedData) policy = "drop_raw_and_mapped";
+
+    string query;
+    query += string("cache=") + (IsCacheEnabled ? "on" : "off");
+    query += string("&cache_policy=") + policy;
+    query += "&negative_cache_ttl=" + std::to_string(NegativeCacheTtl);
+    query += string("&preload=") + (IsPreloadEnabled ? "on" : "off");
+    query += "&change_check_interval=" + std::to_string(ChangeCheckInterval);
+    query += string("&sqlite_mode=") + (IsSQLiteImmutable ? "immutable" : "readonly");
+    query += "&pool_size=" + std::to_string(PoolSize);
+    query += "&async_pool_size=" + std::to_string(AsyncPoolSize);
+    query += string("&trace=") + (IsTracingEnabled ? "on" : "off");
+    query += string("&metrics=") + (IsMetricsEnabled ? "on" : "off");
+    return query;
+}
+
+
+//______________________________________________________________________________
+std::string CalibrationOptions::SplitConnectionString(const std::string& connectionString, std::string& query)
+{
+    query.clear();
+    size_t questionPos = connectionString.rfind('?');
+    if(questionPos == string::npos) return connectionString;
+
+    string tail = connectionString.substr(questionPos + 1);
+    if(tail.find('=') == string::npos || tail.find('/') != string::npos) return connectionString;  // a part of a path
+
+    query = tail;
+    return connectionString.substr(0, questionPos);
+}
+
+}
@@ -0,0 +1,72 @@
+#ifndef _CalibrationOptions_
+#define _CalibrationOptions_
+
+#include <string>
+#include <cstddef>
+
+#include "CCDB/Calibration.h"
+
+namespace ccdb
+{
+    /** @brief Run time settings of Calibration
+     *
+     * Options come from three places, each next one overrides the previous:
+     *  1. Defaults. Cache and tracing defaults are set by CCDB_CACHE_ON and CCDB_PERFLOG_ON build flags
+     *  2. Environment variables CCDB_<NAME>, e.g. CCDB_CACHE=off (read when Calibration is created)
+     *  3. Connection string query, e.g. sqlite:///path/ccdb.sqlite?cache=on&sqlite_mode=immutable
+     * A programmatic struct given to @see Calibration::SetOptions replaces 1 and 2.
+     *
+     * Names and values:
+     *   cache                  on|off     Cache got assignments
+     *   cache_policy           keep_all|drop_raw|drop_raw_and_mapped, @see Calibration::CacheMemoryPolicies
+     *   negative_cache_ttl     seconds    How long not found requests stay cached. -1 - forever, 0 - not cached
+     *   preload                on|off     Load all tables for the default run, variation and time on Connect
+     *   change_check_interval  seconds    @see Calibration::SetChangeCheckInterval
+     *   sqlite_mode            readonly|immutable, @see SQLiteDataProvider::OpenModes
+     *   pool_size              number     Maximum MySQL connections. 0 - provider default
+     *   async_pool_size        number     MySQL connections for asynchronous requests. 0 - provider default
+     *   trace                  on|off     Print CCDB_PERF_LOG lines. Process wide
+     *   metrics                on|off     Print a CCDB_METRICS line with cache counters when Calibration is deleted
+     */
+    struct CalibrationOptions
+    {
+        CalibrationOptions();
+
+        bool IsCacheEnabled;
+        Calibration::CacheMemoryPolicies CacheMemoryPolicy;
+        int NegativeCacheTtl;
+        bool IsPreloadEnabled;
+        int ChangeCheckInterval;
+        bool IsSQLiteImmutable;     /// sqlite_mode=immutable, SQLiteDataProvider::cImmutableMode
+        size_t PoolSize;
+        size_t AsyncPoolSize;
+        bool IsTracingEnabled;
+        bool IsMetricsEnabled;
+
+        /** @brief Defaults overridden by CCDB_<NAME> environment variables */
+        static CalibrationOptions FromEnvironment();
+
+        /** @brief Sets the option by its name. Throws std::logic_error on unknown names and wrong values */
+        void Set(const std::string& name, const std::string& value);
+
+        /** @brief Sets options from "name=value&name=value" query */
+        void SetFromQuery(const std::string& query);
+
+        /** @brief All options as "name=value&name=value" query, names in the order of the list above
+         *
+         * Equal options give equal queries, whatever the order and the spelling (on, true, 1) of the query they were set by
+         */
+        std::string ToQuery() const;
+
+        /** @brief Takes off "?name=value..." from the end of the connection string
+         *
+         * A '?' that is not followed by name=value pairs (e.g. in a file name) is left in the string
+         * @param [in]  connectionString  like sqlite:///path/ccdb.sqlite?cache=on
+         * @param [out] query             "cache=on" or empty if there are no options
+         * @return the connection string without options
+         */
+        static std::string SplitConnectionString(const std::string& connectionString, std::string& query);
+    };
+}
+
+#endif //_CalibrationOptions_
@@ -0,0 +1,60 @@
+#ifndef _MemoryUsage_
+#define _MemoryUsage_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+namespace ccdb
+{
+    /** @brief Bytes held by cached constants, by the form the data is kept in
+     *
+     * The numbers are estimates: heap block headers and allocator rounding are not counted.
+     */
+    struct MemoryUsage
+    {
+        size_t RawBytes = 0;        /// Blobs as they are stored in the database
+        size_t SplitBytes = 0;      /// Values split from blobs
+        size_t MappedBytes = 0;     /// Rows of column name => value maps
+        size_t ObjectBytes = 0;     /// Assignment and vault objects and their other fields
+
+        size_t GetTotal() const { return RawBytes + SplitBytes + MappedBytes + ObjectBytes; }
+
+        MemoryUsage& operator+=(const MemoryUsage& rhs) {
+            RawBytes += rhs.RawBytes;
+            SplitBytes += rhs.SplitBytes;
+            MappedBytes += rhs.MappedBytes;
+            ObjectBytes += rhs.ObjectBytes;
+            return *this;
+        }
+    };
+
+
+    /** @brief Heap bytes of the string. 0 for short strings that are kept inside the string object */
+    inline size_t GetHeapBytes(const std::string& value)
+    {
+        const char* data = value.data();
+        const char* object = reinterpret_cast<const char*>(&value);
+        if(data >= object && data < object + sizeof(value)) return 0;
+        return value.capacity() + 1;
+    }
+
+    /** @brief Heap bytes of the vector and its strings */
+    inline size_t GetHeapBytes(const std::vector<std::string>& values)
+    {
+        size_t bytes = values.capacity() * sizeof(std::string);
+        for(const auto& value: values) bytes += GetHeapBytes(value);
+        return bytes;
+    }
+
+    /** @brief Heap bytes of the map nodes and their strings. A node has 3 links and a color besides the value */
+    inline size_t GetHeapBytes(const std::map<std::string, std::string>& values)
+    {
+        size_t bytes = values.size() * (sizeof(std::map<std::string, std::string>::value_type) + 4 * sizeof(void*));
+        for(const auto& value: values) bytes += GetHeapBytes(value.first) + GetHeapBytes(value.second);
+        return bytes;
+    }
+}
+
+#endif //_MemoryUsage_
@@ -0,0 +1,427 @@
+//
+// Prepared statements helper for MySQL. Works the same way as SQLiteStatement (see SQLite.h)
+//
+
+#ifndef CCDB_MYSQL_H
+#define CCDB_MYSQL_H
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#ifdef WIN32
+#include <winsock.h>
+#endif
+#include <mysql.h>
+#include <errmsg.h>
+#include <fmt/format.h>
+
+namespace ccdb {
+
+// MySQL 8 has replaced my_bool by bool in MYSQL_BIND. MariaDB Connector/C still uses my_bool
+#if !defined(LIBMARIADB) && defined(LIBMYSQL_VERSION_ID) && LIBMYSQL_VERSION_ID >= 80001
+    typedef bool MySQLBool;
+#else
+    typedef my_bool MySQLBool;
+#endif
+
+    /** @brief The connection to the server is lost (server restart, network failure)
+     *
+     * The connection can't be used any more, but the same query could succeed on a new connection
+     */
+    class MySQLConnectionLostError: public std::runtime_error
+    {
+    public:
+        explicit MySQLConnectionLostError(const std::string& what): std::runtime_error(what) {}
+    };
+
+    /** @brief true for client error codes after which the connection is not usable */
+    inline bool IsConnectionLostError(unsigned int errorCode)
+    {
+        return errorCode == CR_SERVER_GONE_ERROR || errorCode == CR_SERVER_LOST ||
+               errorCode == CR_CONNECTION_ERROR || errorCode == CR_CONN_HOST_ERROR;
+    }
+
+
+    /** @brief Server side prepared statement
+     *
+     * The statement is prepared once and then could be executed many times with different parameters.
+     * Parameters are bound by their 0-based position of '?' in the query.
+     * Result columns are bound to typed buffers according to the result metadata:
+     * integer columns are read as int64, floating point as double, everything else as string.
+     *
+     * By default rows are streamed: Execute reads each row from the server right before onRow is called,
+     * so memory doesn't depend on the size of the result. While rows are streamed the connection
+     * can't run other statements, onRow must not execute queries on the same connection.
+     * SetBuffered(true) reads the whole result to the client before the first row is processed.
+     *
+     * Errors that mean the connection is lost are thrown as MySQLConnectionLostError.
+     */
+    class MySQLStatement {
+    public:
+
+        MySQLStatement(MYSQL* connection): mConnection(connection) {}
+
+        /// Same as MySQLStatement(connection); Prepare(query)
+        MySQLStatement(MYSQL* connection, const std::string& query): mConnection(connection) {Prepare(query);}
+
+        ~MySQLStatement() {
+            if(mStatement) mysql_stmt_close(mStatement);
+        }
+
+        void Prepare(const std::string& query) {
+            if(mStatement) mysql_stmt_close(mStatement);
+
+            mStatement = mysql_stmt_init(mConnection);
+            if(!mStatement) {
+                throw std::runtime_error("Error in mysql_stmt_init: out of memory");
+            }
+
+            mLastQuery = query;
+            if(mysql_stmt_prepare(mStatement, query.c_str(), query.length())) {
+                ThrowStatementError("mysql_stmt_prepare");
+            }
+
+            // Parameters
+            mParams.clear();
+            mParams.resize(mysql_stmt_param_count(mStatement));
+            mParamBinds.clear();
+            mParamBinds.resize(mParams.size());
+
+            // Result columns
+            mColumns.clear();
+            mColumnBinds.clear();
+            MYSQL_RES* metadata = mysql_stmt_result_metadata(mStatement);
+            if(metadata) {
+                unsigned int columnCount = mysql_num_fields(metadata);
+                mColumns.resize(columnCount);
+                mColumnBinds.resize(columnCount);
+                for(unsigned int i = 0; i < columnCount; i++) {
+                    MYSQL_FIELD* field = mysql_fetch_field_direct(metadata, i);
+                    BindColumn(i, field->type, (field->flags & UNSIGNED_FLAG) != 0);
+                }
+                mysql_free_result(metadata);
+            }
+        }
+
+        /// Checks if there is a value with this columnIndex (reports error in such case)
+        void ValidateColumnIndex(int columnIndex) {
+            if(columnIndex < 0 || mColumns.size() <= static_cast<size_t>(columnIndex)) {
+                auto error = fmt::format("Requested column index doesn't correspond to the last query. "
+                                         "Req. Index: {}, LastQueryColumnCount: {}, Last Query: {}",
+                                         columnIndex, mColumns.size(), mLastQuery);
+                throw std::runtime_error(error);
+            }
+        }
+
+        void BindInt32(int paramIndex, int32_t value) {
+            Param& param = GetParam(paramIndex);
+            param.Int64 = value;
+            param.Bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            param.Bind.buffer = &param.Int64;
+        }
+
+        void BindInt64(int paramIndex, int64_t value) {
+            Param& param = GetParam(paramIndex);
+            param.Int64 = value;
+            param.Bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            param.Bind.buffer = &param.Int64;
+        }
+
+        void BindDouble(int paramIndex, double value) {
+            Param& param = GetParam(paramIndex);
+            param.Double = value;
+            param.Bind.buffer_type = MYSQL_TYPE_DOUBLE;
+            param.Bind.buffer = &param.Double;
+        }
+
+        void BindString(int paramIndex, const std::string& str) {
+            Param& param = GetParam(paramIndex);
+            param.String = str;
+            param.Length = static_cast<unsigned long>(param.String.length());
+            param.Bind.buffer_type = MYSQL_TYPE_STRING;
+            param.Bind.buffer = const_cast<char*>(param.String.data());
+            param.Bind.buffer_length = param.Length;
+            param.Bind.length = &param.Length;
+        }
+
+        /** @brief Executes the statement and calls onRow(rowIndex) for each selected row
+         *
+         * Inside onRow values of the current row are accessed with Read* functions.
+         * @return number of processed rows (or number of affected rows for queries that don't return a result)
+         */
+        template<typename Func>
+        uint64_t Execute(Func onRow) {
+            return ExecuteWhile([&onRow](uint64_t rowIndex) { onRow(rowIndex); return true; });
+        }
+
+        /** @brief Same as Execute, but stops reading rows as soon as onRow returns false
+         *
+         * Rows that are left unread are dropped
+         */
+        template<typename Func>
+        uint64_t ExecuteWhile(Func onRow) {
+            for(size_t i = 0; i < mParams.size(); i++) {
+                if(!mParams[i].Bind.buffer) {
+                    auto error = fmt::format("Parameter {} is not bound. Query: {}", i, mLastQuery);
+                    throw std::runtime_error(error);
+                }
+                mParamBinds[i] = mParams[i].Bind;
+            }
+
+            if(!mParamBinds.empty() && mysql_stmt_bind_param(mStatement, mParamBinds.data())) {
+                ThrowStatementError("mysql_stmt_bind_param");
+            }
+
+            if(mysql_stmt_execute(mStatement)) {
+                ThrowStatementError("mysql_stmt_execute");
+            }
+
+            // A query that doesn't return a result set
+            if(mColumns.empty()) {
+                return static_cast<uint64_t>(mysql_stmt_affected_rows(mStatement));
+            }
+
+            if(mysql_stmt_bind_result(mStatement, mColumnBinds.data())) {
+                ThrowStatementError("mysql_stmt_bind_result");
+            }
+
+            if(mIsBuffered && mysql_stmt_store_result(mStatement)) {
+                ThrowStatementError("mysql_stmt_store_result");
+            }
+
+            uint64_t rowsProcessed = 0;
+            mIsFetching = true;
+            try {
+                while(true) {
+                    int result = mysql_stmt_fetch(mStatement);
+                    if(result == MYSQL_NO_DATA) break;
+                    if(result == 1) ThrowStatementError("mysql_stmt_fetch");
+                    if(result == MYSQL_DATA_TRUNCATED) FetchTruncatedColumns();
+
+                    rowsProcessed++;
+                    if(!onRow(rowsProcessed - 1)) break;
+                }
+            }
+            catch (...) {
+                // For streamed results this also reads and drops rows left on the server
+                mysql_stmt_free_result(mStatement);
+                mIsFetching = false;
+                throw;
+            }
+
+            mysql_stmt_free_result(mStatement);
+            mIsFetching = false;
+            return rowsProcessed;
+        }
+
+        /// The flag is set to true when the statement fails because the connection is lost. The connection owner checks it
+        void SetConnectionLostFlag(bool* flag) { mConnectionLost = flag; }
+
+        /// true - the whole result is read to the client memory before rows are processed. false (default) - rows are streamed
+        void SetBuffered(bool isBuffered) { mIsBuffered = isBuffered; }
+        bool IsBuffered() const { return mIsBuffered; }
+
+        /// true while Execute is processing rows. A streamed result blocks the connection for other statements
+        bool IsFetching() const { return mIsFetching; }
+
+        /// Executes a statement that doesn't return rows. Returns the number of affected rows
+        uint64_t Execute() {
+            return Execute([](uint64_t){});
+        }
+
+        /// Value of AUTO_INCREMENT column generated by the last executed INSERT
+        uint64_t GetLastInsertId() {
+            return static_cast<uint64_t>(mysql_stmt_insert_id(mStatement));
+        }
+
+        bool IsNull(int columnIndex) {
+            ValidateColumnIndex(columnIndex);
+            return mColumns[columnIndex].IsNull != 0;
+        }
+
+        int32_t ReadInt32(int columnIndex) {
+            return static_cast<int32_t>(ReadInt64(columnIndex));
+        }
+
+        uint32_t ReadUInt32(int columnIndex) {
+            return static_cast<uint32_t>(ReadInt64(columnIndex));
+        }
+
+        int64_t ReadInt64(int columnIndex) {
+            ValidateColumnIndex(columnIndex);
+            Column& column = mColumns[columnIndex];
+            if(column.IsNull) return 0;
+            switch (column.Kind) {
+                case Column::cInteger: return column.Int64;
+                case Column::cReal: return static_cast<int64_t>(column.Double);
+                default: return std::strtoll(ReadString(columnIndex).c_str(), nullptr, 10);
+            }
+        }
+
+        uint64_t ReadUInt64(int columnIndex) {
+            return static_cast<uint64_t>(ReadInt64(columnIndex));
+        }
+
+        bool ReadBool(int columnIndex) {
+            return ReadInt64(columnIndex) != 0;
+        }
+
+        double ReadDouble(int columnIndex) {
+            ValidateColumnIndex(columnIndex);
+            Column& column = mColumns[columnIndex];
+            if(column.IsNull) return 0;
+            switch (column.Kind) {
+                case Column::cInteger: return static_cast<double>(column.Int64);
+                case Column::cReal: return column.Double;
+                default: return std::strtod(ReadString(columnIndex).c_str(), nullptr);
+            }
+        }
+
+        std::string ReadString(int columnIndex) {
+            ValidateColumnIndex(columnIndex);
+            Column& column = mColumns[columnIndex];
+            if(column.IsNull) return std::string("");
+            switch (column.Kind) {
+                case Column::cInteger: return column.IsUnsigned? std::to_string(static_cast<uint64_t>(column.Int64)) : std::to_string(column.Int64);
+                case Column::cReal: return fmt::format("{}", column.Double);
+                default: return std::string(column.Text.data(), column.Length);
+            }
+        }
+
+        time_t ReadUnixTime(int columnIndex) {
+            return static_cast<time_t>(ReadInt64(columnIndex));
+        }
+
+        const std::string& GetLastQuery() const { return mLastQuery; }
+
+    private:
+
+        /// Parameter value storage. MYSQL_BIND points to the fields of this struct
+        struct Param {
+            Param(): Int64(0), Double(0), Length(0) { memset(&Bind, 0, sizeof(Bind)); }
+            int64_t Int64;
+            double Double;
+            std::string String;
+            unsigned long Length;
+            MYSQL_BIND Bind;
+        };
+
+        /// Result column storage. MYSQL_BIND of the column points to the fields of this struct
+        struct Column {
+            enum Kinds {cInteger, cReal, cText};
+            Column(): Kind(cText), IsUnsigned(false), Int64(0), Double(0), Length(0), IsNull(0), Error(0) {}
+            Kinds Kind;
+            bool IsUnsigned;
+            int64_t Int64;
+            double Double;
+            std::vector<char> Text;
+            unsigned long Length;
+            MySQLBool IsNull;
+            MySQLBool Error;
+        };
+
+        Param& GetParam(int paramIndex) {
+            if(paramIndex < 0 || mParams.size() <= static_cast<size_t>(paramIndex)) {
+                auto error = fmt::format("Parameter index {} is out of range. The query has {} parameters. Query: {}",
+                                         paramIndex, mParams.size(), mLastQuery);
+                throw std::runtime_error(error);
+            }
+            return mParams[paramIndex];
+        }
+
+        void BindColumn(unsigned int index, enum_field_types type, bool isUnsigned) {
+            Column& column = mColumns[index];
+            MYSQL_BIND& bind = mColumnBinds[index];
+            memset(&bind, 0, sizeof(bind));
+            column.IsUnsigned = isUnsigned;
+
+            switch (type) {
+                case MYSQL_TYPE_TINY:
+                case MYSQL_TYPE_SHORT:
+                case MYSQL_TYPE_INT24:
+                case MYSQL_TYPE_LONG:
+                case MYSQL_TYPE_LONGLONG:
+                case MYSQL_TYPE_YEAR:
+                    column.Kind = Column::cInteger;
+                    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                    bind.buffer = &column.Int64;
+                    bind.is_unsigned = isUnsigned;
+                    break;
+                case MYSQL_TYPE_FLOAT:
+                case MYSQL_TYPE_DOUBLE:
+                    column.Kind = Column::cReal;
+                    bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                    bind.buffer = &column.Double;
+                    break;
+                default:
+                    // Strings, blobs, decimals and dates are read as text
+                    column.Kind = Column::cText;
+                    column.Text.resize(InitialTextBufferSize);
+                    bind.buffer_type = MYSQL_TYPE_STRING;
+                    bind.buffer = column.Text.data();
+                    bind.buffer_length = static_cast<unsigned long>(column.Text.size());
+                    break;
+            }
+            bind.length = &column.Length;
+            bind.is_null = &column.IsNull;
+            bind.error = &column.Error;
+        }
+
+        /// Text columns longer than the bound buffer are fetched again into an enlarged buffer
+        void FetchTruncatedColumns() {
+            bool rebind = false;
+            for(unsigned int i = 0; i < mColumns.size(); i++) {
+                Column& column = mColumns[i];
+                if(column.Kind != Column::cText || !column.Error || column.Length < column.Text.size()) continue;
+
+                column.Text.resize(column.Length + 1);
+                MYSQL_BIND& bind = mColumnBinds[i];
+                bind.buffer = column.Text.data();
+                bind.buffer_length = static_cast<unsigned long>(column.Text.size());
+                if(mysql_stmt_fetch_column(mStatement, &bind, i, 0)) {
+                    ThrowStatementError("mysql_stmt_fetch_column");
+                }
+                rebind = true;
+            }
+
+            // Buffers were reallocated, so the next rows should go to the new ones
+            if(rebind && mysql_stmt_bind_result(mStatement, mColumnBinds.data())) {
+                ThrowStatementError("mysql_stmt_bind_result");
+            }
+        }
+
+        void ThrowStatementError(const char* functionName) {
+            unsigned int errorCode = mysql_stmt_errno(mStatement);
+            auto error = fmt::format("{} error {}: {}. Query: {}",
+                                     functionName, errorCode, mysql_stmt_error(mStatement), mLastQuery);
+            if(IsConnectionLostError(errorCode)) {
+                if(mConnectionLost) *mConnectionLost = true;
+                throw MySQLConnectionLostError(error);
+            }
+            throw std::runtime_error(error);
+        }
+
+        enum { InitialTextBufferSize = 256 };   // Initial buffer size for text columns
+
+        MYSQL_STMT*                 mStatement = nullptr;
+        MYSQL*                      mConnection;          //Handler to mysql connection
+        std::vector<Param>          mParams;
+        std::vector<MYSQL_BIND>     mParamBinds;
+        std::vector<Column>         mColumns;
+        std::vector<MYSQL_BIND>     mColumnBinds;
+        std::string                 mLastQuery;
+        bool                        mIsBuffered = false;  //Result is read to the client before rows are processed
+        bool                        mIsFetching = false;  //Execute is processing rows right now
+        bool*                       mConnectionLost = nullptr;  //Set when the connection is lost, see SetConnectionLostFlag
+
+        MySQLStatement(const MySQLStatement&) = delete;
+        MySQLStatement& operator=(const MySQLStatement&) = delete;
+    };
+}
+
+#endif //CCDB_MYSQL_H
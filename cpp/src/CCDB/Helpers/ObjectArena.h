@@ -0,0 +1,51 @@
+#ifndef _ObjectArena_
+#define _ObjectArena_
+
+#include <deque>
+#include <utility>
+#include <cstddef>
+
+namespace ccdb
+{
+    /** @brief Owns objects of one type and frees all of them at once
+     *
+     * Objects are constructed in place in large blocks, so they are packed together in memory
+     * and their addresses never change while new objects are added. Objects are destroyed
+     * by Clear() or by the arena destructor. There is no way to free one object.
+     *
+     * The arena is not thread safe, the owner guards it.
+     */
+    template<typename T>
+    class ObjectArena
+    {
+    public:
+        ObjectArena() = default;
+        ObjectArena(const ObjectArena&) = delete;
+        ObjectArena& operator=(const ObjectArena&) = delete;
+
+        /** @brief Constructs a new object. The pointer is valid until Clear() */
+        template<typename... Args>
+        T* Create(Args&&... args) {
+            mObjects.emplace_back(std::forward<Args>(args)...);
+            return &mObjects.back();
+        }
+
+        /** @brief Destroys all objects */
+        void Clear() { mObjects.clear(); }
+
+        /** @brief Number of objects in the arena */
+        size_t GetCount() const { return mObjects.size(); }
+
+        /** @brief Sum of GetRetainedBytes() of the objects. Only for types that have it */
+        size_t GetRetainedBytes() const {
+            size_t bytes = 0;
+            for(const auto& object: mObjects) bytes += object.GetRetainedBytes();
+            return bytes;
+        }
+
+    private:
+        std::deque<T> mObjects;      // deque never moves its elements on emplace_back
+    };
+}
+
+#endif //_ObjectArena_
@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 
 #include "CCDB/Helpers/PathUtils.h"
 
@@ -94,6 +95,90 @@ bool ccdb::PathUtils::WildCardCheck( const char* pattern, const char* source )
 }
 
 
+namespace
+{
+    long long FloorDivide(long long value, long long divisor)
+    {
+        long long quotient = value / divisor;
+        return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+    }
+
+    /** Number of days from 1970-01-01 to year-month-day of the Gregorian calendar. month is [1-12] */
+    long long DaysFromCivil(long long year, unsigned month, unsigned day)
+    {
+        year -= month <= 2;
+        long long era = FloorDivide(year, 400);
+        unsigned yearOfEra = static_cast<unsigned>(year - era * 400);                          // [0, 399]
+        unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;    // [0, 365], from March 1
+        unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;     // [0, 146096]
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    /** The date from the number of days since 1970-01-01. The reverse of DaysFromCivil */
+    void CivilFromDays(long long days, long long& year, unsigned& month, unsigned& day)
+    {
+        days += 719468;
+        long long era = FloorDivide(days, 146097);
+        unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+        unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        unsigned monthFromMarch = (5 * dayOfYear + 2) / 153;
+        day = dayOfYear - (153 * monthFromMarch + 2) / 5 + 1;
+        month = monthFromMarch < 10 ? monthFromMarch + 3 : monthFromMarch - 9;
+        year = yearOfEra + era * 400 + (month <= 2);
+    }
+
+    /** Local time minus UTC in seconds for the local time given as seconds since 1970 (as if it were UTC)
+     *
+     * Time zone offsets change on hour boundaries, so mktime is asked once per hour of local time.
+     * The last hour is cached for each thread, as requests in a job usually have the same time
+     */
+    bool GetLocalOffset(long long localSeconds, long long& offset)
+    {
+        struct HourOffset { long long Hour; long long Offset; bool IsSet; };
+        static thread_local HourOffset cached = {0, 0, false};
+
+        long long hour = FloorDivide(localSeconds, 3600);
+        if(!cached.IsSet || cached.Hour != hour)
+        {
+            long long hourStart = hour * 3600;
+            long long days = FloorDivide(hourStart, 86400);
+            long long year;
+            unsigned month, day;
+            CivilFromDays(days, year, month, day);
+
+            tm time = tm();
+            time.tm_year = static_cast<int>(year - 1900);
+            time.tm_mon = static_cast<int>(month) - 1;
+            time.tm_mday = static_cast<int>(day);
+            time.tm_hour = static_cast<int>((hourStart - days * 86400) / 3600);
+            time.tm_isdst = -1;
+            time_t utcSeconds = mktime(&time);
+            if(utcSeconds == -1) return false;
+
+            cached.Hour = hour;
+            cached.Offset = hourStart - utcSeconds;
+            cached.IsSet = true;
+        }
+        offset = cached.Offset;
+        return true;
+    }
+
+    /** The day ParseTime takes when only year and month are given.
+     *
+     * It is not the calendar: May, July, October and November get 30 days, March gets 28 or 29
+     * by (year - 1900) leap rule and the rest 31, which mktime moves over to the next month.
+     * It is what ParseTime has always returned, so the same time strings keep giving the same timestamps.
+     */
+    int GetDefaultDay(int tmYear, int tmMonth)
+    {
+        if(tmMonth == 9 || tmMonth == 10 || tmMonth == 4 || tmMonth == 6) return 30;
+        if(tmMonth == 2) return ((tmYear % 4 == 0 && tmYear % 100 != 0) || tmYear % 400 == 0) ? 29 : 28;
+        return 31;
+    }
+}
+
+
 //______________________________________________________________________________
 time_t ccdb::PathUtils::ParseTime( const string &timeStr, bool * succsess )
 {
@@ -113,132 +198,84 @@ time_t ccdb::PathUtils::ParseTime( const string &timeStr, bool * succsess )
      * @parameter [out] succsess true if success
      * @return   time_t
      */
-    
-    
-    //default result
-    tm time;
-    time.tm_hour = 23;
-    time.tm_mday = 31;
-    time.tm_min = 59;
-    time.tm_mon = 11;
-    time.tm_sec = 59;
-    time.tm_isdst=-1;   //auto determine. It is not always work automatically. 
-                        //See http://stackoverflow.com/questions/8558919/mktime-and-tm-isdst
-    
-    if(succsess!=NULL) *succsess = true;
+    return ParseTime(timeStr.data(), timeStr.size(), succsess);
+}
+
 
-    //some tmp values
-    string tmpStr =""; //tmp string to buffer chars
-    int delimCount=0;  //number of delimeters we've met
+//______________________________________________________________________________
+time_t ccdb::PathUtils::ParseTime( const char* data, size_t size, bool * succsess )
+{
+    //default result. The same fields as in tm: month is [0-11], year is since 1900
+    int year = 0;
+    int month = 11;
+    int day = 31;
+    int hour = 23;
+    int minute = 59;
+    int second = 59;
 
-    string workStr(timeStr); //we appended a work string for one more non digit symbol
-    workStr.push_back(' ');  //so the logic behind would work in any case
+    if(succsess!=NULL) *succsess = true;
 
-    bool lastIsDigit;   //last symbol was digit
+    int delimCount=0;       //number of delimeters we've met
+    size_t digitCount=0;    //digits of the current value
+    int value=0;            //the current value
+    bool wasDigit=false;    //a digit was met. Non digit symbols before the year are skipped
 
-    //scan all symbols
-    for (size_t i=0; i<workStr.size(); i++)
+    //scan all symbols. One more non digit symbol at the end finishes the last value
+    for (size_t i=0; i<=size; i++)
     {
-        char symbol = workStr[i];
+        char symbol = i<size ? data[i] : ' ';
 
         if(symbol>='0'&&symbol<='9') //Check if it is number
         {
-            tmpStr.push_back(symbol);
-            lastIsDigit = true;
+            if(digitCount<9) value = value*10 + (symbol - '0');
+            digitCount++;
+            wasDigit = true;
+            continue;
         }
-        else if(lastIsDigit) //it is a delimeter after the value;
+
+        if(!wasDigit) continue;
+
+        //it is a delimeter after the value. The year has 4 digits, the rest have 2
+        delimCount++;
+        if(delimCount<=6 && digitCount != (delimCount==1 ? 4u : 2u))
         {
-            delimCount++;
-            if(delimCount ==1) //it was a year
-            {
-                if(tmpStr.length()!=4) //it is an error with lengtn of year
-                {
-                    if(succsess!=NULL) *succsess = false;
-                    return 0;
-                }
-                time.tm_year = StringUtils::ParseInt(tmpStr) - 1900;  //since in tm the year is from 1900
-            }
-            
-            if(delimCount ==2) //it was a month
-            {
-                if(tmpStr.length()!=2) //it is an error with lengtn of year
-                {
-                    if(succsess!=NULL) *succsess = false;
-                    return 0;
-                }
-
-                time.tm_mon = StringUtils::ParseInt(tmpStr) - 1;  // -1 becaouse months since January [0-11]
-
-                //#check for 30 day month
-                if((time.tm_mon == 9)||(time.tm_mon == 10)||(time.tm_mon == 4)||(time.tm_mon == 6))
-                {
-                     time.tm_mday = 30;
-                }
-
-                //February...
-                if(time.tm_mon == 2)
-                {
-                    if( (time.tm_year % 4 == 0 &&  time.tm_year % 100 != 0) || time.tm_year % 400 == 0)
-                    {
-                        time.tm_mday = 29;
-                    }
-                    else
-                    {
-                        time.tm_mday = 28;
-                    }
-                }
-            }
-
-            if(delimCount ==3) //it was a day
-            {
-                if(tmpStr.length()!=2) //it is an error with lengtn of day
-                {
-                    if(succsess!=NULL) *succsess = false;
-                    return 0;
-                }
-                time.tm_mday = StringUtils::ParseInt(tmpStr);  //since in tm the year is from 1900
-            }
-
-            if(delimCount ==4) //it was a hour
-            {
-                if(tmpStr.length()!=2) //it is an error with lengtn
-                {
-                    if(succsess!=NULL) *succsess = false;
-                    return 0;
-                }
-                time.tm_hour = StringUtils::ParseInt(tmpStr);  //since in tm the year is from 1900
-            }
-            
-            if(delimCount ==5) //it was a min
-            {
-                if(tmpStr.length()!=2) //it is an error with lengtn of min
-                {
-                    if(succsess!=NULL) *succsess = false;
-                    return 0;
-                }
-                time.tm_min = StringUtils::ParseInt(tmpStr);  //since in tm the year is from 1900
-            }
-            
-            if(delimCount ==6) //it was a sec
-            {
-                if(tmpStr.length()!=2) //it is an error with lengtn of sec
-                {
-                    if(succsess!=NULL) *succsess = false;
-                    return 0;
-                }
-                time.tm_sec = StringUtils::ParseInt(tmpStr);  //since in tm the year is from 1900
-            }
-
-			
-            //clear temp string for the next digit seria
-            tmpStr.clear();
+            if(succsess!=NULL) *succsess = false;
+            return 0;
         }
-        else
+
+        switch(delimCount)
         {
-            tmpStr.clear(); //in this case we clear temp string too
+            case 1: year = value - 1900; break;
+            case 2: month = value - 1; day = GetDefaultDay(year, month); break;
+            case 3: day = value; break;
+            case 4: hour = value; break;
+            case 5: minute = value; break;
+            case 6: second = value; break;
+            default: break;
         }
+
+        //the next digit seria
+        digitCount = 0;
+        value = 0;
     }
-    time_t result = mktime(&time);
+
+    //there is no year
+    if(delimCount==0)
+    {
+        if(succsess!=NULL) *succsess = false;
+        return 0;
+    }
+
+    //Values out of their ranges go over to the next ones, as mktime does it
+    long long fullYear = 1900LL + year + FloorDivide(month, 12);
+    unsigned monthNumber = static_cast<unsigned>(month - FloorDivide(month, 12) * 12) + 1;
+    long long localSeconds = (DaysFromCivil(fullYear, monthNumber, 1) + day - 1) * 86400LL
+                           + hour * 3600LL + minute * 60LL + second;
+
+    long long offset = 0;
+    time_t result = -1;
+    if(GetLocalOffset(localSeconds, offset)) result = static_cast<time_t>(localSeconds - offset);
+
 	if( result == -1 && succsess!=NULL) *succsess = false;
     return result;
 }
@@ -262,72 +299,71 @@ ccdb::RequestParseResult ccdb::PathUtils::ParseRequest( const string& requestStr
 	 * @return structure that represent user result
 	 */
 
-    //Set default parameters
+    RequestParseView view = ParseRequestView(requestStr);
+
     RequestParseResult result;
-    result.RunNumber=0;	              // Run number
-    result.WasParsedRunNumber=false;  // true if Run number was non empty
-    result.IsInvalidRunNumber=false;  // true if was an error parsing runnumber
-    result.Path = "";                 // Object path
-    result.WasParsedPath=false;       // true if Path was nonempty
-    result.Variation="";              // Variation name
-    result.WasParsedVariation=false;  // true if variation was not empty
-    result.Time=0;                    // Time stamp
-    result.WasParsedTime=false;       // true if time stamp was not empty
-    result.TimeString="";             // Original string with time
-
-    int colonCount=0;
-    string runStr ="";
-    for (size_t i=0; i<requestStr.size(); i++)
-    {
-        char symbol = requestStr[i];
-        if(symbol!=':')
-        {
-            //it is not a colon so we add this symbol somewhere
-            switch(colonCount)
-            {
-            case 0:  //it is a path
-                result.Path.push_back(symbol);
-                result.WasParsedPath=true;
-                break;
-            case 1:  //it is a run range
-                runStr.push_back(symbol);
-                result.WasParsedRunNumber = true;
-                break;
-            case 2:  //it is variation
-                result.Variation.push_back(symbol);     // Variation name
-                result.WasParsedVariation=true;         // true since we've got a variation
-                break;
-            default:  //it should be a time than
-                result.WasParsedTime=true;              // true if time stampt was not empty
-                result.TimeString.push_back(symbol);    // Original string with time
-                break;
-            }
-        }
-        else //the symbol is colon (symbol==':')
-        {
-            colonCount++;
+    result.RunNumber = view.RunNumber;
+    result.WasParsedRunNumber = view.WasParsedRunNumber;
+    result.IsInvalidRunNumber = view.IsInvalidRunNumber;
+    view.Path.AssignTo(result.Path);
+    result.WasParsedPath = view.WasParsedPath;
+    view.Variation.AssignTo(result.Variation);
+    result.WasParsedVariation = view.WasParsedVariation;
+    result.Time = view.Time;
+    result.WasParsedTime = view.WasParsedTime;
+    view.TimeString.AssignTo(result.TimeString);
+    return result;
+}
 
-			//This addition is for situation when ':' is found in time string 
-			if (colonCount > 3) result.TimeString.push_back(':');
-        }
+
+//______________________________________________________________________________
+ccdb::RequestParseView ccdb::PathUtils::ParseRequestView( const string& requestStr )
+{
+    RequestParseView result;
+
+    //path:run:variation:time. Colons after the third one are a part of the time
+    StringSlice runSlice;
+    StringSlice* fields[] = {&result.Path, &runSlice, &result.Variation, &result.TimeString};
+    size_t begin = 0;
+    for(int i=0; i<4; i++)
+    {
+        size_t end = i<3 ? requestStr.find(':', begin) : string::npos;
+        if(end == string::npos) end = requestStr.size();
+        *fields[i] = StringSlice(requestStr.data() + begin, end - begin);
+        if(end == requestStr.size()) break;
+        begin = end + 1;
     }
 
-    // at this point we parsed all symbols and it is time for final parsing
+    result.WasParsedPath = !result.Path.IsEmpty();
+    result.WasParsedRunNumber = !runSlice.IsEmpty();
+    result.WasParsedVariation = !result.Variation.IsEmpty();
+    for(size_t i=0; i<result.TimeString.Size && !result.WasParsedTime; i++)
+    {
+        result.WasParsedTime = result.TimeString.Data[i] != ':';
+    }
 
     //parse run number
     if(result.WasParsedRunNumber)
     {
-        bool success = true;
-        result.RunNumber = StringUtils::ParseInt(runStr, &success);
-
-        result.IsInvalidRunNumber = !success || result.RunNumber<0;
+        char buffer[32];
+        if(runSlice.Size < sizeof(buffer))
+        {
+            memcpy(buffer, runSlice.Data, runSlice.Size);
+            buffer[runSlice.Size] = '\0';
+            result.RunNumber = atoi(buffer);
+        }
+        else
+        {
+            result.RunNumber = StringUtils::ParseInt(runSlice.ToString());
+        }
+        result.IsInvalidRunNumber = result.RunNumber<0;
     }
 
     //parse time
     if(result.WasParsedTime)
     {
         bool success=true;
-        result.Time = ParseTime(result.TimeString, &success);
+        result.Time = ParseTime(result.TimeString.Data, result.TimeString.Size, &success);
     }
     return result;
 }
@@ -378,32 +414,32 @@ ccdb::ContextParseResult ccdb::PathUtils::ParseContext( const string& context )
 	vector<string> tokens = StringUtils::LexicalSplit(context);
 
 	//iterate through pairs
-	for(int i=0; i<tokens.size(); i++)
+	for(size_t i=0; i<tokens.size(); i++)
 	{
-		string token = tokens[i];
+		StringSlice token(tokens[i].data(), tokens[i].size());
 
 		//variation is found?
-		if(token.find("variation=")==0)  //TODO move "variation=" to some define?
+		if(token.StartsWith("variation="))  //TODO move "variation=" to some define?
 		{
 			result.VariationIsParsed = true;
-			result.Variation = StringUtils::Replace("variation=","",token);
+			result.Variation.assign(token.Data + 10, token.Size - 10);
 			continue;
 		}
 
 		//calibtime is found?
-		if(token.find("calibtime=")==0)
+		if(token.StartsWith("calibtime="))
 		{
 			result.ConstantsTimeIsParsed = true;
 			bool parseResult = false;
-			result.ConstantsTime = PathUtils::ParseTime(StringUtils::Replace("calibtime=","",token), &parseResult);
+			result.ConstantsTime = PathUtils::ParseTime(token.Data + 10, token.Size - 10, &parseResult);
 			if(!parseResult) result.ConstantsTime = 0;
 		}
 
-        //calibtime is found?
-        if(token.find("run=")==0)
+        //run is found?
+        if(token.StartsWith("run="))
         {
             result.RunNumberIsParsed = true;
-            result.RunNumber = StringUtils::ParseInt(StringUtils::Replace("run=","",token));
+            result.RunNumber = atoi(tokens[i].c_str() + 4);
         }
 	}
 
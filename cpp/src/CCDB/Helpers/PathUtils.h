@@ -19,6 +19,7 @@
 #include <time.h>
 
 #include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Helpers/StringSlice.h"
 
 
 /** CCDB prior 1.05.00 didnt parse "run=X" in the context string.
@@ -49,6 +50,21 @@ struct RequestParseResult
     std::string TimeString;         /// Original string with time
 };
 
+    /// @brief The same as RequestParseResult but strings are slices of the request. @see PathUtils::ParseRequestView
+struct RequestParseView
+{
+    int    RunNumber = 0;               /// Run number
+    bool   WasParsedRunNumber = false;  /// true if Run number was non empty
+    bool   IsInvalidRunNumber = false;  /// true if was an error parsing runnumber
+    StringSlice Path;                   /// Object path
+    bool   WasParsedPath = false;       /// true if Path was nonempty
+    StringSlice Variation;              /// Variation name
+    bool   WasParsedVariation = false;  /// true if variation was not empty
+    time_t Time = 0;                    /// Time stampt
+    bool   WasParsedTime = false;       /// true if time stampt was not empty
+    StringSlice TimeString;             /// Original string with time
+};
+
 /** @brief represents parse result of JANA context
  * 
  * context is given like 'variation=default time=2012 run=303'
@@ -128,6 +144,14 @@ public:
 	 */
 	static RequestParseResult ParseRequest(const std::string& requestStr);
 
+    /** @brief Parses request like @see ParseRequest but doesn't copy strings
+     *
+     * Path, Variation and TimeString of the result point to requestStr,
+     * so requestStr should live and stay unchanged while they are used
+     */
+    static RequestParseView ParseRequestView(const std::string& requestStr);
+    static RequestParseView ParseRequestView(std::string&&) = delete;     // a temporary would leave slices dangling
+
     /** @brief ParseTime
      * parses time as any part of
      * YYYY:MM:DD-hh:mm:ss
@@ -146,6 +170,14 @@ public:
      */
     static time_t ParseTime(const std::string &timeStr, bool * succsess);
 
+    /** @brief ParseTime of size characters starting at data. Doesn't allocate memory
+     *
+     * The date is converted to seconds by calendar arithmetic. The UTC offset of the local time zone
+     * is taken by mktime once per hour of local time and is cached for the calling thread, so
+     * the time zone (TZ) changed while the program runs is not seen for already cached hours
+     */
+    static time_t ParseTime(const char* data, size_t size, bool * succsess);
+
     /** @brief Adds '/' to the beginning of the path if it is not there
      *
      * If one have 'the/path' this function will change the string as '/the/path'
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <string>
 #include <thread>
+#include <atomic>
 
 #include "StopWatch.h"
 
@@ -23,9 +24,21 @@ namespace ccdb{
             _startTime = _sw.Restart();
         }
 
+        /** @brief The name is prefix + name. They are not concatenated if the output is off */
+        PerfLog (const char* prefix, const std::string& name):
+                _sw(),
+                _name(IsEnabled() ? prefix + name : std::string())
+        {
+            _startTime = _sw.Restart();
+        }
+
         PerfLog(PerfLog&) = default;
         PerfLog(PerfLog&&) noexcept;
 
+        /** @brief Turns CCDB_PERF_LOG output on or off for the process. On by default if built with CCDB_PERFLOG_ON */
+        static void SetEnabled(bool value) { GetEnabledFlag() = value; }
+        static bool IsEnabled() { return GetEnabledFlag(); }
+
         uint64_t GetTimeSinceEpochUs()
         {
             return static_cast<uint64_t>
@@ -35,15 +48,23 @@ namespace ccdb{
 
 
         virtual ~PerfLog(){
-#ifdef CCDB_PERFLOG_ON
+            if(!IsEnabled()) return;
             std::cout<<"CCDB_PERF_LOG:{\"thread_id\":"<<std::this_thread::get_id()<<","
                      <<"\"descr\":\""<<_name<<"\","
                      <<"\"start_stamp\":"<<GetTimeSinceEpochUs()<<","
                      <<"\"elapsed\":"<<_sw.ElapsedUs()<<","
                      <<"\"t_units\":\"us\"}"<<std::endl;
-#endif //ifdef CCDB_PERFLOG_ON
         }
     private:
+        static std::atomic<bool>& GetEnabledFlag() {
+#ifdef CCDB_PERFLOG_ON
+            static std::atomic<bool> isEnabled(true);
+#else
+            static std::atomic<bool> isEnabled(false);
+#endif //ifdef CCDB_PERFLOG_ON
+            return isEnabled;
+        }
+
         ccdb::StopWatch _sw{};
         std::string _name;
         std::chrono::high_resolution_clock::time_point _startTime;
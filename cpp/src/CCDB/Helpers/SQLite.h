@@ -18,10 +18,10 @@ namespace ccdb {
         using RowProcessCallback = void (*)(uint64_t rowIndex);
 
 
-        SQLiteStatement(sqlite3* database): mDatabase(database) {}
+        SQLiteStatement(sqlite3* database): mStatement(nullptr), mDatabase(database) {}
 
         /// Same as SQLiteStatement(db); Prepare(query)
-        SQLiteStatement(sqlite3* database, const std::string& query): mDatabase(database) {Prepare(query);}
+        SQLiteStatement(sqlite3* database, const std::string& query): mStatement(nullptr), mDatabase(database) {Prepare(query);}
 
         ~SQLiteStatement() {
             sqlite3_finalize(mStatement);
@@ -67,6 +67,14 @@ namespace ccdb {
             }
         }
 
+        void BindDouble(int32_t varId, double value) {
+            int result = sqlite3_bind_double(mStatement, varId, value);
+            if( result ) {
+                auto error = fmt::format("sqlite3_bind_double error: {}. Query: {}", sqlite3_errmsg(mDatabase), mLastQuery);
+                throw std::runtime_error(error);
+            }
+        }
+
         void BindString(int32_t varId,const std::string& str) {
             int result = sqlite3_bind_text(mStatement, varId, str.c_str(), -1, SQLITE_TRANSIENT); /*`name`*/
             if( result ) {
@@ -76,10 +84,33 @@ namespace ccdb {
         }
 
 
+        /// Makes prepared statement ready to be bound and executed again
+        void Reset() {
+            sqlite3_reset(mStatement);
+            sqlite3_clear_bindings(mStatement);
+        }
+
+        /// Executes a statement that doesn't return rows
+        uint64_t Execute() {
+            return Execute([](uint64_t){});
+        }
+
+        /// Row id generated by the last INSERT on this database connection
+        int64_t GetLastInsertId() {
+            return sqlite3_last_insert_rowid(mDatabase);
+        }
+
         template<typename Func>
         uint64_t Execute(Func onRow) {
+            return ExecuteWhile([&onRow](uint64_t rowIndex) { onRow(rowIndex); return true; });
+        }
+
+        /// Same as Execute, but stops reading rows as soon as onRow returns false
+        template<typename Func>
+        uint64_t ExecuteWhile(Func onRow) {
             uint64_t rowsProcessed = 0;
             int result;
+            bool isStopped = false;
             mLastQueryColumnCount = sqlite3_column_count(mStatement);
             do
             {
@@ -90,7 +121,7 @@ namespace ccdb {
                         break;
                     case SQLITE_ROW:
                         //ok lets read the data...
-                        onRow(rowsProcessed);
+                        isStopped = !onRow(rowsProcessed);
                         rowsProcessed++;
                         break;
                     default:
@@ -99,7 +130,7 @@ namespace ccdb {
                         throw std::runtime_error(error);
                 }
             }
-            while(result==SQLITE_ROW );
+            while(result==SQLITE_ROW && !isStopped);
             return rowsProcessed;
         }
 
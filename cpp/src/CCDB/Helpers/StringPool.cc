@@ -0,0 +1,60 @@
+#include "CCDB/Helpers/StringPool.h"
+#include "CCDB/Helpers/MemoryUsage.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+InternedString::InternedString()
+{
+    static const std::string* empty = StringPool::Global().Intern(string()).mValue;
+    mValue = empty;
+}
+
+
+//______________________________________________________________________________
+InternedString::InternedString(const std::string& value):
+    mValue(StringPool::Global().Intern(value).mValue)
+{
+}
+
+
+//______________________________________________________________________________
+StringPool& StringPool::Global()
+{
+    // Never destroyed: static objects could use interned strings in their destructors
+    static StringPool* pool = new StringPool();
+    return *pool;
+}
+
+
+//______________________________________________________________________________
+InternedString StringPool::Intern(const std::string& value)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return InternedString(&*mStrings.insert(value).first);
+}
+
+
+//______________________________________________________________________________
+size_t StringPool::GetCount()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStrings.size();
+}
+
+
+//______________________________________________________________________________
+size_t StringPool::GetRetainedBytes()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t bytes = sizeof(StringPool) + mStrings.bucket_count() * sizeof(void*);
+    for(const auto& value: mStrings) {
+        bytes += sizeof(value) + 2 * sizeof(void*) + GetHeapBytes(value);     // node: the string, a link and the hash
+    }
+    return bytes;
+}
+
+}
@@ -0,0 +1,85 @@
+#ifndef _StringPool_
+#define _StringPool_
+
+#include <string>
+#include <mutex>
+#include <unordered_set>
+#include <functional>
+#include <cstddef>
+
+namespace ccdb
+{
+    /** @brief Handle of a string kept in StringPool
+     *
+     * Equal strings have the same handle, so comparison is a pointer compare and copying
+     * the handle doesn't copy characters. The string lives till the end of the process.
+     * operator< orders handles by address, not alphabetically; it is for map keys.
+     */
+    class InternedString
+    {
+    public:
+        /** @brief Empty string */
+        InternedString();
+
+        /** @brief Interns the string in the global pool */
+        explicit InternedString(const std::string& value);
+
+        const std::string& str() const { return *mValue; }
+        operator const std::string&() const { return *mValue; }
+        bool empty() const { return mValue->empty(); }
+
+        bool operator==(const InternedString& rhs) const { return mValue == rhs.mValue; }
+        bool operator!=(const InternedString& rhs) const { return mValue != rhs.mValue; }
+        bool operator<(const InternedString& rhs) const { return std::less<const std::string*>()(mValue, rhs.mValue); }
+
+        /** @brief Address of the pooled string. The same for equal strings */
+        const void* GetKey() const { return mValue; }
+
+    private:
+        friend class StringPool;
+        explicit InternedString(const std::string* value): mValue(value) {}
+
+        const std::string* mValue;
+    };
+
+
+    /** @brief Process wide table of unique catalog strings: names, paths, variations
+     *
+     * Thread safe. Strings are never removed, so the pool is only for names that repeat,
+     * not for data values.
+     */
+    class StringPool
+    {
+    public:
+        /** @brief The pool that InternedString uses */
+        static StringPool& Global();
+
+        /** @brief Handle of the string, the string is added if it is not in the pool yet */
+        InternedString Intern(const std::string& value);
+
+        /** @brief Number of unique strings in the pool */
+        size_t GetCount();
+
+        /** @brief Estimated bytes of the strings and the hash set that holds them */
+        size_t GetRetainedBytes();
+
+    private:
+        StringPool() = default;
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+
+        std::mutex mMutex;
+        std::unordered_set<std::string> mStrings;      // elements never move, so handles stay valid on rehash
+    };
+}
+
+namespace std
+{
+    template<>
+    struct hash<ccdb::InternedString>
+    {
+        size_t operator()(const ccdb::InternedString& value) const { return hash<const void*>()(value.GetKey()); }
+    };
+}
+
+#endif //_StringPool_
@@ -0,0 +1,41 @@
+#ifndef _StringSlice_
+#define _StringSlice_
+
+#include <string>
+#include <cstring>
+#include <cstddef>
+
+namespace ccdb
+{
+    /** @brief Characters of some other string, not a copy of them
+     *
+     * Like std::string_view of C++17. The slice is valid while the string it points to is alive and not changed.
+     */
+    struct StringSlice
+    {
+        const char* Data = nullptr;
+        size_t Size = 0;
+
+        StringSlice() = default;
+        StringSlice(const char* data, size_t size): Data(data), Size(size) {}
+
+        bool IsEmpty() const { return Size == 0; }
+        std::string ToString() const { return std::string(Data, Size); }
+
+        /** @brief Copies characters to the string. Reuses its memory if it is large enough */
+        void AssignTo(std::string& target) const { target.assign(Data, Size); }
+
+        bool StartsWith(const char* prefix) const
+        {
+            size_t prefixSize = strlen(prefix);
+            return prefixSize <= Size && (prefixSize == 0 || memcmp(Data, prefix, prefixSize) == 0);
+        }
+
+        bool operator==(const char* value) const { return strlen(value) == Size && (Size == 0 || memcmp(Data, value, Size) == 0); }
+        bool operator==(const std::string& value) const { return value.size() == Size && (Size == 0 || memcmp(Data, value.data(), Size) == 0); }
+        bool operator!=(const char* value) const { return !(*this == value); }
+        bool operator!=(const std::string& value) const { return !(*this == value); }
+    };
+}
+
+#endif //_StringSlice_
@@ -0,0 +1,182 @@
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "CCDB/Helpers/TableFile.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Model/ConstantsTypeTable.h"
+#include "CCDB/Model/ConstantsTypeColumn.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+namespace {
+    bool IsSignedInteger(const string& value, long long minValue, long long maxValue)
+    {
+        if(value.empty()) return false;
+        char* end = nullptr;
+        errno = 0;
+        long long result = strtoll(value.c_str(), &end, 10);
+        return *end == '\0' && errno != ERANGE && result >= minValue && result <= maxValue;
+    }
+
+    bool IsUnsignedInteger(const string& value, unsigned long long maxValue)
+    {
+        if(value.empty() || value[0] == '-') return false;
+        char* end = nullptr;
+        errno = 0;
+        unsigned long long result = strtoull(value.c_str(), &end, 10);
+        return *end == '\0' && errno != ERANGE && result <= maxValue;
+    }
+
+    bool IsDouble(const string& value)
+    {
+        if(value.empty()) return false;
+        char* end = nullptr;
+        strtod(value.c_str(), &end);
+        return *end == '\0';
+    }
+
+    /** Bool values python ccdb accepts. Returns "1", "0" or "" if value is not bool */
+    string NormalizeBool(string value)
+    {
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if(value == "true" || value == "yes" || value == "t" || value == "1") return "1";
+        if(value == "false" || value == "no" || value == "f" || value == "0") return "0";
+        if(IsSignedInteger(value, LLONG_MIN, LLONG_MAX)) return atoll(value.c_str()) ? "1" : "0";
+        return "";
+    }
+}
+
+
+//______________________________________________________________________________
+TableFile TableFile::Read(const std::string& fileName)
+{
+    std::ifstream stream(fileName);
+    if(!stream) {
+        throw std::runtime_error(fmt::format("ccdb::TableFile::Read => Can't open file '{}'", fileName));
+    }
+    return Parse(stream);
+}
+
+
+//______________________________________________________________________________
+TableFile TableFile::Parse(std::istream& stream)
+{
+    TableFile file;
+    string line;
+    vector<string> tokens;
+
+    while(std::getline(stream, line)) {
+        StringUtils::Trim(line);
+        if(line.empty()) continue;
+
+        if(line.compare(0, 5, "#meta") == 0) {
+            // '#meta key: value' or '#meta key'
+            line.erase(0, 5);
+            StringUtils::Trim(line);
+            size_t colonPos = line.find(':');
+            if(colonPos != string::npos && colonPos != line.length() - 1) {
+                string key = line.substr(0, colonPos);
+                string value = line.substr(colonPos + 1);
+                StringUtils::Trim(key);
+                StringUtils::Trim(value);
+                file.Metas[key] = value;
+            }
+            else {
+                file.Metas[line] = "";
+            }
+        }
+        else if(line.compare(0, 2, "#&") == 0) {
+            StringUtils::LexicalSplit(file.ColumnNames, line.substr(2));
+        }
+        else if(line[0] == '#') {
+            file.CommentLines.push_back(line.substr(1));
+        }
+        else {
+            StringUtils::LexicalSplit(tokens, line);
+
+            // LexicalSplit puts the trailing comment as the last token
+            if(!tokens.empty() && tokens.back()[0] == '#') tokens.pop_back();
+            file.Rows.push_back(tokens);
+        }
+    }
+    return file;
+}
+
+
+//______________________________________________________________________________
+std::vector<std::string> TableFile::Validate(const ConstantsTypeTable& table) const
+{
+    const auto& columns = table.GetColumns();
+    size_t columnsCount = columns.size();
+    if(Rows.empty()) {
+        throw std::runtime_error("File has no data");
+    }
+    if(static_cast<int>(Rows.size()) != table.GetRowsCount()) {
+        throw std::runtime_error(fmt::format("Table '{}' has {} rows, but the file has {} rows",
+                                             table.GetFullPath(), table.GetRowsCount(), Rows.size()));
+    }
+
+    vector<string> values;
+    values.reserve(Rows.size() * columnsCount);
+    for(size_t rowIndex = 0; rowIndex < Rows.size(); rowIndex++) {
+        const auto& row = Rows[rowIndex];
+        if(row.size() != columnsCount) {
+            throw std::runtime_error(fmt::format("Row {} has {} values while table '{}' has {} columns",
+                                                 rowIndex, row.size(), table.GetFullPath(), columnsCount));
+        }
+
+        for(size_t columnIndex = 0; columnIndex < columnsCount; columnIndex++) {
+            const string& value = row[columnIndex];
+            const ConstantsTypeColumn* column = columns[columnIndex];
+            bool isValid = true;
+
+            switch(column->GetType()) {
+                case ConstantsTypeColumn::cIntColumn:
+                    isValid = IsSignedInteger(value, INT_MIN, INT_MAX);
+                    break;
+                case ConstantsTypeColumn::cUIntColumn:
+                    isValid = IsUnsignedInteger(value, UINT_MAX);
+                    break;
+                case ConstantsTypeColumn::cLongColumn:
+                    isValid = IsSignedInteger(value, LLONG_MIN, LLONG_MAX);
+                    break;
+                case ConstantsTypeColumn::cULongColumn:
+                    isValid = IsUnsignedInteger(value, ULLONG_MAX);
+                    break;
+                case ConstantsTypeColumn::cDoubleColumn:
+                    isValid = IsDouble(value);
+                    break;
+                case ConstantsTypeColumn::cBoolColumn: {
+                    string boolValue = NormalizeBool(value);
+                    isValid = !boolValue.empty();
+                    if(isValid) {
+                        values.push_back(boolValue);
+                        continue;
+                    }
+                    break;
+                }
+                case ConstantsTypeColumn::cStringColumn:
+                    break;
+            }
+
+            if(!isValid) {
+                throw std::runtime_error(fmt::format("Value '{}' at row {} column {} ('{}') is not {}",
+                                                     value, rowIndex, columnIndex, column->GetName(),
+                                                     ConstantsTypeColumn::TypeToString(column->GetType())));
+            }
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+}
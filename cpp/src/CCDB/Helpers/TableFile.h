@@ -0,0 +1,45 @@
+#ifndef _TableFile_
+#define _TableFile_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <istream>
+
+namespace ccdb
+{
+    class ConstantsTypeTable;
+
+    /** @brief Content of CCDB text table file (the format 'ccdb add' reads, see python/ccdb/table_file.py)
+     *
+     *  # comment line
+     *  #meta name: value
+     *  #& column1 column2 "column 3"
+     *  1   2.5   "quoted string"   # comment after data
+     *
+     * Lines are split with StringUtils::LexicalSplit, so quoting and comments are the same as in other CCDB text inputs
+     */
+    struct TableFile
+    {
+        std::vector<std::string> CommentLines;              /// Text of '#' lines without '#'
+        std::map<std::string, std::string> Metas;           /// '#meta key: value' lines
+        std::vector<std::string> ColumnNames;               /// '#&' line values
+        std::vector<std::vector<std::string>> Rows;         /// Data values
+
+        /** @brief Reads the file. Throws std::runtime_error if the file can't be opened */
+        static TableFile Read(const std::string& fileName);
+
+        /** @brief Reads table file content from the stream */
+        static TableFile Parse(std::istream& stream);
+
+        /** @brief Checks the data against type table columns and returns rows * columns values in row major order
+         *
+         * Number of rows and columns must be equal to the table ones. Values must be parsable as column types:
+         * int, uint, long, ulong, double, bool (true/false/yes/no/t/f/1/0, written as 1/0), string.
+         * @exception std::runtime_error with the first problem found
+         */
+        std::vector<std::string> Validate(const ConstantsTypeTable& table) const;
+    };
+}
+
+#endif //_TableFile_
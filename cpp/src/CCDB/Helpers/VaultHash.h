@@ -0,0 +1,43 @@
+#ifndef _VaultHash_
+#define _VaultHash_
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace ccdb
+{
+    /** @brief 64 bit FNV-1a hash of constant set vault text
+     *
+     * The same function is used for constantSets.vaultHash column and for in memory
+     * deduplication of vaults, so its value must never change.
+     */
+    inline uint64_t HashVault(const char* data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for(size_t i = 0; i < size; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    inline uint64_t HashVault(const std::string& vault)
+    {
+        return HashVault(vault.data(), vault.size());
+    }
+
+    /** @brief Vault hash as it is stored in constantSets.vaultHash: 16 lower case hex digits */
+    inline std::string VaultHashToString(uint64_t hash)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string result(16, '0');
+        for(int i = 15; i >= 0; i--) {
+            result[i] = digits[hash & 0xF];
+            hash >>= 4;
+        }
+        return result;
+    }
+}
+
+#endif //_VaultHash_
@@ -19,7 +19,6 @@ using namespace std;
 //______________________________________________________________________________
 ccdb::Assignment::Assignment()
 {
-	mRawData = string(); 	// data blob
 	mId=0;					// id in database
 	mDataBlobId   = 0;		// blob id in database
 	mVariationId  = 0;		// database ID of variation
@@ -32,6 +31,7 @@ ccdb::Assignment::Assignment()
 	mEventRange = NULL;		// Event range object, is NULL if not set
 	mVariation  = NULL;		// Variation object, is NULL if not set
 	mTypeTable  = NULL;		// Reference to type table
+	mKeepMappedRows = true;	// GetValue fills mRows
 }
 
 
@@ -51,17 +51,18 @@ bool ccdb::Assignment::MapData(vector<map<string,string> > & mappedData, const v
 		return true;
 	}
 
-	//loop
+	//loop. Rows are filled in place, so each row map is built once and not copied
 	int rows = data.size() / columns.size();
+	mappedData.reserve(mappedData.size() + rows);
 	vector<string>::const_iterator dataIter= data.begin();
 	for (int rowIter = 0; rowIter < rows ; rowIter++)
 	{	
-		map<string,string> line;
+		mappedData.emplace_back();
+		map<string,string>& line = mappedData.back();
 		for(vector<string>::const_iterator it=columns.begin(); it<columns.end(); ++it,++dataIter)
 		{
-			line[*it]=*dataIter;
+			line.emplace(*it, *dataIter);
 		}
-		mappedData.push_back(line);
 	}
 	return true;
 }
@@ -298,8 +299,10 @@ void ccdb::Assignment::GetVectorData(vector<string>& vectorData) const
 {
 	//split data
 	vectorData.clear();
-	auto iter = mVectorData.begin();
-	while (iter<mVectorData.end())
+	if(!mVault) return;
+	const vector<string>& values = mVault->GetValues();
+	auto iter = values.begin();
+	while (iter<values.end())
 	{	
 		vectorData.push_back(DecodeBlobSeparator(*iter));
 		iter++;
@@ -309,19 +312,49 @@ void ccdb::Assignment::GetVectorData(vector<string>& vectorData) const
 //______________________________________________________________________________
 void ccdb::Assignment::SetRawData(std::string val)
 {
-	mVectorData.clear();
 	mRows.clear();
-	mRawData = val;
+	mVault = std::make_shared<VaultData>(std::move(val));     // values are split on the first request
+}
 
-	mVectorData = StringUtils::Split(mRawData, CCDB_DATA_BLOB_DELIMETER);
-	for (size_t i = 0; i < mVectorData.size(); i++)
-	{
-		mVectorData[i] = DecodeBlobSeparator(mVectorData[i]); //Decode blob separators
-	}
+string ccdb::Assignment::GetRawData() const
+{
+	if(!mVault) return string();
+	if(mVault->HasRawData()) return mVault->GetRawData();
+	return VectorToBlob(mVault->GetValues());
+}
+
+
+//______________________________________________________________________________
+ccdb::AssignmentIdentity ccdb::Assignment::GetIdentity() const
+{
+	AssignmentIdentity identity;
+	identity.AssignmentId = mId;
+	identity.ConstantSetId = static_cast<dbkey_t>(mDataVaultId);
+	identity.VaultHash = mVault ? mVault->GetHash() : 0;
+	return identity;
 }
 
+
+//______________________________________________________________________________
+MemoryUsage ccdb::Assignment::GetMemoryUsage(bool includeVault) const
+{
+	MemoryUsage usage;
+	usage.ObjectBytes = sizeof(Assignment) + GetHeapBytes(mComment);
+	usage.MappedBytes = mRows.capacity() * sizeof(map<string,string>);
+	for(const auto& row: mRows) usage.MappedBytes += GetHeapBytes(row);
+	if(includeVault && mVault) usage += mVault->GetMemoryUsage();
+	return usage;
+}
+
+
+//______________________________________________________________________________
 std::string ccdb::Assignment::GetValue(const string& columnName)
 {
+	if(!mKeepMappedRows)
+	{
+		int columnIndex = mTypeTable->GetDescriptor()->FindColumn(columnName);
+		return columnIndex < 0 ? string() : GetValue(static_cast<size_t>(columnIndex));
+	}
 	if (mRows.empty())
 	{
 		//fill data
@@ -352,7 +385,7 @@ std::string ccdb::Assignment::GetValue(size_t columnIndex)
 
 ConstantsTypeColumn::ColumnTypes ccdb::Assignment::GetValueType(const string& columnName)
 {
-	return mTypeTable->GetColumnsByName()[columnName]->GetType();
+	return mTypeTable->GetDescriptor()->GetColumn(columnName).Type;
 }
 
 
@@ -7,10 +7,12 @@
 
 #include <vector>
 #include <map>
+#include <memory>
 
 #include "CCDB/Model/ConstantsTypeTable.h"
 #include "CCDB/Model/ConstantsTypeColumn.h"
 #include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Model/VaultData.h"
 
 
 namespace ccdb {
@@ -19,6 +21,29 @@ class EventRange;
 class Variation;
 class RunRange;
 
+    /** @brief What tells assignments and their constants apart without the constants themselves
+     *
+     * Code that builds something from constants keeps the identity and rebuilds only when the identity changes.
+     */
+    struct AssignmentIdentity
+    {
+        dbkey_t AssignmentId = 0;       /// 0 - there is no assignment
+        dbkey_t ConstantSetId = 0;      /// 0 - not known
+        uint64_t VaultHash = 0;         /// HashVault of the constants. 0 - not known
+
+        /** @brief true if the constants are known to be the same. Different assignments may have the same constants */
+        bool HasSameData(const AssignmentIdentity& other) const
+        {
+            if(AssignmentId == other.AssignmentId) return true;
+            if(ConstantSetId && ConstantSetId == other.ConstantSetId) return true;
+            return VaultHash && VaultHash == other.VaultHash;
+        }
+
+        bool operator==(const AssignmentIdentity& other) const { return AssignmentId == other.AssignmentId && VaultHash == other.VaultHash; }
+        bool operator!=(const AssignmentIdentity& other) const { return !(*this == other); }
+    };
+
+
     class Assignment {
     public:
         Assignment();
@@ -98,9 +123,27 @@ class RunRange;
         time_t	GetModifiedTime() const { return mModifiedTime;}   ///Time of last modification
         void	SetModifiedTime(time_t val) {mModifiedTime = val;} ///Time of last modification
 
-        string	GetRawData() const { return mRawData; }            ///Raw data blob
+        AssignmentIdentity GetIdentity() const;							   ///Id, constant set id (if known) and vault hash
+        string	GetRawData() const;								   ///Raw data blob. Made from values if the vault keeps no blob
         void	SetRawData(std::string val);					   ///Raw data blob
 
+        /** @brief Blob with parsed values. Assignments with the same blob could share one object */
+        const std::shared_ptr<const VaultData>& GetVault() const { return mVault; }
+        void SetVault(std::shared_ptr<const VaultData> vault) { mRows.clear(); mVault = std::move(vault); }
+
+        /** @brief If false, GetValue by column name finds the column index instead of keeping mapped rows (default true)
+         *
+         * Mapped rows take a few times more memory than the values. false releases them.
+         */
+        void SetKeepMappedRows(bool value) { mKeepMappedRows = value; if(!value) vector<map<string,string> >().swap(mRows); }
+        bool GetKeepMappedRows() const { return mKeepMappedRows; }
+
+        /** @brief Bytes held by the assignment: MappedBytes of kept rows and ObjectBytes
+         *
+         * @param includeVault add bytes of the vault. The vault could be shared with other assignments
+         */
+        MemoryUsage GetMemoryUsage(bool includeVault = true) const;
+
 
         /** @brief GetMappedData returns rows vector of maps of column_name => data_value
          * @return   vector<map<string,string> >
@@ -123,6 +166,9 @@ class RunRange;
         void SetTypeTable(ConstantsTypeTable* typeTable) { this->mTypeTable = typeTable;}
         ConstantsTypeTable* GetTypeTable() const { return mTypeTable; }
 
+        /** @brief Shared read only description of the table columns. Null if there is no type table */
+        std::shared_ptr<const TableDescriptor> GetTableDescriptor() const { return mTypeTable ? mTypeTable->GetDescriptor() : nullptr; }
+
         std::string GetValue(size_t columnIndex);
         std::string GetValue(size_t rowIndex, size_t columnIndex);
         std::string GetValue(const std::string& columnName);
@@ -158,7 +204,7 @@ class RunRange;
         bool GetValueBool(const std::string& columnName)                   { return StringUtils::ParseBool(GetValue(columnName)); }
         bool GetValueBool(size_t rowIndex, const std::string& columnName)  { return StringUtils::ParseBool(GetValue(rowIndex, columnName)); }
 
-        ConstantsTypeColumn::ColumnTypes GetValueType(size_t columnIndex) { return mTypeTable->GetColumns()[columnIndex]->GetType(); }
+        ConstantsTypeColumn::ColumnTypes GetValueType(size_t columnIndex) { return mTypeTable->GetDescriptor()->GetColumns()[columnIndex].Type; }
         ConstantsTypeColumn::ColumnTypes GetValueType(const std::string& columnName);
 
         /** Gets number or rows */
@@ -169,7 +215,8 @@ class RunRange;
     private:
 
         vector<map<string,string> > mRows;	// cache for blob data by rows
-        string mRawData;					// data blob
+        bool mKeepMappedRows;				// mRows are filled by GetValue
+        std::shared_ptr<const VaultData> mVault; // data blob and its values
         int mId;							// id in database
         int mDataBlobId;					// blob id in database
         unsigned int mVariationId;			// database ID of variation
@@ -187,7 +234,6 @@ class RunRange;
         time_t mModifiedTime;				// time of last modification
         string mComment;					// Comment of assignment
 
-        vector<string> mVectorData;         // Vectorized blob
 
         Assignment(const Assignment& rhs);
         Assignment& operator=(const Assignment& rhs);
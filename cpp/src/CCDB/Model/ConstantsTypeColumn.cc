@@ -66,14 +66,14 @@ void ConstantsTypeColumn::SetId( dbkey_t val )
 	mId = val;
 }
 
-std::string ConstantsTypeColumn::GetName() const
+const std::string& ConstantsTypeColumn::GetName() const
 {
-	return mName;
+	return mName.str();
 }
 
-void ConstantsTypeColumn::SetName( std::string val )
+void ConstantsTypeColumn::SetName(const std::string& val )
 {
-	mName = val;
+	mName = InternedString(val);
 }
 
 std::string ConstantsTypeColumn::GetComment() const
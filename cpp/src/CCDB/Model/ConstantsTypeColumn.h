@@ -11,6 +11,8 @@
 #include <time.h>
 #include <string>
 #include "CCDB/Globals.h"
+#include "CCDB/Helpers/StringPool.h"
+#include "CCDB/Helpers/MemoryUsage.h"
 
 using namespace std;
 
@@ -65,8 +67,8 @@ public:
 	dbkey_t			GetId() const;						///get database table uniq id;
 	void			SetId(dbkey_t val);					///set database table uniq id;
 
-	string			GetName() const;					///get name
-	void			SetName(string val);				///set name
+	const string&	GetName() const;					///get name. Names are interned
+	void			SetName(const string& val);			///set name
 
 	string			GetComment() const;					///get comment
 	void			SetComment(std::string val);		///set comment
@@ -97,6 +99,9 @@ public:
 	ConstantsTypeTable * GetTypeTable() const;
 	void SetTypeTable(ConstantsTypeTable * val);
 	unsigned int GetOrder() const { return mOrder; }
+
+	/** @brief Bytes of the object and its comment. Interned name is kept by StringPool */
+	size_t GetRetainedBytes() const { return sizeof(ConstantsTypeColumn) + GetHeapBytes(mComment); }
 	//The compare operations must be predefined to use the std::sort function 
 	bool operator<(ConstantsTypeColumn rhs) { return mOrder < rhs.mOrder; }
 	bool operator>(ConstantsTypeColumn rhs) { return mOrder > rhs.mOrder; }
@@ -105,7 +110,7 @@ protected:
 	void SetOrder(unsigned int val) { mOrder = val; }
 private:
 	dbkey_t			mId;			//database table uniq id;
-	string			mName;			//name	
+	InternedString	mName;			//name	
 	string			mComment;		//comment
 	time_t			mCreatedTime;	//mCreatedTime time
 	time_t			mModifiedTime;	//mModifiedTime time
@@ -15,8 +15,6 @@ namespace ccdb {
 
 ConstantsTypeTable::ConstantsTypeTable()
 {
-	mName = "";				//Name of the table of constants
-	mFullPath = "";		//Full path of the constant
 	mDirectory = nullptr;	//Link to the directory that holds this constant
 	mDirectoryId = 0;		//Parent directory ID in the DB
 	mId = 0;					//db id
@@ -26,6 +24,7 @@ ConstantsTypeTable::ConstantsTypeTable()
 	mNRows = 0;
 	mNColumnsFromDB = 0;		//
 	mColumns.clear();
+	UpdateDescriptor();
 }
 
 
@@ -88,12 +87,21 @@ void ConstantsTypeTable::AddColumn( ConstantsTypeColumn *col, int order )
 	{
 		mColumns.push_back(col);
 	}
+	UpdateDescriptor();
 }
 
 void ConstantsTypeTable::AddColumn( ConstantsTypeColumn *col )
 {
 	mColumns.push_back(col);
 	col->SetOrder(mColumns.size()-1);
+	UpdateDescriptor();
+}
+
+void ConstantsTypeTable::SetColumns(const vector<ConstantsTypeColumn *>& columns)
+{
+	mColumns = columns;
+	for(size_t i = 0; i < mColumns.size(); i++) mColumns[i]->SetOrder(i);
+	UpdateDescriptor();
 }
 
 void ConstantsTypeTable::AddColumn( const std::string& name, const std::string& type )
@@ -127,6 +135,7 @@ ConstantsTypeColumn * ConstantsTypeTable::RemoveColumn( int order )
 	vector<ConstantsTypeColumn *>::iterator it= mColumns.begin();
 	ConstantsTypeColumn *col = *it;
 	mColumns.erase(it + order);
+	UpdateDescriptor();
 	return *it;
 
 }
@@ -153,9 +162,9 @@ void ConstantsTypeTable::SetNRows( int val )
         return mDirectoryId;
     }
 
-    string ConstantsTypeTable::GetFullPath() const
+    const string& ConstantsTypeTable::GetFullPath() const
     {
-        return mFullPath;
+        return mFullPath.str();
     }
 
     int ConstantsTypeTable::GetId() const
@@ -163,9 +172,9 @@ void ConstantsTypeTable::SetNRows( int val )
         return mId;
     }
 
-    string ConstantsTypeTable::GetName() const
+    const string& ConstantsTypeTable::GetName() const
     {
-        return mName;
+        return mName.str();
     }
 
 void ConstantsTypeTable::SetDirectory(Directory *fDirectory)
@@ -175,11 +184,11 @@ void ConstantsTypeTable::SetDirectory(Directory *fDirectory)
 	 //now this name affects full path...
 	if(mDirectory!=NULL)	
 	{
-		mFullPath.assign(PathUtils::CombinePath(mDirectory->GetFullPath(), mName));
+		mFullPath = InternedString(PathUtils::CombinePath(mDirectory->GetFullPath(), mName));
 	}
 	else
 	{
-		mFullPath.assign("");
+		mFullPath = InternedString();
 	}
 }
 
@@ -188,9 +197,9 @@ void ConstantsTypeTable::SetDirectoryId(int fDirectoryId)
 	this->mDirectoryId = fDirectoryId;
 }
 
-void ConstantsTypeTable::SetFullPath(string fFullPath)
+void ConstantsTypeTable::SetFullPath(const string& fFullPath)
 {
-	this->mFullPath = fFullPath;
+	this->mFullPath = InternedString(fFullPath);
 }
 
 void ConstantsTypeTable::SetId(dbkey_t id)
@@ -209,16 +218,16 @@ void ConstantsTypeTable::SetId(dbkey_t id)
 
 void ConstantsTypeTable::SetName(const string& name)
 {
-	mName.assign(name);
+	mName = InternedString(name);
 	
 	//now this name affects full path...
 	if(mDirectory!=NULL)	
 	{
-		mFullPath.assign(PathUtils::CombinePath(mDirectory->GetFullPath(), name));
+		mFullPath = InternedString(PathUtils::CombinePath(mDirectory->GetFullPath(), name));
 	}
 	else
 	{
-		mFullPath.assign("");
+		mFullPath = InternedString();
 	}
 }
 
@@ -255,6 +264,7 @@ void ConstantsTypeTable::SetName(const string& name)
 	void ConstantsTypeTable::ClearColumns()
 	{
 		mColumns.clear();
+		UpdateDescriptor();
 	}
 
 	int ConstantsTypeTable::GetNColumnsFromDB() const
@@ -267,45 +277,40 @@ void ConstantsTypeTable::SetName(const string& name)
 		mNColumnsFromDB = val;
 	}
 
-	vector<string> ConstantsTypeTable::GetColumnNames() const
+	const vector<string>& ConstantsTypeTable::GetColumnNames() const
 	{
-		//future result
-		vector<string> names;
+		return mDescriptor->GetColumnNames();
+	}
 
-		//and just a loop through columns
-		vector<ConstantsTypeColumn *>::const_iterator iter = mColumns.begin();
-		while(iter<mColumns.end())
-		{
-			names.push_back((*iter)->GetName());
-			iter++;
-		}
-		return names;
+	const vector<string>& ConstantsTypeTable::GetColumnTypeStrings() const
+	{
+		return mDescriptor->GetColumnTypeStrings();
 	}
 
-	vector<string> ConstantsTypeTable::GetColumnTypeStrings() const
+	const map<string, ConstantsTypeColumn *> & ConstantsTypeTable::GetColumnsByName() const
 	{
-		//future result
-		vector<string> types;
+		return mColumnsByName;
+	}
 
-		//and just a loop through columns
-		vector<ConstantsTypeColumn *>::const_iterator iter = mColumns.begin();
-		while(iter<mColumns.end())
-		{
-			types.push_back((*iter)->GetTypeString());
-			iter++;
+	size_t ConstantsTypeTable::GetRetainedBytes() const
+	{
+		size_t bytes = sizeof(ConstantsTypeTable) + GetHeapBytes(mComment) + GetHeapBytes(mDescription);
+		bytes += mColumns.capacity() * sizeof(ConstantsTypeColumn *);
+		for(const auto& item: mColumnsByName) {
+			bytes += sizeof(item) + 4 * sizeof(void*) + GetHeapBytes(item.first);	//map node: value, 3 links and color
 		}
-		return types;
+		if(mDescriptor) bytes += mDescriptor->GetRetainedBytes();
+		return bytes;
 	}
 
-	map<string, ConstantsTypeColumn *> & ConstantsTypeTable::GetColumnsByName()
+	void ConstantsTypeTable::UpdateDescriptor()
 	{
-		if (mColumnsByName.size() == 0)
-		{
-			for (size_t i = 0; i < mColumns.size(); i++){
-				mColumnsByName[mColumns[i]->GetName()] = mColumns[i];
-			}
+		//Built here, not on the first request, so readers of a shared table never write to it
+		mDescriptor = std::make_shared<const TableDescriptor>(mColumns);
+		mColumnsByName.clear();
+		for (size_t i = 0; i < mColumns.size(); i++){
+			mColumnsByName[mColumns[i]->GetName()] = mColumns[i];
 		}
-		return mColumnsByName;
 	}
 
 
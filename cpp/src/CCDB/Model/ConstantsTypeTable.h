@@ -10,9 +10,12 @@
 
 #include <string>
 #include <map>
+#include <memory>
 
 #include "CCDB/Model/Directory.h"
 #include "CCDB/Model/ConstantsTypeColumn.h"
+#include "CCDB/Model/TableDescriptor.h"
+#include "CCDB/Helpers/StringPool.h"
 
 
 namespace ccdb {
@@ -32,14 +35,14 @@ namespace ccdb {
         void			SetDirectoryId(int directoryId);/// Parent directory id
         int 			GetDirectoryId() const;			/// Parent directory id
 
-        void			SetFullPath(string fFullPath);	/// full path
-        string 			GetFullPath() const;			/// full path
+        void			SetFullPath(const string& fFullPath);	/// full path
+        const string&	GetFullPath() const;			/// full path. Paths and names are interned
 
         void			SetId(dbkey_t id);					/// database Id
         int 			GetId() const;					/// database Id
 
         void			SetName(const string& name);			/// name
-        string 			GetName() const;				/// name
+        const string&	GetName() const;				/// name
 
         std::string		GetComment() const;				///set comment
 
@@ -109,6 +112,12 @@ namespace ccdb {
          */
         void	AddColumn(const std::string& name, const std::string& type);
 
+        /** @brief Replaces all columns. Columns get orders as in the vector. The descriptor is built once
+         *
+         * @param [in] columns
+         */
+        void	SetColumns(const vector<ConstantsTypeColumn *>& columns);
+
         /** @brief RemoveColumn with order
          *
          * @param     int order
@@ -122,14 +131,27 @@ namespace ccdb {
          */
         void				 	ClearColumns();
 
-        vector<string>			GetColumnNames() const;
-        vector<string>			GetColumnTypeStrings() const;
+        /** @brief Names of columns in columns order. Taken from the descriptor, so it is not copied */
+        const vector<string>&	GetColumnNames() const;
+        const vector<string>&	GetColumnTypeStrings() const;
+
+        /** @brief Frozen description of current columns. Could be shared between threads
+         *
+         * Columns changes make a new descriptor, the one that is got before stays the same.
+         * Returned by value, so callers own a reference that outlives columns changes
+         */
+        std::shared_ptr<const TableDescriptor> GetDescriptor() const { return mDescriptor; }
 
-        /** @brief gets map of pointer to columns by name of columns*/
-        std::map<std::string, ConstantsTypeColumn *> &GetColumnsByName();
+        /** @brief gets map of pointer to columns by name of columns. The map is kept up to date with columns */
+        const std::map<std::string, ConstantsTypeColumn *> &GetColumnsByName() const;
+
+        /** @brief Bytes of the table, its strings, columns lists and descriptor. Columns objects are not counted */
+        size_t GetRetainedBytes() const;
     private:
-        string		mName;			//Name of the table of constants
-        string		mFullPath;		//Full path of the constant
+        void		UpdateDescriptor();	//Rebuilds the descriptor and columns by name after columns are changed
+
+        InternedString	mName;			//Name of the table of constants
+        InternedString	mFullPath;		//Full path of the constant
         Directory *mDirectory;		//Link to the directory that holds this constant
         int			mDirectoryId;	//Parent directory ID in the DB
         dbkey_t mId;			//db id
@@ -143,6 +165,7 @@ namespace ccdb {
         std::map<std::string, ConstantsTypeColumn *> mColumnsByName;
 
         vector<ConstantsTypeColumn *> mColumns; //Columns object
+        std::shared_ptr<const TableDescriptor> mDescriptor;    //Description of mColumns
         ConstantsTypeTable(const ConstantsTypeTable& rhs);
         ConstantsTypeTable& operator=(const ConstantsTypeTable& rhs);
     };
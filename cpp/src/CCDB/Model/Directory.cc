@@ -12,9 +12,10 @@ namespace ccdb
 {
 
 Directory::Directory():
-    mSubDirectories(0),
-    mName(""),
-    mComment("")
+    mName(),
+    mFullPath("/"),
+    mComment(""),
+    mSubDirectories(0)
 {
 	mParent = nullptr;
 	mId = 0;
@@ -48,12 +49,32 @@ void ccdb::Directory::AddSubdirectory(Directory* subdirectory)
 {
 	subdirectory->mParent = this;
 	mSubDirectories.push_back(subdirectory);
+	subdirectory->UpdateFullPath();
 }
 
-std::string ccdb::Directory::GetFullPath() const
+void ccdb::Directory::SetName(const std::string& val)
 {
-    string parentFullPath = mParent ? mParent->GetFullPath() : "";
-    return parentFullPath + "/" + mName;
+	mName = InternedString(val);
+	UpdateFullPath();
+}
+
+void ccdb::Directory::UpdateFullPath()
+{
+    if(!mParent) {
+        mFullPath = InternedString("/" + mName.str());
+    }
+    else {
+        // The root directory full path is "/" so its children should not get "//"
+        const string& parentFullPath = mParent->GetFullPath();
+        if(parentFullPath.empty() || parentFullPath[parentFullPath.length()-1] != '/') {
+            mFullPath = InternedString(parentFullPath + '/' + mName.str());
+        }
+        else {
+            mFullPath = InternedString(parentFullPath + mName.str());
+        }
+    }
+
+    for(auto subdirectory: mSubDirectories) subdirectory->UpdateFullPath();
 }
 
 
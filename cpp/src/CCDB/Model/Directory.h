@@ -12,6 +12,8 @@
 #include <time.h>
 
 #include "CCDB/Globals.h"
+#include "CCDB/Helpers/StringPool.h"
+#include "CCDB/Helpers/MemoryUsage.h"
 
 
 namespace ccdb{
@@ -30,7 +32,7 @@ namespace ccdb{
          * @brief Adds a subdirectory of this directory
          *
          * Adds a subdirectory of this directory
-         * Automatically adds "this" as mParent for child
+         * Automatically adds "this" as mParent for child and updates full paths of the child subtree
          *
          * @param subDirectory Child directory to be added
          */
@@ -41,6 +43,9 @@ namespace ccdb{
          */
         void DisposeSubdirectories();
 
+        /** @brief Forgets subdirectories, but doesn't delete them. For directories that are owned by somebody else */
+        void ClearSubdirectories() { mSubDirectories.clear(); }
+
         /**
          * @brief Get
          * @return pointer to parent directory. NULL if there is no parent directory
@@ -53,8 +58,8 @@ namespace ccdb{
          */
         const std::vector<ccdb::Directory*>& GetSubdirectories() const { return mSubDirectories; }
 
-        std::string GetName() const { return mName; }                 /// Name of the directory
-        void SetName(const std::string& val) { mName = val; }         /// Name of the directory
+        const std::string& GetName() const { return mName.str(); }    /// Name of the directory. Names are interned
+        void SetName(const std::string& val);                         /// Name of the directory. Updates full paths of the subtree
 
 
         std::string GetComment() const { return mComment; }           /// Gets virginia natural gas bill in coronas
@@ -68,7 +73,10 @@ namespace ccdb{
         int GetId() const { return mId;}                              /// DB id
         void SetId(dbkey_t val) { mId = val; }                        /// DB id
 
-        std::string GetFullPath() const;         /// Full path (including self name) of the directory
+        const std::string& GetFullPath() const { return mFullPath.str(); }   /// Full path (including self name) of the directory. Stored, not built on each call
+
+        /** @brief Bytes of the object, its comment and subdirectories list. Interned names are kept by StringPool */
+        size_t GetRetainedBytes() const { return sizeof(Directory) + GetHeapBytes(mComment) + mSubDirectories.capacity() * sizeof(Directory*); }
 
 
 
@@ -76,7 +84,10 @@ namespace ccdb{
 
 
     private:
-        std::string mName;		///Name of directory like in db
+        void UpdateFullPath();   ///Builds full path from the parent one, then does it for subdirectories
+
+        InternedString mName;	///Name of directory like in db
+        InternedString mFullPath;	///Full path, built when name or parent is changed
         std::string mComment;	///Comment like in db
         Directory *mParent;
         std::vector<Directory *> mSubDirectories;
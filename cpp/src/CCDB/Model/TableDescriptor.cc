@@ -0,0 +1,64 @@
+#include <stdexcept>
+
+#include "CCDB/Model/TableDescriptor.h"
+#include "CCDB/Helpers/MemoryUsage.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+TableDescriptor::TableDescriptor(const std::vector<ConstantsTypeColumn *>& columns)
+{
+    mColumns.reserve(columns.size());
+    mColumnNames.reserve(columns.size());
+    mColumnTypeStrings.reserve(columns.size());
+    mIndexByName.reserve(columns.size());
+
+    for(auto column: columns) {
+        ColumnDescriptor descriptor;
+        descriptor.Name = InternedString(column->GetName());
+        descriptor.Type = column->GetType();
+        descriptor.Order = mColumns.size();
+        mColumns.push_back(descriptor);
+
+        mColumnNames.push_back(column->GetName());
+        mColumnTypeStrings.push_back(column->GetTypeString());
+        mIndexByName.emplace(column->GetName(), descriptor.Order);     // the first one wins if names repeat
+    }
+}
+
+
+//______________________________________________________________________________
+int TableDescriptor::FindColumn(const std::string& name) const
+{
+    auto iter = mIndexByName.find(name);
+    return iter == mIndexByName.end() ? -1 : static_cast<int>(iter->second);
+}
+
+
+//______________________________________________________________________________
+const ColumnDescriptor& TableDescriptor::GetColumn(const std::string& name) const
+{
+    int index = FindColumn(name);
+    if(index < 0) throw std::out_of_range("ccdb::TableDescriptor::GetColumn => There is no column '" + name + "'");
+    return mColumns[index];
+}
+
+
+//______________________________________________________________________________
+size_t TableDescriptor::GetRetainedBytes() const
+{
+    size_t bytes = sizeof(TableDescriptor) + mColumns.capacity() * sizeof(ColumnDescriptor);
+    bytes += GetHeapBytes(mColumnNames) + GetHeapBytes(mColumnTypeStrings);
+
+    // A hash map node has the value, a link and the cached hash. Plus the buckets array
+    bytes += mIndexByName.bucket_count() * sizeof(void*);
+    for(const auto& item: mIndexByName) {
+        bytes += sizeof(item) + 2 * sizeof(void*) + GetHeapBytes(item.first);
+    }
+    return bytes;
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef _TableDescriptor_
+#define _TableDescriptor_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+
+#include "CCDB/Model/ConstantsTypeColumn.h"
+#include "CCDB/Helpers/StringPool.h"
+
+namespace ccdb
+{
+    /** @brief Column of a table descriptor */
+    struct ColumnDescriptor
+    {
+        InternedString Name;
+        ConstantsTypeColumn::ColumnTypes Type;
+        size_t Order;                           /// Index of the column in a row
+    };
+
+
+    /** @brief Frozen description of type table columns
+     *
+     * Built once from the columns of a table and never changed, so one descriptor is shared
+     * read only by all threads and Calibrations that use the table. Column names and type
+     * strings are kept as ready vectors and a name to index hash map is built, so nothing
+     * is allocated when they are asked for.
+     *
+     * A table gets a new descriptor when its columns are changed. The old one stays valid
+     * for those who hold it.
+     */
+    class TableDescriptor
+    {
+    public:
+        /** @brief Copies columns metadata in the columns order */
+        explicit TableDescriptor(const std::vector<ConstantsTypeColumn *>& columns);
+
+        TableDescriptor(const TableDescriptor&) = delete;
+        TableDescriptor& operator=(const TableDescriptor&) = delete;
+
+        const std::vector<ColumnDescriptor>& GetColumns() const { return mColumns; }
+        size_t GetColumnsCount() const { return mColumns.size(); }
+
+        /** @brief Names of columns in the columns order */
+        const std::vector<std::string>& GetColumnNames() const { return mColumnNames; }
+
+        /** @brief Type names of columns in the columns order: "int", "double", ... */
+        const std::vector<std::string>& GetColumnTypeStrings() const { return mColumnTypeStrings; }
+
+        /** @brief Index of the column with this name or -1 if there is no such column */
+        int FindColumn(const std::string& name) const;
+
+        /** @brief Column with this name. Throws std::out_of_range if there is no such column */
+        const ColumnDescriptor& GetColumn(const std::string& name) const;
+
+        /** @brief Bytes of the descriptor and its vectors and map */
+        size_t GetRetainedBytes() const;
+
+    private:
+        std::vector<ColumnDescriptor> mColumns;
+        std::vector<std::string> mColumnNames;
+        std::vector<std::string> mColumnTypeStrings;
+        std::unordered_map<std::string, size_t> mIndexByName;
+    };
+}
+
+#endif //_TableDescriptor_
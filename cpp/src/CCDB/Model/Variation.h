@@ -12,6 +12,9 @@
 #include <string>
 #include <time.h>
 
+#include "CCDB/Helpers/StringPool.h"
+#include "CCDB/Helpers/MemoryUsage.h"
+
 namespace ccdb
 {
     class Variation
@@ -29,8 +32,8 @@ namespace ccdb
         virtual ~Variation() = default;
         unsigned int GetId() const { return mId; }					//get database table uniq id;
         void SetId(unsigned int val) { mId = val; }	                //set database table uniq id;
-        std::string GetName() const { return mName; }				//get name
-        void SetName(std::string val) { mName = val; }				//set name
+        const std::string& GetName() const { return mName.str(); }	//get name. Names are interned
+        void SetName(const std::string& val) { mName = InternedString(val); }	//set name
         std::string GetComment() const { return mComment; }			//get comment
         void SetComment(std::string val) { mComment = val; }		//set comment
 
@@ -39,13 +42,16 @@ namespace ccdb
 
         unsigned int GetParentDbId() const { return mParentDbId; }
         void SetParentDbId(unsigned int val) { mParentDbId = val; }
+
+        /** @brief Bytes of the object and its comment. Interned name is kept by StringPool */
+        size_t GetRetainedBytes() const { return sizeof(Variation) + GetHeapBytes(mComment); }
     protected:
 
     private:
         unsigned int		mId;			//! database table uniq id;
         unsigned int        mParentDbId;      /// Database id of parent variation
         Variation *         mParent;      /// Get parent variation
-        string			    mName;		//! name
+        InternedString	    mName;		//! name
         string			    mComment;		//! comment
     };
 }
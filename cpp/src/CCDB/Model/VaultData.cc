@@ -0,0 +1,74 @@
+#include "CCDB/Model/VaultData.h"
+#include "CCDB/Model/Assignment.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Helpers/VaultHash.h"
+#include "CCDB/Globals.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+VaultData::VaultData(std::string rawData):
+    mRawData(std::move(rawData)),
+    mHash(HashVault(mRawData)),
+    mHasRawData(true),
+    mIsSplit(false)
+{
+}
+
+
+//______________________________________________________________________________
+VaultData::VaultData(std::vector<std::string> values, uint64_t hash):
+    mHash(hash),
+    mHasRawData(false),
+    mValues(std::move(values)),
+    mIsSplit(true)
+{
+    std::call_once(mValuesParsed, []() {});     // there is no blob to split
+}
+
+
+//______________________________________________________________________________
+std::shared_ptr<const VaultData> VaultData::CopyWithoutRawData(const VaultData& source)
+{
+    return std::shared_ptr<const VaultData>(new VaultData(source.GetValues(), source.GetHash()));
+}
+
+
+//______________________________________________________________________________
+const std::vector<std::string>& VaultData::GetValues() const
+{
+    std::call_once(mValuesParsed, [this]() {
+        mValues = StringUtils::Split(mRawData, CCDB_DATA_BLOB_DELIMETER);
+        for (auto& value: mValues) {
+            value = Assignment::DecodeBlobSeparator(value);     //Decode blob separators
+        }
+        mIsSplit = true;
+    });
+    return mValues;
+}
+
+
+//______________________________________________________________________________
+bool VaultData::HasSameData(const VaultData& other) const
+{
+    if(this == &other) return true;
+    if(mHash != other.mHash) return false;
+    if(mHasRawData && other.mHasRawData) return mRawData == other.mRawData;
+    return GetValues() == other.GetValues();
+}
+
+
+//______________________________________________________________________________
+MemoryUsage VaultData::GetMemoryUsage() const
+{
+    MemoryUsage usage;
+    usage.RawBytes = GetHeapBytes(mRawData);
+    if(mIsSplit) usage.SplitBytes = GetHeapBytes(mValues);
+    usage.ObjectBytes = sizeof(VaultData);
+    return usage;
+}
+
+}
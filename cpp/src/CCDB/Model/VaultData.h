@@ -0,0 +1,65 @@
+#ifndef _VaultData_
+#define _VaultData_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include "CCDB/Helpers/MemoryUsage.h"
+
+namespace ccdb
+{
+    /** @brief Data blob of a constant set and its values
+     *
+     * The object is immutable and is shared between assignments that have the same vault
+     * (@see Calibration, which keeps one VaultData per distinct vault). Values are split
+     * from the blob on the first request, once, even if many threads ask for them.
+     */
+    class VaultData
+    {
+    public:
+        explicit VaultData(std::string rawData);
+
+        /** @brief Vault with the same values and hash but without the blob, to keep less memory
+         *
+         * Values are split from the source blob if they are not split yet.
+         */
+        static std::shared_ptr<const VaultData> CopyWithoutRawData(const VaultData& source);
+
+        /** @brief Blob as it is stored in the database. Empty if the vault was made by CopyWithoutRawData */
+        const std::string& GetRawData() const { return mRawData; }
+
+        /** @brief false if the vault was made by CopyWithoutRawData */
+        bool HasRawData() const { return mHasRawData; }
+
+        /** @brief Values of the blob with decoded separators */
+        const std::vector<std::string>& GetValues() const;
+
+        /** @brief HashVault of the blob (the same as constantSets.vaultHash) */
+        uint64_t GetHash() const { return mHash; }
+
+        /** @brief true if both vaults hold the same values. Blobs are compared if both vaults have them */
+        bool HasSameData(const VaultData& other) const;
+
+        /** @brief Bytes of the blob (RawBytes), of split values (SplitBytes, 0 until values are requested) and of the object */
+        MemoryUsage GetMemoryUsage() const;
+
+    private:
+        VaultData(std::vector<std::string> values, uint64_t hash);
+
+        std::string mRawData;
+        uint64_t mHash;
+        bool mHasRawData;
+        mutable std::vector<std::string> mValues;
+        mutable std::once_flag mValuesParsed;
+        mutable std::atomic<bool> mIsSplit;     // mValues are filled and could be read without mValuesParsed
+
+        VaultData(const VaultData&) = delete;
+        VaultData& operator=(const VaultData&) = delete;
+    };
+}
+
+#endif //_VaultData_
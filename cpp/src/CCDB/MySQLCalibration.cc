@@ -1,9 +1,11 @@
 #include <stdexcept>
 #include <assert.h>
+#include <algorithm>
 
 #include "CCDB/MySQLCalibration.h"
 #include "CCDB/Providers/MySQLDataProvider.h"
 #include "CCDB/Helpers/PathUtils.h"
+#include "CCDB/CalibrationOptions.h"
 
 namespace ccdb
 {
@@ -48,7 +50,9 @@ bool MySQLCalibration::Connect( std::string connectionString )
 	 * @param connectionString the Connection String
 	 * @return true if connected
 	 */
-    std::lock_guard<std::mutex> lock(mReadMutex);
+    connectionString = ApplyConnectionOptions(connectionString);     // ?name=value options are not a part of the provider connection string
+
+    std::unique_lock<std::mutex> lock(mReadMutex);
 
     UpdateActivityTime();
 
@@ -88,9 +92,20 @@ bool MySQLCalibration::Connect( std::string connectionString )
         throw std::logic_error(ERRMSG_CONNECT_LOCKED);
     }
 
-    bool result = mProvider->Connect(connectionString);
-    return result;
-    //TODO decide maybe to throw an exception here?
+    // Pool sizes from options. A provider of other type could be given by UseProvider
+    MySQLDataProvider* mysqlProvider = dynamic_cast<MySQLDataProvider*>(mProvider);
+    if(mysqlProvider && (mOptions->PoolSize || mOptions->AsyncPoolSize)) {
+        MySQLConnectionPoolOptions poolOptions;
+        if(mOptions->PoolSize) poolOptions.MaxSize = mOptions->PoolSize;
+        if(mOptions->AsyncPoolSize) poolOptions.AsyncConnections = mOptions->AsyncPoolSize;
+        poolOptions.MinSize = std::min(poolOptions.MinSize, poolOptions.MaxSize);
+        mysqlProvider->SetPoolOptions(poolOptions);
+    }
+    mProvider->Connect(connectionString);
+    lock.unlock();
+
+    if(mIsPreloadEnabled) Preload();
+    return true; // If we get here, it is 'true'. Connection errors are reported by exceptions
 }
 
 
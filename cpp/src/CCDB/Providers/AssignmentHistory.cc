@@ -0,0 +1,166 @@
+#include <stdexcept>
+#include <algorithm>
+#include <map>
+
+#include "CCDB/Providers/AssignmentHistory.h"
+#include "CCDB/Model/Variation.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+AssignmentHistory::AssignmentHistory(DataProvider& provider, const std::string& path, const std::string& variation,
+                                     bool loadVaults, int runMin, int runMax):
+    mPath(path),
+    mVariation(variation),
+    mEntriesCount(0)
+{
+    Variation* current = provider.GetVariation(variation);
+    if(!current) {
+        throw std::runtime_error("ccdb::AssignmentHistory => No variation '" + variation + "' was found");
+    }
+
+    vector<string> chain;
+    for(; current; current = current->GetParent()) chain.push_back(current->GetName());
+
+    for(size_t level = 0; level < chain.size(); level++) {
+        map<pair<int, int>, RunInterval> intervals;
+        auto addEntry = [&intervals](AssignmentHistoryEntry& entry) {
+            RunInterval& interval = intervals[make_pair(entry.RunMin, entry.RunMax)];
+            interval.RunMin = entry.RunMin;
+            interval.RunMax = entry.RunMax;
+            interval.Entries.push_back(std::move(entry));
+        };
+
+        if(loadVaults) {
+            // One query streams the constants, the run filter is applied here
+            provider.VisitAssignments(path, chain[level], -1, 0, [&](Assignment& assignment) {
+                AssignmentHistoryEntry entry;
+                entry.AssignmentId = assignment.GetId();
+                entry.Created = assignment.GetCreatedTime();
+                entry.RunMin = assignment.GetRunRange()->GetMin();
+                entry.RunMax = assignment.GetRunRange()->GetMax();
+                entry.VariationLevel = level;
+                entry.ConstantSetId = assignment.GetDataVaultId();
+                entry.Vault = assignment.GetVault();
+                if(entry.RunMax >= runMin && entry.RunMin <= runMax) addEntry(entry);
+                return true;
+            });
+        }
+        else {
+            for(const auto& record: provider.GetAssignmentRecords(path, chain[level], runMin, runMax)) {
+                AssignmentHistoryEntry entry;
+                entry.AssignmentId = record.AssignmentId;
+                entry.Created = record.Created;
+                entry.RunMin = record.RunMin;
+                entry.RunMax = record.RunMax;
+                entry.VariationLevel = level;
+                entry.ConstantSetId = record.ConstantSetId;
+                addEntry(entry);
+            }
+        }
+
+        // map keeps intervals sorted by RunMin
+        Level runIntervals;
+        runIntervals.Intervals.reserve(intervals.size());
+        for(auto& item: intervals) {
+            RunInterval& interval = item.second;
+            std::sort(interval.Entries.begin(), interval.Entries.end(),
+                      [](const AssignmentHistoryEntry& left, const AssignmentHistoryEntry& right) {
+                          return left.Created != right.Created ? left.Created < right.Created
+                                                               : left.AssignmentId < right.AssignmentId;
+                      });
+
+            // Ids are not always in the order of creation times (e.g. imported history), the latest id wins
+            interval.MaxIds.reserve(interval.Entries.size());
+            dbkey_t maxId = 0;
+            for(const auto& entry: interval.Entries) {
+                maxId = std::max(maxId, entry.AssignmentId);
+                interval.MaxIds.push_back(maxId);
+            }
+            mEntriesCount += interval.Entries.size();
+            runIntervals.Intervals.push_back(std::move(interval));
+        }
+        BuildSegments(runIntervals);
+        mLevels.push_back(std::move(runIntervals));
+    }
+}
+
+
+//______________________________________________________________________________
+void AssignmentHistory::BuildSegments(Level& level)
+{
+    // Find gives the same answer for all runs between two consecutive range ends
+    for(const auto& interval: level.Intervals) {
+        level.SegmentStarts.push_back(interval.RunMin);
+        if(interval.RunMax < INFINITE_RUN) level.SegmentStarts.push_back(interval.RunMax + 1);
+    }
+    std::sort(level.SegmentStarts.begin(), level.SegmentStarts.end());
+    level.SegmentStarts.erase(std::unique(level.SegmentStarts.begin(), level.SegmentStarts.end()), level.SegmentStarts.end());
+
+    level.SegmentIntervals.resize(level.SegmentStarts.size());
+    for(size_t i = 0; i < level.Intervals.size(); i++) {
+        const RunInterval& interval = level.Intervals[i];
+        auto segment = std::lower_bound(level.SegmentStarts.begin(), level.SegmentStarts.end(), interval.RunMin);
+        for(; segment != level.SegmentStarts.end() && *segment <= interval.RunMax; ++segment) {
+            level.SegmentIntervals[segment - level.SegmentStarts.begin()].push_back(i);
+        }
+    }
+}
+
+
+//______________________________________________________________________________
+const AssignmentHistoryEntry* AssignmentHistory::FindInInterval(const RunInterval& interval, time_t time)
+{
+    size_t count = interval.Entries.size();
+    if(time > 0) {
+        auto end = std::upper_bound(interval.Entries.begin(), interval.Entries.end(), time,
+                                    [](time_t value, const AssignmentHistoryEntry& entry) { return value < entry.Created; });
+        count = static_cast<size_t>(end - interval.Entries.begin());
+    }
+    if(!count) return nullptr;
+
+    // The entry with the greatest id among the first 'count' ones
+    dbkey_t maxId = interval.MaxIds[count - 1];
+    for(size_t i = count; i-- > 0; ) {
+        if(interval.Entries[i].AssignmentId == maxId) return &interval.Entries[i];
+    }
+    return nullptr;
+}
+
+
+//______________________________________________________________________________
+const AssignmentHistoryEntry* AssignmentHistory::Find(int run, time_t time) const
+{
+    for(const auto& level: mLevels) {
+        // The last segment that starts not later than the run
+        auto segment = std::upper_bound(level.SegmentStarts.begin(), level.SegmentStarts.end(), run);
+        if(segment == level.SegmentStarts.begin()) continue;
+        size_t segmentIndex = static_cast<size_t>(segment - level.SegmentStarts.begin()) - 1;
+
+        const AssignmentHistoryEntry* best = nullptr;
+        for(size_t intervalIndex: level.SegmentIntervals[segmentIndex]) {
+            const AssignmentHistoryEntry* candidate = FindInInterval(level.Intervals[intervalIndex], time);
+            if(candidate && (!best || candidate->AssignmentId > best->AssignmentId)) best = candidate;
+        }
+        if(best) return best;       // the closer variation wins even if the parent has newer data
+    }
+    return nullptr;
+}
+
+
+//______________________________________________________________________________
+std::vector<std::pair<int, int>> AssignmentHistory::GetRunRanges() const
+{
+    vector<pair<int, int>> ranges;
+    for(const auto& level: mLevels) {
+        for(const auto& interval: level.Intervals) ranges.push_back(make_pair(interval.RunMin, interval.RunMax));
+    }
+    std::sort(ranges.begin(), ranges.end());
+    ranges.erase(std::unique(ranges.begin(), ranges.end()), ranges.end());
+    return ranges;
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef _AssignmentHistory_
+#define _AssignmentHistory_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <ctime>
+#include <utility>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Providers/DataProvider.h"
+#include "CCDB/Model/VaultData.h"
+
+namespace ccdb
+{
+    /** @brief One assignment kept by AssignmentHistory */
+    struct AssignmentHistoryEntry
+    {
+        dbkey_t AssignmentId = 0;
+        time_t Created = 0;                         /// UNIX time
+        int RunMin = 0;
+        int RunMax = 0;
+        size_t VariationLevel = 0;                  /// 0 - the history variation, 1 - its parent, ...
+        dbkey_t ConstantSetId = 0;
+        std::shared_ptr<const VaultData> Vault;     /// NULL if the history was read without vaults
+    };
+
+
+    /** @brief All assignments of one type table in a variation (with its parents) for as-of queries in memory
+     *
+     * Reproducibility jobs ask the same tables at a fixed time for many runs. Instead of a query per request,
+     * the history is read once and Find answers what GetAssignmentShort(run, path, time, variation) would give:
+     * the variation closest to the requested one wins, then the latest assignment created not later than the time.
+     *
+     * Assignments are grouped by run range. Run ranges are cut into segments at their ends, each segment keeps
+     * the ranges that cover it, and in each range assignments are sorted by creation time, so both the run
+     * and the time lookups are binary searches. The history is not updated, build a new one to see newer assignments.
+     * Without vaults only ids, times and run ranges are read (@see DataProvider::GetAssignmentRecords),
+     * vaults of the entries that are needed are loaded by DataProvider::GetConstantSetVault.
+     *
+     * Usage:
+     *    AssignmentHistory history(provider, "/test/test_vars/test_table", "default");
+     *    auto entry = history.Find(run, time);
+     *    if(entry) ... entry->Vault->GetValues()
+     */
+    class AssignmentHistory
+    {
+    public:
+        /** @brief Reads assignments of the table in the variation and its parents
+         *
+         * @param [in] provider   - connected provider
+         * @param [in] path       - type table path
+         * @param [in] variation  - variation name
+         * @param [in] loadVaults - read constants too. Otherwise entries have ConstantSetId only
+         * @param [in] runMin, runMax - only assignments which run ranges overlap these runs (both included)
+         * @exception std::runtime_error if the table or the variation is not found
+         */
+        AssignmentHistory(DataProvider& provider, const std::string& path, const std::string& variation,
+                          bool loadVaults = true, int runMin = 0, int runMax = INFINITE_RUN);
+
+        /** @brief Assignment for the run as of the time
+         *
+         * @param [in] run  - run number. Runs outside of the constructor runMin..runMax may miss assignments
+         * @param [in] time - UNIX time, assignments created later are not seen. 0 - the latest
+         * @return the entry or nullptr if there is no assignment. The pointer is valid while the history exists
+         */
+        const AssignmentHistoryEntry* Find(int run, time_t time = 0) const;
+
+        const std::string& GetPath() const { return mPath; }
+        const std::string& GetVariation() const { return mVariation; }
+
+        /** @brief Run ranges of all assignments in the history (of all variation levels), each range once
+         *
+         * Find gives the same entry for runs that are in the same set of these ranges
+         */
+        std::vector<std::pair<int, int>> GetRunRanges() const;
+
+        /** @brief Number of assignments in the history */
+        size_t GetEntriesCount() const { return mEntriesCount; }
+
+    private:
+
+        /** @brief Assignments of one run range in one variation */
+        struct RunInterval
+        {
+            int RunMin;
+            int RunMax;
+            std::vector<AssignmentHistoryEntry> Entries;    /// By Created, then by AssignmentId
+            std::vector<dbkey_t> MaxIds;                    /// MaxIds[i] - the greatest id of Entries[0..i]
+        };
+
+        /** @brief Run intervals of one variation level */
+        struct Level
+        {
+            std::vector<RunInterval> Intervals;                 /// By RunMin
+            std::vector<int> SegmentStarts;                     /// Segment i has runs SegmentStarts[i]..SegmentStarts[i+1]-1
+            std::vector<std::vector<size_t>> SegmentIntervals;  /// Indexes of Intervals covering segment i
+        };
+
+        /** @brief Latest entry of the interval created not later than time */
+        static const AssignmentHistoryEntry* FindInInterval(const RunInterval& interval, time_t time);
+
+        /** @brief Cuts the level intervals into segments at their ends */
+        static void BuildSegments(Level& level);
+
+        std::string mPath;
+        std::string mVariation;
+        size_t mEntriesCount;
+        std::vector<Level> mLevels;                         /// For each variation level
+    };
+}
+
+#endif //_AssignmentHistory_
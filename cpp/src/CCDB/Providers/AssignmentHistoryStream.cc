@@ -0,0 +1,79 @@
+#include <stdexcept>
+
+#include "CCDB/Providers/AssignmentHistoryStream.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+AssignmentHistoryStream::AssignmentHistoryStream(DataProvider& provider, const std::string& path, const std::string& variation,
+                                                 int run, size_t pageSize):
+    mProvider(provider),
+    mPath(path),
+    mVariation(variation),
+    mRun(run),
+    mPageSize(pageSize),
+    mPageIndex(0),
+    mIsOver(false),
+    mPageCount(0)
+{
+    if(pageSize == 0) {
+        throw std::logic_error("ccdb::AssignmentHistoryStream => pageSize must be greater than 0");
+    }
+}
+
+
+//______________________________________________________________________________
+bool AssignmentHistoryStream::Next()
+{
+    if(mPageIndex + 1 < mPage.size()) {
+        mPageIndex++;
+        mCursor = mPage[mPageIndex].GetCursor();
+        return true;
+    }
+
+    mPage.clear();
+    mPageIndex = 0;
+    if(mIsOver) return false;
+
+    mPage = mProvider.GetAssignmentHistoryPage(mPath, mVariation, mRun, mCursor, mPageSize);
+    mPageCount++;
+    mIsOver = mPage.size() < mPageSize;
+    if(mPage.empty()) {
+        mIsOver = true;
+        return false;
+    }
+    mCursor = mPage.front().GetCursor();
+    return true;
+}
+
+
+//______________________________________________________________________________
+const AssignmentHistoryRecord& AssignmentHistoryStream::Get() const
+{
+    if(mPageIndex >= mPage.size()) {
+        throw std::logic_error("ccdb::AssignmentHistoryStream::Get => There is no current record. Call Next first");
+    }
+    return mPage[mPageIndex];
+}
+
+
+//______________________________________________________________________________
+std::shared_ptr<const VaultData> AssignmentHistoryStream::LoadVault() const
+{
+    return mProvider.GetConstantSetVault(Get().ConstantSetId);
+}
+
+
+//______________________________________________________________________________
+void AssignmentHistoryStream::Seek(const AssignmentHistoryCursor& cursor)
+{
+    mPage.clear();
+    mPageIndex = 0;
+    mIsOver = false;
+    mCursor = cursor;
+}
+
+}
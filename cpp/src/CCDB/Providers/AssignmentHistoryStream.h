@@ -0,0 +1,81 @@
+#ifndef _AssignmentHistoryStream_
+#define _AssignmentHistoryStream_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include "CCDB/Providers/DataProvider.h"
+
+namespace ccdb
+{
+    /** @brief Reads the assignment history of a type table record by record, oldest first
+     *
+     * Records are fetched by pages of DataProvider::GetAssignmentHistoryPage, so memory doesn't grow with the history
+     * and the metadata can be scanned without reading constants. The vault of the current record is read
+     * only if LoadVault is called. The stream may be resumed later, even by another process, from GetCursor().
+     *
+     * Usage:
+     *    AssignmentHistoryStream stream(provider, "/test/test_vars/test_table");
+     *    while(stream.Next()) {
+     *        if(stream.Get().Comment.find("fix") != string::npos) values = stream.LoadVault()->GetValues();
+     *    }
+     */
+    class AssignmentHistoryStream
+    {
+    public:
+        static const size_t cDefaultPageSize = 500;
+
+        /** @brief The stream is positioned before the first record, nothing is read until Next
+         *
+         * @param [in] provider   - connected provider. It must live while the stream is used
+         * @param [in] path       - type table path
+         * @param [in] variation  - variation name. Empty - all variations
+         * @param [in] run        - only assignments which run range contains the run. Negative - all runs
+         * @param [in] pageSize   - records fetched by one query
+         * @exception std::logic_error if pageSize is 0
+         */
+        AssignmentHistoryStream(DataProvider& provider, const std::string& path, const std::string& variation = std::string(),
+                                int run = -1, size_t pageSize = cDefaultPageSize);
+
+        /** @brief Moves to the next record, fetching the next page if needed. false - the history is over
+         *
+         * @exception std::runtime_error if the table or the variation is not found
+         */
+        bool Next();
+
+        /** @brief Current record. Valid after Next returned true
+         *  @exception std::logic_error if there is no current record
+         */
+        const AssignmentHistoryRecord& Get() const;
+
+        /** @brief Reads constants of the current record. @see DataProvider::GetConstantSetVault */
+        std::shared_ptr<const VaultData> LoadVault() const;
+
+        /** @brief Position after the current record. Give it to Seek (or to a new stream) to go on from here */
+        AssignmentHistoryCursor GetCursor() const { return mCursor; }
+
+        /** @brief Drops the fetched page, the next record will be the one after the cursor */
+        void Seek(const AssignmentHistoryCursor& cursor);
+
+        /** @brief Number of queries made to get pages */
+        uint64_t GetPageCount() const { return mPageCount; }
+
+    private:
+        DataProvider& mProvider;
+        std::string mPath;
+        std::string mVariation;
+        int mRun;
+        size_t mPageSize;
+
+        std::vector<AssignmentHistoryRecord> mPage;
+        size_t mPageIndex;                      /// Index of the current record in mPage. mPage.size() - none
+        bool mIsOver;                           /// The last fetched page was not full, there is nothing after it
+        AssignmentHistoryCursor mCursor;
+        uint64_t mPageCount;
+    };
+}
+
+#endif //_AssignmentHistoryStream_
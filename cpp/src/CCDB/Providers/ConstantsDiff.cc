@@ -0,0 +1,264 @@
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <map>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+#include "CCDB/Providers/ConstantsDiff.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+namespace
+{
+    bool IsSignedColumn(ConstantsTypeColumn::ColumnTypes type)
+    {
+        return type == ConstantsTypeColumn::cIntColumn || type == ConstantsTypeColumn::cLongColumn;
+    }
+
+    bool IsUnsignedColumn(ConstantsTypeColumn::ColumnTypes type)
+    {
+        return type == ConstantsTypeColumn::cUIntColumn || type == ConstantsTypeColumn::cULongColumn;
+    }
+
+    /** Values of the column, row by row, into a contiguous array */
+    void ReadColumn(const vector<string>& values, size_t column, size_t columnsCount, vector<double>& target)
+    {
+        for(size_t row = 0; row < target.size(); row++) {
+            target[row] = strtod(values[row * columnsCount + column].c_str(), nullptr);
+        }
+    }
+
+    void ReadColumn(const vector<string>& values, size_t column, size_t columnsCount, vector<int64_t>& target)
+    {
+        for(size_t row = 0; row < target.size(); row++) {
+            target[row] = strtoll(values[row * columnsCount + column].c_str(), nullptr, 10);
+        }
+    }
+
+    void ReadColumn(const vector<string>& values, size_t column, size_t columnsCount, vector<uint64_t>& target)
+    {
+        for(size_t row = 0; row < target.size(); row++) {
+            target[row] = strtoull(values[row * columnsCount + column].c_str(), nullptr, 10);
+        }
+    }
+
+    /** Integers are compared exactly. The difference is taken in 64 bits, so it is exact too before it is made double */
+    template<typename T>
+    void CompareIntegers(const vector<T>& a, const vector<T>& b, double absoluteTolerance, double relativeTolerance,
+                         vector<double>& absolute, vector<double>& relative, vector<unsigned char>& isChanged, vector<unsigned char>& isDifferent)
+    {
+        for(size_t row = 0; row < a.size(); row++) {
+            uint64_t magnitude = a[row] > b[row] ? uint64_t(a[row]) - uint64_t(b[row]) : uint64_t(b[row]) - uint64_t(a[row]);
+            double delta = static_cast<double>(magnitude);
+            double scale = std::max(std::fabs(static_cast<double>(a[row])), std::fabs(static_cast<double>(b[row])));
+            bool changed = a[row] != b[row];
+            absolute[row] = delta;
+            relative[row] = scale > 0 ? delta / scale : 0.0;
+            isChanged[row] = changed;
+            isDifferent[row] = changed & !(delta <= absoluteTolerance) & !(delta <= relativeTolerance * scale);
+        }
+    }
+
+    bool HasSameColumns(const TableDescriptor& left, const TableDescriptor& right)
+    {
+        return left.GetColumnNames() == right.GetColumnNames() && left.GetColumnTypeStrings() == right.GetColumnTypeStrings();
+    }
+}
+
+
+//______________________________________________________________________________
+ConstantsDiff::ConstantsDiff(const ConstantsDiffOptions& options):
+    mOptions(options)
+{
+}
+
+
+//______________________________________________________________________________
+TableDiff ConstantsDiff::Compare(const TableDescriptor& columns, const VaultData& left, const VaultData& right) const
+{
+    TableDiff diff;
+    if(left.GetHash() == right.GetHash() && left.HasSameData(right)) return diff;
+
+    const vector<string>& leftValues = left.GetValues();
+    const vector<string>& rightValues = right.GetValues();
+    size_t columnsCount = columns.GetColumnsCount();
+    if(columnsCount == 0 || leftValues.size() != rightValues.size() || leftValues.size() % columnsCount != 0) {
+        diff.Result = TableDiff::cIncompatible;
+        return diff;
+    }
+
+    size_t rowsCount = leftValues.size() / columnsCount;
+    diff.ComparedCells = leftValues.size();
+
+    // Column arrays are reused for all columns
+    vector<double> a(rowsCount), b(rowsCount), absolute(rowsCount), relative(rowsCount);
+    vector<int64_t> signedA, signedB;
+    vector<uint64_t> unsignedA, unsignedB;
+    vector<unsigned char> isChanged(rowsCount), isDifferent(rowsCount);
+    const double absoluteTolerance = mOptions.AbsoluteTolerance;
+    const double relativeTolerance = mOptions.RelativeTolerance;
+
+    for(size_t column = 0; column < columnsCount; column++) {
+        auto type = columns.GetColumns()[column].Type;
+        bool isNumeric = IsSignedColumn(type) || IsUnsignedColumn(type) || type == ConstantsTypeColumn::cDoubleColumn;
+        size_t changedCount = 0;
+
+        if(IsSignedColumn(type)) {
+            signedA.resize(rowsCount);
+            signedB.resize(rowsCount);
+            ReadColumn(leftValues, column, columnsCount, signedA);
+            ReadColumn(rightValues, column, columnsCount, signedB);
+            CompareIntegers(signedA, signedB, absoluteTolerance, relativeTolerance, absolute, relative, isChanged, isDifferent);
+        }
+        else if(IsUnsignedColumn(type)) {
+            unsignedA.resize(rowsCount);
+            unsignedB.resize(rowsCount);
+            ReadColumn(leftValues, column, columnsCount, unsignedA);
+            ReadColumn(rightValues, column, columnsCount, unsignedB);
+            CompareIntegers(unsignedA, unsignedB, absoluteTolerance, relativeTolerance, absolute, relative, isChanged, isDifferent);
+        }
+        else if(isNumeric) {
+            ReadColumn(leftValues, column, columnsCount, a);
+            ReadColumn(rightValues, column, columnsCount, b);
+
+            // No branches here, so the loop is vectorized. A NaN is equal to a NaN and differs from any number
+            for(size_t row = 0; row < rowsCount; row++) {
+                double delta = std::fabs(a[row] - b[row]);
+                double scale = std::max(std::fabs(a[row]), std::fabs(b[row]));
+                bool bothNaN = (a[row] != a[row]) & (b[row] != b[row]);
+                bool changed = (a[row] != b[row]) & !bothNaN;
+                absolute[row] = delta;
+                relative[row] = scale > 0 ? delta / scale : 0.0;
+                isChanged[row] = changed;
+                isDifferent[row] = changed & !(delta <= absoluteTolerance) & !(delta <= relativeTolerance * scale);
+            }
+        }
+        else {
+            for(size_t row = 0; row < rowsCount; row++) {
+                size_t index = row * columnsCount + column;
+                isChanged[row] = leftValues[index] != rightValues[index];
+                isDifferent[row] = isChanged[row];
+            }
+        }
+
+        for(size_t row = 0; row < rowsCount; row++) changedCount += isChanged[row];
+        if(changedCount == 0) continue;
+        diff.ChangedCells += changedCount;
+
+        // Changed cells are few, they are looked at one by one
+        size_t detailsOfColumn = 0;
+        for(size_t row = 0; row < rowsCount; row++) {
+            if(!isChanged[row]) continue;
+            if(isNumeric) {
+                if(absolute[row] > diff.MaxAbsolute) diff.MaxAbsolute = absolute[row];
+                if(relative[row] > diff.MaxRelative) diff.MaxRelative = relative[row];
+            }
+            if(!isDifferent[row]) continue;
+
+            diff.DifferentCells++;
+            if(detailsOfColumn >= mOptions.MaxDetails) continue;
+            detailsOfColumn++;
+
+            CellDifference cell;
+            cell.Row = row;
+            cell.Column = column;
+            cell.Left = leftValues[row * columnsCount + column];
+            cell.Right = rightValues[row * columnsCount + column];
+            cell.IsNumeric = isNumeric;
+            if(isNumeric) {
+                cell.Absolute = absolute[row];
+                cell.Relative = relative[row];
+            }
+            diff.Details.push_back(std::move(cell));
+        }
+    }
+
+    // Columns were walked one by one, details are given row by row
+    std::sort(diff.Details.begin(), diff.Details.end(), [](const CellDifference& x, const CellDifference& y) {
+        return x.Row != y.Row ? x.Row < y.Row : x.Column < y.Column;
+    });
+    if(diff.Details.size() > mOptions.MaxDetails) diff.Details.resize(mOptions.MaxDetails);
+
+    if(diff.DifferentCells > 0) diff.Result = TableDiff::cDifferent;
+    else if(diff.ChangedCells > 0) diff.Result = TableDiff::cWithinTolerance;
+    return diff;
+}
+
+
+//______________________________________________________________________________
+TableDiff ConstantsDiff::Compare(const Assignment& left, const Assignment& right) const
+{
+    auto leftColumns = left.GetTableDescriptor();
+    auto rightColumns = right.GetTableDescriptor();
+    if(!leftColumns || !rightColumns || leftColumns->GetColumnsCount() == 0 || rightColumns->GetColumnsCount() == 0) {
+        throw std::logic_error("ccdb::ConstantsDiff::Compare => Assignments must have type tables with columns");
+    }
+    if(!left.GetVault() || !right.GetVault()) {
+        throw std::logic_error("ccdb::ConstantsDiff::Compare => Assignments must have data");
+    }
+
+    TableDiff diff;
+    if(HasSameColumns(*leftColumns, *rightColumns)) {
+        diff = Compare(*leftColumns, *left.GetVault(), *right.GetVault());
+    }
+    else {
+        diff.Result = TableDiff::cIncompatible;
+    }
+
+    diff.Path = left.GetTypeTable()->GetFullPath();
+    diff.Left = left.GetIdentity();
+    diff.Right = right.GetIdentity();
+    return diff;
+}
+
+
+//______________________________________________________________________________
+SnapshotDiffSummary ConstantsDiff::CompareSnapshots(DataProvider& provider, const CalibrationSnapshotKey& left, const CalibrationSnapshotKey& right,
+                                                    const std::function<void(const TableDiff&)>& onTable) const
+{
+    vector<unique_ptr<Assignment>> leftAssignments, rightAssignments;
+    for(auto assignment: provider.GetLatestAssignments(left.Run, left.Time, left.Variation, true)) {
+        leftAssignments.emplace_back(assignment);
+    }
+    for(auto assignment: provider.GetLatestAssignments(right.Run, right.Time, right.Variation, true)) {
+        rightAssignments.emplace_back(assignment);
+    }
+
+    // path => (left, right)
+    map<string, pair<const Assignment*, const Assignment*>> tables;
+    for(const auto& assignment: leftAssignments) tables[assignment->GetTypeTable()->GetFullPath()].first = assignment.get();
+    for(const auto& assignment: rightAssignments) tables[assignment->GetTypeTable()->GetFullPath()].second = assignment.get();
+
+    SnapshotDiffSummary summary;
+    for(const auto& table: tables) {
+        const Assignment* leftAssignment = table.second.first;
+        const Assignment* rightAssignment = table.second.second;
+
+        TableDiff diff;
+        if(leftAssignment && rightAssignment) {
+            diff = Compare(*leftAssignment, *rightAssignment);
+        }
+        else {
+            diff.Path = table.first;
+            diff.Result = leftAssignment ? TableDiff::cOnlyLeft : TableDiff::cOnlyRight;
+            if(leftAssignment) diff.Left = leftAssignment->GetIdentity();
+            if(rightAssignment) diff.Right = rightAssignment->GetIdentity();
+        }
+
+        summary.Tables++;
+        if(diff.Result == TableDiff::cIdentical) summary.IdenticalTables++;
+        else if(diff.Result == TableDiff::cWithinTolerance) summary.WithinToleranceTables++;
+        else summary.DifferentTables++;
+        summary.DifferentCells += diff.DifferentCells;
+
+        onTable(diff);
+    }
+    return summary;
+}
+
+}
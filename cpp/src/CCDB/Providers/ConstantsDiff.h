@@ -0,0 +1,138 @@
+#ifndef _ConstantsDiff_
+#define _ConstantsDiff_
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <ctime>
+#include <cstddef>
+#include <cstdint>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Model/Assignment.h"
+#include "CCDB/Model/TableDescriptor.h"
+#include "CCDB/Model/VaultData.h"
+#include "CCDB/Providers/DataProvider.h"
+
+namespace ccdb
+{
+    /** @brief What ConstantsDiff reports as a difference */
+    struct ConstantsDiffOptions
+    {
+        /** A numeric cell differs if |left - right| > AbsoluteTolerance
+         *  and |left - right| > RelativeTolerance * max(|left|, |right|). 0 and 0 - any change */
+        double AbsoluteTolerance = 0;
+        double RelativeTolerance = 0;
+        size_t MaxDetails = 1000;       /// Cells listed in TableDiff::Details. Differences are counted anyway
+    };
+
+
+    /** @brief A cell that differs */
+    struct CellDifference
+    {
+        size_t Row = 0;
+        size_t Column = 0;
+        std::string Left;               /// Values as they are stored
+        std::string Right;
+        bool IsNumeric = false;         /// Absolute and Relative are set only for numeric columns
+        double Absolute = 0;            /// |left - right|
+        double Relative = 0;            /// |left - right| / max(|left|, |right|)
+    };
+
+
+    /** @brief Comparison of one table */
+    struct TableDiff
+    {
+        enum Results
+        {
+            cIdentical,             /// The same values. Not compared if vaults are the same
+            cWithinTolerance,       /// Values differ, but not more than the tolerance
+            cDifferent,             /// Some cells differ more than the tolerance
+            cIncompatible,          /// Different columns or rows count. Cells are not compared
+            cOnlyLeft,              /// The right side has no assignment of the table
+            cOnlyRight              /// The left side has no assignment of the table
+        };
+
+        std::string Path;               /// Type table path, if it is known
+        Results Result = cIdentical;
+        AssignmentIdentity Left;
+        AssignmentIdentity Right;
+        size_t ComparedCells = 0;
+        size_t ChangedCells = 0;        /// Cells with different values, including those within the tolerance
+        size_t DifferentCells = 0;      /// Cells that differ more than the tolerance
+        double MaxAbsolute = 0;         /// Over changed numeric cells
+        double MaxRelative = 0;
+        std::vector<CellDifference> Details;    /// First MaxDetails different cells, row by row
+
+        bool IsDifferent() const { return Result != cIdentical && Result != cWithinTolerance; }
+    };
+
+
+    /** @brief Run, variation and time that select constants of all tables, @see DataProvider::GetLatestAssignments */
+    struct CalibrationSnapshotKey
+    {
+        int Run = 0;
+        std::string Variation = "default";
+        time_t Time = 0;                /// 0 - the latest
+    };
+
+
+    /** @brief Totals of ConstantsDiff::CompareSnapshots */
+    struct SnapshotDiffSummary
+    {
+        size_t Tables = 0;
+        size_t IdenticalTables = 0;
+        size_t WithinToleranceTables = 0;
+        size_t DifferentTables = 0;     /// cDifferent, cIncompatible, cOnlyLeft and cOnlyRight
+        size_t DifferentCells = 0;
+    };
+
+
+    /** @brief Per cell differences of constants between two assignments or two whole run snapshots
+     *
+     * Assignments with the same vault are reported identical without looking at values. Otherwise numeric columns
+     * are parsed once into contiguous arrays, column by column, and compared by plain loops
+     * without branches, which the compiler vectorizes. Double columns are parsed as doubles, integer columns
+     * as 64 bit integers, so they are compared exactly. Text and bool columns are compared as text.
+     *
+     * Usage:
+     *    ConstantsDiffOptions options;
+     *    options.RelativeTolerance = 1e-6;
+     *    ConstantsDiff diff(options);
+     *    TableDiff table = diff.Compare(*assignmentA, *assignmentB);
+     *
+     *    CalibrationSnapshotKey a, b;
+     *    a.Run = b.Run = 1000; b.Variation = "mc";
+     *    diff.CompareSnapshots(provider, a, b, [](const TableDiff& table) { ... });
+     */
+    class ConstantsDiff
+    {
+    public:
+        explicit ConstantsDiff(const ConstantsDiffOptions& options = ConstantsDiffOptions());
+
+        const ConstantsDiffOptions& GetOptions() const { return mOptions; }
+
+        /** @brief Compares values of two vaults of a table with these columns */
+        TableDiff Compare(const TableDescriptor& columns, const VaultData& left, const VaultData& right) const;
+
+        /** @brief Compares two assignments of a table. Identities and the path are filled from the assignments
+         *
+         * @exception std::logic_error if an assignment has no vault or no type table columns
+         */
+        TableDiff Compare(const Assignment& left, const Assignment& right) const;
+
+        /** @brief Compares all tables of two snapshots, gives the result of each table to onTable, ordered by path
+         *
+         * Tables are read by DataProvider::GetLatestAssignments, so a table that has no data on one side
+         * is reported as cOnlyLeft or cOnlyRight.
+         * @return totals over all tables
+         */
+        SnapshotDiffSummary CompareSnapshots(DataProvider& provider, const CalibrationSnapshotKey& left, const CalibrationSnapshotKey& right,
+                                             const std::function<void(const TableDiff&)>& onTable) const;
+
+    private:
+        ConstantsDiffOptions mOptions;
+    };
+}
+
+#endif //_ConstantsDiff_
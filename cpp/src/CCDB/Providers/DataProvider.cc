@@ -18,13 +18,16 @@ DataProvider::DataProvider()
 {
     //Constructor
     mConnectionString="";
+    mRootDir = nullptr;
+    mDirsAreLoaded = false;
 }
 
 
 //______________________________________________________________________________
 DataProvider::~DataProvider()
 {
-	//Guess what is it?
+	//Directories, type tables, columns and variations are freed by arenas. The root directory is not in the arena
+	delete mRootDir;
 }
 
 
@@ -81,7 +84,7 @@ Directory* DataProvider::GetDirectory( const string& path )
 	UpdateDirectoriesIfNeeded();
 
 	//search full path
-	map<string, Directory*>::iterator it = mDirectoriesByFullPath.find(string(path));
+	auto it = mDirectoriesByFullPath.find(path);
 
 	//found?
 	if(it == mDirectoriesByFullPath.end()) return NULL; //not found
@@ -89,6 +92,19 @@ Directory* DataProvider::GetDirectory( const string& path )
 }
 
 
+//______________________________________________________________________________
+string DataProvider::GetTypeTablePath(dbkey_t directoryId, const string& name)
+{
+	UpdateDirectoriesIfNeeded();
+
+	// Directories are not reloaded here: that would break directory pointers of existing type tables
+	if(directoryId == 0) return PathUtils::CombinePath(mRootDir->GetFullPath(), name);
+	auto dirIter = mDirectoriesById.find(directoryId);
+	if(dirIter == mDirectoriesById.end()) return string();
+	return PathUtils::CombinePath(dirIter->second->GetFullPath(), name);
+}
+
+
 //______________________________________________________________________________
 void DataProvider::BuildDirectoryDependencies()
 {
@@ -98,6 +114,10 @@ void DataProvider::BuildDirectoryDependencies()
 
 	//clear the full path dictionary
 	mDirectoriesByFullPath.clear();
+
+	//cached tables point to the old directories. Both stay alive in the arenas, but tables are read again on request
+	mTypeTablesByPath.clear();
+	mTypeTablesById.clear();
 	mDirectoriesByFullPath[mRootDir->GetFullPath()] = mRootDir;
 
 	//begin loop through the directories
@@ -129,10 +149,11 @@ void DataProvider::BuildDirectoryDependencies()
 			// so we place it to root directory
 			mRootDir->AddSubdirectory(*dirIter);
 		}
-
-		//add to our full path map
-		mDirectoriesByFullPath[dir->GetFullPath()] = dir;
 	}
+
+	//full paths are built by AddSubdirectory, they are final when all directories are linked
+	mDirectoriesByFullPath.reserve(mDirectories.size() + 1);
+	for(auto dir: mDirectories) mDirectoriesByFullPath[dir->GetFullPath()] = dir;
 }
 
 
@@ -173,7 +194,14 @@ ConstantsTypeTable * DataProvider::GetConstantsTypeTable(const string& path, boo
      * @param  [in] parentDir directory that contains type table
      * @return new object of ConstantsTypeTable
      */
-    
+
+	//Tables that are already read are found by the full path with one lookup
+	if(mDirsAreLoaded)
+	{
+		ConstantsTypeTable* table = FindCachedTypeTable(path);
+		if(table) return table;
+	}
+
 	//get directory path
 	string dirPath = PathUtils::ExtractDirectory(path);
 
@@ -190,5 +218,121 @@ ConstantsTypeTable * DataProvider::GetConstantsTypeTable(const string& path, boo
 }
 
 
+//______________________________________________________________________________
+ConstantsTypeTable* DataProvider::FindCachedTypeTable(const string& fullPath)
+{
+	auto iter = mTypeTablesByPath.find(fullPath);
+	return iter == mTypeTablesByPath.end() ? nullptr : iter->second;
+}
+
+
+//______________________________________________________________________________
+ConstantsTypeTable* DataProvider::FindCachedTypeTable(dbkey_t id)
+{
+	auto iter = mTypeTablesById.find(id);
+	return iter == mTypeTablesById.end() ? nullptr : iter->second;
+}
+
+
+//______________________________________________________________________________
+void DataProvider::AddCachedTypeTable(ConstantsTypeTable* table)
+{
+	mTypeTablesByPath[table->GetFullPath()] = table;
+	mTypeTablesById[table->GetId()] = table;
+}
+
+
+//______________________________________________________________________________
+RunRange* DataProvider::GetCachedRunRange(dbkey_t id, int runMin, int runMax)
+{
+	auto cached = mRunRangesById.find(id);
+	if(cached != mRunRangesById.end()) return cached->second;
+
+	RunRange* runRange = mRunRangesArena.Create();
+	runRange->SetId(id);
+	runRange->SetRange(runMin, runMax);
+	mRunRangesById[id] = runRange;
+	return runRange;
+}
+
+
+//______________________________________________________________________________
+size_t DataProvider::GetCatalogObjectsCount() const
+{
+	return mDirectoriesArena.GetCount() + mTypeTablesArena.GetCount() + mColumnsArena.GetCount() +
+	       mVariationsArena.GetCount() + mRunRangesArena.GetCount();
+}
+
+
+//______________________________________________________________________________
+size_t DataProvider::GetCatalogRetainedBytes() const
+{
+	size_t bytes = mTypeTablesArena.GetRetainedBytes() + mColumnsArena.GetRetainedBytes() + mVariationsArena.GetRetainedBytes();
+	bytes += mRunRangesArena.GetCount() * sizeof(RunRange);
+	bytes += mDirectoriesArena.GetRetainedBytes();
+	return bytes;
+}
+
+
+//______________________________________________________________________________
+AssignmentIdentity DataProvider::GetAssignmentIdentity(int run, const string& path, time_t time, const string& variation)
+{
+	std::unique_ptr<Assignment> assignment(GetAssignmentShort(run, path, time, variation, false));
+	return assignment ? assignment->GetIdentity() : AssignmentIdentity();
+}
+
+
+//______________________________________________________________________________
+std::future<Assignment*> DataProvider::GetAssignmentShortAsync(int run, const string& path, time_t time, const string& variation, bool loadColumns)
+{
+	std::promise<Assignment*> promise;
+	try
+	{
+		promise.set_value(GetAssignmentShort(run, path, time, variation, loadColumns));
+	}
+	catch (...)
+	{
+		promise.set_exception(std::current_exception());
+	}
+	return promise.get_future();
+}
+
+
+//______________________________________________________________________________
+std::vector<Assignment *> DataProvider::GetLatestAssignments(int run, time_t time, const string& variation, bool loadColumns)
+{
+	//paths of all tables
+	std::vector<string> paths;
+	for(auto table: GetAllConstantsTypeTables(false))
+	{
+		paths.push_back(table->GetFullPath());
+	}
+
+	//one request per table
+	std::vector<Assignment *> assignments;
+	try
+	{
+		for(const auto& path: paths)
+		{
+			Assignment *assignment = GetAssignmentShort(run, path, time, variation, loadColumns);
+			if(assignment) assignments.push_back(assignment);
+		}
+	}
+	catch (...)
+	{
+		for(auto assignment: assignments) delete assignment;
+		throw;
+	}
+	return assignments;
+}
+
+
+//______________________________________________________________________________
+bool DataProvider::IsChangedSinceLastCheck()
+{
+	return true;
+}
+
+
 } //namespace ccdb
 
@@ -4,12 +4,16 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <functional>
+#include <future>
 
 #include "CCDB/Model/Assignment.h"
 #include "CCDB/Model/ConstantsTypeTable.h"
 #include "CCDB/Model/Directory.h"
 #include "CCDB/Model/RunRange.h"
 #include "CCDB/Model/Variation.h"
+#include "CCDB/Helpers/ObjectArena.h"
 
 
 
@@ -44,13 +48,61 @@
  *  | MySQL Database |        |     SQLite     |    -   Data storages 
  *  <________________>        <________________>
  *
- *
- *
- *
+ * Ownership:
+ * Directories, type tables, their columns, variations and run ranges of assignments that the provider returns
+ * are owned by the provider.
+ * They are created once, kept in provider arenas and are freed all together when the provider is destroyed.
+ * Users must not delete them. Assignments are owned by users, their data (VaultData) is reference counted.
  */
 namespace ccdb
 {
 
+    /** @brief Assignment added to the database. Change detection gives them to find out what is outdated */
+    struct AssignmentChange
+    {
+        dbkey_t AssignmentId = 0;
+        dbkey_t TypeTableId = 0;
+        std::string TablePath;          /// Full path of the type table. Empty if its directory was created after directories were loaded
+        std::string Variation;          /// Variation name
+        int RunMin = 0;
+        int RunMax = 0;
+        time_t Created = 0;             /// UNIX time
+    };
+
+
+    /** @brief Position in the assignment history. Pages are keyed by (created, id) so rows added later don't shift them */
+    struct AssignmentHistoryCursor
+    {
+        time_t Created = 0;             /// UNIX time of the last seen assignment
+        dbkey_t AssignmentId = 0;       /// Id of the last seen assignment. 0 - the history start
+
+        bool IsAtStart() const { return AssignmentId == 0; }
+    };
+
+
+    /** @brief Assignment of a history page. Only metadata, the vault is loaded by DataProvider::GetConstantSetVault */
+    struct AssignmentHistoryRecord
+    {
+        dbkey_t AssignmentId = 0;
+        time_t Created = 0;             /// UNIX time
+        std::string Comment;
+        int RunMin = 0;
+        int RunMax = 0;
+        dbkey_t VariationId = 0;
+        std::string Variation;          /// Variation name
+        dbkey_t ConstantSetId = 0;
+
+        /** @brief Cursor to continue the history right after this record */
+        AssignmentHistoryCursor GetCursor() const
+        {
+            AssignmentHistoryCursor cursor;
+            cursor.Created = Created;
+            cursor.AssignmentId = AssignmentId;
+            return cursor;
+        }
+    };
+
+
     class DataProvider
     {
     public:
@@ -89,23 +141,27 @@ namespace ccdb
         /** @brief Reads all directories from DB
          *
          * Explicitly forces to load directories from DB and build directory structure
-         * (!) At this implementation all existing directories references will be deleted,
-         * thus  references to them will become broken
+         * Directories of previous loads are not deleted, so existing references stay valid,
+         * but they are not in the new directory tree
          * @return   bool
          */
         virtual void LoadDirectories() = 0;
 
         /** @brief Gets ConstantsType information from the DB
+         *
+         * The table is read once and then is taken from the provider cache.
+         * Columns are loaded before the table is cached whatever loadColumns is, so cached tables
+         * are not changed afterwards and could be read from many threads.
          *
          * @param  [in] name name of ConstantsTypeTable
          * @param  [in] parentDir directory that contains type table
-         * @return new object of ConstantsTypeTable
+         * @return ConstantsTypeTable owned by the provider or NULL if not found. Must not be deleted
          */
         virtual ConstantsTypeTable * GetConstantsTypeTable(const string& name, Directory *parentDir, bool loadColumns)=0;
 
 
-        /** @brief gets all type tables from DB
-         * @return bool
+        /** @brief gets all type tables from DB. Columns of tables that are not cached yet are read by one query
+         * @return type tables owned by the provider. Must not be deleted
          */
         virtual std::vector<ConstantsTypeTable *> GetAllConstantsTypeTables(bool loadColumns)=0;
 
@@ -130,6 +186,109 @@ namespace ccdb
         */
         virtual Assignment* GetAssignmentShort(int run, const string& path, time_t time, const string& variation, bool loadColumns)=0;
 
+        /** @brief Identity of the assignment GetAssignmentShort would give, without reading its constants
+        *
+        * Gives AssignmentId and ConstantSetId. VaultHash is 0 if the provider doesn't read the vault.
+        * The default implementation gets the whole assignment with GetAssignmentShort.
+        * @return the identity. AssignmentId is 0 if there is no assignment
+        */
+        virtual AssignmentIdentity GetAssignmentIdentity(int run, const string& path, time_t time, const string& variation);
+
+        /** @brief Lists assignments of the type table in the variation, newest first
+        *
+        * Rows are turned into Assignment objects while they are read from the database,
+        * so memory doesn't grow with the number of listed assignments.
+        * The Assignment and its RunRange given to onAssignment are deleted right after the call.
+        * The variation parents are not looked into. onAssignment must not make other requests to the provider.
+        *
+        * @param [in] path - object path
+        * @param [in] variation - variation name
+        * @param [in] run - only assignments which run range contains the run. Negative - all runs
+        * @param [in] time - only assignments created equal or earlier than the timestamp. 0 - any time
+        * @param [in] onAssignment - called for each assignment. Return false to stop the listing
+        * @return number of assignments given to onAssignment
+        */
+        virtual uint64_t VisitAssignments(const string& path, const string& variation, int run, time_t time,
+                                          const std::function<bool(Assignment&)>& onAssignment)=0;
+
+        /** @brief Gets the latest assignments of all type tables for the run
+        *
+        * Gives the same assignments as GetAssignmentShort called for each type table,
+        * including the fallback to the parent variations. Type tables that have no data for the run are skipped.
+        * The default implementation does exactly that; providers for remote databases
+        * override it to get everything in a few round trips.
+        *
+        * @param [in] run - run number
+        * @param [in] time - timestamp, data that is equal or earlier in time than that timestamp is returned. 0 - latest
+        * @param [in] variation - variation name
+        * @param [in] loadColumns - load columns of type tables
+        * @return new Assignment objects with type tables and variations set. The caller owns them
+        */
+        virtual std::vector<Assignment *> GetLatestAssignments(int run, time_t time, const string& variation, bool loadColumns);
+
+        /** @brief Asynchronous version of GetAssignmentShort
+        *
+        * Many requests could be started before waiting for any of them, so their round trips to the database overlap.
+        * The default implementation runs GetAssignmentShort right away and returns a ready future.
+        * Errors are rethrown by future::get()
+        */
+        virtual std::future<Assignment*> GetAssignmentShortAsync(int run, const string& path, time_t time, const string& variation, bool loadColumns);
+
+        /** @brief Id of the newest assignment. 0 if there are no assignments
+        *
+        * Assignment ids only grow, so together with GetAssignmentsAfter it tells what was added since some moment.
+        * If it is less than it was before, assignments were deleted.
+        */
+        virtual dbkey_t GetLastAssignmentId()=0;
+
+        /** @brief Assignments with id greater than assignmentId, oldest first
+        *
+        * @param [in] assignmentId - usually a value returned by GetLastAssignmentId some time ago
+        * @return what was added: type tables, variations and run ranges
+        */
+        virtual std::vector<AssignmentChange> GetAssignmentsAfter(dbkey_t assignmentId)=0;
+
+        /** @brief Page of the type table assignment history, oldest first, without constants
+        *
+        * Rows are ordered by (created, id) and the page starts right after the cursor (keyset pagination),
+        * so each page costs the same however deep in the history it is. Vaults are not read,
+        * @see GetConstantSetVault to load them for the records that need it. @see AssignmentHistoryStream
+        *
+        * @param [in] path - object path
+        * @param [in] variation - variation name. Empty - all variations. The variation parents are not looked into
+        * @param [in] run - only assignments which run range contains the run. Negative - all runs
+        * @param [in] after - the cursor of the last record of the previous page. A default one - from the start
+        * @param [in] limit - maximum records in the page
+        * @exception std::runtime_error if the type table or the variation is not found
+        */
+        virtual std::vector<AssignmentHistoryRecord> GetAssignmentHistoryPage(const string& path, const string& variation, int run,
+                                                                              const AssignmentHistoryCursor& after, size_t limit)=0;
+
+        /** @brief Assignments of the type table in the variation which run ranges overlap runMin..runMax, without constants
+        *
+        * Only ids, creation times, run ranges and constant set ids are read, so the whole history of a table is cheap
+        * to scan. @see GetConstantSetVault to load the vaults that are needed. Comment is not filled.
+        * The variation parents are not looked into.
+        *
+        * @param [in] path - object path
+        * @param [in] variation - variation name
+        * @param [in] runMin, runMax - runs, both included
+        * @return records ordered by assignment id
+        * @exception std::runtime_error if the type table or the variation is not found
+        */
+        virtual std::vector<AssignmentHistoryRecord> GetAssignmentRecords(const string& path, const string& variation, int runMin, int runMax)=0;
+
+        /** @brief Data blob of the constant set by its id. NULL if there is no such constant set */
+        virtual std::shared_ptr<const VaultData> GetConstantSetVault(dbkey_t constantSetId)=0;
+
+        /** @brief Quick check if the database could have been changed since the previous call
+        *
+        * Providers that can learn it without queries to tables (like SQLite file version) override it,
+        * so polling doesn't cost anything while nothing is written. The first call and
+        * the default implementation return true, which means "ask GetLastAssignmentId".
+        */
+        virtual bool IsChangedSinceLastCheck();
+
 
 
 
@@ -165,6 +324,9 @@ namespace ccdb
         virtual Directory * const GetRootDirectory();
 
 
+        /** @brief Full path of the type table by its directory id and name. Empty if the directory is not loaded */
+        string GetTypeTablePath(dbkey_t directoryId, const string& name);
+
         void BuildDirectoryDependencies();  /// Builds directory relational structure.
         void UpdateDirectoriesIfNeeded();   /// Update directories structure if this is required
 
@@ -177,10 +339,19 @@ namespace ccdb
         /** @brief Gets ConstantsType information from the DB
          *
          * @param  [in] path absolute path of the type table
-         * @return new object of ConstantsTypeTable
+         * @return ConstantsTypeTable owned by the provider or NULL if not found. Must not be deleted
          */
         ConstantsTypeTable * GetConstantsTypeTable(const string& path, bool loadColumns);
 
+        /** @brief Number of directories, type tables, columns, variations and run ranges the provider holds */
+        size_t GetCatalogObjectsCount() const;
+
+        /** @brief Estimated bytes of directories, type tables, columns and variations the provider holds
+         *
+         * Names are interned and kept by StringPool, see StringPool::GetRetainedBytes
+         */
+        size_t GetCatalogRetainedBytes() const;
+
 
 
         //----------------------------------------------------------------------------------------
@@ -197,9 +368,33 @@ namespace ccdb
 
     protected:
 
+        /** @brief Cached type table by full path. NULL if it is not read yet */
+        ConstantsTypeTable* FindCachedTypeTable(const string& fullPath);
+
+        /** @brief Cached type table by database id. NULL if it is not read yet */
+        ConstantsTypeTable* FindCachedTypeTable(dbkey_t id);
+
+        /** @brief New type table in the provider arena. Call AddCachedTypeTable when it is filled, columns included */
+        ConstantsTypeTable* CreateTypeTable() { return mTypeTablesArena.Create(); }
+
+        /** @brief Puts filled table to the cache, so next requests of its path don't go to the database */
+        void AddCachedTypeTable(ConstantsTypeTable* table);
+
+        /** @brief New column in the provider arena */
+        ConstantsTypeColumn* CreateColumn() { return mColumnsArena.Create(); }
+
+        /** @brief New variation in the provider arena */
+        Variation* CreateVariation() { return mVariationsArena.Create(); }
+
+        /** @brief New directory in the provider arena. Directories of previous loads stay there for tables that point to them */
+        Directory* CreateDirectoryObject() { return mDirectoriesArena.Create(); }
+
+        /** @brief Run range in the provider arena, one object for each run range id. Created on the first request */
+        RunRange* GetCachedRunRange(dbkey_t id, int runMin, int runMax);
+
         std::vector<Directory *>  mDirectories;
         std::map<dbkey_t,Directory *> mDirectoriesById;
-        std::map<string,Directory *>  mDirectoriesByFullPath;
+        std::unordered_map<string,Directory *>  mDirectoriesByFullPath;
         bool mDirsAreLoaded;                 //Directories are loaded from database
         Directory *mRootDir;                ///root directory. This directory contains all other directories. It is not stored in databases
 
@@ -208,6 +403,16 @@ namespace ccdb
 
         std::map<dbkey_t, Variation *> mVariationsById;
         std::map<std::string, Variation *> mVariationsByName;
+
+    private:
+        ObjectArena<ConstantsTypeTable> mTypeTablesArena;
+        ObjectArena<ConstantsTypeColumn> mColumnsArena;
+        ObjectArena<Variation> mVariationsArena;
+        ObjectArena<RunRange> mRunRangesArena;
+        ObjectArena<Directory> mDirectoriesArena;
+        std::unordered_map<dbkey_t, RunRange*> mRunRangesById;
+        std::unordered_map<std::string, ConstantsTypeTable*> mTypeTablesByPath;      /// Cached tables by full path
+        std::unordered_map<dbkey_t, ConstantsTypeTable*> mTypeTablesById;            /// The same tables by id
     };
 }
 #endif // _DDataProvider_
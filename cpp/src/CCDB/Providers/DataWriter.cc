@@ -0,0 +1,243 @@
+#include <stdexcept>
+
+#include "CCDB/Providers/DataWriter.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Helpers/VaultHash.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+DataWriter::DataWriter():
+    mCommitEvery(1000),
+    mAuthorId(1),
+    mIsReuseConstantSets(true),
+    mHasVaultHash(false),
+    mIsInTransaction(false),
+    mUncommittedCount(0)
+{
+}
+
+
+//______________________________________________________________________________
+DataWriter::~DataWriter()
+{
+}
+
+
+//______________________________________________________________________________
+void DataWriter::ClearCache()
+{
+    mTypeTables.clear();
+    mVariations.clear();
+    mRunRanges.clear();
+    mIsInTransaction = false;
+    mUncommittedCount = 0;
+}
+
+
+//______________________________________________________________________________
+void DataWriter::OnConnected()
+{
+    ClearCache();
+    mHasVaultHash = HasVaultHashColumn();
+}
+
+
+//______________________________________________________________________________
+uint64_t DataWriter::BackfillVaultHashes(size_t batchSize)
+{
+    if(!batchSize) batchSize = 1000;
+    Commit();
+
+    if(!mHasVaultHash) {
+        AddVaultHashColumn();
+        mHasVaultHash = true;
+    }
+
+    uint64_t updated = 0;
+    while(true) {
+        auto constantSets = SelectConstantSetsWithoutHash(batchSize);
+        if(constantSets.empty()) break;
+
+        BeginTransaction();
+        mIsInTransaction = true;
+        for(const auto& constantSet: constantSets) {
+            UpdateVaultHash(constantSet.first, VaultHashToString(HashVault(constantSet.second)));
+        }
+        CommitTransaction();
+        mIsInTransaction = false;
+        mStats.Commits++;
+        updated += constantSets.size();
+    }
+    return updated;
+}
+
+
+//______________________________________________________________________________
+dbkey_t DataWriter::GetOrCreateRunRange(int runMin, int runMax)
+{
+    if(runMin > runMax) {
+        throw std::runtime_error(fmt::format("ccdb::DataWriter::GetOrCreateRunRange => runMin {} is greater than runMax {}", runMin, runMax));
+    }
+
+    auto key = std::make_pair(runMin, runMax);
+    auto cached = mRunRanges.find(key);
+    if(cached != mRunRanges.end()) return cached->second;
+
+    dbkey_t id = FindRunRangeId(runMin, runMax);
+    if(!id) {
+        if(!mIsInTransaction) {
+            BeginTransaction();
+            mIsInTransaction = true;
+        }
+        id = InsertRunRange(runMin, runMax);
+        mStats.RunRanges++;
+    }
+    mRunRanges[key] = id;
+    return id;
+}
+
+
+//______________________________________________________________________________
+void DataWriter::Commit()
+{
+    if(!mIsInTransaction) return;
+
+    StopWatch stopwatch;
+    CommitTransaction();
+    mIsInTransaction = false;
+    mUncommittedCount = 0;
+    mStats.Commits++;
+    mStats.WriteTimeUs += stopwatch.ElapsedUs();
+}
+
+
+//______________________________________________________________________________
+void DataWriter::Rollback()
+{
+    if(!mIsInTransaction) return;
+
+    RollbackTransaction();
+    mIsInTransaction = false;
+    mUncommittedCount = 0;
+
+    // Run ranges created in the transaction are gone
+    mRunRanges.clear();
+}
+
+
+//______________________________________________________________________________
+const DataWriter::TypeTableInfo& DataWriter::GetTypeTable(const std::string& path)
+{
+    auto cached = mTypeTables.find(path);
+    if(cached != mTypeTables.end()) return cached->second;
+
+    vector<string> tokens = StringUtils::Split(path, "/");
+    if(tokens.empty()) {
+        throw std::runtime_error(fmt::format("ccdb::DataWriter::GetTypeTable => Invalid type table path '{}'", path));
+    }
+
+    // Walk directories from the root (root directory id is 0)
+    dbkey_t directoryId = 0;
+    for(size_t i = 0; i + 1 < tokens.size(); i++) {
+        directoryId = FindDirectoryId(directoryId, tokens[i]);
+        if(!directoryId) {
+            throw std::runtime_error(fmt::format("ccdb::DataWriter::GetTypeTable => Directory '{}' is not found for path '{}'", tokens[i], path));
+        }
+    }
+
+    TypeTableInfo info;
+    if(!FindTypeTable(directoryId, tokens.back(), info)) {
+        throw std::runtime_error(fmt::format("ccdb::DataWriter::GetTypeTable => Type table '{}' is not found", path));
+    }
+    return mTypeTables[path] = info;
+}
+
+
+//______________________________________________________________________________
+dbkey_t DataWriter::GetVariationId(const std::string& name)
+{
+    auto cached = mVariations.find(name);
+    if(cached != mVariations.end()) return cached->second;
+
+    dbkey_t id = FindVariationId(name);
+    if(!id) {
+        throw std::runtime_error(fmt::format("ccdb::DataWriter::GetVariationId => Variation '{}' is not found", name));
+    }
+    mVariations[name] = id;
+    return id;
+}
+
+
+//______________________________________________________________________________
+void DataWriter::ValidateValuesCount(const std::string& path, const TypeTableInfo& table, size_t count)
+{
+    size_t expected = static_cast<size_t>(table.RowsCount) * static_cast<size_t>(table.ColumnsCount);
+    if(count != expected) {
+        throw std::runtime_error(fmt::format("ccdb::DataWriter::CreateAssignment => Table '{}' has {} rows and {} columns, "
+                                             "so {} values are expected, but {} are given",
+                                             path, table.RowsCount, table.ColumnsCount, expected, count));
+    }
+}
+
+
+//______________________________________________________________________________
+dbkey_t DataWriter::WriteAssignment(const TypeTableInfo& table, const std::string& variation, int runMin, int runMax,
+                                    const std::string& vault, const std::string& comment)
+{
+    dbkey_t variationId = GetVariationId(variation);
+    dbkey_t runRangeId = GetOrCreateRunRange(runMin, runMax);
+
+    if(!mIsInTransaction) {
+        BeginTransaction();
+        mIsInTransaction = true;
+    }
+
+    dbkey_t constantSetId = 0;
+    string vaultHash;
+    if(mHasVaultHash) {
+        vaultHash = VaultHashToString(HashVault(vault));
+        if(mIsReuseConstantSets) constantSetId = FindConstantSet(table.Id, vault, vaultHash);
+    }
+
+    if(constantSetId) {
+        mStats.ReusedConstantSets++;
+    }
+    else {
+        constantSetId = InsertConstantSet(table.Id, vault, vaultHash);
+        mStats.ConstantSets++;
+    }
+
+    dbkey_t assignmentId = InsertAssignment(variationId, runRangeId, constantSetId, mAuthorId, comment);
+    mStats.Assignments++;
+    mUncommittedCount++;
+
+    if(mCommitEvery && mUncommittedCount >= mCommitEvery) {
+        CommitTransaction();
+        mIsInTransaction = false;
+        mUncommittedCount = 0;
+        mStats.Commits++;
+    }
+    return assignmentId;
+}
+
+
+//______________________________________________________________________________
+void DataWriter::AppendVaultValue(fmt::memory_buffer& buffer, const std::string& value)
+{
+    // Same encoding as Assignment::EncodeBlobSeparator, but without temporary strings
+    for(char symbol: value) {
+        if(symbol == '|') {
+            static const char encoded[] = "&delimiter;";
+            buffer.append(encoded, encoded + sizeof(encoded) - 1);
+        }
+        else {
+            buffer.push_back(symbol);
+        }
+    }
+}
+
+}
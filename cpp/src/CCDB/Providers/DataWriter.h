@@ -0,0 +1,211 @@
+#ifndef _DataWriter_
+#define _DataWriter_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstdint>
+
+#include <fmt/format.h>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Helpers/StopWatch.h"
+
+namespace ccdb
+{
+    /** @brief Counters of DataWriter work */
+    struct DataWriterStats
+    {
+        uint64_t Assignments = 0;           /// Number of assignments created
+        uint64_t ConstantSets = 0;          /// Number of constant sets (vaults) created
+        uint64_t ReusedConstantSets = 0;    /// Number of assignments that got existing constant set with the same vault
+        uint64_t RunRanges = 0;             /// Number of run ranges created (existing ones are reused)
+        uint64_t Commits = 0;               /// Number of committed transactions
+        uint64_t WriteTimeUs = 0;           /// Time spent inside CreateAssignment and Commit calls
+
+        /** @brief Write throughput. 0 if nothing is written yet */
+        double GetAssignmentsPerSecond() const {
+            return WriteTimeUs ? Assignments * 1000000.0 / WriteTimeUs : 0;
+        }
+    };
+
+
+    /** @brief Fast upload of many assignments
+     *
+     * Creates run ranges, constant sets and assignments the same way python ccdb provider create_assignment does,
+     * but inserts them with prepared statements in large transactions. A transaction is committed each
+     * SetCommitEvery assignments and by Commit(). Type tables, variations and run ranges ids are cached,
+     * so the database is asked about each of them only once.
+     *
+     * Data is given as typed flat arrays in row major order: rows * columns values. Vault text is built
+     * from the values directly.
+     *
+     * If constantSets table has vaultHash column (sql/update_vault_hash.*.sql), the hash is written
+     * and an existing constant set of the same table with the same vault is reused instead of a new one.
+     *
+     * Log records are not written. The writer is not thread safe, use one writer per thread.
+     *
+     * Usage:
+     *    SQLiteDataWriter writer;
+     *    writer.Connect("sqlite:///path/to/ccdb.sqlite");
+     *    writer.SetCommitEvery(1000);
+     *    for(...) writer.CreateAssignment("/test/test_vars/test_table", "default", run, run, values);
+     *    writer.Commit();
+     *    cout << writer.GetStats().GetAssignmentsPerSecond();
+     */
+    class DataWriter
+    {
+    public:
+        DataWriter();
+        virtual ~DataWriter();
+
+        /** @brief Opens connection to the database. Throws std::runtime_error on failure */
+        virtual void Connect(const std::string& connectionString) = 0;
+
+        /** @brief Commits not committed assignments and closes the connection */
+        virtual void Disconnect() = 0;
+
+        /** @brief true if connection is opened */
+        virtual bool IsConnected() = 0;
+
+        /** @brief Number of assignments in one transaction. 0 - commit only when Commit() is called */
+        void SetCommitEvery(size_t count) { mCommitEvery = count; }
+        size_t GetCommitEvery() const { return mCommitEvery; }
+
+        /** @brief Id of the user written as the author of assignments. Default is 1 - anonymous */
+        void SetAuthorId(dbkey_t authorId) { mAuthorId = authorId; }
+        dbkey_t GetAuthorId() const { return mAuthorId; }
+
+        /** @brief Reuse constant sets with identical vaults if the database has vaultHash column. Default true */
+        void SetReuseConstantSets(bool value) { mIsReuseConstantSets = value; }
+        bool IsReuseConstantSets() const { return mIsReuseConstantSets; }
+
+        /** @brief true if connected database has constantSets.vaultHash column */
+        bool HasVaultHash() const { return mHasVaultHash; }
+
+        /** @brief Adds vaultHash column if it doesn't exist and fills it for constant sets that don't have it
+         *
+         * @param batchSize - rows updated in one transaction
+         * @return number of updated constant sets
+         */
+        uint64_t BackfillVaultHashes(size_t batchSize = 1000);
+
+        /** @brief Gets id of run range with this min and max runs or creates new not named run range */
+        dbkey_t GetOrCreateRunRange(int runMin, int runMax);
+
+        /** @brief Creates assignment of the type table
+         *
+         * @param path      - full path of the type table, like /test/test_vars/test_table
+         * @param variation - variation name
+         * @param runMin, runMax - run range, it is created if not exists
+         * @param values    - rows * columns values in row major order
+         * @param comment   - assignment comment
+         * @return id of created assignment
+         * @exception std::runtime_error if table or variation is not found, number of values is wrong or insert fails
+         */
+        template<typename T>
+        dbkey_t CreateAssignment(const std::string& path, const std::string& variation, int runMin, int runMax,
+                                 const std::vector<T>& values, const std::string& comment = "") {
+            StopWatch stopwatch;
+            const TypeTableInfo& table = GetTypeTable(path);
+            ValidateValuesCount(path, table, values.size());
+            dbkey_t id = WriteAssignment(table, variation, runMin, runMax, BuildVault(values), comment);
+            mStats.WriteTimeUs += stopwatch.ElapsedUs();
+            return id;
+        }
+
+        /** @brief Commits the open transaction if there is one */
+        void Commit();
+
+        /** @brief Rolls back assignments that are not committed yet */
+        void Rollback();
+
+        /** @brief Number of assignments created since the last commit */
+        size_t GetUncommittedCount() const { return mUncommittedCount; }
+
+        /** @brief Write counters */
+        const DataWriterStats& GetStats() const { return mStats; }
+        void ResetStats() { mStats = DataWriterStats(); }
+
+        /** @brief Builds vault text from values. Values are separated by '|', '|' in strings is encoded as &delimiter; */
+        template<typename T>
+        static std::string BuildVault(const std::vector<T>& values) {
+            fmt::memory_buffer buffer;
+            for(size_t i = 0; i < values.size(); i++) {
+                if(i) buffer.push_back('|');
+                AppendVaultValue(buffer, values[i]);
+            }
+            return fmt::to_string(buffer);
+        }
+
+    protected:
+
+        /** @brief Type table information needed to write assignments */
+        struct TypeTableInfo {
+            dbkey_t Id = 0;
+            int RowsCount = 0;
+            int ColumnsCount = 0;
+        };
+
+        //----------------------------------------------------------------------------------------
+        //  Database specific part. Not found objects are returned as 0 id
+        //----------------------------------------------------------------------------------------
+        virtual void BeginTransaction() = 0;
+        virtual void CommitTransaction() = 0;
+        virtual void RollbackTransaction() = 0;
+        virtual dbkey_t FindDirectoryId(dbkey_t parentId, const std::string& name) = 0;
+        virtual bool FindTypeTable(dbkey_t directoryId, const std::string& name, TypeTableInfo& info) = 0;
+        virtual dbkey_t FindVariationId(const std::string& name) = 0;
+        virtual dbkey_t FindRunRangeId(int runMin, int runMax) = 0;
+        virtual dbkey_t InsertRunRange(int runMin, int runMax) = 0;
+        virtual dbkey_t InsertConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash) = 0;     /// vaultHash is empty if there is no column
+        virtual bool HasVaultHashColumn() = 0;
+        virtual void AddVaultHashColumn() = 0;
+        virtual dbkey_t FindConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash) = 0;
+        virtual std::vector<std::pair<dbkey_t, std::string>> SelectConstantSetsWithoutHash(size_t limit) = 0;      /// (id, vault)
+        virtual void UpdateVaultHash(dbkey_t constantSetId, const std::string& vaultHash) = 0;
+        virtual dbkey_t InsertAssignment(dbkey_t variationId, dbkey_t runRangeId, dbkey_t constantSetId,
+                                         dbkey_t authorId, const std::string& comment) = 0;
+
+        /** @brief Derived classes call it when connection is opened or closed */
+        void ClearCache();
+
+        /** @brief Derived classes call it when connection is opened. Clears caches and checks for vaultHash column */
+        void OnConnected();
+
+        bool IsInTransaction() const { return mIsInTransaction; }
+
+    private:
+
+        const TypeTableInfo& GetTypeTable(const std::string& path);
+        dbkey_t GetVariationId(const std::string& name);
+        static void ValidateValuesCount(const std::string& path, const TypeTableInfo& table, size_t count);
+        dbkey_t WriteAssignment(const TypeTableInfo& table, const std::string& variation, int runMin, int runMax,
+                                const std::string& vault, const std::string& comment);
+
+        static void AppendVaultValue(fmt::memory_buffer& buffer, const std::string& value);
+        static void AppendVaultValue(fmt::memory_buffer& buffer, const char* value) { AppendVaultValue(buffer, std::string(value)); }
+        static void AppendVaultValue(fmt::memory_buffer& buffer, bool value) { buffer.push_back(value ? '1' : '0'); }
+
+        template<typename T>
+        static void AppendVaultValue(fmt::memory_buffer& buffer, T value) { fmt::format_to(buffer, "{}", value); }
+
+        size_t mCommitEvery;
+        dbkey_t mAuthorId;
+        bool mIsReuseConstantSets;
+        bool mHasVaultHash;
+        bool mIsInTransaction;
+        size_t mUncommittedCount;
+        DataWriterStats mStats;
+
+        std::map<std::string, TypeTableInfo> mTypeTables;           // by full path
+        std::map<std::string, dbkey_t> mVariations;                 // by name
+        std::map<std::pair<int, int>, dbkey_t> mRunRanges;          // by (min, max)
+
+        DataWriter(const DataWriter&) = delete;
+        DataWriter& operator=(const DataWriter&) = delete;
+    };
+}
+
+#endif //_DataWriter_
@@ -0,0 +1,68 @@
+#include <stdexcept>
+#include <algorithm>
+
+#include "CCDB/Providers/EpochCalculator.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+EpochCalculator::EpochCalculator(DataProvider& provider, const std::vector<std::string>& paths, const std::string& variation, time_t time,
+                                 int runMin, int runMax):
+    mPaths(paths),
+    mVariation(variation),
+    mTime(time),
+    mRunMin(runMin),
+    mRunMax(runMax)
+{
+    // Epochs need assignment ids only, the constants are not read
+    mHistories.reserve(paths.size());
+    for(const auto& path: paths) mHistories.emplace_back(provider, path, variation, false, runMin, runMax);
+}
+
+
+//______________________________________________________________________________
+std::vector<CalibrationEpoch> EpochCalculator::GetEpochs(int runMin, int runMax) const
+{
+    if(runMin > runMax) {
+        throw std::logic_error("ccdb::EpochCalculator::GetEpochs => runMin is greater than runMax");
+    }
+    if(runMin < mRunMin || runMax > mRunMax) {
+        throw std::logic_error("ccdb::EpochCalculator::GetEpochs => Runs are out of the range the calculator has read");
+    }
+
+    // Runs where some run range starts or ends. Assignments can change only there
+    vector<int> starts(1, runMin);
+    for(const auto& history: mHistories) {
+        for(const auto& range: history.GetRunRanges()) {
+            if(range.first > runMin && range.first <= runMax) starts.push_back(range.first);
+            if(range.second >= runMin && range.second < runMax) starts.push_back(range.second + 1);
+        }
+    }
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+    vector<CalibrationEpoch> epochs;
+    for(size_t i = 0; i < starts.size(); i++) {
+        CalibrationEpoch epoch;
+        epoch.RunMin = starts[i];
+        epoch.RunMax = i + 1 < starts.size() ? starts[i + 1] - 1 : runMax;
+        epoch.AssignmentIds.reserve(mHistories.size());
+        for(const auto& history: mHistories) {
+            const AssignmentHistoryEntry* entry = history.Find(epoch.RunMin, mTime);
+            epoch.AssignmentIds.push_back(entry ? entry->AssignmentId : 0);
+        }
+
+        // The same assignments as in the previous interval - the epoch goes on
+        if(!epochs.empty() && epochs.back().AssignmentIds == epoch.AssignmentIds) {
+            epochs.back().RunMax = epoch.RunMax;
+            continue;
+        }
+        epochs.push_back(std::move(epoch));
+    }
+    return epochs;
+}
+
+}
@@ -0,0 +1,74 @@
+#ifndef _EpochCalculator_
+#define _EpochCalculator_
+
+#include <string>
+#include <vector>
+#include <ctime>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Providers/DataProvider.h"
+#include "CCDB/Providers/AssignmentHistory.h"
+
+namespace ccdb
+{
+    /** @brief Runs in which all tables have the same assignments */
+    struct CalibrationEpoch
+    {
+        int RunMin = 0;
+        int RunMax = 0;
+        std::vector<dbkey_t> AssignmentIds;     /// In the order of the calculator paths. 0 - no assignment
+    };
+
+
+    /** @brief Splits a run range into epochs: the longest run intervals in which every table resolves to the same assignment
+     *
+     * A job that gets runs of one epoch may initialize with the constants once. A scheduler may split jobs along epochs.
+     * Assignments are resolved as GetAssignmentShort(run, path, time, variation) does, including parent variations.
+     * Assignments of each table are read once without constants (@see AssignmentHistory), a query per table
+     * and variation level, then epochs for any runs of the calculator range are calculated in memory.
+     *
+     * Usage:
+     *    EpochCalculator calculator(provider, {"/test/test_vars/test_table", "/test/test_vars/test_table2"}, "default");
+     *    for(const auto& epoch: calculator.GetEpochs(1000, 2000)) ... epoch.RunMin, epoch.RunMax
+     */
+    class EpochCalculator
+    {
+    public:
+        /** @brief Reads assignments of the tables
+         *
+         * @param [in] provider   - connected provider
+         * @param [in] paths      - type table paths
+         * @param [in] variation  - variation name
+         * @param [in] time       - UNIX time, assignments created later are not seen. 0 - the latest
+         * @param [in] runMin, runMax - runs that GetEpochs may be asked for, only assignments of these runs are read
+         * @exception std::runtime_error if a table or the variation is not found
+         */
+        EpochCalculator(DataProvider& provider, const std::vector<std::string>& paths, const std::string& variation, time_t time = 0,
+                        int runMin = 0, int runMax = INFINITE_RUN);
+
+        /** @brief Epochs covering runMin to runMax (both included), ordered by runs
+         *
+         * Adjacent epochs differ in at least one assignment. Runs without an assignment of some table
+         * are in epochs too, with 0 assignment id for that table.
+         * @exception std::logic_error if runMin is greater than runMax or the runs are out of the calculator range
+         */
+        std::vector<CalibrationEpoch> GetEpochs(int runMin, int runMax) const;
+
+        const std::vector<std::string>& GetPaths() const { return mPaths; }
+        const std::string& GetVariation() const { return mVariation; }
+        time_t GetTime() const { return mTime; }
+
+        /** @brief Assignments of the table paths[index] */
+        const AssignmentHistory& GetHistory(size_t index) const { return mHistories.at(index); }
+
+    private:
+        std::vector<std::string> mPaths;
+        std::string mVariation;
+        time_t mTime;
+        int mRunMin;
+        int mRunMax;
+        std::vector<AssignmentHistory> mHistories;      /// One for each path
+    };
+}
+
+#endif //_EpochCalculator_
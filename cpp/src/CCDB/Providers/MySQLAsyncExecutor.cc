@@ -0,0 +1,320 @@
+#include <stdexcept>
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "CCDB/Providers/MySQLAsyncExecutor.h"
+
+#ifdef CCDB_MYSQL_NONBLOCKING
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+MySQLAsyncExecutor::MySQLAsyncExecutor(const MySQLConnectionInfo& info, size_t connectionsCount):
+    mInfo(info),
+    mIsStopping(false)
+{
+    mWakePipe[0] = mWakePipe[1] = -1;
+    if(connectionsCount == 0) connectionsCount = 1;
+
+    for(size_t i = 0; i < connectionsCount; i++) {
+        std::unique_ptr<Slot> slot(new Slot());
+        slot->Connection.reset(new MySQLConnection());
+        slot->Connection->Open(mInfo, IsNonBlocking());
+        mSlots.push_back(std::move(slot));
+    }
+
+#ifdef CCDB_MYSQL_NONBLOCKING
+    if(pipe(mWakePipe) != 0) {
+        throw std::runtime_error("ccdb::MySQLAsyncExecutor => Can't create wake up pipe");
+    }
+    fcntl(mWakePipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(mWakePipe[1], F_SETFL, O_NONBLOCK);
+    mThreads.emplace_back(&MySQLAsyncExecutor::RunIOLoop, this);
+#else
+    for(auto& slot: mSlots) {
+        mThreads.emplace_back(&MySQLAsyncExecutor::RunWorker, this, std::ref(*slot));
+    }
+#endif
+}
+
+
+//______________________________________________________________________________
+MySQLAsyncExecutor::~MySQLAsyncExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mTaskAdded.notify_all();
+#ifdef CCDB_MYSQL_NONBLOCKING
+    char wakeByte = 1;
+    if(write(mWakePipe[1], &wakeByte, 1) < 0) { /* the pipe is full, the thread is awake anyway */ }
+#endif
+
+    for(auto& thread: mThreads) thread.join();
+
+    // Nobody will run what is left
+    auto error = std::make_exception_ptr(std::runtime_error("ccdb::MySQLAsyncExecutor => Executor is stopped before the query is done"));
+    for(auto& task: mQueue) task.OnError(error);
+    for(auto& slot: mSlots) {
+        if(slot->Stage != Slot::sIdle) slot->CurrentTask.OnError(error);
+    }
+    mSlots.clear();
+
+#ifdef CCDB_MYSQL_NONBLOCKING
+    close(mWakePipe[0]);
+    close(mWakePipe[1]);
+#endif
+}
+
+
+//______________________________________________________________________________
+bool MySQLAsyncExecutor::IsNonBlocking()
+{
+#ifdef CCDB_MYSQL_NONBLOCKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+//______________________________________________________________________________
+void MySQLAsyncExecutor::Submit(const std::string& query, ResultHandler onResult, ErrorHandler onError)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(mIsStopping) {
+            onError(std::make_exception_ptr(std::runtime_error("ccdb::MySQLAsyncExecutor::Submit => Executor is stopped")));
+            return;
+        }
+        mQueue.push_back(Task{query, std::move(onResult), std::move(onError)});
+    }
+
+#ifdef CCDB_MYSQL_NONBLOCKING
+    char wakeByte = 1;
+    if(write(mWakePipe[1], &wakeByte, 1) < 0) { /* the pipe is full, the thread is awake anyway */ }
+#else
+    mTaskAdded.notify_one();
+#endif
+}
+
+
+//______________________________________________________________________________
+void MySQLAsyncExecutor::Complete(Slot& slot, MYSQL_RES* result)
+{
+    Task task = std::move(slot.CurrentTask);
+    slot.CurrentTask = Task();
+    slot.Stage = Slot::sIdle;
+    slot.WaitStatus = 0;
+
+    try {
+        task.OnResult(result);
+    }
+    catch (...) {
+        task.OnError(std::current_exception());
+    }
+    if(result) mysql_free_result(result);
+}
+
+
+//______________________________________________________________________________
+void MySQLAsyncExecutor::Fail(Slot& slot, const std::string& error)
+{
+    Task task = std::move(slot.CurrentTask);
+    slot.CurrentTask = Task();
+    slot.Stage = Slot::sIdle;
+    slot.WaitStatus = 0;
+
+    task.OnError(std::make_exception_ptr(std::runtime_error(error + " Query: " + task.Query)));
+
+    // The connection could be lost. Reopen it so next queries have a chance
+    if(!slot.Connection->Ping()) {
+        try {
+            slot.Connection->Open(mInfo, IsNonBlocking());
+        }
+        catch (std::exception&) {
+            slot.Connection->Close();   // Next queries on this slot fail with 'not opened' error
+        }
+    }
+}
+
+
+#ifdef CCDB_MYSQL_NONBLOCKING
+
+//______________________________________________________________________________
+void MySQLAsyncExecutor::Advance(Slot& slot, int readyStatus)
+{
+    MYSQL* handle = slot.Connection->GetHandle();
+
+    if(slot.Stage == Slot::sQuery) {
+        int error = 0;
+        int status = slot.WaitStatus == 0 ?
+                     mysql_real_query_start(&error, handle, slot.CurrentTask.Query.c_str(), slot.CurrentTask.Query.length()) :
+                     mysql_real_query_cont(&error, handle, readyStatus);
+        if(status) {
+            slot.WaitStatus = status;
+            return;
+        }
+        if(error) {
+            Fail(slot, fmt::format("mysql_real_query error {}: {}.", mysql_errno(handle), mysql_error(handle)));
+            return;
+        }
+        slot.Stage = Slot::sStoreResult;
+        slot.WaitStatus = 0;
+    }
+
+    if(slot.Stage == Slot::sStoreResult) {
+        MYSQL_RES* result = nullptr;
+        int status = slot.WaitStatus == 0 ?
+                     mysql_store_result_start(&result, handle) :
+                     mysql_store_result_cont(&result, handle, readyStatus);
+        if(status) {
+            slot.WaitStatus = status;
+            return;
+        }
+        if(!result && mysql_errno(handle)) {
+            Fail(slot, fmt::format("mysql_store_result error {}: {}.", mysql_errno(handle), mysql_error(handle)));
+            return;
+        }
+        Complete(slot, result);
+    }
+}
+
+
+//______________________________________________________________________________
+void MySQLAsyncExecutor::RunIOLoop()
+{
+    mysql_thread_init();
+
+    std::vector<pollfd> pollFds;
+    std::vector<Slot*> polledSlots;
+
+    while(true) {
+        // Give queued tasks to idle connections
+        std::vector<Slot*> started;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if(mIsStopping) break;
+
+            for(auto& slot: mSlots) {
+                if(mQueue.empty()) break;
+                if(slot->Stage != Slot::sIdle) continue;
+                slot->CurrentTask = std::move(mQueue.front());
+                mQueue.pop_front();
+                slot->Stage = Slot::sQuery;
+                slot->WaitStatus = 0;
+                started.push_back(slot.get());
+            }
+        }
+
+        for(auto slot: started) {
+            if(!slot->Connection->IsOpened()) {
+                Fail(*slot, "ccdb::MySQLAsyncExecutor => Connection is lost and can't be reopened.");
+                continue;
+            }
+            Advance(*slot, 0);
+        }
+
+        // Some queries could finish without waiting. Then their connections are free for queued tasks
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            bool hasIdleSlot = std::any_of(mSlots.begin(), mSlots.end(),
+                                           [](const std::unique_ptr<Slot>& slot){ return slot->Stage == Slot::sIdle; });
+            if(hasIdleSlot && !mQueue.empty()) continue;
+        }
+
+        // Wait for the sockets of the running queries and for the wake up pipe
+        pollFds.clear();
+        polledSlots.clear();
+        pollFds.push_back(pollfd{mWakePipe[0], POLLIN, 0});
+        int timeoutMs = -1;
+        for(auto& slot: mSlots) {
+            if(slot->Stage == Slot::sIdle) continue;
+
+            short events = 0;
+            if(slot->WaitStatus & MYSQL_WAIT_READ)   events |= POLLIN;
+            if(slot->WaitStatus & MYSQL_WAIT_WRITE)  events |= POLLOUT;
+            if(slot->WaitStatus & MYSQL_WAIT_EXCEPT) events |= POLLPRI;
+            if(slot->WaitStatus & MYSQL_WAIT_TIMEOUT) {
+                int slotTimeoutMs = static_cast<int>(mysql_get_timeout_value(slot->Connection->GetHandle())) * 1000;
+                timeoutMs = (timeoutMs < 0) ? slotTimeoutMs : std::min(timeoutMs, slotTimeoutMs);
+            }
+            pollFds.push_back(pollfd{static_cast<int>(mysql_get_socket(slot->Connection->GetHandle())), events, 0});
+            polledSlots.push_back(slot.get());
+        }
+
+        int pollResult = poll(pollFds.data(), pollFds.size(), timeoutMs);
+        if(pollResult < 0) continue;    // EINTR
+
+        if(pollFds[0].revents & POLLIN) {
+            char buffer[64];
+            while(read(mWakePipe[0], buffer, sizeof(buffer)) > 0) {}
+        }
+
+        for(size_t i = 0; i < polledSlots.size(); i++) {
+            short revents = pollFds[i + 1].revents;
+            int readyStatus = 0;
+            if(revents & (POLLIN | POLLHUP | POLLERR)) readyStatus |= MYSQL_WAIT_READ;
+            if(revents & POLLOUT) readyStatus |= MYSQL_WAIT_WRITE;
+            if(revents & POLLPRI) readyStatus |= MYSQL_WAIT_EXCEPT;
+            if(pollResult == 0 && (polledSlots[i]->WaitStatus & MYSQL_WAIT_TIMEOUT)) readyStatus |= MYSQL_WAIT_TIMEOUT;
+
+            if(readyStatus) Advance(*polledSlots[i], readyStatus);
+        }
+    }
+
+    mysql_thread_end();
+}
+
+#else
+
+//______________________________________________________________________________
+void MySQLAsyncExecutor::RunWorker(Slot& slot)
+{
+    mysql_thread_init();
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskAdded.wait(lock, [this](){ return mIsStopping || !mQueue.empty(); });
+            if(mIsStopping) break;
+            slot.CurrentTask = std::move(mQueue.front());
+            mQueue.pop_front();
+            slot.Stage = Slot::sQuery;
+        }
+
+        if(!slot.Connection->IsOpened()) {
+            Fail(slot, "ccdb::MySQLAsyncExecutor => Connection is lost and can't be reopened.");
+            continue;
+        }
+
+        MYSQL* handle = slot.Connection->GetHandle();
+        if(mysql_real_query(handle, slot.CurrentTask.Query.c_str(), slot.CurrentTask.Query.length())) {
+            Fail(slot, fmt::format("mysql_real_query error {}: {}.", mysql_errno(handle), mysql_error(handle)));
+            continue;
+        }
+
+        slot.Stage = Slot::sStoreResult;
+        MYSQL_RES* result = mysql_store_result(handle);
+        if(!result && mysql_errno(handle)) {
+            Fail(slot, fmt::format("mysql_store_result error {}: {}.", mysql_errno(handle), mysql_error(handle)));
+            continue;
+        }
+        Complete(slot, result);
+    }
+
+    mysql_thread_end();
+}
+
+#endif //CCDB_MYSQL_NONBLOCKING
+
+}
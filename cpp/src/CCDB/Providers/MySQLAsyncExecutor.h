@@ -0,0 +1,116 @@
+#ifndef _MySQLAsyncExecutor_
+#define _MySQLAsyncExecutor_
+
+#ifdef WIN32
+#include <winsock.h>
+#endif
+#include <mysql.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <functional>
+#include <exception>
+
+#include "CCDB/Providers/MySQLConnectionInfo.h"
+#include "CCDB/Providers/MySQLConnectionPool.h"
+
+// MariaDB Connector/C has the non-blocking API (mysql_real_query_start/cont ...)
+// With other client libraries queries are run by blocking worker threads
+#if defined(LIBMARIADB) && !defined(WIN32)
+#define CCDB_MYSQL_NONBLOCKING 1
+#endif
+
+namespace ccdb
+{
+    /** @brief Runs many text queries at once on several connections
+     *
+     * With MariaDB client library one I/O thread drives all connections with the non-blocking API
+     * and poll(), so N queries take about N / connections round trips instead of N.
+     * With other client libraries each connection has its own worker thread.
+     *
+     * Result handlers are called on the I/O (worker) thread. They must be short and must not
+     * submit queries and wait for them.
+     */
+    class MySQLAsyncExecutor
+    {
+    public:
+        typedef std::function<void(MYSQL_RES* result)> ResultHandler;        /// result is NULL for queries without result set
+        typedef std::function<void(std::exception_ptr error)> ErrorHandler;
+
+        /** @brief Opens connectionsCount connections and starts the I/O thread. Throws if a connection fails */
+        MySQLAsyncExecutor(const MySQLConnectionInfo& info, size_t connectionsCount);
+
+        /** @brief Stops the I/O thread. Queries not completed yet get an error */
+        ~MySQLAsyncExecutor();
+
+        /** @brief Queues the query
+         *
+         * onResult gets the whole result when it is read. If the query fails or onResult throws, onError is called.
+         * Exactly one of them is called for each query.
+         */
+        void Submit(const std::string& query, ResultHandler onResult, ErrorHandler onError);
+
+        /** @brief Queues the query and returns the future of onResult value */
+        template<typename T>
+        std::future<T> Submit(const std::string& query, std::function<T(MYSQL_RES*)> onResult) {
+            auto promise = std::make_shared<std::promise<T>>();
+            Submit(query,
+                   [promise, onResult](MYSQL_RES* result) { promise->set_value(onResult(result)); },
+                   [promise](std::exception_ptr error) { promise->set_exception(error); });
+            return promise->get_future();
+        }
+
+        /** @brief Number of connections used for queries */
+        size_t GetConnectionsCount() const { return mSlots.size(); }
+
+        /** @brief true if the client library non-blocking API is used (false - blocking worker threads) */
+        static bool IsNonBlocking();
+
+    private:
+
+        struct Task {
+            std::string Query;
+            ResultHandler OnResult;
+            ErrorHandler OnError;
+        };
+
+        /** @brief One connection and the query it runs */
+        struct Slot {
+            enum Stages { sIdle, sQuery, sStoreResult };
+
+            std::unique_ptr<MySQLConnection> Connection;
+            Task CurrentTask;
+            Stages Stage = sIdle;
+            int WaitStatus = 0;         // MYSQL_WAIT_* flags the library waits for. 0 - stage is not started
+        };
+
+#ifdef CCDB_MYSQL_NONBLOCKING
+        void RunIOLoop();                                   /// I/O thread main loop
+        void Advance(Slot& slot, int readyStatus);          /// Starts or continues the slot stage
+#else
+        void RunWorker(Slot& slot);                         /// Worker thread main loop
+#endif
+        void Complete(Slot& slot, MYSQL_RES* result);       /// Calls result handler and frees the slot
+        void Fail(Slot& slot, const std::string& error);    /// Calls error handler, frees the slot, reopens lost connection
+
+        MySQLConnectionInfo mInfo;
+        std::vector<std::unique_ptr<Slot>> mSlots;
+        std::vector<std::thread> mThreads;
+
+        std::mutex mMutex;
+        std::condition_variable mTaskAdded;
+        std::deque<Task> mQueue;
+        bool mIsStopping;
+        int mWakePipe[2];           // Submit writes a byte here to wake up poll() of the I/O thread
+
+        MySQLAsyncExecutor(const MySQLAsyncExecutor&) = delete;
+        MySQLAsyncExecutor& operator=(const MySQLAsyncExecutor&) = delete;
+    };
+}
+
+#endif //_MySQLAsyncExecutor_
@@ -11,9 +11,13 @@ namespace ccdb
         MySQLConnectionInfo()
             :UserName(""),
             Password(""),
-            HostName(""),
             Database(""),
-            Port(0)
+            HostName(""),
+            Port(0),
+            Compress(false),
+            ReadTimeout(0),
+            WriteTimeout(0),
+            KeepAlive(0)
         {}
 
         std::string UserName;
@@ -21,6 +25,11 @@ namespace ccdb
         std::string Database;
         std::string HostName;
         int Port;
+
+        bool Compress;          /// Use client/server protocol compression (?compress=true)
+        int ReadTimeout;        /// Seconds to wait for the server reply. 0 - library default (?read_timeout=)
+        int WriteTimeout;       /// Seconds to wait for the server to accept data. 0 - library default (?write_timeout=)
+        int KeepAlive;          /// Seconds of idle before TCP keepalive probes are sent. 0 - off (?keepalive=)
     };
 }
 
@@ -0,0 +1,414 @@
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#include <fmt/format.h>
+
+#include "CCDB/Providers/MySQLConnectionPool.h"
+
+using namespace std;
+using namespace std::chrono;
+
+namespace ccdb
+{
+
+namespace
+{
+    /** Each thread that uses MySQL client library is initialized once and is deinitialized on exit */
+    struct MySQLThreadInitializer
+    {
+        MySQLThreadInitializer() { mysql_thread_init(); }
+        ~MySQLThreadInitializer() { mysql_thread_end(); }
+    };
+}
+
+
+//______________________________________________________________________________
+MySQLConnection::MySQLConnection():
+    mHandle(nullptr),
+    mIsBroken(false)
+{
+}
+
+
+//______________________________________________________________________________
+MySQLConnection::~MySQLConnection()
+{
+    Close();
+}
+
+
+//______________________________________________________________________________
+void MySQLConnection::Open(const MySQLConnectionInfo& info, bool isNonBlocking)
+{
+    string thisFuncName = "ccdb::MySQLConnection::Open";
+
+    if(IsOpened()) Close();
+
+    // mysql_init calls mysql_library_init which is not thread safe
+    static std::once_flag libraryInitFlag;
+    std::call_once(libraryInitFlag, [](){ mysql_library_init(0, nullptr, nullptr); });
+
+    //init connection variable
+    mHandle = mysql_init(nullptr);
+    if(mHandle == nullptr)
+    {
+        throw std::runtime_error(thisFuncName + " => mysql_init() returned NULL, probably memory allocation problem");
+    }
+
+#ifdef LIBMARIADB
+    if(isNonBlocking) {
+        mysql_options(mHandle, MYSQL_OPT_NONBLOCK, nullptr);
+    }
+#else
+    if(isNonBlocking) {
+        mysql_close(mHandle);
+        mHandle = nullptr;
+        throw std::logic_error(thisFuncName + " => Non-blocking connections need MariaDB client library");
+    }
+#endif
+
+    //connection options from the connection string
+    if(info.Compress) {
+        mysql_options(mHandle, MYSQL_OPT_COMPRESS, nullptr);
+    }
+    if(info.ReadTimeout > 0) {
+        unsigned int timeout = static_cast<unsigned int>(info.ReadTimeout);
+        mysql_options(mHandle, MYSQL_OPT_READ_TIMEOUT, &timeout);
+    }
+    if(info.WriteTimeout > 0) {
+        unsigned int timeout = static_cast<unsigned int>(info.WriteTimeout);
+        mysql_options(mHandle, MYSQL_OPT_WRITE_TIMEOUT, &timeout);
+    }
+
+    //Try to connect to server
+    if(!mysql_real_connect (
+        mHandle,                        //pointer to connection handler
+        info.HostName.c_str(),          //host to connect to
+        info.UserName.c_str(),          //user name
+        info.Password.c_str(),          //password
+        info.Database.c_str(),          //database to use
+        info.Port,                      //port
+        nullptr,                        //socket (use default)
+        0))                             //flags (none)
+    {
+        auto error = fmt::format("{} => mysql_real_connect() failed. Error {}: {}",
+                                 thisFuncName, mysql_errno(mHandle), mysql_error(mHandle));
+        mysql_close(mHandle);
+        mHandle = nullptr;
+        throw std::runtime_error(error);
+    }
+
+    if(info.KeepAlive > 0) SetKeepAlive(info.KeepAlive);
+    mIsBroken = false;
+    mLastUsedTime = steady_clock::now();
+}
+
+
+//______________________________________________________________________________
+void MySQLConnection::SetKeepAlive(int idleSeconds)
+{
+#ifndef WIN32
+#ifdef LIBMARIADB
+    int socket = static_cast<int>(mysql_get_socket(mHandle));
+#else
+    int socket = mHandle->net.fd;
+#endif
+    if(socket < 0) return;     // Local socket or pipe, nothing to keep alive
+
+    int isOn = 1;
+    setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE, &isOn, sizeof(isOn));
+#ifdef TCP_KEEPIDLE
+    setsockopt(socket, IPPROTO_TCP, TCP_KEEPIDLE, &idleSeconds, sizeof(idleSeconds));
+#elif defined(TCP_KEEPALIVE)
+    setsockopt(socket, IPPROTO_TCP, TCP_KEEPALIVE, &idleSeconds, sizeof(idleSeconds));   // macOS
+#endif
+#endif //WIN32
+}
+
+
+//______________________________________________________________________________
+void MySQLConnection::Close()
+{
+    mStatements.clear();    // statements must be closed before the connection
+    if(mHandle) {
+        mysql_close(mHandle);
+        mHandle = nullptr;
+    }
+}
+
+
+//______________________________________________________________________________
+bool MySQLConnection::Ping()
+{
+    if(mHandle && mysql_ping(mHandle) == 0) return true;
+    mIsBroken = true;
+    return false;
+}
+
+
+//______________________________________________________________________________
+MySQLStatement& MySQLConnection::GetStatement(const std::string& query)
+{
+    if(!IsOpened()) {
+        throw std::runtime_error("ccdb::MySQLConnection::GetStatement => Connection is not opened");
+    }
+    if(mIsBroken) {
+        throw MySQLConnectionLostError("ccdb::MySQLConnection::GetStatement => Connection is lost");
+    }
+
+    // Rows of a streamed result are still on the wire. MySQL can't run another statement until they are read
+    for(auto& cached: mStatements) {
+        if(cached.second->IsFetching() && !cached.second->IsBuffered()) {
+            throw std::logic_error("ccdb::MySQLConnection::GetStatement => The connection is busy streaming rows of: " + cached.first);
+        }
+    }
+
+    auto iter = mStatements.find(query);
+    if(iter != mStatements.end()) return *iter->second;
+
+    std::unique_ptr<MySQLStatement> statement(new MySQLStatement(mHandle));
+    statement->SetConnectionLostFlag(&mIsBroken);
+    statement->Prepare(query);
+    MySQLStatement& result = *statement;
+    mStatements[query] = std::move(statement);
+    return result;
+}
+
+
+//______________________________________________________________________________
+MySQLConnectionPool::MySQLConnectionPool(const MySQLConnectionInfo& info, const MySQLConnectionPoolOptions& options):
+    mInfo(info),
+    mOptions(options),
+    mPendingOpens(0),
+    mDroppedToReplace(0)
+{
+    if(mOptions.MaxSize == 0) mOptions.MaxSize = 1;
+    if(mOptions.MinSize > mOptions.MaxSize) mOptions.MinSize = mOptions.MaxSize;
+
+    // Initial connections are opened with one attempt, so wrong connection settings fail fast
+    for(size_t i = 0; i < mOptions.MinSize; i++) {
+        std::unique_ptr<MySQLConnection> connection(new MySQLConnection());
+        connection->Open(mInfo);
+        mIdle.push_back(connection.get());
+        mConnections.push_back(std::move(connection));
+        mStats.ConnectionsOpened++;
+    }
+}
+
+
+//______________________________________________________________________________
+MySQLConnectionPool::~MySQLConnectionPool()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mIdle.clear();
+    mInUse.clear();
+    mConnections.clear();   // closes connections
+}
+
+
+//______________________________________________________________________________
+std::chrono::milliseconds MySQLConnectionPool::GetBackoffDelay(int attempt, const MySQLConnectionPoolOptions& options, double jitter)
+{
+    double delay = options.BackoffInitialMs;
+    for(int i = 0; i < attempt && delay < options.BackoffMaxMs; i++) delay *= 2;
+    delay = std::min(delay, static_cast<double>(options.BackoffMaxMs));
+
+    jitter = std::max(0.0, std::min(1.0, jitter));
+    return milliseconds(static_cast<long>(delay / 2 + delay / 2 * jitter));
+}
+
+
+//______________________________________________________________________________
+void MySQLConnectionPool::OpenWithBackoff(MySQLConnection& connection)
+{
+    thread_local std::mt19937 randomEngine(std::random_device{}());
+    std::uniform_real_distribution<double> jitterDistribution(0.0, 1.0);
+
+    int attempts = std::max(1, mOptions.ReconnectAttempts);
+    string lastError;
+    for(int attempt = 0; attempt < attempts; attempt++) {
+        try {
+            connection.Open(mInfo);
+            return;
+        }
+        catch (std::runtime_error& ex) {
+            lastError = ex.what();
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStats.FailedConnects++;
+            }
+        }
+
+        if(attempt + 1 < attempts) {
+            std::this_thread::sleep_for(GetBackoffDelay(attempt, mOptions, jitterDistribution(randomEngine)));
+        }
+    }
+
+    throw std::runtime_error(fmt::format("ccdb::MySQLConnectionPool => Can't connect after {} attempts. Last error: {}", attempts, lastError));
+}
+
+
+//______________________________________________________________________________
+MySQLConnectionPool::Lease MySQLConnectionPool::Acquire()
+{
+    // Each thread that uses MySQL client library should be initialized
+    thread_local MySQLThreadInitializer threadInitializer;
+
+    auto threadId = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // Nested acquire from the same thread gets the same connection
+    auto slotIter = mInUse.find(threadId);
+    if(slotIter != mInUse.end()) {
+        slotIter->second.Depth++;
+        return Lease(this, slotIter->second.Connection);
+    }
+
+    // Take an idle connection, or reserve a place for a new one, or wait
+    MySQLConnection* connection = nullptr;
+    bool needsOpen = false;
+    bool waited = false;
+    auto waitStart = steady_clock::now();
+    auto deadline = waitStart + milliseconds(mOptions.AcquireTimeoutMs);
+    while(true) {
+        if(!mIdle.empty()) {
+            connection = mIdle.back();
+            mIdle.pop_back();
+            break;
+        }
+
+        if(mConnections.size() + mPendingOpens < mOptions.MaxSize) {
+            mPendingOpens++;
+            needsOpen = true;
+            break;
+        }
+
+        waited = true;
+        if(mOptions.AcquireTimeoutMs > 0) {
+            if(mConnectionReleased.wait_until(lock, deadline) == std::cv_status::timeout) {
+                // A connection could be released or dropped right at the deadline
+                if(!mIdle.empty() || mConnections.size() + mPendingOpens < mOptions.MaxSize) continue;
+                mStats.Waits++;
+                mStats.WaitTimeUs += duration_cast<microseconds>(steady_clock::now() - waitStart).count();
+                throw std::runtime_error(fmt::format("ccdb::MySQLConnectionPool::Acquire => No free connection in {} ms. Pool size {}",
+                                                     mOptions.AcquireTimeoutMs, mOptions.MaxSize));
+            }
+        }
+        else {
+            mConnectionReleased.wait(lock);
+        }
+    }
+
+    if(waited) {
+        mStats.Waits++;
+        mStats.WaitTimeUs += duration_cast<microseconds>(steady_clock::now() - waitStart).count();
+    }
+
+    // Open a new connection or validate the idle one. Network is done without the lock
+    bool isIdleTooLong = connection &&
+            steady_clock::now() - connection->GetLastUsedTime() > milliseconds(mOptions.ValidateAfterIdleMs);
+
+    if(needsOpen || isIdleTooLong) {
+        lock.unlock();
+
+        std::unique_ptr<MySQLConnection> newConnection;
+        bool isReconnected = false;
+        try {
+            if(needsOpen) {
+                newConnection.reset(new MySQLConnection());
+                OpenWithBackoff(*newConnection);
+            }
+            else if(!connection->Ping()) {
+                connection->Close();
+                OpenWithBackoff(*connection);
+                isReconnected = true;
+            }
+        }
+        catch (...) {
+            lock.lock();
+            if(needsOpen) {
+                mPendingOpens--;
+            }
+            else {
+                // The connection is dead. Remove it so a place for a new one is freed
+                auto iter = std::find_if(mConnections.begin(), mConnections.end(),
+                                         [connection](const std::unique_ptr<MySQLConnection>& c){ return c.get() == connection; });
+                if(iter != mConnections.end()) mConnections.erase(iter);
+            }
+            mConnectionReleased.notify_one();
+            throw;
+        }
+
+        lock.lock();
+        if(needsOpen) {
+            mPendingOpens--;
+            connection = newConnection.get();
+            mConnections.push_back(std::move(newConnection));
+            mStats.ConnectionsOpened++;
+            if(mDroppedToReplace > 0) {
+                mDroppedToReplace--;
+                mStats.Reconnects++;
+            }
+        }
+        if(isReconnected) mStats.Reconnects++;
+    }
+
+    mStats.Acquires++;
+    mInUse[threadId] = ThreadSlot{connection, 1};
+    return Lease(this, connection);
+}
+
+
+//______________________________________________________________________________
+void MySQLConnectionPool::Release(MySQLConnection* connection)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // Lease may be moved to another thread, so search by the connection
+    auto slotIter = mInUse.find(std::this_thread::get_id());
+    if(slotIter == mInUse.end() || slotIter->second.Connection != connection) {
+        slotIter = std::find_if(mInUse.begin(), mInUse.end(),
+                                [connection](const std::pair<const std::thread::id, ThreadSlot>& slot){ return slot.second.Connection == connection; });
+        if(slotIter == mInUse.end()) return;
+    }
+
+    if(--slotIter->second.Depth > 0) return;
+
+    mInUse.erase(slotIter);
+
+    // The connection is lost, another thread must not get it. A place for a new connection is freed,
+    // the next Acquire that finds no idle connection opens it. Lease destructors don't wait for the server
+    if(connection->IsBroken()) {
+        auto iter = std::find_if(mConnections.begin(), mConnections.end(),
+                                 [connection](const std::unique_ptr<MySQLConnection>& c){ return c.get() == connection; });
+        if(iter != mConnections.end()) mConnections.erase(iter);     // closes the connection
+        mStats.DroppedConnections++;
+        mDroppedToReplace++;
+        mConnectionReleased.notify_one();
+        return;
+    }
+
+    connection->SetLastUsedTime(steady_clock::now());
+    mIdle.push_back(connection);
+    mConnectionReleased.notify_one();
+}
+
+
+//______________________________________________________________________________
+MySQLConnectionPoolStats MySQLConnectionPool::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    MySQLConnectionPoolStats stats = mStats;
+    stats.OpenedNow = mConnections.size();
+    stats.IdleNow = mIdle.size();
+    return stats;
+}
+
+}
@@ -0,0 +1,195 @@
+#ifndef _MySQLConnectionPool_
+#define _MySQLConnectionPool_
+
+#ifdef WIN32
+#include <winsock.h>
+#endif
+#include <mysql.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+
+#include "CCDB/Providers/MySQLConnectionInfo.h"
+#include "CCDB/Helpers/MySQL.h"
+
+namespace ccdb
+{
+    /** @brief Settings of MySQLConnectionPool */
+    struct MySQLConnectionPoolOptions
+    {
+        size_t MinSize = 1;                 /// Number of connections opened at pool creation. Dropped ones are reopened when needed
+        size_t MaxSize = 8;                 /// Maximum number of simultaneously opened connections
+        int ValidateAfterIdleMs = 30000;    /// Idle connections are pinged before reuse if idle longer than this
+        int AcquireTimeoutMs = 0;           /// How long to wait for a free connection. 0 - wait forever
+        int ReconnectAttempts = 5;          /// Connection attempts before giving up
+        int BackoffInitialMs = 50;          /// Delay before the first reconnection attempt
+        int BackoffMaxMs = 5000;            /// Maximum delay between reconnection attempts
+        size_t AsyncConnections = 4;        /// Connections used by asynchronous requests (opened on the first one)
+    };
+
+
+    /** @brief Counters of MySQLConnectionPool usage */
+    struct MySQLConnectionPoolStats
+    {
+        uint64_t Acquires = 0;              /// Number of times a connection was given to a thread
+        uint64_t Waits = 0;                 /// Number of times a thread waited for a free connection
+        uint64_t WaitTimeUs = 0;            /// Total time threads spent waiting for a free connection
+        uint64_t ConnectionsOpened = 0;     /// Number of physical connections opened
+        uint64_t Reconnects = 0;            /// Number of connections reopened after failed validation or opened in place of dropped ones
+        uint64_t DroppedConnections = 0;    /// Number of connections dropped because they were lost during a query
+        uint64_t FailedConnects = 0;        /// Number of failed connection attempts
+        size_t OpenedNow = 0;               /// Number of currently opened connections
+        size_t IdleNow = 0;                 /// Number of currently idle connections
+    };
+
+
+    /** @brief One physical connection to MySQL with its cache of prepared statements */
+    class MySQLConnection
+    {
+    public:
+        MySQLConnection();
+        ~MySQLConnection();
+
+        /** @brief Opens the connection. Throws std::runtime_error on failure
+         *
+         * isNonBlocking - prepare the connection for MariaDB non-blocking API (mysql_*_start/cont functions)
+         */
+        void Open(const MySQLConnectionInfo& info, bool isNonBlocking = false);
+
+        /** @brief Closes the connection and all prepared statements */
+        void Close();
+
+        /** @brief true if the connection is opened */
+        bool IsOpened() const { return mHandle != nullptr; }
+
+        /** @brief Checks that the server is alive. Returns false and marks the connection broken if it is lost */
+        bool Ping();
+
+        /** @brief true if a statement failed with MySQLConnectionLostError. The pool drops such connections */
+        bool IsBroken() const { return mIsBroken; }
+        void MarkBroken() { mIsBroken = true; }
+
+        /** @brief Returns prepared statement for the query
+         *
+         * Statements are prepared on the server once per connection and are cached by the query text
+         * @exception MySQLConnectionLostError if the connection is broken
+         */
+        MySQLStatement& GetStatement(const std::string& query);
+
+        /** @brief Underlying MySQL handle */
+        MYSQL* GetHandle() const { return mHandle; }
+
+        /** @brief Time when the connection was returned to the pool last time */
+        std::chrono::steady_clock::time_point GetLastUsedTime() const { return mLastUsedTime; }
+        void SetLastUsedTime(std::chrono::steady_clock::time_point val) { mLastUsedTime = val; }
+
+    private:
+        /** @brief Turns on TCP keepalive probes after idleSeconds of silence on the connection socket */
+        void SetKeepAlive(int idleSeconds);
+
+        MYSQL* mHandle;
+        bool mIsBroken;                                                         // Set by statements when the connection is lost
+        std::map<std::string, std::unique_ptr<MySQLStatement>> mStatements;   // Prepared statements by query text
+        std::chrono::steady_clock::time_point mLastUsedTime;
+
+        MySQLConnection(const MySQLConnection&) = delete;
+        MySQLConnection& operator=(const MySQLConnection&) = delete;
+    };
+
+
+    /** @brief Pool of MySQL connections shared between threads
+     *
+     * Each thread that calls Acquire gets its own connection, so queries from different threads
+     * run in parallel. Nested Acquire calls from the same thread return the same connection.
+     * Idle connections are validated by ping before reuse and lost connections are reopened
+     * with exponential backoff and jitter. A connection whose statement failed with MySQLConnectionLostError
+     * is not given back to idle connections: it is closed when its lease ends, and a new one is opened
+     * by the next Acquire that needs it, so a thread that ends a lease never waits for the server. Threads that acquire connections are initialized for MySQL client library
+     * on the first Acquire and are deinitialized (mysql_thread_end) when they exit.
+     */
+    class MySQLConnectionPool
+    {
+    public:
+
+        /** @brief RAII handle of the acquired connection. Returns the connection to the pool on destruction */
+        class Lease
+        {
+        public:
+            Lease(MySQLConnectionPool* pool, MySQLConnection* connection): mPool(pool), mConnection(connection) {}
+            Lease(Lease&& other): mPool(other.mPool), mConnection(other.mConnection) { other.mPool = nullptr; other.mConnection = nullptr; }
+            ~Lease() { if(mPool && mConnection) mPool->Release(mConnection); }
+
+            MySQLConnection* operator->() const { return mConnection; }
+            MySQLConnection& operator*() const { return *mConnection; }
+
+        private:
+            MySQLConnectionPool* mPool;
+            MySQLConnection* mConnection;
+
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+        };
+
+        /** @brief Creates the pool and opens options.MinSize connections. Throws if the first connection fails */
+        MySQLConnectionPool(const MySQLConnectionInfo& info, const MySQLConnectionPoolOptions& options);
+        ~MySQLConnectionPool();
+
+        /** @brief Gets connection for the current thread
+         *
+         * Waits if MaxSize connections are in use by other threads.
+         * @exception std::runtime_error if connection could not be opened or AcquireTimeoutMs is exceeded
+         */
+        Lease Acquire();
+
+        /** @brief Usage counters */
+        MySQLConnectionPoolStats GetStats();
+
+        const MySQLConnectionPoolOptions& GetOptions() const { return mOptions; }
+
+        /** @brief Delay before the reconnection attempt number 'attempt' (0 based)
+         *
+         * Delay grows exponentially from BackoffInitialMs up to BackoffMaxMs.
+         * The jitter in [0, 1] scales it down randomly, so clients that lost the server together
+         * don't retry all at the same moment. The delay is never less than a half of the exponential value.
+         */
+        static std::chrono::milliseconds GetBackoffDelay(int attempt, const MySQLConnectionPoolOptions& options, double jitter);
+
+    private:
+        friend class Lease;
+
+        /** @brief Returns connection to the pool (or decreases nesting level for the thread) */
+        void Release(MySQLConnection* connection);
+
+        /** @brief Opens the connection retrying with backoff. Must be called without mMutex locked */
+        void OpenWithBackoff(MySQLConnection& connection);
+
+        /** @brief Thread owning a connection and how many leases of it the thread holds */
+        struct ThreadSlot {
+            MySQLConnection* Connection;
+            int Depth;
+        };
+
+        MySQLConnectionInfo mInfo;
+        MySQLConnectionPoolOptions mOptions;
+
+        std::mutex mMutex;
+        std::condition_variable mConnectionReleased;
+        std::vector<std::unique_ptr<MySQLConnection>> mConnections;    // All connections owned by the pool
+        std::vector<MySQLConnection*> mIdle;                            // Connections not used by any thread
+        std::map<std::thread::id, ThreadSlot> mInUse;                   // Connections used by threads
+        size_t mPendingOpens;                                           // Connections being opened right now
+        size_t mDroppedToReplace;                                       // Dropped connections not reopened yet
+        MySQLConnectionPoolStats mStats;
+
+        MySQLConnectionPool(const MySQLConnectionPool&) = delete;
+        MySQLConnectionPool& operator=(const MySQLConnectionPool&) = delete;
+    };
+}
+
+#endif //_MySQLConnectionPool_
@@ -1,59 +1,60 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
-#include <sstream>
 #include <time.h>
 #include <string.h>
 #include <limits.h>
+#include <mutex>
+
+#include <fmt/format.h>
 
 #include "CCDB/Globals.h"
-#include "CCDB/Log.h"
 #include "CCDB/Helpers/StringUtils.h"
 #include "CCDB/Helpers/PathUtils.h"
+#include "CCDB/Helpers/MySQL.h"
 #include "CCDB/Providers/MySQLDataProvider.h"
 #include "CCDB/Model/ConstantsTypeTable.h"
 #include "CCDB/Model/RunRange.h"
 
-#ifdef __MACH__
-#include <mach/clock.h>
-#include <mach/mach.h>
-#endif
-
 
 using namespace ccdb;
 
-
-#pragma region constructors
-
-ccdb::MySQLDataProvider::MySQLDataProvider(void)
+//______________________________________________________________________________
+ccdb::MySQLDataProvider::MySQLDataProvider()
 {
 	mIsConnected = false;
-	mMySQLHnd=NULL;
-	mResult=NULL;
-	mRootDir = new Directory(this, this);
+	mRootDir = new Directory();
 	mDirsAreLoaded = false;
-	mLastFullQuerry="";
-	mLastShortQuerry="";
-    mLastVariation = NULL; 
-    
 }
 
 
-ccdb::MySQLDataProvider::~MySQLDataProvider(void)
+//______________________________________________________________________________
+ccdb::MySQLDataProvider::~MySQLDataProvider()
 {
 	if(IsConnected())
 	{
 		Disconnect();
 	}
 }
-#pragma endregion constructors
 
-#pragma region Connection
 
-bool ccdb::MySQLDataProvider::Connect(const std::string& connectionString )
+//______________________________________________________________________________
+void ccdb::MySQLDataProvider::Connect(const std::string& connectionString )
 {
+	std::string thisFuncName = "ccdb::MySQLDataProvider::Connect";
+
+	//check if we are connected
+	if(IsConnected())
+	{
+		if(connectionString != mConnectionString) {
+			throw std::runtime_error(thisFuncName + " => Connection already opened with different connection string");
+		}
+
+		// We already connected with this connection string
+		return;
+	}
 
-	//Setting default connection	
+	//Setting default connection
 	MySQLConnectionInfo connection;
 	connection.UserName.assign(CCDB_DEFAULT_MYSQL_USERNAME);
 	connection.Password.assign(CCDB_DEFAULT_MYSQL_PASSWORD);
@@ -64,65 +65,38 @@ bool ccdb::MySQLDataProvider::Connect(const std::string& connectionString )
 	//try to parse connection string
 	if(!ParseConnectionString(connectionString, connection))
 	{
-		Error(CCDB_ERROR_PARSE_CONNECTION_STRING, "MySQLDataProvider::Connect()", "Error parse mysql string");
-		return false;
+		throw std::runtime_error(thisFuncName + " => Error parse MySQL string. The string is not started with mysql://");
 	}
-						
+
 	//try to connect
-    bool result = Connect(connection);
-    if(result) mConnectionString = connectionString;
-    return result;
+	Connect(connection);
+	mConnectionString = connectionString;
 }
 
-bool ccdb::MySQLDataProvider::Connect(MySQLConnectionInfo connection)
+
+//______________________________________________________________________________
+void ccdb::MySQLDataProvider::Connect(const MySQLConnectionInfo& connection)
 {
-	ClearErrors(); //Clear error in function that can produce new ones
+	std::string thisFuncName = "ccdb::MySQLDataProvider::Connect(MySQLConnectionInfo)";
 
 	//check if we are connected
 	if(IsConnected())
 	{
-		Error(CCDB_ERROR_CONNECTION_ALREADY_OPENED, "MySQLDataProvider::Connect(MySQLConnectionInfo)", "Connection already opened");
-		return false;
-	}
-
-
-	//verbose...
-	Log::Verbose("ccdb::MySQLDataProvider::Connect", StringUtils::Format("Connecting to database:\n UserName: %s \n Password: %i symbols \n HostName: %s Database: %s Port: %i",
-					connection.UserName.c_str(), connection.Password.length(), connection.HostName.c_str(), connection.Database.c_str(), connection.Port) );
-					
-	//init connection variable
-	if(mMySQLHnd == NULL)mMySQLHnd = mysql_init(NULL);
-	if(mMySQLHnd == NULL)
-	{
-		Error(CCDB_ERROR_CONNECTION_INITIALIZATION, "MySQLDataProvider::Connect(DMySQLConnectionInfo)", "mysql_init() returned NULL, probably memory allocation problem");
-		return false;
+		throw std::runtime_error(thisFuncName + " => Connection already opened");
 	}
-	
-	//Try to connect to server
-	if(!mysql_real_connect (
-		mMySQLHnd,						//pointer to connection handler
-		connection.HostName.c_str(),	//host to connect to
-		connection.UserName.c_str(),	//user name
-		connection.Password.c_str(),	//password
-		connection.Database.c_str(),	//database to use
-		connection.Port, 				//port
-		NULL,							//socket (use default)
-		0))								//flags (none)
-	{
-		string errStr = ComposeMySQLError("mysql_real_connect()");
-		Error(CCDB_ERROR_CONNECTION_EXTERNAL_ERROR,"bool MySQLDataProvider::Connect(MySQLConnectionInfo)",errStr.c_str());
 
-		mMySQLHnd=NULL;		//some compilers dont set NULL after delete
-		return false;
-	}
+	//open the pool. It opens the first connection right away and throws if it fails
+	mPool.reset(new MySQLConnectionPool(connection, mPoolOptions));
+	mConnectionInfo = connection;
 	mIsConnected = true;
-	return true;
 }
 
+
+//______________________________________________________________________________
 bool ccdb::MySQLDataProvider::ParseConnectionString(std::string conStr, MySQLConnectionInfo &connection)
 {
 	//first check for uri type
-	int typePos = conStr.find("mysql://");
+	size_t typePos = conStr.find("mysql://");
 	if(typePos==string::npos)
 	{
 		return false;
@@ -131,13 +105,21 @@ bool ccdb::MySQLDataProvider::ParseConnectionString(std::string conStr, MySQLCon
 	//ok we dont need mysql:// in the future. Moreover it will mess our separation logic
 	conStr.erase(0,8);
 
+	//connection options go after '?' like: ?compress=true&read_timeout=30
+	size_t questionPos = conStr.find('?');
+	if(questionPos!=string::npos)
+	{
+		ParseConnectionOptions(conStr.substr(questionPos+1), connection);
+		conStr.erase(questionPos);
+	}
+
 	//then if there is '@' that separates login/password part of uri
-	int atPos = conStr.find('@');
+	size_t atPos = conStr.find('@');
 	if(atPos!=string::npos)
 	{
 		string logPassStr;
 
-		//ok! we have it! 
+		//ok! we have it!
 		//take it... but with caution
 		if(atPos == conStr.length()-1)
 		{
@@ -155,11 +137,11 @@ bool ccdb::MySQLDataProvider::ParseConnectionString(std::string conStr, MySQLCon
 		{
 			//a regular case
 			logPassStr = conStr.substr(0,atPos);
-			conStr=conStr.substr(atPos+1);			
+			conStr=conStr.substr(atPos+1);
 		}
 
 		//is it only login or login&&password?
-		int colonPos = logPassStr.find(':');
+		size_t colonPos = logPassStr.find(':');
 		if(colonPos!=string::npos)
 		{
 			connection.UserName = logPassStr.substr(0,colonPos);
@@ -171,10 +153,10 @@ bool ccdb::MySQLDataProvider::ParseConnectionString(std::string conStr, MySQLCon
 		}
 	}
 
-	//ok, now we have only "address:port database" part of the string
+	//ok, now we have only "address:port/database" part of the string
 
 	//1) deal with database;
-	int whitePos=conStr.find('/');
+	size_t whitePos=conStr.find('/');
 	if(whitePos!=string::npos)
 	{
 		connection.Database = conStr.substr(whitePos+1);
@@ -182,7 +164,7 @@ bool ccdb::MySQLDataProvider::ParseConnectionString(std::string conStr, MySQLCon
 	}
 
 	//2) deal with port
-	int colonPos = conStr.find(':');
+	size_t colonPos = conStr.find(':');
 	if(colonPos!=string::npos)
 	{
 		string portStr=conStr.substr(colonPos+1);
@@ -198,1232 +180,1048 @@ bool ccdb::MySQLDataProvider::ParseConnectionString(std::string conStr, MySQLCon
 }
 
 
+//______________________________________________________________________________
+void ccdb::MySQLDataProvider::ParseConnectionOptions(const std::string& options, MySQLConnectionInfo &connection)
+{
+	for(const auto& option: StringUtils::Split(options, "&"))
+	{
+		if(option.empty()) continue;
+
+		size_t equalPos = option.find('=');
+		string name = option.substr(0, equalPos);
+		string value = equalPos==string::npos ? string("true") : option.substr(equalPos+1);
+
+		if(name == "compress")           connection.Compress = StringUtils::ParseBool(value);
+		else if(name == "read_timeout")  connection.ReadTimeout = StringUtils::ParseInt(value);
+		else if(name == "write_timeout") connection.WriteTimeout = StringUtils::ParseInt(value);
+		else if(name == "keepalive")     connection.KeepAlive = StringUtils::ParseInt(value);
+		else
+		{
+			throw std::runtime_error("ccdb::MySQLDataProvider::ParseConnectionString => Unknown connection option '" + name + "'. "
+			                         "Known options are: compress, read_timeout, write_timeout, keepalive");
+		}
+	}
+}
+
+
+//______________________________________________________________________________
 bool ccdb::MySQLDataProvider::IsConnected()
 {
 	return mIsConnected;
 }
 
 
+//______________________________________________________________________________
 void ccdb::MySQLDataProvider::Disconnect()
 {
 	if(IsConnected())
 	{
-		FreeMySQLResult();	//it would free the result or do nothing
-		
-		mysql_close(mMySQLHnd);
-		mMySQLHnd = NULL;
+		{
+			std::lock_guard<std::mutex> asyncLock(mAsyncMutex);
+			mAsyncExecutor.reset();     // fails requests that are not done yet
+		}
+		mPool.reset();
 		mIsConnected = false;
 	}
 }
 
 
-bool ccdb::MySQLDataProvider::LoadDirectories()
+//______________________________________________________________________________
+void ccdb::MySQLDataProvider::SetPoolOptions(const MySQLConnectionPoolOptions& options)
 {
-	//
-	if(IsConnected())
-	{
-		if(!QuerySelect("SELECT `id`, `parentId`, `name`, `comment` FROM `directories`"))
-		{
-			//TODO: report error
-			return false;
-		}
+	if(IsConnected()) {
+		throw std::logic_error("ccdb::MySQLDataProvider::SetPoolOptions => Pool options should be set before Connect");
+	}
+	mPoolOptions = options;
+}
 
-		//clear diretory arrays
-		mDirectories.clear();
-		mDirectoriesById.clear();
 
-		//clear root directory (delete all directory structure objects)
-		mRootDir->DisposeSubdirectories();
+//______________________________________________________________________________
+MySQLConnectionPoolStats ccdb::MySQLDataProvider::GetPoolStats()
+{
+	if(!mPool) return MySQLConnectionPoolStats();
+	return mPool->GetStats();
+}
 
-		//Ok! We querryed our directories! lets catch them! 
-		while(FetchRow())
-		{
-			auto dir = new Directory();
-			dir->SetId(ReadIndex(0));				// `id`,
-            dir->SetParentId(ReadInt(1));			// `parentId`,
-			dir->SetName(ReadString(2));			// `name`,
-			dir->SetComment(ReadString(3));			// `comment`
-
-			mDirectories.push_back(dir);
-			mDirectoriesById[dir->GetId()] = dir;
-		}
 
-		BuildDirectoryDependencies();
-		mDirsAreLoaded=true;
+//______________________________________________________________________________
+MySQLConnectionPool::Lease ccdb::MySQLDataProvider::AcquireConnection()
+{
+	if(!IsConnected()) {
+		throw std::runtime_error("ccdb::MySQLDataProvider::AcquireConnection => Not connected to MySQL database");
 	}
-	return false;
+	return mPool->Acquire();
 }
 
 
-
-#pragma region Type Tables
-ConstantsTypeTable * ccdb::MySQLDataProvider::GetConstantsTypeTable( const string& name, Directory *parentDir, bool loadColumns/*=false*/ )
+//______________________________________________________________________________
+void ccdb::MySQLDataProvider::LoadDirectories()
 {
-	ClearErrors(); //Clear error in function that can produce new ones
-
-	//check the directory is ok
-	if(parentDir == NULL || parentDir->GetId()<=0)
-	{
-		//error
-		Error(CCDB_ERROR_NO_PARENT_DIRECTORY,"MySQLDataProvider::GetConstantsTypeTable", "Parent directory is null or have invalid ID");
-		return NULL;
+	string thisFunc("MySQLDataProvider::LoadDirectories");
+	if (!IsConnected()) {
+		throw std::runtime_error(thisFunc + " => Not connected to MySQL database ");
 	}
 
-	//check connection
-	if(!IsConnected())
-	{
-		//error !not connect
-		Error(CCDB_ERROR_NOT_CONNECTED,"MySQLDataProvider::GetConstantsTypeTable", "Provider is not connected to MySQL.");
-		return NULL;
-	}
-	
-	string query = StringUtils::Format("SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` FROM `typeTables` WHERE `name` = '%s' AND `directoryId` = '%i';",
-		 /*`name`*/ name.c_str(),
-		 /*`directoryId`*/ parentDir->GetId());
-
-	if(!QuerySelect(query))
-	{
-		//TODO: report error
-		return NULL;
-	}
+	std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+	auto connection = AcquireConnection();
+	MySQLStatement& query = connection->GetStatement("SELECT `id`, `name`, `parentId`, `comment` FROM `directories`");
 
-	
-	//Ok! We querryed our directories! lets catch them! 
-	if(!FetchRow())
-	{
-		//TODO error not selected
-		return NULL;
-	}
+	//clear diretory arrays
+	mDirectories.clear();
+	mDirectoriesById.clear();
 
-	//ok lets read the data...
-	ConstantsTypeTable *result = new ConstantsTypeTable(this, this);
-	result->SetId(ReadULong(0));
-	result->SetCreatedTime(ReadUnixTime(1));
-	result->SetModifiedTime(ReadUnixTime(2));
-	result->SetName(ReadString(3));
-	result->SetDirectoryId(ReadULong(4));
-	result->SetNRows(ReadInt(5));
-	result->SetNColumnsFromDB(ReadInt(6));
-	result->SetComment(ReadString(7));
-	
-	SetObjectLoaded(result); //set object flags that it was just loaded from DB
-	
-	result->SetDirectory(parentDir);
-
-	//some validation of loaded record...
-	if(result->GetName() == "")
-	{
-		//TODO error, name should be not null and not empty
-		Error(CCDB_ERROR_TYPETABLE_HAS_NO_NAME,"MySQLDataProvider::GetConstantsTypeTable", "");
-		delete result;
-		return NULL;
-	}
-	
-	//Ok set a full path for this constant...
-	result->SetFullPath(PathUtils::CombinePath(parentDir->GetFullPath(), result->GetName()));
-
-	
-	FreeMySQLResult();
-	
-	//load columns if needed
-	if(loadColumns) LoadColumns(result);
-        
-
-	return result;
-}
+	query.Execute([&query, this](uint64_t rowIndex) {
+		auto dir = CreateDirectoryObject();
+		dir->SetId(query.ReadInt32(0));               // `id`,
+		dir->SetName(query.ReadString(1));            // `name`,
+		dir->SetParentId(query.ReadInt32(2));         // `parentId`,
+		dir->SetComment(query.ReadString(3));         // `comment`
 
+		mDirectories.push_back(dir);
+		mDirectoriesById[dir->GetId()] = dir;
+	});
 
-bool ccdb::MySQLDataProvider::SearchConstantsTypeTables( vector<ConstantsTypeTable *>& typeTables, const string& pattern, const string& parentPath /*= ""*/, bool loadColumns/*=false*/, int take/*=0*/, int startWith/*=0 */ )
-{
-	ClearErrors(); //Clear error in function that can produce new ones
-
-	// in MYSQL compared to wildcards % is * and _ is 
-	// convert it. 
-	string likePattern = WilcardsToLike(pattern);
-    
-	//do we need to search only in specific directory?
-	string parentAddon("");         //this addition is to query with right parent directory
-	Directory *parentDir = NULL;    //we will need it later anyway
-	if(parentPath!="")
-	{	
-        //we must take care of parent path!
-        if((parentDir = GetDirectory(parentPath.c_str())))
-        {
-            parentAddon = StringUtils::Format(" AND `directoryId` = '%i'", parentDir->GetId());
-        }
-        else
-        {
-            //request was made for directory that doesn't exits
-            //TODO place warning or not?
-            Error(CCDB_ERROR_DIRECTORY_NOT_FOUND,"MySQLDataProvider::GetAllConstantsTypeTables", "Path to search is not found");
-            return false;
-        }
-    }
-    else
-    {
-        //In this case we will need mDirectoriesById
-        //maybe we need to update our directories?
-        UpdateDirectoriesIfNeeded();
-    }
-	    
-	//Ok, lets cleanup result list
-	if(typeTables.size()>0)
-	{
-		vector<ConstantsTypeTable *>::iterator iter = typeTables.begin();
-		while(iter != typeTables.end())
-		{
-			ConstantsTypeTable *obj = *iter;
-			if(IsOwner(obj) ) delete obj;		//delete objects if this provider is owner
-			iter++;	
-		}
-	}
-	typeTables.clear(); //we clear the consts. Considering that some one else  should handle deletion
-
-	string limitAddon = PrepareLimitInsertion(take, startWith);
-    
-	//combine query
-	string query = StringUtils::Format("SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` FROM `typeTables` WHERE `name` LIKE '%s' %s ORDER BY `name` %s;",
-		likePattern.c_str(), parentAddon.c_str(), limitAddon.c_str());
-        
-	if(!QuerySelect(query))
-	{
-		//no report error
-		return false;
-	}
+	//old directories are not deleted: type tables read before may point to them
+	mRootDir->ClearSubdirectories();
 
-    
-	//Ok! We queried our directories! lets catch them! 
-	while(FetchRow())
-	{
-		//ok lets read the data...
-		ConstantsTypeTable *result = new ConstantsTypeTable(this, this);
-
-		result->SetId(ReadULong(0));
-		result->SetCreatedTime(ReadUnixTime(1));
-		result->SetModifiedTime(ReadUnixTime(2));
-		result->SetName(ReadString(3));
-		result->SetDirectoryId(ReadULong(4));
-		result->SetNRows(ReadInt(5));
-		result->SetNColumnsFromDB(ReadInt(6));
-		result->SetComment(ReadString(7));
-
-        if(parentDir) //we already may have parrent directory
-        {
-		    result->SetDirectory(parentDir);
-        }
-        else //Or we should find it...
-        {
-            result->SetDirectory(mDirectoriesById[result->GetDirectoryId()]);
-        }
-
-		SetObjectLoaded(result); //set object flags that it was just loaded from DB
-		
-		typeTables.push_back(result);
-	}
+	BuildDirectoryDependencies();
 
-    //Load COLUMNS if needed...
-	if(loadColumns)
-    {
-        for (int i=0; i< typeTables.size(); i++)
-        {
-            LoadColumns(typeTables[i]);
-        }   
-    }
-    
-	FreeMySQLResult();
-	
-	return true;
+	mDirsAreLoaded = true;
 }
 
 
-std::vector<ConstantsTypeTable *> ccdb::MySQLDataProvider::GetAllConstantsTypeTables(const string &pattern,
-                                                                                     const string &parentPath /*= ""*/,
-                                                                                     bool loadColumns/*=false*/,
-                                                                                     int take/*=0*/,
-                                                                                     int startWith/*=0 */ )
+//______________________________________________________________________________
+ConstantsTypeTable * ccdb::MySQLDataProvider::ReadConstantsTypeTable(MySQLStatement& query)
 {
-	std::vector<ConstantsTypeTable *> tables;
-	SearchConstantsTypeTables(tables, pattern, parentPath,loadColumns, take, startWith);
-	return tables;
+	auto table = CreateTypeTable();
+	table->SetId(query.ReadInt32(0));
+	table->SetCreatedTime(query.ReadUnixTime(1));
+	table->SetModifiedTime(query.ReadUnixTime(2));
+	table->SetName(query.ReadString(3));
+	table->SetDirectoryId(query.ReadInt32(4));
+	table->SetNRows(query.ReadInt32(5));
+	table->SetNColumnsFromDB(query.ReadInt32(6));
+	table->SetComment(query.ReadString(7));
+	return table;
 }
 
-bool ccdb::MySQLDataProvider::LoadColumns( ConstantsTypeTable* table )
-{
-	ClearErrors(); //Clear error in function that can produce new ones
 
-	//check the directory is ok
-	if(table->GetId()<=0)
-	{
-		//TODO error
-		Error(CCDB_ERROR_INVALID_ID,"MySQLDataProvider::LoadColumns", "Type table has wrong ID");
-		return false;
-	}
-		
-	string query = StringUtils::Format("SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `columnType`, `comment` FROM `columns` WHERE `typeId` = '%i' ORDER BY `order`;",
-		/*`directoryId`*/ table->GetId());
+//______________________________________________________________________________
+ConstantsTypeTable * ccdb::MySQLDataProvider::GetConstantsTypeTable( const string& name, Directory *parentDir, bool loadColumns/*=false*/ )
+{
+	std::string thisFunc("ccdb::MySQLDataProvider::GetConstantsTypeTable");
 
-	if(!QuerySelect(query))
-	{
-		return false;
-	}
+	if(!IsConnected()) { throw std::runtime_error(thisFunc + " => MySQLDataProvider is not connected to DB");}
 
-	//clear(); //we clear the consts. Considering that some one else should handle deletion
+	std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+	UpdateDirectoriesIfNeeded();
 
-	//Ok! We querried our directories! lets catch them! 
-	while(FetchRow())
-	{
-		//ok lets read the data...
-		ConstantsTypeColumn *result = new ConstantsTypeColumn(table, this);
-		result->SetId(ReadULong(0));				
-		result->SetCreatedTime(ReadUnixTime(1));
-		result->SetModifiedTime(ReadUnixTime(2));
-		result->SetName(ReadString(3));
-		result->SetType(ReadString(4));
-		result->SetComment(ReadString(5));
-		result->SetDBTypeTableId(table->GetId());
-
-		SetObjectLoaded(result); //set object flags that it was just loaded from DB
-
-		table->AddColumn(result);
+	//check the directory is ok
+	if(parentDir == nullptr || (parentDir->GetFullPath()!=string("/") && parentDir->GetId()<=0)) {
+		throw std::runtime_error(thisFunc + " => Parent directory is null or have invalid ID");
 	}
 
-	FreeMySQLResult();
+	//The table could be already read
+	ConstantsTypeTable *table = FindCachedTypeTable(PathUtils::CombinePath(parentDir->GetFullPath(), name));
+	if(table) return table;
 
-	return true;
-}
-#pragma endregion Type Tables
-
-#pragma region Run ranges
+	auto connection = AcquireConnection();
+	MySQLStatement& query = connection->GetStatement(
+		"SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, "
+		"`name`, `directoryId`, `nRows`, `nColumns`, `comment` "
+		"FROM `typeTables` WHERE `name` = ? AND `directoryId` = ?");
+	query.BindString(0, name);
+	query.BindInt32(1, parentDir->GetId());
 
+	query.Execute([&table, &query, parentDir, this](uint64_t rowIndex) {
+		table = ReadConstantsTypeTable(query);
+		table->SetDirectory(parentDir);
 
+		//Ok set a full path for this constant...
+		table->SetFullPath(PathUtils::CombinePath(parentDir->GetFullPath(), table->GetName()));
+	});
 
-RunRange* ccdb::MySQLDataProvider::GetRunRange( int min, int max, const string& name /*= ""*/ )
-{
-	//build query
-	string query = "SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `runMin`, `runMax`,  `comment`"
-	               " FROM `runRanges` WHERE `runMin`='%i' AND `runMax`='%i' AND `name`=\"%s\"";
-	query = StringUtils::Format(query.c_str(), min, max, name.c_str());
-	
-	//query this
-	if(!QuerySelect(query))
-	{
-		//NO report error
-		return NULL;
-	}
-	
-	//Ok! We queried our run range! lets catch it! 
-	
-	if(!FetchRow())
-	{
-		//nothing was selected
-		return NULL;
-	}
+	if(!table) return nullptr;
 
-	//ok lets read the data...
-	RunRange *result = new RunRange(this, this);
-	result->SetId(ReadULong(0));
-	result->SetCreatedTime(ReadUnixTime(1));
-	result->SetModifiedTime(ReadUnixTime(2));
-	result->SetName(ReadString(3));
-	result->SetMin(ReadInt(4));
-	result->SetMax(ReadInt(5));
-	result->SetComment(ReadString(6));
-	
-	if(mReturnedRowsNum>1)
-	{
-		//TODO warning not uniq row
-		Error(CCDB_ERROR,"MySQLDataProvider::GetRunRange", "Run range with such min, max and name is not alone in the DB");
-	}
+	//Columns are loaded before the table is cached, cached tables are not changed
+	LoadColumns(table);
+	AddCachedTypeTable(table);
 
-	FreeMySQLResult();
-	return result;
+	return table;
 }
 
 
-RunRange* ccdb::MySQLDataProvider::GetRunRange( const string& name )
+//______________________________________________________________________________
+std::vector<ConstantsTypeTable *> ccdb::MySQLDataProvider::GetAllConstantsTypeTables(bool loadColumns)
 {
-	ClearErrors(); //Clear error in function that can produce new ones
-
-	//build query
-	string query = "SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, `name`, `runMin`, `runMax`,  `comment`"
-		" FROM `runRanges` WHERE `name`=\"%s\"";
-	query = StringUtils::Format(query.c_str(), name.c_str());
+	//In this case we will need mDirectoriesById
+	//maybe we need to update our directories?
+	std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+	UpdateDirectoriesIfNeeded();
 
-	//query this
-	if(!QuerySelect(query))
-	{
-		//NO report error
-		return NULL;
-	}
+	auto connection = AcquireConnection();
+	MySQLStatement& query = connection->GetStatement(
+		"SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, "
+		"`name`, `directoryId`, `nRows`, `nColumns`, `comment` FROM `typeTables`");
 
-	//Ok! We querried our run range! lets catch it! 
-	if(!FetchRow())
-	{
-		//nothing was selected
-		return NULL;
-	}
+	//Tables that are already read are taken from the cache
+	std::vector<ConstantsTypeTable *> tables;
+	std::vector<ConstantsTypeTable *> newTables;
+	query.Execute([&query, &tables, &newTables, this](uint64_t rowIndex) {
+		Directory *parentDir = mDirectoriesById[query.ReadInt32(4)];
+		ConstantsTypeTable *table = parentDir ? FindCachedTypeTable(PathUtils::CombinePath(parentDir->GetFullPath(), query.ReadString(3))) : nullptr;
+		if(!table) {
+			table = ReadConstantsTypeTable(query);
+			table->SetDirectory(parentDir);
+			if(parentDir) table->SetFullPath(PathUtils::CombinePath(parentDir->GetFullPath(), table->GetName()));
+			newTables.push_back(table);
+		}
+		tables.push_back(table);
+	});
 
-	//ok lets read the data...
-	RunRange *result = new RunRange(this, this);
-	result->SetId(ReadULong(0));
-	result->SetCreatedTime(ReadUnixTime(1));
-	result->SetModifiedTime(ReadUnixTime(2));
-	result->SetName(ReadString(3));
-	result->SetMin(ReadInt(4));
-	result->SetMax(ReadInt(5));
-	result->SetComment(ReadString(6));
-
-	if(mReturnedRowsNum>1)
-	{
-		//warning not uniq row
-		Error(CCDB_ERROR,"MySQLDataProvider::GetRunRange", "Run range with such name is not alone in the DB");
+	//Columns are loaded before tables are cached, cached tables are not changed
+	LoadColumns(newTables);
+	for(auto table: newTables) {
+		if(table->GetDirectory()) AddCachedTypeTable(table);
 	}
-
-	FreeMySQLResult();
-	return result;
+	return tables;
 }
 
 
-bool ccdb::MySQLDataProvider::GetRunRanges(vector<RunRange*>& resultRunRanges, ConstantsTypeTable* table, const string& variation/*=""*/, int take/*=0*/, int startWith/*=0*/)
+//______________________________________________________________________________
+void ccdb::MySQLDataProvider::LoadColumns( ConstantsTypeTable* table )
 {
-	ClearErrors(); //Clear error in function that can produce new ones
-
-	if(!CheckConnection("MySQLDataProvider::GetRunRanges(vector<DRunRange*>& resultRunRanges, ConstantsTypeTable* table, int take, int startWith)")) return false;
-	
-	//validate table
-	if(!table || !table->GetId())
-	{
-		//TODO report error
-		Error(CCDB_ERROR_NO_TYPETABLE,"MySQLDataProvider::GetRunRanges", "Type table is null or have invalid id");
-		return false;
-	}
-	//variation handle
-	string variationWhere("");
-	if(variation != "")
-	{
-		variationWhere.assign(StringUtils::Format(" AND `variations`.`name`=\"%s\" ", variation.c_str()));
-	}
-
-	//limits handle 
-	string limitInsertion = PrepareLimitInsertion(take, startWith);
-	
-	//Ok, lets cleanup result list
-	if(resultRunRanges.size()>0)
-	{
-		vector<RunRange *>::iterator iter = resultRunRanges.begin();
-		while(iter != resultRunRanges.end())
-		{
-			RunRange *obj = *iter;
-			if(IsOwner(obj)) delete obj;		//delete objects if this provider is owner
-			iter++;
-		}
-	}
-	resultRunRanges.clear(); //we clear the consts. Considering that some one else should handle deletion
+	auto connection = AcquireConnection();
+	MySQLStatement& query = connection->GetStatement(
+		"SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, "
+		"`name`, `columnType`, `comment` FROM `columns` WHERE `typeId` = ? ORDER BY `order`");
+	query.BindInt32(0, table->GetId());
+
+	//Columns are set all at once, so the table descriptor is built once
+	vector<ConstantsTypeColumn *> columns;
+	query.Execute([&table, &query, &columns, this](uint64_t rowIndex) {
+		auto column = CreateColumn();
+		column->SetId(query.ReadInt32(0));
+		column->SetCreatedTime(query.ReadUnixTime(1));
+		column->SetModifiedTime(query.ReadUnixTime(2));
+		column->SetName(query.ReadString(3));
+		column->SetType(query.ReadString(4));
+		column->SetComment(query.ReadString(5));
+		column->SetDBTypeTableId(table->GetId());
+		columns.push_back(column);
+	});
+	table->SetColumns(columns);
+}
 
 
-	//ok now we must build our mighty query...
-	string query= 
-		" SELECT "
-		" DISTINCT `runRanges`.`id` as `id`, "
-		" UNIX_TIMESTAMP(`runRanges`.`created`) as `created`, "
-		" UNIX_TIMESTAMP(`runRanges`.`modified`) as `modified`, "
-		" `runRanges`.`name` as `name`, "
-		" `runRanges`.`runMin` as `runMin`, "
-		" `runRanges`.`runMax` as `runMax`, "
-		"`runRanges`.`comment` as `comment` "
-		" FROM `typeTables` "
-		" INNER JOIN `assignments` ON `assignments`.`runRangeId`= `runRanges`.`id` "
-		" INNER JOIN `variations` ON `assignments`.`variationId`= `variations`.`id` "
-		" INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
-		" INNER JOIN `typeTables` ON `constantSets`.`constantTypeId` = `typeTables`.`id` "
-		" WHERE `typeTables`.`id` = '%i' "
-		" %s "
-		" ORDER BY `runRanges`.`runMin` ASC	 %s";
-		
-	query=StringUtils::Format(query.c_str(), table->GetId(), variationWhere.c_str(), limitInsertion.c_str());
-	
-	//query this
-	if(!QuerySelect(query))
-	{
-		//TODO report error
-		return false;
-	}
-
-	//Ok! We querried our run range! lets catch it! 
-	while(FetchRow())
-	{
-		//ok lets read the data...
-		RunRange *result = new RunRange(this, this);
-		result->SetId(ReadULong(0));
-		result->SetCreatedTime(ReadUnixTime(1));
-		result->SetModifiedTime(ReadUnixTime(2));
-		result->SetName(ReadString(3));
-		result->SetMin(ReadInt(4));
-		result->SetMax(ReadInt(5));
-		result->SetComment(ReadString(7));
-		
-		SetObjectLoaded(result);
-		resultRunRanges.push_back(result);
+//______________________________________________________________________________
+void ccdb::MySQLDataProvider::LoadColumns(const std::vector<ConstantsTypeTable*>& tables)
+{
+	if(tables.size() < 2) {
+		for(auto table: tables) LoadColumns(table);
+		return;
 	}
 
-	FreeMySQLResult();
-	return true;
+	//Columns of all tables are read by one query and are given to the requested ones
+	std::map<dbkey_t, vector<ConstantsTypeColumn *>> columnsByTableId;
+	for(auto table: tables) columnsByTableId[table->GetId()];
+
+	auto connection = AcquireConnection();
+	MySQLStatement& query = connection->GetStatement(
+		"SELECT `id`, UNIX_TIMESTAMP(`created`) as `created`, UNIX_TIMESTAMP(`modified`) as `modified`, "
+		"`name`, `columnType`, `comment`, `typeId` FROM `columns` ORDER BY `typeId`, `order`");
+
+	query.Execute([&query, &columnsByTableId, this](uint64_t rowIndex) {
+		auto columns = columnsByTableId.find(query.ReadInt32(6));
+		if(columns == columnsByTableId.end()) return;
+
+		auto column = CreateColumn();
+		column->SetId(query.ReadInt32(0));
+		column->SetCreatedTime(query.ReadUnixTime(1));
+		column->SetModifiedTime(query.ReadUnixTime(2));
+		column->SetName(query.ReadString(3));
+		column->SetType(query.ReadString(4));
+		column->SetComment(query.ReadString(5));
+		column->SetDBTypeTableId(columns->first);
+		columns->second.push_back(column);
+	});
+
+	for(auto table: tables) table->SetColumns(columnsByTableId[table->GetId()]);
 }
 
 
-
-
+//______________________________________________________________________________
 Variation* ccdb::MySQLDataProvider::GetVariation( const string& name )
 {
-	ClearErrors(); //Clear error in function that can produce new ones
-    if(mLastVariation!=NULL && mLastVariation->GetName()==name) return mLastVariation;
-
-    return SelectVariation("`name`= \"" + name + "\"");
+	//check that maybe we have this variation id by the last request?
+	std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+	auto iter = mVariationsByName.find(name);
+	if(iter != mVariationsByName.end()) return iter->second;
+
+	auto connection = AcquireConnection();
+	MySQLStatement& query = connection->GetStatement("SELECT `id`, `parentId`, `name`, `comment` FROM `variations` WHERE `name` = ?");
+	query.BindString(0, name);
+	return SelectVariation(query);
 }
 
-/** @brief Load variation by name
-* 
-* @param     const char * name
-* @return   DVariation*
-*/
-Variation* ccdb::MySQLDataProvider::GetVariationById(int id)
-{
-    if(mVariationsById.find(id) != mVariationsById.end()) return mVariationsById[id];
-    
-    ClearErrors(); //Clear error in function that can produce new ones
-    return SelectVariation("`id`= " + StringUtils::IntToString(id) + "");
-}
 
-/**
-* Get variation by database request
-*/
-Variation* ccdb::MySQLDataProvider::SelectVariation(const string& whereClause)
+//______________________________________________________________________________
+Variation* ccdb::MySQLDataProvider::GetVariationById(dbkey_t id)
 {
-    //TODO: Implement method
-    string query = "SELECT `id`, `name`, `comment`, `parentId`"
-        " FROM `variations` WHERE "+whereClause+";";
-
-    //query this
-    if(!QuerySelect(query))
-    {
-        //TODO report error
-        return NULL;
-    }
-
-    //Ok! We queried our run range! lets catch it! 
-    if(!FetchRow())
-    {
-        //nothing was selected
-        return NULL;
-    }
-
-    //ok lets read the data...
-    Variation *result = new Variation();
-    result->SetId(ReadULong(0));
-    result->SetName(ReadString(3));
-    result->SetComment(ReadString(5));
-    result->SetParentDbId(ReadULong(6));
-
-    if(mReturnedRowsNum>1)
-    {
-        //TODO warning not uniq row
-    }
-
-    mVariationsById[result->GetId()] = result;
-    mLastVariation = result;
-    FreeMySQLResult();
-
-    //Get parent recursively
-    if(result->GetParentDbId()!=0)
-    {
-        result->SetParent(GetVariationById(result->GetParentDbId()));
-    }
-
-    return result;
+	//check that maybe we have this variation id by the last request?
+	std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+	auto iter = mVariationsById.find(id);
+	if(iter != mVariationsById.end()) return iter->second;
+
+	auto connection = AcquireConnection();
+	MySQLStatement& query = connection->GetStatement("SELECT `id`, `parentId`, `name`, `comment` FROM `variations` WHERE `id` = ?");
+	query.BindInt32(0, id);
+	return SelectVariation(query);
 }
 
 
-#pragma endregion Variations
+//______________________________________________________________________________
+Variation* ccdb::MySQLDataProvider::SelectVariation(MySQLStatement& query)
+{
+	Variation *var = nullptr;
+	query.Execute([&var, &query, this](uint64_t rowIndex) {
+		var = CreateVariation();
+		var->SetId(query.ReadUInt32(0));
+		var->SetParentDbId(query.ReadUInt32(1));
+		var->SetName(query.ReadString(2));
+		var->SetComment(query.ReadString(3));
+	});
+
+	if(var) {
+		//add to cache
+		mVariationsById[var->GetId()] = var;
+		mVariationsByName[var->GetName()] = var;
+
+		//recursive call to get variation parent
+		if(var->GetParentDbId() > 0) {
+			var->SetParent(GetVariationById(var->GetParentDbId()));
+		}
+	}
 
-//----------------------------------------------------------------------------------------
-//	A S S I G N M E N T S
-//----------------------------------------------------------------------------------------
+	return var;
+}
 
 
+//______________________________________________________________________________
 Assignment* ccdb::MySQLDataProvider::GetAssignmentShort(int run, const string& path, time_t time, const string& variationName, bool loadColumns /*=false*/)
 {
-    /** @brief Get specified by creation time version of Assignment with data blob only.
-     *
-     * The Time is a timestamp, data that is equal or earlier in time than that timestamp is returned
-     *
-     * @remarks this function is named so
-     * @param [in] run - run number
-     * @param [in] path - object path
-     * @param [in] time - timestamp, data that is equal or earlier in time than that timestamp is returned
-     * @param [in] variation - variation name
-     * @return new DAssignment object or 
-     */
-
-    string thisFuncName("ccdb::MySQLDataProvider::GetAssignmentShort");
+	string thisFuncName("ccdb::MySQLDataProvider::GetAssignmentShort");
 
 	if(!IsConnected()) {
-	    throw runtime_error(thisFuncName+" => Not connected to DB");
+		throw std::runtime_error(thisFuncName+" => Not connected to DB");
 	}
-	        
-    //Get directory. Directories should be cached. So this doesn't make a database request
-    
-    ConstantsTypeTable *table = GetConstantsTypeTable(path, loadColumns);
-    if(!table)
-    {
-        throw runtime_error(thisFuncName+" => Type table was not found: '"+path+"'");
-    }
-
-    //retrieve name of our constant table 
-    string tableName = PathUtils::ExtractObjectname(path);
-
-    //get variation
-    Variation* variation = GetVariation(variationName);
-    if(!variation)
-    {
-        throw runtime_error(thisFuncName+" => No variation '"+variationName+"' was found");
-        return NULL;
-    }
-
-    //run number to string
-    string runStr = StringUtils::IntToString(run);
 
-	//ok now we must build our mighty query...
-	string query=
-        "SELECT `assignments`.`id` AS `asId`, "
-        "`constantSets`.`vault` AS `blob` "
-        "FROM  `assignments` "
-        "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
-        "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
-        "INNER JOIN `typeTables` ON `constantSets`.`constantTypeId` = `typeTables`.`id` "
-        "WHERE  `runRanges`.`runMin` <= '"+runStr+"' "
-        "AND `runRanges`.`runMax` >= '"+runStr+"' "
-        "AND `assignments`.`variationId`= '"+StringUtils::IntToString(variation->GetId())+"' "
-        "AND `constantSets`.`constantTypeId` ='"+StringUtils::IntToString(table->GetId())+"' ";
-    
-    //time in querY?
-    if(time>0)
-    {
-        char timeBuf[32];
-        sprintf(timeBuf,"%lu",time);
-        query=query + "AND UNIX_TIMESTAMP(`assignments`.`created`) <= '"+string(timeBuf)+"' ";
-    }
-
-    //finish query 
-    query = query + "ORDER BY `assignments`.`id` DESC LIMIT 1 ";
-	
-	//query this
-	if(!QuerySelect(query))
+	//Catalog objects are shared between threads. Lock them before any connection is taken
+	//(catalog lock -> connection is the only lock order used here)
+	ConstantsTypeTable *table;
+	Variation* variation;
 	{
-		return nullptr;
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+
+		//Get type table. Directories are cached. So this doesn't make a database request
+		table = DataProvider::GetConstantsTypeTable(path, loadColumns);
+		if(!table)
+		{
+			throw std::runtime_error(thisFuncName+" => Type table was not found: '"+path+"'");
+		}
+
+		//get variation
+		variation = GetVariation(variationName);
+		if(!variation)
+		{
+			throw std::runtime_error(thisFuncName+" => No variation '"+variationName+"' was found");
+		}
 	}
 
-    //If We have not found data for this variation, getting data for parent variation
-    if(mReturnedRowsNum==0 && variation->GetParentDbId()!=0)
-    {
-        delete table;
-		return GetAssignmentShort(run, path, time, variation->GetParent()->GetName(), loadColumns);
-    }
+	//ok now we must build our mighty query...
+	//The connection is given back to the pool at the end of the block, before the catalog may be locked again
+	//The assignment is owned here until it is returned, so errors after the row is read don't leak it
+	std::unique_ptr<Assignment> assignment;
+	dbkey_t runRangeId = 0;
+	int runMin = 0, runMax = 0;
+	uint64_t selectedRows = ReadWithRetry([&](MySQLConnection& connection) -> uint64_t {
+		assignment.reset();      // Left by a lost connection
+		MySQLStatement& query = connection.GetStatement(
+			"SELECT `assignments`.`id` AS `asId`, "
+			"`constantSets`.`vault` AS `blob`, "
+			"`assignments`.`constantSetId`, "
+			"`runRanges`.`id`, `runRanges`.`runMin`, `runRanges`.`runMax` "
+			"FROM  `assignments` "
+			"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+			"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+			"WHERE  `runRanges`.`runMin` <= ? "
+			"AND `runRanges`.`runMax` >= ? "
+			"AND `assignments`.`variationId`= ? "
+			"AND `constantSets`.`constantTypeId` = ? " +
+			((time>0)? string("AND `assignments`.`created` <= FROM_UNIXTIME(?) ") : string()) +
+			"ORDER BY `assignments`.`id` DESC "
+			"LIMIT 1");
+
+		query.BindInt32(0, run);
+		query.BindInt32(1, run);
+		query.BindInt32(2, variation->GetId());
+		query.BindInt32(3, table->GetId());
+		if(time>0) {
+			query.BindInt64(4, time);
+		}
 
-	//Ok! We queried our run range! lets catch it! 
-	if(!FetchRow())
+		return query.Execute([&assignment, &query, &runRangeId, &runMin, &runMax, run](uint64_t rowIndex) {
+			assignment.reset(new Assignment());
+			assignment->SetId( query.ReadInt32(0) );
+			assignment->SetRawData(query.ReadString(1));
+			assignment->SetDataVaultId(query.ReadInt32(2));
+			assignment->SetRequestedRun(run);
+			runRangeId = query.ReadInt32(3);
+			runMin = query.ReadInt32(4);
+			runMax = query.ReadInt32(5);
+		});
+	});
+
+	//If We have not found data for this variation, getting data for parent variation
+	if((assignment == nullptr && selectedRows==0) && variation->GetParentDbId()!=0)
 	{
-		Error(CCDB_ERROR_NO_ASSIGMENT,"MySQLDataProvider::GetAssignmentShort(int, const string&, time_t, const string&)")
-		return NULL;
+		return GetAssignmentShort(run, path, time, variation->GetParent()->GetName(), loadColumns);
 	}
 
-	//ok lets read the data...
-	Assignment *result = new Assignment();
-	result->SetId( ReadIndex(0) );
-	result->SetRawData( ReadString(1) );
-	
-	//additional fill
-	result->SetRequestedRun(run);
-	result->SetVariationId(variation->GetId());
-	
-    //type table
-    result->SetTypeTable(table);
-    result->BeOwner(table);
-    table->SetOwner(result);
-
-	if(mReturnedRowsNum>1)
+	if(assignment != nullptr)
 	{
-		//TODO warning not uniq row
-	}
+		assignment->SetTypeTable(table);
+		assignment->SetVariation(variation);
+		assignment->SetRunRangeId(runRangeId);
 
-	FreeMySQLResult();
-	return result;
+		//Run ranges are catalog objects shared between threads
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+		assignment->SetRunRange(GetCachedRunRange(runRangeId, runMin, runMax));
+	}
 
+	return assignment.release();
 }
 
 
-bool ccdb::MySQLDataProvider::GetAssignments( vector<Assignment *> &assingments,const string& path, int runMin, int runMax, const string& runRangeName, const string& variation, time_t beginTime, time_t endTime, int sortBy/*=0*/,  int take/*=0*/, int startWith/*=0*/ )
+//______________________________________________________________________________
+ccdb::AssignmentIdentity ccdb::MySQLDataProvider::GetAssignmentIdentity(int run, const string& path, time_t time, const string& variationName)
 {
-	ClearErrors(); //Clear error in function that can produce new ones
+	string thisFuncName("ccdb::MySQLDataProvider::GetAssignmentIdentity");
 
-	if(!CheckConnection("MySQLDataProvider::GetAssignments( ... )")) return false;
-
-	//get table! 
-	ConstantsTypeTable *table = GetConstantsTypeTable(path, true);
-	if(!table)
-	{
-		//TODO report error
-		Error(CCDB_ERROR_NO_TYPETABLE,"MySQLDataProvider::GetAssignments", "Type table was not found");
-		return false;
+	if(!IsConnected()) {
+		throw std::runtime_error(thisFuncName+" => Not connected to DB");
 	}
 
-	//Ok, lets cleanup result list
-	if(assingments.size()>0)
+	ConstantsTypeTable *table;
+	Variation* variation;
 	{
-		vector<Assignment *>::iterator iter = assingments.begin();
-		while(iter != assingments.end())
-		{
-			Assignment *obj = *iter;
-			if(IsOwner(obj)) delete obj;	//delete objects if this provider is owner
-			iter++;
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+		table = DataProvider::GetConstantsTypeTable(path, false);
+		if(!table) {
+			throw std::runtime_error(thisFuncName+" => Type table was not found: '"+path+"'");
+		}
+		variation = GetVariation(variationName);
+		if(!variation) {
+			throw std::runtime_error(thisFuncName+" => No variation '"+variationName+"' was found");
 		}
 	}
-	assingments.clear();
 
-	//run range handle
-	string runRangeWhere(""); //Where clause for run range
-	if(runRangeName != "")
-	{
-		runRangeWhere = StringUtils::Format(" AND `runRanges`.`name` = \"%s\" ", runRangeName.c_str());
-	}
-	else if(runMax!=0 || runMin!=0)
-	{
-		runRangeWhere = StringUtils::Format(" AND `runRanges`.`runMin` <= '%i' AND `runRanges`.`runMax` >= '%i' ", runMin, runMax);
-	}
+	//The same selection as GetAssignmentShort, but the vault is not transferred
+	AssignmentIdentity identity = ReadWithRetry([&](MySQLConnection& connection) -> AssignmentIdentity {
+		AssignmentIdentity result;
+		MySQLStatement& query = connection.GetStatement(
+			"SELECT `assignments`.`id`, `assignments`.`constantSetId` "
+			"FROM  `assignments` "
+			"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+			"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+			"WHERE  `runRanges`.`runMin` <= ? "
+			"AND `runRanges`.`runMax` >= ? "
+			"AND `assignments`.`variationId`= ? "
+			"AND `constantSets`.`constantTypeId` = ? " +
+			((time>0)? string("AND `assignments`.`created` <= FROM_UNIXTIME(?) ") : string()) +
+			"ORDER BY `assignments`.`id` DESC "
+			"LIMIT 1");
+
+		query.BindInt32(0, run);
+		query.BindInt32(1, run);
+		query.BindInt32(2, variation->GetId());
+		query.BindInt32(3, table->GetId());
+		if(time>0) {
+			query.BindInt64(4, time);
+		}
 
-	//variation handle
-	string variationWhere("");
-	if(variation != "")
-	{
-		variationWhere.assign(StringUtils::Format(" AND `variations`.`name`=\"%s\" ", variation.c_str()));
-	}
+		query.Execute([&result, &query](uint64_t rowIndex) {
+			result.AssignmentId = query.ReadInt32(0);
+			result.ConstantSetId = query.ReadInt32(1);
+		});
+		return result;
+	});
 
-	//time handle 
-	string timeWhere("");
-	if(beginTime!=0 || endTime!=0)
-	{
-		timeWhere.assign(StringUtils::Format(" AND `asCreated` >= '%i' AND `asCreated` <= '%i' ", beginTime, endTime));
+	//If We have not found data for this variation, getting data for parent variation
+	if(!identity.AssignmentId && variation->GetParentDbId()!=0) {
+		return GetAssignmentIdentity(run, path, time, variation->GetParent()->GetName());
 	}
+	return identity;
+}
 
-	//limits handle 
-	string limitInsertion = PrepareLimitInsertion(take, startWith);
-
-	//sort order
-	string orderByInsertion(" ORDER BY `assignments`.`created` DESC ");
-	if(sortBy == 1)
-	{
-		orderByInsertion.assign(" ORDER BY `assignments`.`created` ASC ");
-	}
 
+//______________________________________________________________________________
+uint64_t ccdb::MySQLDataProvider::VisitAssignments(const string& path, const string& variationName, int run, time_t time,
+												   const std::function<bool(Assignment&)>& onAssignment)
+{
+	string thisFuncName("ccdb::MySQLDataProvider::VisitAssignments");
 
-	//ok now we must build our mighty query...
-	string query=
-	/*fieldN*/  " SELECT "
-	/*00*/  " `assignments`.`id` AS `asId`,	"
-	/*01*/  " UNIX_TIMESTAMP(`assignments`.`created`) as `asCreated`,"
-	/*02*/  " UNIX_TIMESTAMP(`assignments`.`modified`) as `asModified`,	"
-	/*03*/  " `assignments`.`comment` as `asComment`, "
-	/*04*/  " `constantSets`.`id` AS `constId`, "
-	/*05*/  " `constantSets`.`vault` AS `blob`, "
-	/*06*/  " `runRanges`.`id`   AS `rrId`, "
-	/*07*/  " UNIX_TIMESTAMP(`runRanges`.`created`) as `rrCreated`,"
-	/*08*/  " UNIX_TIMESTAMP(`runRanges`.`modified`) as `rrModified`,	"
-	/*09*/  " `runRanges`.`name`   AS `rrName`, "
-	/*10*/  " `runRanges`.`runMin`   AS `rrMin`, "
-	/*11*/  " `runRanges`.`runMax`   AS `runMax`, "
-	/*12*/  " `runRanges`.`comment` as `rrComment`, "
-	/*13*/  " `variations`.`id`  AS `varId`, "
-	/*14*/  " UNIX_TIMESTAMP(`variations`.`created`) as `varCreated`,"
-	/*15*/  " UNIX_TIMESTAMP(`variations`.`modified`) as `varModified`,	"
-	/*16*/  " `variations`.`name` AS `varName`, "
-	/*17*/  " `variations`.`comment`  AS `varComment` "
-		    " FROM `runRanges` "
-		    " INNER JOIN `assignments` ON `assignments`.`runRangeId`= `runRanges`.`id`"
-		    " INNER JOIN `variations` ON `assignments`.`variationId`= `variations`.`id`	"
-		    " INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id`"
-		    " INNER JOIN `typeTables` ON `constantSets`.`constantTypeId` = `typeTables`.`id`"
-		    " WHERE  `typeTables`.`id` = '%i' %s %s %s %s %s";
-
-
-	query=StringUtils::Format(query.c_str(), table->GetId(), runRangeWhere.c_str(), variationWhere.c_str(), timeWhere.c_str(), orderByInsertion.c_str(), limitInsertion.c_str());
-	//query this
-	if(!QuerySelect(query))
+	//Get type table with columns, so visited assignments could map their data
+	ConstantsTypeTable* table;
+	Variation* variation;
 	{
-		//TODO report error
-		return false;
-	}
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+		table = DataProvider::GetConstantsTypeTable(path, true);
+		if(!table)
+		{
+			throw std::runtime_error(thisFuncName+" => Type table was not found: '"+path+"'");
+		}
 
-	//Ok! We querried our run range! lets catch it! 
-	while(FetchRow())
-	{
-		assingments.push_back(FetchAssignment(table));
-		
+		variation = GetVariation(variationName);
+		if(!variation)
+		{
+			throw std::runtime_error(thisFuncName+" => No variation '"+variationName+"' was found");
+		}
 	}
 
-	FreeMySQLResult();
-	
-	return true;
-}
-
-bool ccdb::MySQLDataProvider::GetAssignments(vector<Assignment*>& assingments, const string& path, int run, const string& variation, time_t date, int take, int startWith)
-{
-	return GetAssignments(assingments, path, run, run,"",variation, 0, date, take, startWith);
-}
+	//Rows are read by pages, newest first, and the connection is given back before onAssignment is called.
+	//So the callback may call the provider (the catalog -> connection lock order is kept) and a page read
+	//that lost its connection is simply repeated
+	struct VisitedRow
+	{
+		dbkey_t Id;
+		time_t Created;
+		string Comment;
+		dbkey_t RunRangeId;
+		int RunMin;
+		int RunMax;
+		string Vault;
+		dbkey_t ConstantSetId;
+	};
+	const size_t pageSize = 256;
+
+	uint64_t visitedCount = 0;
+	dbkey_t lastId = 0;
+	while(true)
+	{
+		std::vector<VisitedRow> page = ReadWithRetry([&](MySQLConnection& connection) -> std::vector<VisitedRow> {
+			MySQLStatement& query = connection.GetStatement(
+				"SELECT `assignments`.`id`, UNIX_TIMESTAMP(`assignments`.`created`), `assignments`.`comment`, "
+				"`runRanges`.`id`, `runRanges`.`runMin`, `runRanges`.`runMax`, "
+				"`constantSets`.`vault`, `constantSets`.`id` "
+				"FROM  `assignments` "
+				"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+				"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+				"WHERE `assignments`.`variationId`= ? "
+				"AND `constantSets`.`constantTypeId` = ? " +
+				((run>=0)? string("AND `runRanges`.`runMin` <= ? AND `runRanges`.`runMax` >= ? ") : string()) +
+				((time>0)? string("AND `assignments`.`created` <= FROM_UNIXTIME(?) ") : string()) +
+				((lastId>0)? string("AND `assignments`.`id` < ? ") : string()) +
+				"ORDER BY `assignments`.`id` DESC "
+				"LIMIT ?");
+
+			int paramIndex = 0;
+			query.BindInt32(paramIndex++, variation->GetId());
+			query.BindInt32(paramIndex++, table->GetId());
+			if(run>=0) {
+				query.BindInt32(paramIndex++, run);
+				query.BindInt32(paramIndex++, run);
+			}
+			if(time>0) {
+				query.BindInt64(paramIndex++, time);
+			}
+			if(lastId>0) {
+				query.BindInt32(paramIndex++, lastId);
+			}
+			query.BindInt64(paramIndex++, static_cast<int64_t>(pageSize));
+
+			std::vector<VisitedRow> rows;
+			rows.reserve(pageSize);
+			query.Execute([&rows, &query](uint64_t rowIndex) {
+				VisitedRow row;
+				row.Id = query.ReadInt32(0);
+				row.Created = query.ReadUnixTime(1);
+				row.Comment = query.ReadString(2);
+				row.RunRangeId = query.ReadInt32(3);
+				row.RunMin = query.ReadInt32(4);
+				row.RunMax = query.ReadInt32(5);
+				row.Vault = query.ReadString(6);
+				row.ConstantSetId = query.ReadInt32(7);
+				rows.push_back(std::move(row));
+			});
+			return rows;
+		});
+
+		for(auto& row: page)
+		{
+			RunRange runRange;
+			runRange.SetId(row.RunRangeId);
+			runRange.SetRange(row.RunMin, row.RunMax);
+
+			Assignment assignment;
+			assignment.SetId(row.Id);
+			assignment.SetCreatedTime(row.Created);
+			assignment.SetComment(row.Comment);
+			assignment.SetRunRangeId(runRange.GetId());
+			assignment.SetRunRange(&runRange);
+			assignment.SetRawData(std::move(row.Vault));
+			assignment.SetDataVaultId(row.ConstantSetId);
+			assignment.SetRequestedRun(run);
+			assignment.SetTypeTable(table);
+			assignment.SetVariation(variation);
+			assignment.SetVariationId(variation->GetId());
+
+			visitedCount++;
+			if(!onAssignment(assignment)) return visitedCount;
+		}
 
-vector<Assignment *> ccdb::MySQLDataProvider::GetAssignments( const string& path, int run, const string& variation/*=""*/, time_t date/*=0*/, int take/*=0*/, int startWith/*=0*/ )
-{
-	vector<Assignment *> assingments;
-	GetAssignments(assingments, path, run,variation, date, take, startWith);
-	return assingments;
+		if(page.size() < pageSize) return visitedCount;
+		lastId = page.back().Id;
+	}
 }
 
-bool ccdb::MySQLDataProvider::GetAssignments( vector<Assignment *> &assingments,const string& path, const string& runName, const string& variation/*=""*/, time_t date/*=0*/, int take/*=0*/, int startWith/*=0*/ )
-{
-	return GetAssignments(assingments, path, 0, 0,runName,variation, 0, date, take, startWith);
-}
 
-vector<Assignment *> ccdb::MySQLDataProvider::GetAssignments( const string& path, const string& runName, const string& variation/*=""*/, time_t date/*=0*/, int take/*=0*/, int startWith/*=0*/ )
+//______________________________________________________________________________
+std::vector<Assignment *> ccdb::MySQLDataProvider::GetLatestAssignments(int run, time_t time, const string& variationName, bool loadColumns)
 {
-	vector<Assignment *> assingments;
-	GetAssignments(assingments, path, runName,variation, date, take, startWith);
-	return assingments;
-}
+	string thisFuncName("ccdb::MySQLDataProvider::GetLatestAssignments");
 
+	//Variation chain from the requested variation to the root. The closer variation has a priority
+	std::vector<Variation*> chain;
+	{
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+		Variation* variation = GetVariation(variationName);
+		if(!variation)
+		{
+			throw std::runtime_error(thisFuncName+" => No variation '"+variationName+"' was found");
+		}
+		for(; variation; variation = variation->GetParent()) chain.push_back(variation);
+	}
 
+	//Latest assignment id for each (table, variation) pair in one query
+	std::string variationPlaceholders;
+	for(size_t i = 0; i < chain.size(); i++) variationPlaceholders += (i==0) ? "?" : ", ?";
 
-bool ccdb::MySQLDataProvider::FillAssignment(Assignment* assignment)
-{
-	ClearErrors(); //Clear error in function that can produce new ones
-	if(assignment == NULL || !assignment->GetId())
+	//The best assignment of a table and its run range, which is a catalog object taken after the read
+	struct LatestAssignment
 	{
-		//TODO report errors
-		Error(CCDB_ERROR_ASSIGMENT_INVALID,"MySQLDataProvider::FillAssignment", "ASSIGnMENt is NULL or has improper ID so update operations cant be done");
-		return false;
-	}
-	
-	//ok now we must build our mighty query...
-	string query=
-	/*fieldN*/  " SELECT "
-	/*00*/  " `assignments`.`id` AS `asId`,	"
-	/*01*/  " UNIX_TIMESTAMP(`assignments`.`created`) as `asCreated`,"
-	/*02*/  " UNIX_TIMESTAMP(`assignments`.`modified`) as `asModified`,	"
-	/*03*/  " `assignments`.`comment` as `asComment`, "
-	/*04*/  " `constantSets`.`id` AS `constId`, "
-	/*05*/  " `constantSets`.`vault` AS `blob`, "
-	/*06*/  " `runRanges`.`id`   AS `rrId`, "
-	/*07*/  " UNIX_TIMESTAMP(`runRanges`.`created`) as `rrCreated`,"
-	/*08*/  " UNIX_TIMESTAMP(`runRanges`.`modified`) as `rrModified`,	"
-	/*09*/  " `runRanges`.`name`   AS `rrName`, "
-	/*10*/  " `runRanges`.`runMin`   AS `rrMin`, "
-	/*11*/  " `runRanges`.`runMax`   AS `runMax`, "
-	/*12*/  " `runRanges`.`comment` as `rrComment`, "
-	/*13*/  " `variations`.`id`  AS `varId`, "
-	/*14*/  " UNIX_TIMESTAMP(`variations`.`created`) as `varCreated`,"
-	/*15*/  " UNIX_TIMESTAMP(`variations`.`modified`) as `varModified`,	"
-	/*16*/  " `variations`.`name` AS `varName`, "
-	/*17*/  " `variations`.`comment`  AS `varComment`, "
-	/*18*/  " `typeTables`.`name` AS `typeTableName`, "
-	/*19*/  " `directories`.`id` AS `dirId` "
-		    " FROM `runRanges` "
-		    " INNER JOIN `assignments` ON `assignments`.`runRangeId`= `runRanges`.`id`"
-		    " INNER JOIN `variations` ON `assignments`.`variationId`= `variations`.`id`	"
-		    " INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id`"
-		    " INNER JOIN `typeTables` ON `constantSets`.`constantTypeId` = `typeTables`.`id`"
-			" INNER JOIN `directories` ON `typeTables`.`directoryId` = `directories`.`id`"
-		    " WHERE  `assignments`.`id` = '%i'";
-	
-	
-	query=StringUtils::Format(query.c_str(), assignment->GetId());
-	//cout << query<<endl;
-	//query this
-	if(!QuerySelect(query))
+		size_t ChainIndex;
+		Assignment* Selected;
+		int RunMin;
+		int RunMax;
+	};
+	std::map<dbkey_t, LatestAssignment> bestByTableId;
+	try
 	{
-		//TODO report error
-		cout<<"!QuerySelect(query)"<<endl;
-		return false;
+		ReadWithRetry([&](MySQLConnection& connection) {
+			for(auto& best: bestByTableId) delete best.second.Selected;     // Left by a lost connection
+			bestByTableId.clear();
+
+			MySQLStatement& query = connection.GetStatement(
+				"SELECT `assignments`.`id`, `assignments`.`variationId`, `constantSets`.`constantTypeId`, `constantSets`.`vault`, "
+				"`assignments`.`constantSetId`, `runRanges`.`id`, `runRanges`.`runMin`, `runRanges`.`runMax` "
+				"FROM `assignments` "
+				"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+				"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+				"INNER JOIN ("
+					"SELECT MAX(`assignments`.`id`) AS `id` "
+					"FROM `assignments` "
+					"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+					"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+					"WHERE `runRanges`.`runMin` <= ? "
+					"AND `runRanges`.`runMax` >= ? "
+					"AND `assignments`.`variationId` IN (" + variationPlaceholders + ") " +
+					((time>0)? string("AND `assignments`.`created` <= FROM_UNIXTIME(?) ") : string()) +
+					"GROUP BY `constantSets`.`constantTypeId`, `assignments`.`variationId`"
+				") AS `latest` ON `assignments`.`id` = `latest`.`id`");
+
+			int paramIndex = 0;
+			query.BindInt32(paramIndex++, run);
+			query.BindInt32(paramIndex++, run);
+			for(auto variation: chain) query.BindInt32(paramIndex++, variation->GetId());
+			if(time>0) query.BindInt64(paramIndex++, time);
+
+			query.Execute([&](uint64_t rowIndex) {
+				unsigned int variationId = static_cast<unsigned int>(query.ReadInt32(1));   // the type of Variation::GetId
+				dbkey_t tableId = query.ReadInt32(2);
+
+				size_t chainIndex = 0;
+				while(chainIndex < chain.size() && chain[chainIndex]->GetId() != variationId) chainIndex++;
+
+				auto best = bestByTableId.find(tableId);
+				if(best != bestByTableId.end() && best->second.ChainIndex <= chainIndex) return;   // closer variation already found
+
+				auto assignment = new Assignment();
+				assignment->SetId(query.ReadInt32(0));
+				assignment->SetRawData(query.ReadString(3));
+				assignment->SetDataVaultId(query.ReadInt32(4));
+				assignment->SetRunRangeId(query.ReadInt32(5));
+				assignment->SetRequestedRun(run);
+				assignment->SetVariation(chain[chainIndex]);
+				assignment->SetVariationId(variationId);
+
+				LatestAssignment latest{chainIndex, assignment, query.ReadInt32(6), query.ReadInt32(7)};
+				if(best != bestByTableId.end()) {
+					delete best->second.Selected;
+					best->second = latest;
+				}
+				else {
+					bestByTableId[tableId] = latest;
+				}
+			});
+		});
 	}
-	
-	if(!FetchRow())
+	catch (...)
 	{
-		//TODO report error
-		cout<<"no assignment selected!"<<endl;
-		return false;
+		for(auto& best: bestByTableId) delete best.second.Selected;
+		throw;
 	}
-	
-	//fetch readed row
-	FetchAssignment(assignment, assignment->GetTypeTable());
-	
-	//Ok! Here is a tricky moment. We should load a constant type table 
-	//but we have an API that allows us to load such directories by name
-	//The problem that we should know a full path of it. 
-	//So we pulled a directory ID and data table name. 
-	// We have a list of directories by their ID thus we will know a full path
-	// of type table. 
-	// lets make this plan work
-	
-	string typeTableName = ReadString(18);
-	dbkey_t directoryId = ReadIndex(19);
-	
-	//maybe we need to update our directories?
-	UpdateDirectoriesIfNeeded();
 
-	if(mDirectoriesById.find(directoryId) == mDirectoriesById.end())
+	//Tables and run ranges come from the catalog caches. Tables are read from the database only
+	//if some of them are not cached yet (the first call or new tables)
+	std::vector<Assignment *> assignments;
+	try
 	{
-		//TODO report errors
-		Error(CCDB_ERROR,"MySQLDataProvider::FillAssignment", "Cannot find directory locally by ID taken from database");
-		return false;
-	}
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+		UpdateDirectoriesIfNeeded();
 
-	Directory *parent = mDirectoriesById[directoryId];
-	
-	ConstantsTypeTable * table = GetConstantsTypeTable(typeTableName, parent, true);
-	if(!table)
+		bool isTablesRead = false;
+		for(auto& best: bestByTableId)
+		{
+			Assignment* assignment = best.second.Selected;
+			ConstantsTypeTable* table = FindCachedTypeTable(best.first);
+			if(!table && !isTablesRead)
+			{
+				GetAllConstantsTypeTables(false);
+				isTablesRead = true;
+				table = FindCachedTypeTable(best.first);
+			}
+			if(!table)
+			{
+				delete assignment;  // table was created after the assignments were read
+				best.second.Selected = nullptr;
+				continue;
+			}
+
+			assignment->SetTypeTable(table);
+			assignment->SetRunRange(GetCachedRunRange(assignment->GetRunRangeId(), best.second.RunMin, best.second.RunMax));
+			assignments.push_back(assignment);
+			best.second.Selected = nullptr;
+		}
+	}
+	catch (...)
 	{
-		Error(CCDB_ERROR_NO_TYPETABLE,"MySQLDataProvider::FillAssignment", "Type table was not loaded");
-		return false;
+		for(auto& best: bestByTableId) delete best.second.Selected;
+		for(auto assignment: assignments) delete assignment;
+		throw;
 	}
 
-	assignment->SetTypeTable(table);
-	table->SetOwner(assignment);
-
-	FreeMySQLResult();
-	
-	return true;
+	return assignments;
 }
 
-Assignment* ccdb::MySQLDataProvider::FetchAssignment(ConstantsTypeTable* table)
-{
-	Assignment * assignment = new Assignment(this, this); //it is our victim
-
-	FetchAssignment(assignment, table);
-
-	//take it!
-	return assignment;
-}
-
-
-void ccdb::MySQLDataProvider::FetchAssignment(Assignment* assignment, ConstantsTypeTable* table)
-{
-	//ok now we must fetch our mighty query...
-	assignment->SetId(ReadIndex(0));				/*00  " `assignments`.`id` AS `asId`,	"*/
-	assignment->SetCreatedTime(ReadUnixTime(1));	/*01  " UNIX_TIMESTAMP(`assignments`.`created`) as `asCreated`,"*/
-	assignment->SetModifiedTime(ReadUnixTime(2));	/*02  " UNIX_TIMESTAMP(`assignments`.`modified`) as `asModified`,	"*/
-	assignment->SetComment(ReadString(3));			/*03  " `assignments`.`comment) as `asComment`,	"					 */
-	assignment->SetDataVaultId(ReadIndex(4));		/*04  " `constantSets`.`id` AS `constId`, "							 */
-	assignment->SetRawData(ReadString(5));			/*05  " `constantSets`.`vault` AS `blob`, "							 */
-	
-	RunRange * runRange = new RunRange(assignment, this);	
-	runRange->SetId(ReadIndex(6));					/*06  " `runRanges`.`id`   AS `rrId`, "	*/
-	runRange->SetCreatedTime(ReadUnixTime(7));		/*07  " UNIX_TIMESTAMP(`runRanges`.`created`) as `rrCreated`,"*/
-	runRange->SetModifiedTime(ReadUnixTime(8));		/*08  " UNIX_TIMESTAMP(`runRanges`.`modified`) as `rrModified`,	"*/
-	runRange->SetName(ReadString(9));				/*09  " `runRanges`.`name`   AS `rrName`, "		*/
-	runRange->SetMin(ReadInt(10));					/*10  " `runRanges`.`runMin`   AS `rrMin`, "	*/
-	runRange->SetMax(ReadInt(11));					/*11  " `runRanges`.`runMax`   AS `runMax`, "	*/
-	runRange->SetComment(ReadString(12));			/*12  " `runRanges`.`comment` as `rrComment`, "	*/
-	
-	Variation * variation = new Variation(assignment, this);
-	variation->SetId(ReadIndex(13));				/*13  " `variations`.`id`  AS `varId`, */
-	variation->SetCreatedTime(ReadUnixTime(14));	/*14  " UNIX_TIMESTAMP(`variations`.`created`) as `varCreated`,"	 */
-	variation->SetModifiedTime(ReadUnixTime(15));	/*15  " UNIX_TIMESTAMP(`variations`.`modified`) as `varModified`,	 */
-	variation->SetName(ReadString(16));			/*16  " `variations`.`name` AS `varName` "*/
-	variation->SetComment(StringUtils::Decode(ReadString(12)));		/*17  " `variations`.`comment`  AS `varComment` "*/
-
-	//compose objects
-	assignment->SetRunRange(runRange);
-	assignment->SetVariation(variation);
-	assignment->SetTypeTable(table);
-	if(IsOwner(table)) table->SetOwner(assignment);
-}
-
-#pragma endregion Assignment
-
-#pragma region Misc
-
-std::string ccdb::MySQLDataProvider::WilcardsToLike( const string& str )
-{	
-	//MySQL - wildcards
-	//% - *
-	//_ - ?
-
-	//encode underscores
-	string result = StringUtils::Replace("_", "\\_", str);
 
-	//replace ? to _
-	StringUtils::Replace("?","_",result, result);
-
-	//replace * to %
-	StringUtils::Replace("*","%",result, result);
-
-	return result;
-}
-
-std::string ccdb::MySQLDataProvider::PrepareCommentForInsert( const string& comment )
+//______________________________________________________________________________
+std::future<Assignment*> ccdb::MySQLDataProvider::GetAssignmentShortAsync(int run, const string& path, time_t time, const string& variationName, bool loadColumns)
 {
-	// The idea is that we have to place 
-	// (..., NULL) in INSERT queries if comment is NULL
-	// and (..., "<content>") if it is not NULL
-	// So this function returns string containing NULL or \"<comment content>\"
-	
+	string thisFuncName("ccdb::MySQLDataProvider::GetAssignmentShortAsync");
 
-	if(comment.length() == 0)
-	{
-		// we put empty comments as NULL
-		//because comments uses "TEXT" field that takes additional size
-		// if text field in DB is NULL it will be read as "" by ReadString()
-		// so it is safe to do this 
-		
-		return string("NULL");
-	}
-	else
-	{
-		string commentIns ="\"";
-		commentIns.append(comment);
-		commentIns.append("\"");
-		return commentIns;
+	if(!IsConnected()) {
+		throw std::runtime_error(thisFuncName+" => Not connected to DB");
 	}
 
-}
-
-#pragma endregion Misc
-
-#pragma region MySQL_Field_Operations
-
-bool ccdb::MySQLDataProvider::IsNullOrUnreadable( int fieldNum )
-{
-	// Checks if there is a value with this fieldNum index (reports error in such case)
-	// and if it is not null (just returns false in this case)
-
-	if(mReturnedFieldsNum<=fieldNum)
+	//Type table and variation chain. They come from caches after the first request
+	ConstantsTypeTable* table;
+	std::vector<Variation*> chain;
 	{
-		//Add error, we have less fields than fieldNum
-		Error(CCDB_WARNING_DBRESULT_FIELD_INDEX,"MySQLDataProvider::IsNullOrUnreadable", "we have less fields than fieldNum");
-		return true;
-	}
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+		table = DataProvider::GetConstantsTypeTable(path, loadColumns);
+		if(!table)
+		{
+			throw std::runtime_error(thisFuncName+" => Type table was not found: '"+path+"'");
+		}
 
-	if(mRow[fieldNum]==NULL) 
-	{	
-		return true;
+		Variation* variation = GetVariation(variationName);
+		if(!variation)
+		{
+			throw std::runtime_error(thisFuncName+" => No variation '"+variationName+"' was found");
+		}
+		for(; variation; variation = variation->GetParent()) chain.push_back(variation);
 	}
-	//fine! 
-	return false;
-}
-
-int ccdb::MySQLDataProvider::ReadInt( int fieldNum )
-{	
-	if(IsNullOrUnreadable(fieldNum)) return 0;
 
-	return atoi(mRow[fieldNum]); //ugly isn't it?
-}
-
-unsigned int ccdb::MySQLDataProvider::ReadUInt( int fieldNum )
-{	
-	if(IsNullOrUnreadable(fieldNum)) return 0;
-
-	return static_cast<unsigned int>(atoi(mRow[fieldNum])); //ugly isn't it?
-}
-
-long ccdb::MySQLDataProvider::ReadLong( int fieldNum )
-{
-	if(IsNullOrUnreadable(fieldNum)) return 0;
-
-	return atol(mRow[fieldNum]); //ugly isn't it?
-}
-
-unsigned long ccdb::MySQLDataProvider::ReadULong( int fieldNum )
-{
-	if(IsNullOrUnreadable(fieldNum)) return 0;
-
-	return static_cast<unsigned long>(atol(mRow[fieldNum])); //ugly isn't it?
-}
-
-dbkey_t ccdb::MySQLDataProvider::ReadIndex( int fieldNum )
-{
-	if(IsNullOrUnreadable(fieldNum)) return 0;
-
-	return static_cast<dbkey_t>(atol(mRow[fieldNum])); //ugly isn't it?
-}
-
-bool ccdb::MySQLDataProvider::ReadBool( int fieldNum )
-{
-	if(IsNullOrUnreadable(fieldNum)) return false;
-
-	return static_cast<bool>(atoi(mRow[fieldNum])!=0); //ugly isn't it?
+	MySQLAsyncExecutor* executor;
+	{
+		std::lock_guard<std::mutex> asyncLock(mAsyncMutex);
+		if(!mAsyncExecutor) mAsyncExecutor.reset(new MySQLAsyncExecutor(mConnectionInfo, mPoolOptions.AsyncConnections));
+		executor = mAsyncExecutor.get();
+	}
 
+	//The variation fallback is done by the query itself: the closest variation first, then the latest assignment.
+	//Only integers go to the query text, so it is safe to format it
+	string variationIds;
+	for(size_t i = 0; i < chain.size(); i++) variationIds += (i==0 ? "" : ", ") + std::to_string(chain[i]->GetId());
+
+	string query = fmt::format(
+		"SELECT `assignments`.`id`, `assignments`.`variationId`, `constantSets`.`vault`, `assignments`.`constantSetId`, "
+		"`runRanges`.`id`, `runRanges`.`runMin`, `runRanges`.`runMax` "
+		"FROM  `assignments` "
+		"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+		"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+		"WHERE  `runRanges`.`runMin` <= {0} "
+		"AND `runRanges`.`runMax` >= {0} "
+		"AND `assignments`.`variationId` IN ({1}) "
+		"AND `constantSets`.`constantTypeId` = {2} "
+		"{3}"
+		"ORDER BY FIELD(`assignments`.`variationId`, {1}), `assignments`.`id` DESC "
+		"LIMIT 1",
+		run, variationIds, table->GetId(),
+		(time>0) ? fmt::format("AND `assignments`.`created` <= FROM_UNIXTIME({}) ", static_cast<int64_t>(time)) : string());
+
+	//The table is owned by the provider, so handlers only keep the pointer.
+	//The executor is owned by the provider too, so the provider outlives the handlers
+	auto promise = std::make_shared<std::promise<Assignment*>>();
+
+	executor->Submit(query,
+		[this, promise, table, chain, run](MYSQL_RES* result) {
+			MYSQL_ROW row = result ? mysql_fetch_row(result) : nullptr;
+			if(!row) {
+				promise->set_value(nullptr);
+				return;
+			}
+
+			unsigned long* lengths = mysql_fetch_lengths(result);
+			unsigned int variationId = static_cast<unsigned int>(atoi(row[1]));   // the type of Variation::GetId
+
+			std::unique_ptr<Assignment> assignment(new Assignment());
+			assignment->SetId(atoi(row[0]));
+			assignment->SetRawData(string(row[2], lengths[2]));
+			assignment->SetDataVaultId(atoi(row[3]));
+			assignment->SetRequestedRun(run);
+			assignment->SetVariationId(variationId);
+			for(auto variation: chain) {
+				if(variation->GetId() == variationId) assignment->SetVariation(variation);
+			}
+			assignment->SetTypeTable(table);
+
+			//The same run range object as GetAssignmentShort gives, they share the Calibration cache
+			dbkey_t runRangeId = atoi(row[4]);
+			assignment->SetRunRangeId(runRangeId);
+			{
+				std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+				assignment->SetRunRange(GetCachedRunRange(runRangeId, atoi(row[5]), atoi(row[6])));
+			}
+			promise->set_value(assignment.release());
+		},
+		[promise](std::exception_ptr error) {
+			promise->set_exception(error);
+		});
+
+	return promise->get_future();
 }
 
-double ccdb::MySQLDataProvider::ReadDouble( int fieldNum )
-{
-	if(IsNullOrUnreadable(fieldNum)) return 0;
-
-	return atof(mRow[fieldNum]); //ugly isn't it?
-}
 
-std::string ccdb::MySQLDataProvider::ReadString( int fieldNum )
+//______________________________________________________________________________
+dbkey_t ccdb::MySQLDataProvider::GetLastAssignmentId()
 {
-	if(IsNullOrUnreadable(fieldNum)) return string("");
-	return string(mRow[fieldNum]);
-}
-
+	return ReadWithRetry([&](MySQLConnection& connection) -> dbkey_t {
+		MySQLStatement& query = connection.GetStatement("SELECT COALESCE(MAX(`id`), 0) FROM `assignments`");
 
-time_t ccdb::MySQLDataProvider::ReadUnixTime( int fieldNum )
-{	
-	return static_cast<time_t>(ReadULong(fieldNum));
+		dbkey_t id = 0;
+		query.Execute([&id, &query](uint64_t rowIndex) { id = query.ReadInt32(0); });
+		return id;
+	});
 }
 
-#pragma endregion MySQL_Field_Operations
-
 
-#pragma region Queries
-
-bool ccdb::MySQLDataProvider::QuerySelect(const char* query)
+//______________________________________________________________________________
+std::vector<AssignmentChange> ccdb::MySQLDataProvider::GetAssignmentsAfter(dbkey_t assignmentId)
 {
-	if(!CheckConnection("MySQLDataProvider::QuerySelect")) return false;
-	
-	//do we have some results we need to free?
-	if(mResult!=NULL)
-	{		
-		FreeMySQLResult();
-	}
-
-	//query
-	if(mysql_query(mMySQLHnd, query))
+	std::vector<AssignmentChange> changes;
+	std::vector<std::pair<dbkey_t, string>> tableLocations;     //(directoryId, name) of each change
+	ReadWithRetry([&](MySQLConnection& connection) {
+		changes.clear();        // Left by a lost connection
+		tableLocations.clear();
+		MySQLStatement& query = connection.GetStatement(
+			"SELECT `assignments`.`id`, UNIX_TIMESTAMP(`assignments`.`created`), "
+			"`variations`.`name`, `runRanges`.`runMin`, `runRanges`.`runMax`, "
+			"`typeTables`.`id`, `typeTables`.`directoryId`, `typeTables`.`name` "
+			"FROM  `assignments` "
+			"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+			"INNER JOIN `variations` ON `assignments`.`variationId`= `variations`.`id` "
+			"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+			"INNER JOIN `typeTables` ON `constantSets`.`constantTypeId` = `typeTables`.`id` "
+			"WHERE `assignments`.`id` > ? "
+			"ORDER BY `assignments`.`id`");
+		query.BindInt32(0, assignmentId);
+
+		query.Execute([&changes, &tableLocations, &query](uint64_t rowIndex) {
+			AssignmentChange change;
+			change.AssignmentId = query.ReadInt32(0);
+			change.Created = query.ReadUnixTime(1);
+			change.Variation = query.ReadString(2);
+			change.RunMin = query.ReadInt32(3);
+			change.RunMax = query.ReadInt32(4);
+			change.TypeTableId = query.ReadInt32(5);
+			changes.push_back(change);
+			tableLocations.emplace_back(query.ReadInt32(6), query.ReadString(7));
+		});
+	});
+
+	//The catalog mutex can't be locked while the connection is held
+	std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+	for(size_t i = 0; i < changes.size(); i++)
 	{
-		string errStr = ComposeMySQLError("mysql_query()"); errStr.append("\n Query: "); errStr.append(query);
-		Error(CCDB_ERROR_QUERY_SELECT,"ccdb::MySQLDataProvider::QuerySelect()",errStr.c_str());
-		return false;
+		changes[i].TablePath = GetTypeTablePath(tableLocations[i].first, tableLocations[i].second);
 	}
-
-	//get results
-	mResult = mysql_store_result(mMySQLHnd);
-
-	if(!mResult)
-	{
-		string errStr = ComposeMySQLError("mysql_query()"); errStr.append("\n Query: "); errStr.append(query);
-		Error(CCDB_ERROR_QUERY_SELECT,"ccdb::MySQLDataProvider::QuerySelect()",errStr.c_str());
-
-			
-		mReturnedRowsNum = 0;
-		mReturnedFieldsNum = 0;
-		return false;
-	}
-
-	//a rows number?
-	mReturnedRowsNum = mysql_num_rows(mResult);
-
-	//a fields number?
-	mReturnedFieldsNum = mysql_num_fields(mResult);
-
-	return true;
-	
+	return changes;
 }
 
-bool ccdb::MySQLDataProvider::QuerySelect(const string& query )
-{
-	return QuerySelect(query.c_str());
-}
 
-bool ccdb::MySQLDataProvider::QueryCustom( const string& query )
+//______________________________________________________________________________
+std::vector<AssignmentHistoryRecord> ccdb::MySQLDataProvider::GetAssignmentHistoryPage(const string& path, const string& variationName, int run,
+																					   const AssignmentHistoryCursor& after, size_t limit)
 {
-	if(!CheckConnection("MySQLDataProvider::QueryCustom")) return false;
+	string thisFuncName("ccdb::MySQLDataProvider::GetAssignmentHistoryPage");
 
-	//do we have some results we need to free?
-	if(mResult!=NULL)
-	{	
-		FreeMySQLResult();
-	}
-	//query
-	if(mysql_query(mMySQLHnd, query.c_str()))
+	ConstantsTypeTable* table;
+	Variation* variation = nullptr;
 	{
-		string errStr = ComposeMySQLError("mysql_query()"); errStr.append("\n Query: "); errStr.append(query);
-		Error(CCDB_ERROR_MYSQL_CUSTOM_QUERY,"ccdb::MySQLDataProvider::QueryCustom( string query )",errStr.c_str());
-		return false;
-	}
-	return true;
-}
-
-
-
-#pragma endregion
-
-
-#pragma region Fetch_free_and_other_MySQL_operations
-
-bool ccdb::MySQLDataProvider::FetchRow()
-{	
-    
-	if((mRow = mysql_fetch_row(mResult))) return true;
-	return false;
-}
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+		table = DataProvider::GetConstantsTypeTable(path, false);
+		if(!table)
+		{
+			throw std::runtime_error(thisFuncName+" => Type table was not found: '"+path+"'");
+		}
 
-void ccdb::MySQLDataProvider::FreeMySQLResult()
-{
-	mysql_free_result(mResult);
-	mResult = NULL;
-}
+		if(!variationName.empty())
+		{
+			variation = GetVariation(variationName);
+			if(!variation)
+			{
+				throw std::runtime_error(thisFuncName+" => No variation '"+variationName+"' was found");
+			}
+		}
+	}
 
-std::string ccdb::MySQLDataProvider::ComposeMySQLError(std::string mySqlFunctionName)
-{
-	string mysqlErr=StringUtils::Format("%s failed:\nError %u (%s)\n",mySqlFunctionName.c_str(), mysql_errno(mMySQLHnd), mysql_error (mMySQLHnd));
-	return mysqlErr;
+	//(created, id) > cursor. The vault column is not selected, so pages are light whatever the constants are
+	return ReadWithRetry([&](MySQLConnection& connection) -> std::vector<AssignmentHistoryRecord> {
+		MySQLStatement& query = connection.GetStatement(
+			"SELECT `assignments`.`id`, UNIX_TIMESTAMP(`assignments`.`created`), `assignments`.`comment`, "
+			"`runRanges`.`runMin`, `runRanges`.`runMax`, `variations`.`id`, `variations`.`name`, `constantSets`.`id` "
+			"FROM  `assignments` "
+			"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+			"INNER JOIN `variations` ON `assignments`.`variationId`= `variations`.`id` "
+			"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+			"WHERE `constantSets`.`constantTypeId` = ? " +
+			(variation? string("AND `assignments`.`variationId`= ? ") : string()) +
+			((run>=0)? string("AND `runRanges`.`runMin` <= ? AND `runRanges`.`runMax` >= ? ") : string()) +
+			(!after.IsAtStart()? string("AND (`assignments`.`created` > FROM_UNIXTIME(?) "
+										"OR (`assignments`.`created` = FROM_UNIXTIME(?) AND `assignments`.`id` > ?)) ") : string()) +
+			"ORDER BY `assignments`.`created`, `assignments`.`id` "
+			"LIMIT ?");
+
+		int paramIndex = 0;
+		query.BindInt32(paramIndex++, table->GetId());
+		if(variation) {
+			query.BindInt32(paramIndex++, variation->GetId());
+		}
+		if(run>=0) {
+			query.BindInt32(paramIndex++, run);
+			query.BindInt32(paramIndex++, run);
+		}
+		if(!after.IsAtStart()) {
+			query.BindInt64(paramIndex++, after.Created);
+			query.BindInt64(paramIndex++, after.Created);
+			query.BindInt32(paramIndex++, after.AssignmentId);
+		}
+		query.BindInt64(paramIndex++, static_cast<int64_t>(limit));
+
+		std::vector<AssignmentHistoryRecord> records;
+		query.Execute([&records, &query](uint64_t rowIndex) {
+			AssignmentHistoryRecord record;
+			record.AssignmentId = query.ReadInt32(0);
+			record.Created = query.ReadUnixTime(1);
+			record.Comment = query.ReadString(2);
+			record.RunMin = query.ReadInt32(3);
+			record.RunMax = query.ReadInt32(4);
+			record.VariationId = query.ReadInt32(5);
+			record.Variation = query.ReadString(6);
+			record.ConstantSetId = query.ReadInt32(7);
+			records.push_back(std::move(record));
+		});
+		return records;
+	});
 }
-#pragma endregion Fetch_free_and_other_MySQL_operations
 
 
-
-dbkey_t ccdb::MySQLDataProvider::GetUserId( string userName )
+//______________________________________________________________________________
+std::vector<AssignmentHistoryRecord> ccdb::MySQLDataProvider::GetAssignmentRecords(const string& path, const string& variationName, int runMin, int runMax)
 {
-	if(userName == "" || !ValidateName(userName))
-	{
-		return 1; //anonymous id
-	}
+	string thisFuncName("ccdb::MySQLDataProvider::GetAssignmentRecords");
 
-	string query = StringUtils::Format("SELECT `id` FROM `authors` WHERE `name` = \"%s\" LIMIT 0,1", userName.c_str());
-	if(!QuerySelect(query))
+	ConstantsTypeTable* table;
+	Variation* variation;
 	{
-		return 1; //anonymous id
-	}
-
+		std::lock_guard<std::recursive_mutex> catalogLock(mCatalogMutex);
+		table = DataProvider::GetConstantsTypeTable(path, false);
+		if(!table)
+		{
+			throw std::runtime_error(thisFuncName+" => Type table was not found: '"+path+"'");
+		}
 
-	if(!FetchRow())
-	{
-		return 1; //anonymous id
+		variation = GetVariation(variationName);
+		if(!variation)
+		{
+			throw std::runtime_error(thisFuncName+" => No variation '"+variationName+"' was found");
+		}
 	}
 
-	dbkey_t id = ReadIndex(0);
-
-	FreeMySQLResult();
-
-	if(id<=0) return 1;
-	return id;
+	//Neither the vault nor the comment are selected, the rows are a few numbers each
+	return ReadWithRetry([&](MySQLConnection& connection) -> std::vector<AssignmentHistoryRecord> {
+		MySQLStatement& query = connection.GetStatement(
+			"SELECT `assignments`.`id`, UNIX_TIMESTAMP(`assignments`.`created`), "
+			"`runRanges`.`runMin`, `runRanges`.`runMax`, `assignments`.`constantSetId` "
+			"FROM  `assignments` "
+			"INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+			"INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+			"WHERE `constantSets`.`constantTypeId` = ? AND `assignments`.`variationId`= ? "
+			"AND `runRanges`.`runMax` >= ? AND `runRanges`.`runMin` <= ? "
+			"ORDER BY `assignments`.`id`");
+		query.BindInt32(0, table->GetId());
+		query.BindInt32(1, variation->GetId());
+		query.BindInt32(2, runMin);
+		query.BindInt32(3, runMax);
+
+		std::vector<AssignmentHistoryRecord> records;
+		query.Execute([&records, &query, variation](uint64_t rowIndex) {
+			AssignmentHistoryRecord record;
+			record.AssignmentId = query.ReadInt32(0);
+			record.Created = query.ReadUnixTime(1);
+			record.RunMin = query.ReadInt32(2);
+			record.RunMax = query.ReadInt32(3);
+			record.VariationId = variation->GetId();
+			record.Variation = variation->GetName();
+			record.ConstantSetId = query.ReadInt32(4);
+			records.push_back(std::move(record));
+		});
+		return records;
+	});
 }
 
 
-std::string ccdb::MySQLDataProvider::PrepareLimitInsertion(  int take/*=0*/, int startWith/*=0*/ )
+//______________________________________________________________________________
+std::shared_ptr<const VaultData> ccdb::MySQLDataProvider::GetConstantSetVault(dbkey_t constantSetId)
 {
-	if(startWith != 0 && take != 0) return StringUtils::Format(" LIMIT %i, %i ", startWith, take);
-	if(startWith != 0 && take == 0) return StringUtils::Format(" LIMIT %i, %i ", startWith, INFINITE_RUN);
-	if(startWith == 0 && take != 0) return StringUtils::Format(" LIMIT %i ", take);
-	
-	return string(); //No LIMIT at all, if run point is here it corresponds to if(startWith == 0 && take ==0 )
+	return ReadWithRetry([&](MySQLConnection& connection) -> std::shared_ptr<const VaultData> {
+		MySQLStatement& query = connection.GetStatement("SELECT `vault` FROM `constantSets` WHERE `id` = ?");
+		query.BindInt32(0, constantSetId);
+
+		std::shared_ptr<const VaultData> vault;
+		query.Execute([&vault, &query](uint64_t rowIndex) { vault = std::make_shared<VaultData>(query.ReadString(0)); });
+		return vault;
+	});
 }
-
-
-int ccdb::MySQLDataProvider::CountConstantsTypeTables(Directory *dir)
-{
-	/**
-	 * @brief This function counts number of type tables for a given directory 
-	 * @param [in] directory to look tables in
-	 * @return number of tables to return
-	 */
-	return 0;
-}
-
@@ -7,10 +7,16 @@
 #include <mysql.h>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 
 #include "CCDB/Providers/DataProvider.h"
 #include "CCDB/Providers/MySQLConnectionInfo.h"
+#include "CCDB/Providers/MySQLConnectionPool.h"
+#include "CCDB/Providers/MySQLAsyncExecutor.h"
 #include "CCDB/Model/ConstantsTypeTable.h"
+#include "CCDB/Helpers/MySQL.h"
 
 #define CCDB_DEFAULT_MYSQL_USERNAME  "ccdbuser"
 #define CCDB_DEFAULT_MYSQL_PASSWORD  ""
@@ -18,9 +24,6 @@
 #define CCDB_DEFAULT_MYSQL_PORT 	 3306
 #define CCDB_DEFAULT_MYSQL_DATABASE	 "ccdb"
 
-///We making this define to be sure if we switch to other library nothing will change
-#define MYSQL_ULONG my_ulonglong
-
 namespace ccdb
 {
 
@@ -29,11 +32,10 @@ namespace ccdb
 
     public:
         MySQLDataProvider();
-        virtual ~MySQLDataProvider();
-
+        ~MySQLDataProvider() override;
 
         //----------------------------------------------------------------------------------------
-        //	C O N N E C T I O N
+        //  I M P L E M E N T   I N T E R F A C E
         //----------------------------------------------------------------------------------------
 
         /**
@@ -41,292 +43,208 @@ namespace ccdb
          *
          * Connects to database using connection string
          * connection string might be in form:
-         * mysql://<username>:<password>@<mysql.address>:<port> <database>
+         * mysql://<username>:<password>@<mysql.address>:<port>/<database>
          *
-         * @param connectionString "mysql://<username>:<password>@<mysql.address>:<port> <database>"
-         * @return true if connected
+         * @param connectionString "mysql://<username>:<password>@<mysql.address>:<port>/<database>"
          */
-        virtual void Connect(string connectionString);
+        void Connect(const std::string &connectionString) override;
 
         /**
-         * @brief Connects to database using DMySQLConnectionInfo
+         * @brief Connects to database using MySQLConnectionInfo
          *
          * @param connection
-         * @return true if connected
-         */
-        virtual bool Connect(MySQLConnectionInfo connection);
-
-        /**
-         * @brief indicates ether the connection is open or not
-         *
-         * @return true if  connection is open
          */
-        virtual bool IsConnected();
+        void Connect(const MySQLConnectionInfo& connection);
 
         /**
          * @brief closes connection to data
          */
-        virtual void Disconnect();
+        void Disconnect() override;
 
-        /** @brief Parse Connection String
+        /**
+         * @brief indicates ether the connection is open or not
          *
-         * @param   [in]  conStr
-         * @param   [out] DMySQLConnectionInfo & connection
-         * @return   bool
+         * @return true if  connection is open
          */
-        static bool ParseConnectionString(std::string conStr, MySQLConnectionInfo &connection);
-
-
-        //----------------------------------------------------------------------------------------
-        //	D I R E C T O R Y   M A N G E M E N T
-        //----------------------------------------------------------------------------------------
-
-
+        bool IsConnected() override;
 
         /** @brief Reads all directories from DB
          *
          * Explicitly forces to load directories from DB and build directory structure
-         * (!) At this implementation all existing directories references will be deleted,
-         * thus  references to them will become broken
-         * @return   bool
+         * Directories of previous loads are not deleted, so existing references stay valid,
+         * but they are not in the new directory tree
          */
-        bool LoadDirectories() override;
-
-
+        void LoadDirectories() override;
 
         /** @brief Gets ConstantsType information from the DB
          *
-         * @param  [in] name nfme of ConstantsTypeTable
+         * @param  [in] name name of ConstantsTypeTable
          * @param  [in] parentDir directory that contains type table
          * @return new object of ConstantsTypeTable
          */
-        ConstantsTypeTable * GetConstantsTypeTable(const string& name, Directory *parentDir, bool loadColumns=false) override;
-
-
-        /** @brief Searches for type tables that matches the patten
-         *
-         * Searches type table that matches the pattern
-         * inside parent directory with path @see parentPath
-         * or globally through all type tables if parentPath is empty
-         * The pattern might contain
-         * '*' - any character sequence
-         * '?' - any single character
-         *
-         * paging could be done with @see startWith  @see take
-         * startRecord=0 and selectRecords=0 means select all records;
-         *
-         * objects that are contained in vector<DDirectory *>& resultDirectories will be
-         * 1) if this provider owned - deleted (@see ReleaseOwnership)
-         * 2) if not owned - just leaved on user control
-         * @param  pattern
-         * @param  parentPath
-         * @return vector<ConstantsTypeTable *>
-         */
-        std::vector<ConstantsTypeTable *> GetAllConstantsTypeTables(bool loadColumns = false) override;
+        ConstantsTypeTable * GetConstantsTypeTable(const string& name, Directory *parentDir, bool loadColumns) override;
 
-        /** @brief Searches for type tables that matches the patten
-         *
-         * Searches type table that matches the pattern
-         * inside parent directory with path @see parentPath
-         * or globally through all type tables if parentPath is empty
-         * The pattern might contain
-         * '*' - any character sequence
-         * '?' - any single character
-         *
-         * paging could be done with @see startWith  @see take
-         * startRecord=0 and selectRecords=0 means select all records;
-         *
-         * objects that are contained in vector<DDirectory *>& resultDirectories will be
-         * 1) if this provider owned - deleted (@see ReleaseOwnership)
-         * 2) if not owned - just leaved on user control
-         * @param  pattern
-         * @param  parentPath
+        /** @brief gets all type tables from DB
          * @return bool
          */
-        virtual bool SearchConstantsTypeTables(vector<ConstantsTypeTable *>& typeTables, const string& pattern, const string& parentPath = "", bool loadColumns=false, int take=0, int startWith=0 );
+        std::vector<ConstantsTypeTable *> GetAllConstantsTypeTables(bool loadColumns) override;
 
-        /**
-         * @brief This function counts number of type tables for a given directory
-         * @param [in] directory to look tables in
-         * @return number of tables to return
-         */
-        virtual int CountConstantsTypeTables(Directory *dir);
+        /** @brief Get variation by name*/
+        Variation* GetVariation(const string& name) override;
 
+        /** @brief Get specified by creation time version of Assignment with data blob only.
+        *
+        * This function is optimized for fast data retrieving and is assumed to be performance critical;
+        * This function doesn't return any specified information like variation object or run-range object
+        * The Time is a timestamp, data that is equal or earlier in time than that timestamp is returned
+        *
+        * @param [in] run - run number
+        * @param [in] path - object path
+        * @param [in] time - timestamp, data that is equal or earlier in time than that timestamp is returned
+        * @param [in] variation - variation name
+        * @param [in] loadColumns - optional, do we need to load table columns information (for column names and types) or not
+        * @return DAssignment object or NULL if no assignment is found or error
+        */
+        Assignment* GetAssignmentShort(int run, const string& path, time_t time, const string& variation, bool loadColumns) override;
 
-        /** @brief Loads columns for "table" type table
-         *
-         * @param [in out] table
-         * @return true if no errors (even if no columns loaded)
-         */
-        virtual bool LoadColumns(ConstantsTypeTable* table);
+        /** @brief Assignment and constant set ids for the request. The vault is not transferred. See DataProvider::GetAssignmentIdentity */
+        AssignmentIdentity GetAssignmentIdentity(int run, const string& path, time_t time, const string& variation) override;
 
-        #pragma endregion Constant type table
+        /** @brief Lists assignments of the type table in the variation, newest first
+        *
+        * Rows are read by pages of 256 (keyed by assignment id), so memory doesn't grow with the history.
+        * No connection is held while onAssignment runs, here it may make requests to the provider.
+        * See DataProvider::VisitAssignments
+        */
+        uint64_t VisitAssignments(const string& path, const string& variation, int run, time_t time,
+                                  const std::function<bool(Assignment&)>& onAssignment) override;
 
-        //----------------------------------------------------------------------------------------
-        //	R U N   R A N G E S
-        //----------------------------------------------------------------------------------------
-        #pragma region Run ranges
+        /** @brief Gets the latest assignments of all type tables for the run
+        *
+        * Instead of a query per table, the latest assignment ids for each table and each variation
+        * in the variation chain are selected by one query and the closest variation wins on the client.
+        * See DataProvider::GetLatestAssignments
+        */
+        std::vector<Assignment *> GetLatestAssignments(int run, time_t time, const string& variation, bool loadColumns) override;
 
-        /** @brief GetRun Range from db
-         *
-         * @param     int min
-         * @param     int max
-         * @param     const char * name
-         * @return   DRunRange* return NULL if not found or failed
-         */
-        virtual RunRange* GetRunRange(int min, int max, const string& name = "");
+        /** @brief Asynchronous version of GetAssignmentShort
+        *
+        * The type table and the variation are resolved right away (they are cached after the first request).
+        * Then one query that also looks into the parent variations is queued to MySQLAsyncExecutor
+        * which runs up to AsyncConnections queries at once (see MySQLConnectionPoolOptions).
+        */
+        std::future<Assignment*> GetAssignmentShortAsync(int run, const string& path, time_t time, const string& variation, bool loadColumns) override;
 
-        /** @brief GetRun Range from db
-         *
-         * @param     int min
-         * @param     int max
-         * @param     const char * name
-         * @return   DRunRange* return NULL if not found or failed
-         */
-        virtual RunRange* GetRunRange(const string& name);
+        /** @brief Id of the newest assignment. It is one primary key lookup, so it is used as the change probe */
+        dbkey_t GetLastAssignmentId() override;
 
-        /**
-         * @brief Searches all run ranges associated with this type table
-         *
-         * @param [out] resultRunRanges result run ranges
-         * @param [in]  table		table to search run ranges in
-         * @param [in]  variation	variation to search, if not set all variations will be selected
-         * @param [in]  take			how many records to take
-         * @param [in]  startWith	start record to take
-         * @return
-         */
-        virtual bool GetRunRanges(vector<RunRange *>& resultRunRanges, ConstantsTypeTable *table, const string& variation="", int take=0, int startWith=0 );
+        /** @brief Assignments with id greater than assignmentId. See DataProvider::GetAssignmentsAfter */
+        std::vector<AssignmentChange> GetAssignmentsAfter(dbkey_t assignmentId) override;
 
+        /** @brief Page of the assignment history without vaults. See DataProvider::GetAssignmentHistoryPage */
+        std::vector<AssignmentHistoryRecord> GetAssignmentHistoryPage(const string& path, const string& variation, int run,
+                                                                      const AssignmentHistoryCursor& after, size_t limit) override;
 
+        /** @brief Assignments overlapping the runs without vaults. See DataProvider::GetAssignmentRecords */
+        std::vector<AssignmentHistoryRecord> GetAssignmentRecords(const string& path, const string& variation, int runMin, int runMax) override;
 
-        #pragma endregion Run ranges
+        /** @brief Data blob of the constant set, one primary key lookup. See DataProvider::GetConstantSetVault */
+        std::shared_ptr<const VaultData> GetConstantSetVault(dbkey_t constantSetId) override;
 
         //----------------------------------------------------------------------------------------
-        //	V A R I A T I O N
+        //  E N D   I M P L E M E N T   I N T E R F A C E
         //----------------------------------------------------------------------------------------
-        #pragma region Variation
 
-        /** @brief Load variation by name
+        /** @brief Parse Connection String
          *
-         * @param     const char * name
-         * @return   DVariation*
+         * Besides the address the string may have options after '?':
+         * mysql://user@host:3306/ccdb?compress=true&read_timeout=30&write_timeout=30&keepalive=60
+         * compress - protocol compression; read_timeout, write_timeout - seconds;
+         * keepalive - seconds of idle before TCP keepalive probes
+         *
+         * @param   [in]  conStr
+         * @param   [out] MySQLConnectionInfo & connection
+         * @return   true if the string has mysql:// format
          */
-        virtual Variation* GetVariation(const string& name);
-
+        static bool ParseConnectionString(std::string conStr, MySQLConnectionInfo &connection);
 
-    private:
-        /** @brief Load variation by name
-        *
-        * @param     const char * name
-        * @return   DVariation*
-        */
-        virtual Variation* GetVariationById(int id);
+        /** @brief Parses 'name=value&name=value' options part of the connection string. Throws on unknown option */
+        static void ParseConnectionOptions(const std::string& options, MySQLConnectionInfo &connection);
 
-        /**
-         * Get variation by database request
+        /** @brief Sets connection pool settings. Must be called before Connect
+         *
+         * Each thread that requests data gets its own connection from the pool,
+         * so requests from different threads are not serialized on one socket
          */
-        virtual Variation* SelectVariation(const string& query);
+        void SetPoolOptions(const MySQLConnectionPoolOptions& options);
 
-        #pragma endregion Variation
+        /** @brief Connection pool usage counters. Empty if not connected */
+        MySQLConnectionPoolStats GetPoolStats();
 
-        //----------------------------------------------------------------------------------------
-        //	A S S I G N M E N T S
-        //----------------------------------------------------------------------------------------
-    public:
-        #pragma region Assignments
+    private:
 
-        /** @brief Get Assignment with data blob only
+        /** @brief Gets connection of the current thread from the pool
          *
-         * This function is optimized for fast data retrieving and is assumed to be performance critical;
-         * This function doesn't return any specified information like variation object or run-range object
-         * @see GetAssignmentFull
-         * @param [in] run - run number
-         * @param [in] path - object path
-         * @param [in] variation - variation name
-         * @param [in] loadColumns - optional, do we need to load table columns information (for column names and types) or not
-         * @return DAssignment object or NULL if no assignment is found or error
+         * Prepared statements are cached by each connection.
+         * If the catalog mutex is needed it must be locked before the connection is acquired
          */
-        virtual Assignment* GetAssignmentShort(int run, const string& path, const string& variation="default", bool loadColumns=false);
-
+        MySQLConnectionPool::Lease AcquireConnection();
 
-         /** @brief Get specified by creation time version of Assignment with data blob only.
-         *
-         * The Time is a timestamp, data that is equal or earlier in time than that timestamp is returned
+        /** @brief Runs read(connection) on a pooled connection, once more on a new connection if it was lost
          *
-         * @remarks this function is named so
-         * @param [in] run - run number
-         * @param [in] path - object path
-         * @param [in] time - timestamp, data that is equal or earlier in time than that timestamp is returned
-         * @param [in] variation - variation name
-         * @param [in] loadColumns - optional, do we need to load table columns information (for column names and types) or not
-         * @return new DAssignment object or
+         * Only for reads that can be repeated: read must not keep anything from the first attempt.
+         * A read nested in another lease of the same thread is not repeated, the outer lease holds the lost connection.
          */
-        virtual Assignment* GetAssignmentShort(int run, const string& path, time_t time, const string& variation="default", bool loadColumns=false);
-
-
-
-    protected:
-
-
+        template<typename Func>
+        auto ReadWithRetry(Func read) -> decltype(read(std::declval<MySQLConnection&>()))
+        {
+            try {
+                auto connection = AcquireConnection();
+                return read(*connection);
+            }
+            catch (const MySQLConnectionLostError&) {
+                // The lease gave the lost connection back and the pool dropped it
+            }
+            auto connection = AcquireConnection();
+            return read(*connection);
+        }
 
+        /** @brief Loads columns for "table" type table
+         *
+         * @param [in out] table
+         */
+        void LoadColumns(ConstantsTypeTable* table);
 
-        virtual bool QuerySelect(const char* query);	///Do "select" queries
-        virtual bool QuerySelect(const string& query);	///Do "select" queries
-        virtual bool QueryCustom(const string& query);	///Do any custom queries queries
+        /** @brief Loads columns for many type tables by one query */
+        void LoadColumns(const std::vector<ConstantsTypeTable*>& tables);
 
-        virtual void FreeMySQLResult();	///Frees my sql result manually
+        /** @brief Load variation by DB id */
+        Variation* GetVariationById(dbkey_t id);
 
-        /** @brief gets last error and description and composes it as a string
-         * @return string with composed error
+        /** @brief Executes statement and create Variation object.
+         *
+         * The assumed data order in prepared statement is:
+         * `id`, `parentId`, `name`
+         * @return   DVariation*
          */
-        std::string ComposeMySQLError(std::string mySqlFunctionName="");
+        Variation *SelectVariation(MySQLStatement& statement);
 
-        /** @brief Fetches next Row
+        /** @brief Fills table fields from the statement row
          *
-         * @return true if row was read, false if no more rows
+         * The assumed data order in prepared statement is:
+         * `id`, `created`, `modified`, `name`, `directoryId`, `nRows`, `nColumns`, `comment`
          */
-        bool FetchRow();
-
-        //read of row fields
-        bool IsNullOrUnreadable(int fieldNum);		///Check if the field is NULL or is unreadable. If it is Unreadable
-        int				ReadInt(int fieldNum);		///Reads int	from the last query row
-        dbkey_t			ReadIndex(int fieldNum);	///Reads dbkey_t from the last query row
-        unsigned int	ReadUInt(int fieldNum);		///Reads unsigned int from the last query row
-        long			ReadLong(int fieldNum);		///Reads long from the last query row
-        unsigned long	ReadULong(int fieldNum);	///Reads unsigned long from the last query row
-        bool			ReadBool(int fieldNum);		///Reads bool from the last query row
-        double			ReadDouble(int fieldNum);	///Reads double from the last query row
-        string			ReadString(int fieldNum);	///Reads string from the last query row
-        time_t			ReadUnixTime(int fieldNum); ///Reads string from the last query row
-
-    private:
-
-
-        MYSQL *mMySQLHnd;			//Handler to mysql object
-        bool mIsStoredObjectOwner;
-        Assignment* FetchAssignment(ConstantsTypeTable *table);
-        virtual void FetchAssignment(Assignment* assignment, ConstantsTypeTable *table);
-
-
-        bool mHaveUnfreeResults; 			//indicates that we have some unfree results from mysql, that must be freed
-        MYSQL_RES *mResult;					//result from last queue
-        MYSQL_ROW mRow;						//last fetched row
-        MYSQL_ULONG mReturnedRowsNum;		//number of returned rows from last SELECT query
-        MYSQL_ULONG mReturnedFieldsNum;		//number of returned fields from last SELECT query
-        MYSQL_ULONG mReturnedAffectedRows;	//number of affected rows from last INSERT, DELETE, UPDATE queries
-        MYSQL_ULONG mLastInsertedId;		//number of last id
-        bool mIsConnected;					//indicates connection to db
-        static bool mMySqlIsInitialized;	//flag that mysql is initialized
-
-        string mLastFullQuerry;   //full text of last full get assignment query
-
-        string mLastShortQuerry;  //full text of last short assignment query
-
-        //VARIATIONs WORK
-        Variation* mLastVariation;                     ///Last requested variation ID. Used for caching
+        ConstantsTypeTable * ReadConstantsTypeTable(MySQLStatement& statement);
 
+        bool mIsConnected;                  //indicates connection to db
 
+        MySQLConnectionPoolOptions mPoolOptions;        // Settings for the pool created on Connect
+        std::unique_ptr<MySQLConnectionPool> mPool;     // Connections to the database
+        std::recursive_mutex mCatalogMutex;             // Guards directories, variations and their caches
 
+        MySQLConnectionInfo mConnectionInfo;            // Connection settings of the last Connect
+        std::unique_ptr<MySQLAsyncExecutor> mAsyncExecutor;    // Created on the first asynchronous request
+        std::mutex mAsyncMutex;                         // Guards mAsyncExecutor creation
     };
 }
 
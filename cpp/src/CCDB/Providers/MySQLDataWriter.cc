@@ -0,0 +1,271 @@
+#include <stdexcept>
+
+#include "CCDB/Providers/MySQLDataWriter.h"
+#include "CCDB/Providers/MySQLDataProvider.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+MySQLDataWriter::MySQLDataWriter()
+{
+}
+
+
+//______________________________________________________________________________
+MySQLDataWriter::~MySQLDataWriter()
+{
+    try {
+        Disconnect();
+    }
+    catch (std::exception&) {
+        // Destructor must not throw. Not committed data is lost
+    }
+}
+
+
+//______________________________________________________________________________
+void MySQLDataWriter::Connect(const std::string& connectionString)
+{
+    string thisFuncName = "ccdb::MySQLDataWriter::Connect";
+    if(IsConnected()) {
+        throw std::runtime_error(thisFuncName + " => Connection is already opened");
+    }
+
+    MySQLConnectionInfo info;
+    info.UserName.assign(CCDB_DEFAULT_MYSQL_USERNAME);
+    info.Password.assign(CCDB_DEFAULT_MYSQL_PASSWORD);
+    info.HostName.assign(CCDB_DEFAULT_MYSQL_URL);
+    info.Database.assign(CCDB_DEFAULT_MYSQL_DATABASE);
+    info.Port = CCDB_DEFAULT_MYSQL_PORT;
+    if(!MySQLDataProvider::ParseConnectionString(connectionString, info)) {
+        throw std::runtime_error(thisFuncName + " => Error parse MySQL string. The string is not started with mysql://");
+    }
+
+    mConnection.Open(info);
+    OnConnected();
+}
+
+
+//______________________________________________________________________________
+void MySQLDataWriter::Disconnect()
+{
+    if(!IsConnected()) return;
+
+    Commit();
+    mConnection.Close();
+    ClearCache();
+}
+
+
+//______________________________________________________________________________
+void MySQLDataWriter::Exec(const char* sql)
+{
+    if(!IsConnected()) {
+        throw std::runtime_error("ccdb::MySQLDataWriter => Not connected to MySQL database");
+    }
+
+    MYSQL* handle = mConnection.GetHandle();
+    if(mysql_query(handle, sql)) {
+        throw std::runtime_error(fmt::format("ccdb::MySQLDataWriter => '{}' failed. Error {}: {}", sql, mysql_errno(handle), mysql_error(handle)));
+    }
+}
+
+
+//______________________________________________________________________________
+MySQLStatement& MySQLDataWriter::GetStatement(const std::string& query)
+{
+    if(!IsConnected()) {
+        throw std::runtime_error("ccdb::MySQLDataWriter => Not connected to MySQL database");
+    }
+    return mConnection.GetStatement(query);
+}
+
+
+//______________________________________________________________________________
+void MySQLDataWriter::BeginTransaction()
+{
+    Exec("START TRANSACTION");
+}
+
+
+//______________________________________________________________________________
+void MySQLDataWriter::CommitTransaction()
+{
+    Exec("COMMIT");
+}
+
+
+//______________________________________________________________________________
+void MySQLDataWriter::RollbackTransaction()
+{
+    Exec("ROLLBACK");
+}
+
+
+//______________________________________________________________________________
+dbkey_t MySQLDataWriter::FindDirectoryId(dbkey_t parentId, const std::string& name)
+{
+    auto& query = GetStatement("SELECT `id` FROM `directories` WHERE `parentId` = ? AND `name` = ? LIMIT 1");
+    query.BindInt32(0, parentId);
+    query.BindString(1, name);
+
+    dbkey_t id = 0;
+    query.Execute([&id, &query](uint64_t) { id = query.ReadInt32(0); });
+    return id;
+}
+
+
+//______________________________________________________________________________
+bool MySQLDataWriter::FindTypeTable(dbkey_t directoryId, const std::string& name, TypeTableInfo& info)
+{
+    auto& query = GetStatement("SELECT `id`, `nRows`, `nColumns` FROM `typeTables` WHERE `directoryId` = ? AND `name` = ? LIMIT 1");
+    query.BindInt32(0, directoryId);
+    query.BindString(1, name);
+
+    return query.Execute([&info, &query](uint64_t) {
+        info.Id = query.ReadInt32(0);
+        info.RowsCount = query.ReadInt32(1);
+        info.ColumnsCount = query.ReadInt32(2);
+    }) > 0;
+}
+
+
+//______________________________________________________________________________
+dbkey_t MySQLDataWriter::FindVariationId(const std::string& name)
+{
+    auto& query = GetStatement("SELECT `id` FROM `variations` WHERE `name` = ? LIMIT 1");
+    query.BindString(0, name);
+
+    dbkey_t id = 0;
+    query.Execute([&id, &query](uint64_t) { id = query.ReadInt32(0); });
+    return id;
+}
+
+
+//______________________________________________________________________________
+dbkey_t MySQLDataWriter::FindRunRangeId(int runMin, int runMax)
+{
+    auto& query = GetStatement("SELECT `id` FROM `runRanges` WHERE `runMin` = ? AND `runMax` = ? ORDER BY `id` LIMIT 1");
+    query.BindInt32(0, runMin);
+    query.BindInt32(1, runMax);
+
+    dbkey_t id = 0;
+    query.Execute([&id, &query](uint64_t) { id = query.ReadInt32(0); });
+    return id;
+}
+
+
+//______________________________________________________________________________
+dbkey_t MySQLDataWriter::InsertRunRange(int runMin, int runMax)
+{
+    auto& statement = GetStatement("INSERT INTO `runRanges` (`created`, `modified`, `name`, `runMin`, `runMax`, `comment`) "
+                                   "VALUES (NOW(), NOW(), '', ?, ?, '')");
+    statement.BindInt32(0, runMin);
+    statement.BindInt32(1, runMax);
+    statement.Execute();
+    return static_cast<dbkey_t>(statement.GetLastInsertId());
+}
+
+
+//______________________________________________________________________________
+dbkey_t MySQLDataWriter::InsertConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash)
+{
+    if(vaultHash.empty()) {
+        auto& statement = GetStatement("INSERT INTO `constantSets` (`created`, `modified`, `vault`, `constantTypeId`) "
+                                       "VALUES (NOW(), NOW(), ?, ?)");
+        statement.BindString(0, vault);
+        statement.BindInt32(1, typeTableId);
+        statement.Execute();
+        return static_cast<dbkey_t>(statement.GetLastInsertId());
+    }
+
+    auto& statement = GetStatement("INSERT INTO `constantSets` (`created`, `modified`, `vault`, `constantTypeId`, `vaultHash`) "
+                                   "VALUES (NOW(), NOW(), ?, ?, ?)");
+    statement.BindString(0, vault);
+    statement.BindInt32(1, typeTableId);
+    statement.BindString(2, vaultHash);
+    statement.Execute();
+    return static_cast<dbkey_t>(statement.GetLastInsertId());
+}
+
+
+//______________________________________________________________________________
+bool MySQLDataWriter::HasVaultHashColumn()
+{
+    auto& query = GetStatement("SELECT COUNT(*) FROM `information_schema`.`COLUMNS` "
+                               "WHERE `TABLE_SCHEMA` = DATABASE() AND `TABLE_NAME` = 'constantSets' AND `COLUMN_NAME` = 'vaultHash'");
+    int64_t count = 0;
+    query.Execute([&count, &query](uint64_t) { count = query.ReadInt64(0); });
+    return count > 0;
+}
+
+
+//______________________________________________________________________________
+void MySQLDataWriter::AddVaultHashColumn()
+{
+    // The same as sql/update_vault_hash.mysql.sql
+    Exec("ALTER TABLE `constantSets` "
+         "ADD COLUMN `vaultHash` CHAR(16) NULL DEFAULT NULL AFTER `constantTypeId`, "
+         "ADD INDEX `constantSets_vaultHash_idx` (`vaultHash` ASC, `constantTypeId` ASC)");
+}
+
+
+//______________________________________________________________________________
+dbkey_t MySQLDataWriter::FindConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash)
+{
+    auto& query = GetStatement("SELECT `id`, `vault` FROM `constantSets` WHERE `vaultHash` = ? AND `constantTypeId` = ? ORDER BY `id`");
+    query.BindString(0, vaultHash);
+    query.BindInt32(1, typeTableId);
+
+    // Hashes could collide, vaults are compared to be sure
+    dbkey_t id = 0;
+    query.Execute([&id, &query, &vault](uint64_t) {
+        if(!id && query.ReadString(1) == vault) id = query.ReadInt32(0);
+    });
+    return id;
+}
+
+
+//______________________________________________________________________________
+std::vector<std::pair<dbkey_t, std::string>> MySQLDataWriter::SelectConstantSetsWithoutHash(size_t limit)
+{
+    auto& query = GetStatement("SELECT `id`, `vault` FROM `constantSets` WHERE `vaultHash` IS NULL ORDER BY `id` LIMIT ?");
+    query.BindInt64(0, static_cast<int64_t>(limit));
+
+    std::vector<std::pair<dbkey_t, std::string>> result;
+    query.Execute([&result, &query](uint64_t) {
+        result.emplace_back(query.ReadInt32(0), query.ReadString(1));
+    });
+    return result;
+}
+
+
+//______________________________________________________________________________
+void MySQLDataWriter::UpdateVaultHash(dbkey_t constantSetId, const std::string& vaultHash)
+{
+    auto& statement = GetStatement("UPDATE `constantSets` SET `vaultHash` = ? WHERE `id` = ?");
+    statement.BindString(0, vaultHash);
+    statement.BindInt32(1, constantSetId);
+    statement.Execute();
+}
+
+
+//______________________________________________________________________________
+dbkey_t MySQLDataWriter::InsertAssignment(dbkey_t variationId, dbkey_t runRangeId, dbkey_t constantSetId,
+                                          dbkey_t authorId, const std::string& comment)
+{
+    auto& statement = GetStatement("INSERT INTO `assignments` (`created`, `modified`, `variationId`, `runRangeId`, `constantSetId`, `authorId`, `comment`) "
+                                   "VALUES (NOW(), NOW(), ?, ?, ?, ?, ?)");
+    statement.BindInt32(0, variationId);
+    statement.BindInt32(1, runRangeId);
+    statement.BindInt32(2, constantSetId);
+    statement.BindInt32(3, authorId);
+    statement.BindString(4, comment);
+    statement.Execute();
+    return static_cast<dbkey_t>(statement.GetLastInsertId());
+}
+
+}
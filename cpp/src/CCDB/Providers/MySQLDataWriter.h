@@ -0,0 +1,54 @@
+#ifndef _MySQLDataWriter_
+#define _MySQLDataWriter_
+
+#include <string>
+
+#include "CCDB/Providers/DataWriter.h"
+#include "CCDB/Providers/MySQLConnectionPool.h"
+
+namespace ccdb
+{
+    /** @brief DataWriter for MySQL databases
+     *
+     * Uses own connection and server side prepared statements.
+     * Tables created with ENGINE = MyISAM (the default ccdb schema) ignore transactions, there
+     * each row is visible right after insert and Rollback() doesn't remove rows.
+     */
+    class MySQLDataWriter: public DataWriter
+    {
+    public:
+        MySQLDataWriter();
+        ~MySQLDataWriter() override;
+
+        /** @brief Connects. Connection string is the same as for MySQLDataProvider */
+        void Connect(const std::string& connectionString) override;
+        void Disconnect() override;
+        bool IsConnected() override { return mConnection.IsOpened(); }
+
+    protected:
+        void BeginTransaction() override;
+        void CommitTransaction() override;
+        void RollbackTransaction() override;
+        dbkey_t FindDirectoryId(dbkey_t parentId, const std::string& name) override;
+        bool FindTypeTable(dbkey_t directoryId, const std::string& name, TypeTableInfo& info) override;
+        dbkey_t FindVariationId(const std::string& name) override;
+        dbkey_t FindRunRangeId(int runMin, int runMax) override;
+        dbkey_t InsertRunRange(int runMin, int runMax) override;
+        dbkey_t InsertConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash) override;
+        bool HasVaultHashColumn() override;
+        void AddVaultHashColumn() override;
+        dbkey_t FindConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash) override;
+        std::vector<std::pair<dbkey_t, std::string>> SelectConstantSetsWithoutHash(size_t limit) override;
+        void UpdateVaultHash(dbkey_t constantSetId, const std::string& vaultHash) override;
+        dbkey_t InsertAssignment(dbkey_t variationId, dbkey_t runRangeId, dbkey_t constantSetId,
+                                 dbkey_t authorId, const std::string& comment) override;
+
+    private:
+        void Exec(const char* sql);
+        MySQLStatement& GetStatement(const std::string& query);
+
+        MySQLConnection mConnection;
+    };
+}
+
+#endif //_MySQLDataWriter_
@@ -5,6 +5,8 @@
 #include <time.h>
 #include <string.h>
 #include <limits.h>
+#include <memory>
+#include <sys/stat.h>
 
 #include <fmt/format.h>
 
@@ -22,7 +24,11 @@ using namespace ccdb;
 ccdb::SQLiteDataProvider::SQLiteDataProvider()
 {
 	mIsConnected = false;
+	mOpenMode = cReadOnlyMode;
 	mDatabase=nullptr;
+	mDataVersion = -1;
+	mFileModifiedTime = 0;
+	mFileSize = 0;
 	mRootDir = new Directory();
 	mDirsAreLoaded = false;
 }
@@ -63,7 +69,17 @@ void ccdb::SQLiteDataProvider::Connect(const std::string& connectionString )
     filePath.erase(0,9);            // ok we dont need sqlite:// in the beginning.
 
 	//Try to open sqlite database
-	int result = sqlite3_open_v2(filePath.c_str(), &mDatabase, SQLITE_OPEN_READONLY|SQLITE_OPEN_FULLMUTEX|SQLITE_OPEN_SHAREDCACHE, nullptr); // NOLINT(hicpp-signed-bitwise)
+	int flags = SQLITE_OPEN_READONLY|SQLITE_OPEN_FULLMUTEX|SQLITE_OPEN_SHAREDCACHE; // NOLINT(hicpp-signed-bitwise)
+	std::string openName(filePath);
+	if(mOpenMode == cImmutableMode)
+	{
+		// URI file name, so characters that have meaning in URIs are escaped
+		openName = "file:" + StringUtils::Replace("%", "%25", filePath);
+		openName = StringUtils::Replace("?", "%3f", openName);
+		openName = StringUtils::Replace("#", "%23", openName) + "?immutable=1";
+		flags |= SQLITE_OPEN_URI; // NOLINT(hicpp-signed-bitwise)
+	}
+	int result = sqlite3_open_v2(openName.c_str(), &mDatabase, flags, nullptr);
 
 	if (result != SQLITE_OK) 
 	{
@@ -74,7 +90,9 @@ void ccdb::SQLiteDataProvider::Connect(const std::string& connectionString )
 	}
 
     sqlite3_exec(mDatabase, "PRAGMA journal_mode = OFF;", nullptr, nullptr, nullptr);
-	
+
+	mFilePath = filePath;
+	mDataVersion = -1;
 	mIsConnected = true;
 }
 
@@ -116,7 +134,7 @@ void ccdb::SQLiteDataProvider::LoadDirectories()
     Directory *dir = nullptr;
 
     query.Execute([&dir, &query, this](uint64_t rowIndex) {
-        dir = new Directory();
+        dir = CreateDirectoryObject();
         dir->SetId(query.ReadUInt64(0));              // `id`,
         dir->SetName(query.ReadString(1));            // `name`,
         dir->SetParentId(query.ReadInt32(2));         // `parentId`,
@@ -126,8 +144,8 @@ void ccdb::SQLiteDataProvider::LoadDirectories()
         mDirectoriesById[dir->GetId()] = dir;
     });
 
-    //clear root directory (delete all directory structure objects)
-    mRootDir->DisposeSubdirectories();
+    //old directories are not deleted: type tables read before may point to them
+    mRootDir->ClearSubdirectories();
 
     BuildDirectoryDependencies();
 
@@ -149,6 +167,10 @@ ConstantsTypeTable * ccdb::SQLiteDataProvider::GetConstantsTypeTable( const stri
         throw std::runtime_error(thisFunc + " => Parent directory is null or have invalid ID");
 	}
 
+	//The table could be already read
+	ConstantsTypeTable *table = FindCachedTypeTable(PathUtils::CombinePath(parentDir->GetFullPath(), name));
+	if(table) return table;
+
 	SQLiteStatement query(mDatabase);
 	query.Prepare("SELECT `id`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` "
                   "FROM `typeTables` WHERE `name` = ?1 AND `directoryId` = ?2");
@@ -156,10 +178,9 @@ ConstantsTypeTable * ccdb::SQLiteDataProvider::GetConstantsTypeTable( const stri
 	query.BindInt64(2, parentDir->GetId());
 
 	// execute the statement
-	ConstantsTypeTable *table = nullptr;
     query.Execute([&table, &query, parentDir, this](uint64_t rowIndex) {
         //ok lets read the data...
-        table = new ConstantsTypeTable();
+        table = CreateTypeTable();
         table->SetId(query.ReadUInt64(0));
         table->SetName(query.ReadString(1));
         table->SetDirectoryId(query.ReadUInt64(2));
@@ -172,8 +193,11 @@ ConstantsTypeTable * ccdb::SQLiteDataProvider::GetConstantsTypeTable( const stri
         table->SetFullPath(PathUtils::CombinePath(parentDir->GetFullPath(), table->GetName()));
     });
 
-	//load columns if needed
-	if(loadColumns && table) LoadColumns(table);
+	if(!table) return nullptr;
+
+	//Columns are loaded before the table is cached, cached tables are not changed
+	LoadColumns(table);
+	AddCachedTypeTable(table);
 
 	//return result;
 	return table;
@@ -190,30 +214,31 @@ std::vector<ConstantsTypeTable *> ccdb::SQLiteDataProvider::GetAllConstantsTypeT
     SQLiteStatement query(mDatabase);
     query.Prepare("SELECT `id`, `name`, `directoryId`, `nRows`, `nColumns`, `comment` FROM typeTables");
 
-    // execute the statement
+    // execute the statement. Tables that are already read are taken from the cache
     std::vector<ConstantsTypeTable *> tables;
-    ConstantsTypeTable *table = nullptr;
-    query.Execute([&table, &query, &tables, this](uint64_t rowIndex) {
-        //ok lets read the data...
-        table = new ConstantsTypeTable();
-        table->SetId(query.ReadUInt64(0));
-        table->SetName(query.ReadString(1));
-        table->SetDirectoryId(query.ReadUInt64(2));
-        table->SetNRows(query.ReadUInt32(3));
-        table->SetNColumnsFromDB(query.ReadUInt32(4));
-        table->SetComment(query.ReadString(5));
-        table->SetDirectory(mDirectoriesById[table->GetDirectoryId()]);
+    std::vector<ConstantsTypeTable *> newTables;
+    query.Execute([&query, &tables, &newTables, this](uint64_t rowIndex) {
+        Directory *parentDir = mDirectoriesById[query.ReadUInt64(2)];
+        ConstantsTypeTable *table = parentDir ? FindCachedTypeTable(PathUtils::CombinePath(parentDir->GetFullPath(), query.ReadString(1))) : nullptr;
+        if(!table) {
+            //ok lets read the data...
+            table = CreateTypeTable();
+            table->SetId(query.ReadUInt64(0));
+            table->SetName(query.ReadString(1));
+            table->SetDirectoryId(query.ReadUInt64(2));
+            table->SetNRows(query.ReadUInt32(3));
+            table->SetNColumnsFromDB(query.ReadUInt32(4));
+            table->SetComment(query.ReadString(5));
+            table->SetDirectory(parentDir);
+            newTables.push_back(table);
+        }
         tables.push_back(table);
     });
 
-
-    //Load COLUMNS if needed...
-	if(loadColumns)
-    {
-        for (auto & tableForColumns : tables)
-        {
-            LoadColumns(tableForColumns);
-        }
+    //Columns are loaded before tables are cached, cached tables are not changed
+    LoadColumns(newTables);
+    for(auto table: newTables) {
+        if(table->GetDirectory()) AddCachedTypeTable(table);
     }
  	return tables;
 }
@@ -225,17 +250,47 @@ void ccdb::SQLiteDataProvider::LoadColumns( ConstantsTypeTable* table )
     query.Prepare("SELECT `id`, `name`, `columnType` FROM `columns` WHERE `typeId` = ?1 ORDER BY `order`");
 	query.BindInt32(1, table->GetId());
 
-    // execute the statement
-    ConstantsTypeColumn *column;
-    query.Execute([&table, &query, &column, this](uint64_t rowIndex) {
+    // execute the statement. Columns are set all at once, so the table descriptor is built once
+    vector<ConstantsTypeColumn *> columns;
+    query.Execute([&table, &query, &columns, this](uint64_t rowIndex) {
 
-        column = new ConstantsTypeColumn();
+        ConstantsTypeColumn *column = CreateColumn();
         column->SetId(query.ReadUInt64(0));
         column->SetName(query.ReadString(1));
         column->SetType(query.ReadString(2));
         column->SetDBTypeTableId(table->GetId());
-        table->AddColumn(column);
+        columns.push_back(column);
     });
+    table->SetColumns(columns);
+}
+
+
+void ccdb::SQLiteDataProvider::LoadColumns(const std::vector<ConstantsTypeTable*>& tables)
+{
+    if(tables.size() < 2) {
+        for(auto table: tables) LoadColumns(table);
+        return;
+    }
+
+    // Columns of all tables are read by one query and are given to the requested ones
+    std::map<dbkey_t, vector<ConstantsTypeColumn *>> columnsByTableId;
+    for(auto table: tables) columnsByTableId[table->GetId()];
+
+    SQLiteStatement query(mDatabase);
+    query.Prepare("SELECT `id`, `name`, `columnType`, `typeId` FROM `columns` ORDER BY `typeId`, `order`");
+    query.Execute([&query, &columnsByTableId, this](uint64_t rowIndex) {
+        auto columns = columnsByTableId.find(query.ReadUInt64(3));
+        if(columns == columnsByTableId.end()) return;
+
+        ConstantsTypeColumn *column = CreateColumn();
+        column->SetId(query.ReadUInt64(0));
+        column->SetName(query.ReadString(1));
+        column->SetType(query.ReadString(2));
+        column->SetDBTypeTableId(columns->first);
+        columns->second.push_back(column);
+    });
+
+    for(auto table: tables) table->SetColumns(columnsByTableId[table->GetId()]);
 }
 
 
@@ -266,7 +321,7 @@ Variation* ccdb::SQLiteDataProvider::SelectVariation(SQLiteStatement& query)
     // execute the statement
     Variation *var = nullptr;
     query.Execute([&var, &query, this](uint64_t rowIndex) {
-        var = new Variation();
+        var = CreateVariation();
         var->SetId(query.ReadUInt64(0));
         var->SetParentDbId(query.ReadUInt64(1));
         var->SetName(query.ReadString(2));
@@ -307,7 +362,9 @@ Assignment* ccdb::SQLiteDataProvider::GetAssignmentShort(int run, const string&
     SQLiteStatement query(mDatabase);
     query.Prepare(
         "SELECT `assignments`.`id` AS `asId`, "
-        "`constantSets`.`vault` AS `blob` "
+        "`constantSets`.`vault` AS `blob`, "
+        "`assignments`.`constantSetId`, "
+        "`runRanges`.`id`, `runRanges`.`runMin`, `runRanges`.`runMax` "
         "FROM  `assignments` "
         "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
         "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
@@ -330,10 +387,13 @@ Assignment* ccdb::SQLiteDataProvider::GetAssignmentShort(int run, const string&
 
 	// execute the statement
 	Assignment *assignment = nullptr;
-    auto selectedRows = query.Execute([&assignment, &query, run](uint64_t rowIndex) {
+    auto selectedRows = query.Execute([&assignment, &query, run, this](uint64_t rowIndex) {
         assignment = new Assignment();
         assignment->SetId( query.ReadUInt64(0) );
         assignment->SetRawData(query.ReadString(1));
+        assignment->SetDataVaultId(query.ReadInt32(2));
+        assignment->SetRunRangeId(query.ReadInt32(3));
+        assignment->SetRunRange(GetCachedRunRange(query.ReadInt32(3), query.ReadInt32(4), query.ReadInt32(5)));
         assignment->SetRequestedRun(run);
     });
 
@@ -351,4 +411,305 @@ Assignment* ccdb::SQLiteDataProvider::GetAssignmentShort(int run, const string&
 	}
 
 	return assignment;
-}
\ No newline at end of file
+}
+
+
+//______________________________________________________________________________
+ccdb::AssignmentIdentity ccdb::SQLiteDataProvider::GetAssignmentIdentity(int run, const string& path, time_t time, const string& variationName)
+{
+    ConstantsTypeTable *table = DataProvider::GetConstantsTypeTable(path, false);
+    if(!table) {
+        throw std::runtime_error("SQLiteDataProvider::GetAssignmentIdentity => Type table was not found: '"+path+"'");
+    }
+
+    Variation* variation = GetVariation(variationName);
+    if(!variation) {
+        throw std::runtime_error("SQLiteDataProvider::GetAssignmentIdentity => No variation '"+variationName+"' was found");
+    }
+
+    // The same selection as GetAssignmentShort, but the vault column is not touched
+    SQLiteStatement query(mDatabase);
+    query.Prepare(
+        "SELECT `assignments`.`id`, `assignments`.`constantSetId` "
+        "FROM  `assignments` "
+        "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+        "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+        "WHERE  `runRanges`.`runMin` <= ?1 "
+        "AND `runRanges`.`runMax` >= ?1 "
+        "AND `assignments`.`variationId`= ?2 "
+        "AND  `constantSets`.`constantTypeId` =?3 " +
+        ((time>0)? string("AND  `assignments`.`created` <= datetime(?4, 'unixepoch', 'localtime') ") : string()) +
+        "ORDER BY `assignments`.`id` DESC "
+        "LIMIT 1 ");
+
+    query.BindInt32(1, run);
+    query.BindInt32(2, variation->GetId());
+    query.BindInt32(3, table->GetId());
+    if(time>0) query.BindInt64(4, time);
+
+    AssignmentIdentity identity;
+    query.Execute([&identity, &query](uint64_t rowIndex) {
+        identity.AssignmentId = query.ReadInt32(0);
+        identity.ConstantSetId = query.ReadInt32(1);
+    });
+
+    //If We have not found data for this variation, getting data for parent variation
+    if(!identity.AssignmentId && variation->GetParentDbId()!=0) {
+        return GetAssignmentIdentity(run, path, time, variation->GetParent()->GetName());
+    }
+    return identity;
+}
+
+
+//______________________________________________________________________________
+uint64_t ccdb::SQLiteDataProvider::VisitAssignments(const string& path, const string& variationName, int run, time_t time,
+                                                    const std::function<bool(Assignment&)>& onAssignment)
+{
+    //Get type table with columns, so visited assignments could map their data
+    ConstantsTypeTable* table = DataProvider::GetConstantsTypeTable(path, true);
+    if(!table) {
+        throw std::runtime_error("SQLiteDataProvider::VisitAssignments => Type table was not found: '"+path+"'");
+    }
+
+    Variation* variation = GetVariation(variationName);
+    if(!variation) {
+        throw std::runtime_error("SQLiteDataProvider::VisitAssignments => No variation '"+variationName+"' was found");
+    }
+
+    SQLiteStatement query(mDatabase);
+    query.Prepare(
+        "SELECT `assignments`.`id`, strftime('%s', `assignments`.`created`, 'utc'), `assignments`.`comment`, "
+        "`runRanges`.`id`, `runRanges`.`runMin`, `runRanges`.`runMax`, "
+        "`constantSets`.`vault`, `constantSets`.`id` "
+        "FROM  `assignments` "
+        "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+        "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+        "WHERE `assignments`.`variationId`= ?1 "
+        "AND `constantSets`.`constantTypeId` = ?2 " +
+        ((run>=0)? string("AND `runRanges`.`runMin` <= ?3 AND `runRanges`.`runMax` >= ?3 ") : string()) +
+        ((time>0)? string("AND `assignments`.`created` <= datetime(?4, 'unixepoch', 'localtime') ") : string()) +
+        "ORDER BY `assignments`.`id` DESC");
+
+    query.BindInt32(1, variation->GetId());
+    query.BindInt32(2, table->GetId());
+    if(run>=0) query.BindInt32(3, run);
+    if(time>0) query.BindInt64(4, time);
+
+    // sqlite3_step gives rows one by one, they are not accumulated anywhere
+    return query.ExecuteWhile([&](uint64_t rowIndex) {
+        RunRange runRange;
+        runRange.SetId(query.ReadInt32(3));
+        runRange.SetRange(query.ReadInt32(4), query.ReadInt32(5));
+
+        Assignment assignment;
+        assignment.SetId(query.ReadInt32(0));
+        assignment.SetCreatedTime(query.ReadUnixTime(1));
+        assignment.SetComment(query.ReadString(2));
+        assignment.SetRunRangeId(runRange.GetId());
+        assignment.SetRunRange(&runRange);
+        assignment.SetRawData(query.ReadString(6));
+        assignment.SetDataVaultId(query.ReadInt32(7));
+        assignment.SetRequestedRun(run);
+        assignment.SetTypeTable(table);
+        assignment.SetVariation(variation);
+        assignment.SetVariationId(variation->GetId());
+
+        return onAssignment(assignment);
+    });
+}
+
+
+//______________________________________________________________________________
+dbkey_t ccdb::SQLiteDataProvider::GetLastAssignmentId()
+{
+    if(!IsConnected()) {
+        throw std::runtime_error("SQLiteDataProvider::GetLastAssignmentId => Not connected to SQLite database");
+    }
+
+    SQLiteStatement query(mDatabase, "SELECT COALESCE(MAX(`id`), 0) FROM `assignments`");
+    dbkey_t id = 0;
+    query.Execute([&id, &query](uint64_t rowIndex) { id = query.ReadInt32(0); });
+    return id;
+}
+
+
+//______________________________________________________________________________
+std::vector<AssignmentChange> ccdb::SQLiteDataProvider::GetAssignmentsAfter(dbkey_t assignmentId)
+{
+    if(!IsConnected()) {
+        throw std::runtime_error("SQLiteDataProvider::GetAssignmentsAfter => Not connected to SQLite database");
+    }
+
+    SQLiteStatement query(mDatabase,
+        "SELECT `assignments`.`id`, strftime('%s', `assignments`.`created`, 'utc'), "
+        "`variations`.`name`, `runRanges`.`runMin`, `runRanges`.`runMax`, "
+        "`typeTables`.`id`, `typeTables`.`directoryId`, `typeTables`.`name` "
+        "FROM  `assignments` "
+        "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+        "INNER JOIN `variations` ON `assignments`.`variationId`= `variations`.`id` "
+        "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+        "INNER JOIN `typeTables` ON `constantSets`.`constantTypeId` = `typeTables`.`id` "
+        "WHERE `assignments`.`id` > ?1 "
+        "ORDER BY `assignments`.`id`");
+    query.BindInt32(1, assignmentId);
+
+    std::vector<AssignmentChange> changes;
+    query.Execute([&changes, &query, this](uint64_t rowIndex) {
+        AssignmentChange change;
+        change.AssignmentId = query.ReadInt32(0);
+        change.Created = query.ReadUnixTime(1);
+        change.Variation = query.ReadString(2);
+        change.RunMin = query.ReadInt32(3);
+        change.RunMax = query.ReadInt32(4);
+        change.TypeTableId = query.ReadInt32(5);
+        change.TablePath = GetTypeTablePath(query.ReadInt32(6), query.ReadString(7));
+        changes.push_back(change);
+    });
+    return changes;
+}
+
+
+//______________________________________________________________________________
+std::vector<AssignmentHistoryRecord> ccdb::SQLiteDataProvider::GetAssignmentHistoryPage(const string& path, const string& variationName, int run,
+                                                                                        const AssignmentHistoryCursor& after, size_t limit)
+{
+    ConstantsTypeTable *table = DataProvider::GetConstantsTypeTable(path, false);
+    if(!table) {
+        throw std::runtime_error("SQLiteDataProvider::GetAssignmentHistoryPage => Type table was not found: '"+path+"'");
+    }
+
+    Variation* variation = nullptr;
+    if(!variationName.empty()) {
+        variation = GetVariation(variationName);
+        if(!variation) {
+            throw std::runtime_error("SQLiteDataProvider::GetAssignmentHistoryPage => No variation '"+variationName+"' was found");
+        }
+    }
+
+    // (created, id) > cursor. created is compared as stored, the same way time filters of other queries do
+    SQLiteStatement query(mDatabase);
+    query.Prepare(
+        "SELECT `assignments`.`id`, strftime('%s', `assignments`.`created`, 'utc'), `assignments`.`comment`, "
+        "`runRanges`.`runMin`, `runRanges`.`runMax`, `variations`.`id`, `variations`.`name`, `constantSets`.`id` "
+        "FROM  `assignments` "
+        "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+        "INNER JOIN `variations` ON `assignments`.`variationId`= `variations`.`id` "
+        "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+        "WHERE `constantSets`.`constantTypeId` = ?1 " +
+        (variation? string("AND `assignments`.`variationId`= ?2 ") : string()) +
+        ((run>=0)? string("AND `runRanges`.`runMin` <= ?3 AND `runRanges`.`runMax` >= ?3 ") : string()) +
+        (!after.IsAtStart()? string("AND (`assignments`.`created` > datetime(?4, 'unixepoch', 'localtime') "
+                                    "OR (`assignments`.`created` = datetime(?4, 'unixepoch', 'localtime') AND `assignments`.`id` > ?5)) ") : string()) +
+        "ORDER BY `assignments`.`created`, `assignments`.`id` "
+        "LIMIT ?6");
+
+    query.BindInt32(1, table->GetId());
+    if(variation) query.BindInt32(2, variation->GetId());
+    if(run>=0) query.BindInt32(3, run);
+    if(!after.IsAtStart()) {
+        query.BindInt64(4, after.Created);
+        query.BindInt32(5, after.AssignmentId);
+    }
+    query.BindInt64(6, static_cast<int64_t>(limit));
+
+    std::vector<AssignmentHistoryRecord> records;
+    query.Execute([&records, &query](uint64_t rowIndex) {
+        AssignmentHistoryRecord record;
+        record.AssignmentId = query.ReadInt32(0);
+        record.Created = query.ReadUnixTime(1);
+        record.Comment = query.ReadString(2);
+        record.RunMin = query.ReadInt32(3);
+        record.RunMax = query.ReadInt32(4);
+        record.VariationId = query.ReadInt32(5);
+        record.Variation = query.ReadString(6);
+        record.ConstantSetId = query.ReadInt32(7);
+        records.push_back(std::move(record));
+    });
+    return records;
+}
+
+
+//______________________________________________________________________________
+std::vector<AssignmentHistoryRecord> ccdb::SQLiteDataProvider::GetAssignmentRecords(const string& path, const string& variationName, int runMin, int runMax)
+{
+    ConstantsTypeTable *table = DataProvider::GetConstantsTypeTable(path, false);
+    if(!table) {
+        throw std::runtime_error("SQLiteDataProvider::GetAssignmentRecords => Type table was not found: '"+path+"'");
+    }
+
+    Variation* variation = GetVariation(variationName);
+    if(!variation) {
+        throw std::runtime_error("SQLiteDataProvider::GetAssignmentRecords => No variation '"+variationName+"' was found");
+    }
+
+    SQLiteStatement query(mDatabase);
+    query.Prepare(
+        "SELECT `assignments`.`id`, strftime('%s', `assignments`.`created`, 'utc'), "
+        "`runRanges`.`runMin`, `runRanges`.`runMax`, `assignments`.`constantSetId` "
+        "FROM  `assignments` "
+        "INNER JOIN `runRanges` ON `assignments`.`runRangeId`= `runRanges`.`id` "
+        "INNER JOIN `constantSets` ON `assignments`.`constantSetId` = `constantSets`.`id` "
+        "WHERE `constantSets`.`constantTypeId` = ?1 AND `assignments`.`variationId`= ?2 "
+        "AND `runRanges`.`runMax` >= ?3 AND `runRanges`.`runMin` <= ?4 "
+        "ORDER BY `assignments`.`id`");
+    query.BindInt32(1, table->GetId());
+    query.BindInt32(2, variation->GetId());
+    query.BindInt32(3, runMin);
+    query.BindInt32(4, runMax);
+
+    std::vector<AssignmentHistoryRecord> records;
+    query.Execute([&records, &query, variation](uint64_t rowIndex) {
+        AssignmentHistoryRecord record;
+        record.AssignmentId = query.ReadInt32(0);
+        record.Created = query.ReadUnixTime(1);
+        record.RunMin = query.ReadInt32(2);
+        record.RunMax = query.ReadInt32(3);
+        record.VariationId = variation->GetId();
+        record.Variation = variation->GetName();
+        record.ConstantSetId = query.ReadInt32(4);
+        records.push_back(std::move(record));
+    });
+    return records;
+}
+
+
+//______________________________________________________________________________
+std::shared_ptr<const VaultData> ccdb::SQLiteDataProvider::GetConstantSetVault(dbkey_t constantSetId)
+{
+    if(!IsConnected()) {
+        throw std::runtime_error("SQLiteDataProvider::GetConstantSetVault => Not connected to SQLite database");
+    }
+
+    SQLiteStatement query(mDatabase, "SELECT `vault` FROM `constantSets` WHERE `id` = ?1");
+    query.BindInt32(1, constantSetId);
+
+    std::shared_ptr<const VaultData> vault;
+    query.Execute([&vault, &query](uint64_t rowIndex) { vault = std::make_shared<VaultData>(query.ReadString(0)); });
+    return vault;
+}
+
+
+//______________________________________________________________________________
+bool ccdb::SQLiteDataProvider::IsChangedSinceLastCheck()
+{
+    if(!IsConnected()) {
+        throw std::runtime_error("SQLiteDataProvider::IsChangedSinceLastCheck => Not connected to SQLite database");
+    }
+
+    // The file time has 1 second resolution, data_version catches commits within a second
+    bool isChanged = mDataVersion < 0;
+    struct stat fileInfo;
+    if(stat(mFilePath.c_str(), &fileInfo) == 0) {
+        isChanged = isChanged || fileInfo.st_mtime != mFileModifiedTime || fileInfo.st_size != mFileSize;
+        mFileModifiedTime = fileInfo.st_mtime;
+        mFileSize = fileInfo.st_size;
+    }
+
+    SQLiteStatement query(mDatabase, "PRAGMA data_version");
+    int64_t dataVersion = mDataVersion;
+    query.Execute([&dataVersion, &query](uint64_t rowIndex) { dataVersion = query.ReadInt64(0); });
+    isChanged = isChanged || dataVersion != mDataVersion;
+    mDataVersion = dataVersion;
+
+    return isChanged;
+}
@@ -20,9 +20,20 @@ class SQLiteDataProvider: public DataProvider
 {
 	
 public:
+	/** @brief How the database file is opened */
+	enum OpenModes
+	{
+		cReadOnlyMode,		/// Read only, with file locks (default)
+		cImmutableMode		/// Read only, without file locks. For files that are not changed while they are open
+	};
+
 	SQLiteDataProvider();
 	~SQLiteDataProvider() override;
 
+	/** @brief Open mode for the next Connect */
+	void SetOpenMode(OpenModes mode) { mOpenMode = mode; }
+	OpenModes GetOpenMode() const { return mOpenMode; }
+
     //----------------------------------------------------------------------------------------
     //  I M P L E M E N T   I N T E R F A C E
     //----------------------------------------------------------------------------------------
@@ -54,8 +65,8 @@ public:
     /** @brief Reads all directories from DB
      *
      * Explicitly forces to load directories from DB and build directory structure
-     * (!) At this implementation all existing directories references will be deleted,
-     * thus  references to them will become broken
+     * Directories of previous loads are not deleted, so existing references stay valid,
+     * but they are not in the new directory tree
      * @return   bool
      */
     void LoadDirectories() override;
@@ -95,6 +106,40 @@ public:
     */
     Assignment* GetAssignmentShort(int run, const string& path, time_t time, const string& variation, bool loadColumns) override;
 
+    /** @brief Assignment and constant set ids for the request. The vault is not read. See DataProvider::GetAssignmentIdentity */
+    AssignmentIdentity GetAssignmentIdentity(int run, const string& path, time_t time, const string& variation) override;
+
+    /** @brief Lists assignments of the type table in the variation, newest first
+    *
+    * Rows are read with sqlite3_step one by one and are not accumulated in memory.
+    * See DataProvider::VisitAssignments
+    */
+    uint64_t VisitAssignments(const string& path, const string& variation, int run, time_t time,
+                              const std::function<bool(Assignment&)>& onAssignment) override;
+
+    /** @brief Id of the newest assignment. See DataProvider::GetLastAssignmentId */
+    dbkey_t GetLastAssignmentId() override;
+
+    /** @brief Assignments with id greater than assignmentId. See DataProvider::GetAssignmentsAfter */
+    std::vector<AssignmentChange> GetAssignmentsAfter(dbkey_t assignmentId) override;
+
+    /** @brief Page of the assignment history without vaults. See DataProvider::GetAssignmentHistoryPage */
+    std::vector<AssignmentHistoryRecord> GetAssignmentHistoryPage(const string& path, const string& variation, int run,
+                                                                  const AssignmentHistoryCursor& after, size_t limit) override;
+
+    /** @brief Assignments overlapping the runs without vaults. See DataProvider::GetAssignmentRecords */
+    std::vector<AssignmentHistoryRecord> GetAssignmentRecords(const string& path, const string& variation, int runMin, int runMax) override;
+
+    /** @brief Data blob of the constant set. See DataProvider::GetConstantSetVault */
+    std::shared_ptr<const VaultData> GetConstantSetVault(dbkey_t constantSetId) override;
+
+    /** @brief Checks the file modification time and PRAGMA data_version
+     *
+     * data_version changes when other connections (other processes too) commit to the file.
+     * Both checks don't read tables, so it is cheap to call it often.
+     */
+    bool IsChangedSinceLastCheck() override;
+
 
     //----------------------------------------------------------------------------------------
     //  E N D   I M P L E M E N T   I N T E R F A C E
@@ -109,6 +154,9 @@ public:
 	 */
     void LoadColumns(ConstantsTypeTable* table);
 
+    /** @brief Loads columns for many type tables by one query */
+    void LoadColumns(const std::vector<ConstantsTypeTable*>& tables);
+
     /** @brief Load variation by DB id
 	 * 
 	 * @param     const char * name
@@ -134,6 +182,12 @@ private:
 	sqlite3 *		mDatabase;			//Handler to sqlite object
 
 	bool mIsConnected;					//indicates connection to db
+	OpenModes mOpenMode;				//How the file is opened on Connect
+
+	std::string mFilePath;				//Path of the opened file
+	int64_t mDataVersion;				//PRAGMA data_version on the last IsChangedSinceLastCheck. -1 - not checked yet
+	time_t mFileModifiedTime;			//File modification time on the last IsChangedSinceLastCheck
+	int64_t mFileSize;					//File size on the last IsChangedSinceLastCheck
 
 };
 }
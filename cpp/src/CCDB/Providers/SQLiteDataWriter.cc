@@ -0,0 +1,310 @@
+#include <stdexcept>
+
+#include "CCDB/Providers/SQLiteDataWriter.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+SQLiteDataWriter::SQLiteDataWriter():
+    mDatabase(nullptr)
+{
+}
+
+
+//______________________________________________________________________________
+SQLiteDataWriter::~SQLiteDataWriter()
+{
+    try {
+        Disconnect();
+    }
+    catch (std::exception&) {
+        // Destructor must not throw. Not committed data is lost
+    }
+}
+
+
+//______________________________________________________________________________
+void SQLiteDataWriter::Connect(const std::string& connectionString)
+{
+    string thisFuncName = "ccdb::SQLiteDataWriter::Connect";
+    if(connectionString.find("sqlite://") != 0) {
+        throw std::runtime_error(thisFuncName + " => Error parse SQLite string. The string is not started with sqlite://");
+    }
+    if(IsConnected()) {
+        throw std::runtime_error(thisFuncName + " => Connection is already opened");
+    }
+
+    string filePath = connectionString.substr(9);   // remove sqlite://
+    int result = sqlite3_open_v2(filePath.c_str(), &mDatabase, SQLITE_OPEN_READWRITE|SQLITE_OPEN_FULLMUTEX, nullptr); // NOLINT(hicpp-signed-bitwise)
+    if(result != SQLITE_OK) {
+        string errStr = mDatabase ? sqlite3_errmsg(mDatabase) : "out of memory";
+        sqlite3_close(mDatabase);
+        mDatabase = nullptr;
+        throw std::runtime_error(thisFuncName + " => SQLite open error: " + errStr);
+    }
+
+    // Readers could hold the file for a moment. Wait for them instead of failing
+    sqlite3_busy_timeout(mDatabase, 10000);
+    OnConnected();
+}
+
+
+//______________________________________________________________________________
+void SQLiteDataWriter::Disconnect()
+{
+    if(!IsConnected()) return;
+
+    Commit();
+
+    mInsertRunRange.reset();
+    mInsertConstantSet.reset();
+    mInsertHashedConstantSet.reset();
+    mFindConstantSet.reset();
+    mInsertAssignment.reset();
+    sqlite3_close(mDatabase);
+    mDatabase = nullptr;
+    ClearCache();
+}
+
+
+//______________________________________________________________________________
+void SQLiteDataWriter::Exec(const char* sql)
+{
+    if(!IsConnected()) {
+        throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+    }
+
+    char* errorMessage = nullptr;
+    if(sqlite3_exec(mDatabase, sql, nullptr, nullptr, &errorMessage) != SQLITE_OK) {
+        string error = fmt::format("ccdb::SQLiteDataWriter => '{}' failed: {}", sql, errorMessage ? errorMessage : "");
+        sqlite3_free(errorMessage);
+        throw std::runtime_error(error);
+    }
+}
+
+
+//______________________________________________________________________________
+SQLiteStatement& SQLiteDataWriter::GetStatement(std::unique_ptr<SQLiteStatement>& statement, const char* query)
+{
+    if(!IsConnected()) {
+        throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+    }
+    if(!statement) {
+        statement.reset(new SQLiteStatement(mDatabase, query));
+    }
+    statement->Reset();
+    return *statement;
+}
+
+
+//______________________________________________________________________________
+void SQLiteDataWriter::BeginTransaction()
+{
+    Exec("BEGIN IMMEDIATE TRANSACTION");
+}
+
+
+//______________________________________________________________________________
+void SQLiteDataWriter::CommitTransaction()
+{
+    Exec("COMMIT TRANSACTION");
+}
+
+
+//______________________________________________________________________________
+void SQLiteDataWriter::RollbackTransaction()
+{
+    Exec("ROLLBACK TRANSACTION");
+}
+
+
+//______________________________________________________________________________
+dbkey_t SQLiteDataWriter::FindDirectoryId(dbkey_t parentId, const std::string& name)
+{
+    if(!IsConnected()) throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+
+    SQLiteStatement query(mDatabase, "SELECT `id` FROM `directories` WHERE `parentId` = ?1 AND `name` = ?2 LIMIT 1");
+    query.BindInt32(1, parentId);
+    query.BindString(2, name);
+
+    dbkey_t id = 0;
+    query.Execute([&id, &query](uint64_t) { id = query.ReadInt32(0); });
+    return id;
+}
+
+
+//______________________________________________________________________________
+bool SQLiteDataWriter::FindTypeTable(dbkey_t directoryId, const std::string& name, TypeTableInfo& info)
+{
+    if(!IsConnected()) throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+
+    SQLiteStatement query(mDatabase, "SELECT `id`, `nRows`, `nColumns` FROM `typeTables` WHERE `directoryId` = ?1 AND `name` = ?2 LIMIT 1");
+    query.BindInt32(1, directoryId);
+    query.BindString(2, name);
+
+    return query.Execute([&info, &query](uint64_t) {
+        info.Id = query.ReadInt32(0);
+        info.RowsCount = query.ReadInt32(1);
+        info.ColumnsCount = query.ReadInt32(2);
+    }) > 0;
+}
+
+
+//______________________________________________________________________________
+dbkey_t SQLiteDataWriter::FindVariationId(const std::string& name)
+{
+    if(!IsConnected()) throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+
+    SQLiteStatement query(mDatabase, "SELECT `id` FROM `variations` WHERE `name` = ?1 LIMIT 1");
+    query.BindString(1, name);
+
+    dbkey_t id = 0;
+    query.Execute([&id, &query](uint64_t) { id = query.ReadInt32(0); });
+    return id;
+}
+
+
+//______________________________________________________________________________
+dbkey_t SQLiteDataWriter::FindRunRangeId(int runMin, int runMax)
+{
+    if(!IsConnected()) throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+
+    SQLiteStatement query(mDatabase, "SELECT `id` FROM `runRanges` WHERE `runMin` = ?1 AND `runMax` = ?2 ORDER BY `id` LIMIT 1");
+    query.BindInt32(1, runMin);
+    query.BindInt32(2, runMax);
+
+    dbkey_t id = 0;
+    query.Execute([&id, &query](uint64_t) { id = query.ReadInt32(0); });
+    return id;
+}
+
+
+//______________________________________________________________________________
+dbkey_t SQLiteDataWriter::InsertRunRange(int runMin, int runMax)
+{
+    // 'created' is stored in local time like python ccdb does
+    auto& statement = GetStatement(mInsertRunRange,
+        "INSERT INTO `runRanges` (`created`, `modified`, `name`, `runMin`, `runMax`, `comment`) "
+        "VALUES (datetime('now', 'localtime'), datetime('now', 'localtime'), '', ?1, ?2, '')");
+    statement.BindInt32(1, runMin);
+    statement.BindInt32(2, runMax);
+    statement.Execute();
+    return static_cast<dbkey_t>(statement.GetLastInsertId());
+}
+
+
+//______________________________________________________________________________
+dbkey_t SQLiteDataWriter::InsertConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash)
+{
+    if(vaultHash.empty()) {
+        auto& statement = GetStatement(mInsertConstantSet,
+            "INSERT INTO `constantSets` (`created`, `modified`, `vault`, `constantTypeId`) "
+            "VALUES (datetime('now', 'localtime'), datetime('now', 'localtime'), ?1, ?2)");
+        statement.BindString(1, vault);
+        statement.BindInt32(2, typeTableId);
+        statement.Execute();
+        return static_cast<dbkey_t>(statement.GetLastInsertId());
+    }
+
+    auto& statement = GetStatement(mInsertHashedConstantSet,
+        "INSERT INTO `constantSets` (`created`, `modified`, `vault`, `constantTypeId`, `vaultHash`) "
+        "VALUES (datetime('now', 'localtime'), datetime('now', 'localtime'), ?1, ?2, ?3)");
+    statement.BindString(1, vault);
+    statement.BindInt32(2, typeTableId);
+    statement.BindString(3, vaultHash);
+    statement.Execute();
+    return static_cast<dbkey_t>(statement.GetLastInsertId());
+}
+
+
+//______________________________________________________________________________
+bool SQLiteDataWriter::HasVaultHashColumn()
+{
+    if(!IsConnected()) throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+
+    SQLiteStatement query(mDatabase, "PRAGMA table_info(`constantSets`)");
+    bool hasColumn = false;
+    query.Execute([&hasColumn, &query](uint64_t) {
+        if(query.ReadString(1) == "vaultHash") hasColumn = true;      // table_info columns: cid, name, type, ...
+    });
+    return hasColumn;
+}
+
+
+//______________________________________________________________________________
+void SQLiteDataWriter::AddVaultHashColumn()
+{
+    // The same as sql/update_vault_hash.sqlite.sql
+    Exec("ALTER TABLE constantSets ADD COLUMN vaultHash CHAR(16) NULL DEFAULT NULL");
+    Exec("CREATE INDEX IF NOT EXISTS constantSets_vaultHash_idx ON constantSets (vaultHash, constantTypeId)");
+}
+
+
+//______________________________________________________________________________
+dbkey_t SQLiteDataWriter::FindConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash)
+{
+    auto& query = GetStatement(mFindConstantSet,
+        "SELECT `id`, `vault` FROM `constantSets` WHERE `vaultHash` = ?1 AND `constantTypeId` = ?2 ORDER BY `id`");
+    query.BindString(1, vaultHash);
+    query.BindInt32(2, typeTableId);
+
+    // Hashes could collide, vaults are compared to be sure
+    dbkey_t id = 0;
+    query.ExecuteWhile([&id, &query, &vault](uint64_t) {
+        if(query.ReadString(1) != vault) return true;
+        id = query.ReadInt32(0);
+        return false;
+    });
+    query.Reset();      // don't keep the read open till the next call
+    return id;
+}
+
+
+//______________________________________________________________________________
+std::vector<std::pair<dbkey_t, std::string>> SQLiteDataWriter::SelectConstantSetsWithoutHash(size_t limit)
+{
+    if(!IsConnected()) throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+
+    SQLiteStatement query(mDatabase, "SELECT `id`, `vault` FROM `constantSets` WHERE `vaultHash` IS NULL ORDER BY `id` LIMIT ?1");
+    query.BindInt64(1, static_cast<int64_t>(limit));
+
+    std::vector<std::pair<dbkey_t, std::string>> result;
+    query.Execute([&result, &query](uint64_t) {
+        result.emplace_back(query.ReadInt32(0), query.ReadString(1));
+    });
+    return result;
+}
+
+
+//______________________________________________________________________________
+void SQLiteDataWriter::UpdateVaultHash(dbkey_t constantSetId, const std::string& vaultHash)
+{
+    if(!IsConnected()) throw std::runtime_error("ccdb::SQLiteDataWriter => Not connected to SQLite database");
+
+    SQLiteStatement query(mDatabase, "UPDATE `constantSets` SET `vaultHash` = ?1 WHERE `id` = ?2");
+    query.BindString(1, vaultHash);
+    query.BindInt32(2, constantSetId);
+    query.Execute();
+}
+
+
+//______________________________________________________________________________
+dbkey_t SQLiteDataWriter::InsertAssignment(dbkey_t variationId, dbkey_t runRangeId, dbkey_t constantSetId,
+                                           dbkey_t authorId, const std::string& comment)
+{
+    auto& statement = GetStatement(mInsertAssignment,
+        "INSERT INTO `assignments` (`created`, `modified`, `variationId`, `runRangeId`, `constantSetId`, `authorId`, `comment`) "
+        "VALUES (datetime('now', 'localtime'), datetime('now', 'localtime'), ?1, ?2, ?3, ?4, ?5)");
+    statement.BindInt32(1, variationId);
+    statement.BindInt32(2, runRangeId);
+    statement.BindInt32(3, constantSetId);
+    statement.BindInt32(4, authorId);
+    statement.BindString(5, comment);
+    statement.Execute();
+    return static_cast<dbkey_t>(statement.GetLastInsertId());
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef _SQLiteDataWriter_
+#define _SQLiteDataWriter_
+
+#include <sqlite3.h>
+#include <string>
+#include <memory>
+
+#include "CCDB/Providers/DataWriter.h"
+#include "CCDB/Helpers/SQLite.h"
+
+namespace ccdb
+{
+    /** @brief DataWriter for SQLite files
+     *
+     * Opens own read-write connection, so the file could be read by SQLiteDataProvider at the same time.
+     * Readers see written assignments after they are committed.
+     */
+    class SQLiteDataWriter: public DataWriter
+    {
+    public:
+        SQLiteDataWriter();
+        ~SQLiteDataWriter() override;
+
+        /** @brief Opens the file. Connection string is "sqlite://<path to file>" */
+        void Connect(const std::string& connectionString) override;
+        void Disconnect() override;
+        bool IsConnected() override { return mDatabase != nullptr; }
+
+    protected:
+        void BeginTransaction() override;
+        void CommitTransaction() override;
+        void RollbackTransaction() override;
+        dbkey_t FindDirectoryId(dbkey_t parentId, const std::string& name) override;
+        bool FindTypeTable(dbkey_t directoryId, const std::string& name, TypeTableInfo& info) override;
+        dbkey_t FindVariationId(const std::string& name) override;
+        dbkey_t FindRunRangeId(int runMin, int runMax) override;
+        dbkey_t InsertRunRange(int runMin, int runMax) override;
+        dbkey_t InsertConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash) override;
+        bool HasVaultHashColumn() override;
+        void AddVaultHashColumn() override;
+        dbkey_t FindConstantSet(dbkey_t typeTableId, const std::string& vault, const std::string& vaultHash) override;
+        std::vector<std::pair<dbkey_t, std::string>> SelectConstantSetsWithoutHash(size_t limit) override;
+        void UpdateVaultHash(dbkey_t constantSetId, const std::string& vaultHash) override;
+        dbkey_t InsertAssignment(dbkey_t variationId, dbkey_t runRangeId, dbkey_t constantSetId,
+                                 dbkey_t authorId, const std::string& comment) override;
+
+    private:
+        void Exec(const char* sql);
+        SQLiteStatement& GetStatement(std::unique_ptr<SQLiteStatement>& statement, const char* query);
+
+        sqlite3* mDatabase;
+
+        // Statements are prepared on first use and are reused for all rows
+        std::unique_ptr<SQLiteStatement> mInsertRunRange;
+        std::unique_ptr<SQLiteStatement> mInsertConstantSet;
+        std::unique_ptr<SQLiteStatement> mInsertHashedConstantSet;
+        std::unique_ptr<SQLiteStatement> mFindConstantSet;
+        std::unique_ptr<SQLiteStatement> mInsertAssignment;
+    };
+}
+
+#endif //_SQLiteDataWriter_
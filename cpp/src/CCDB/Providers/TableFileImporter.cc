@@ -0,0 +1,148 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <map>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "CCDB/Providers/TableFileImporter.h"
+#include "CCDB/Helpers/TableFile.h"
+#include "CCDB/Helpers/StopWatch.h"
+
+using namespace std;
+
+namespace ccdb
+{
+
+//______________________________________________________________________________
+TableFileImporter::TableFileImporter(DataProvider& provider, DataWriter& writer, size_t threadsCount):
+    mProvider(provider),
+    mWriter(writer),
+    mThreadsCount(threadsCount)
+{
+    if(!mThreadsCount) mThreadsCount = std::thread::hardware_concurrency();
+    if(!mThreadsCount) mThreadsCount = 1;
+}
+
+
+//______________________________________________________________________________
+TableImportResult TableFileImporter::Import(const std::vector<TableImportJob>& jobs)
+{
+    StopWatch stopwatch;
+    TableImportResult result;
+
+    // Type tables are read here, parsing threads only read this map. Tables are owned by the provider
+    std::map<std::string, ConstantsTypeTable*> tables;
+    std::map<std::string, std::string> tableErrors;
+    for(const auto& job: jobs) {
+        if(tables.count(job.TablePath) || tableErrors.count(job.TablePath)) continue;
+        try {
+            ConstantsTypeTable* table = mProvider.GetConstantsTypeTable(job.TablePath, true);
+            if(table) tables[job.TablePath] = table;
+            else tableErrors[job.TablePath] = fmt::format("Type table '{}' is not found", job.TablePath);
+        }
+        catch (std::exception& ex) {
+            tableErrors[job.TablePath] = fmt::format("Type table '{}' is not found: {}", job.TablePath, ex.what());
+        }
+    }
+
+    struct ParsedFile {
+        bool IsReady = false;
+        std::vector<std::string> Values;
+        std::string Error;
+    };
+    std::vector<ParsedFile> parsed(jobs.size());
+
+    // Parsing threads take jobs in order and stay at most 'window' files ahead of the writer
+    const size_t window = mThreadsCount * 4;
+    std::mutex mutex;
+    std::condition_variable fileParsed;
+    std::condition_variable fileWritten;
+    size_t nextJob = 0;
+    size_t nextWrite = 0;
+    bool isStopping = false;
+
+    auto parseFiles = [&]() {
+        while(true) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                fileWritten.wait(lock, [&]() { return isStopping || nextJob >= jobs.size() || nextJob < nextWrite + window; });
+                if(isStopping || nextJob >= jobs.size()) return;
+                index = nextJob++;
+            }
+
+            const TableImportJob& job = jobs[index];
+            ParsedFile file;
+            auto tableIter = tables.find(job.TablePath);
+            if(tableIter == tables.end()) {
+                file.Error = fmt::format("{}: {}", job.FileName, tableErrors.at(job.TablePath));
+            }
+            else {
+                try {
+                    file.Values = TableFile::Read(job.FileName).Validate(*tableIter->second);
+                }
+                catch (std::exception& ex) {
+                    file.Error = fmt::format("{}: {}", job.FileName, ex.what());
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                parsed[index] = std::move(file);
+                parsed[index].IsReady = true;
+            }
+            fileParsed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < std::min(mThreadsCount, jobs.size()); i++) {
+        threads.emplace_back(parseFiles);
+    }
+
+    auto stopThreads = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isStopping = true;
+        }
+        fileWritten.notify_all();
+        for(auto& thread: threads) thread.join();
+    };
+
+    // The writer works only in this thread
+    try {
+        for(size_t i = 0; i < jobs.size(); i++) {
+            ParsedFile file;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                fileParsed.wait(lock, [&]() { return parsed[i].IsReady; });
+                file = std::move(parsed[i]);
+                nextWrite = i + 1;
+            }
+            fileWritten.notify_all();
+
+            if(!file.Error.empty()) {
+                result.Errors.push_back(file.Error);
+                continue;
+            }
+
+            const TableImportJob& job = jobs[i];
+            mWriter.CreateAssignment(job.TablePath, job.Variation, job.RunMin, job.RunMax, file.Values, job.Comment);
+            result.Imported++;
+        }
+    }
+    catch (...) {
+        stopThreads();
+        throw;
+    }
+
+    stopThreads();
+    mWriter.Commit();
+    result.ElapsedUs = stopwatch.ElapsedUs();
+    return result;
+}
+
+}
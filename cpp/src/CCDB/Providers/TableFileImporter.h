@@ -0,0 +1,68 @@
+#ifndef _TableFileImporter_
+#define _TableFileImporter_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "CCDB/Providers/DataProvider.h"
+#include "CCDB/Providers/DataWriter.h"
+
+namespace ccdb
+{
+    /** @brief One table file to import */
+    struct TableImportJob
+    {
+        std::string FileName;               /// Table file
+        std::string TablePath;              /// Type table full path
+        std::string Variation = "default";
+        int RunMin = 0;
+        int RunMax = INFINITE_RUN;
+        std::string Comment;
+    };
+
+
+    /** @brief Outcome of TableFileImporter::Import */
+    struct TableImportResult
+    {
+        size_t Imported = 0;                /// Number of files written as assignments
+        std::vector<std::string> Errors;    /// One message per file that was not imported
+        uint64_t ElapsedUs = 0;             /// Wall time of the whole import
+    };
+
+
+    /** @brief Imports many table files at once
+     *
+     * Files are read and validated against type table columns by a pool of threads.
+     * All writes are done by the thread that calls Import through the one DataWriter,
+     * so the writer (and SQLite connection) is never used from two threads.
+     * Assignments are written in the order of jobs, so a later job for the same table and run range wins
+     * as it would with one by one 'ccdb add' calls.
+     */
+    class TableFileImporter
+    {
+    public:
+        /**
+         * @param provider      - used to read type tables definitions. Is used only from the calling thread
+         * @param writer        - writes assignments. Its SetCommitEvery sets how often the import commits
+         * @param threadsCount  - number of parsing threads, 0 - number of hardware threads
+         */
+        TableFileImporter(DataProvider& provider, DataWriter& writer, size_t threadsCount = 0);
+
+        /** @brief Imports the files and commits. Files with errors are skipped and reported in the result
+         *
+         * Writer errors (database failures) stop the import and are thrown after parsing threads are stopped.
+         * Assignments written before that are committed or not according to the writer commit settings.
+         */
+        TableImportResult Import(const std::vector<TableImportJob>& jobs);
+
+        size_t GetThreadsCount() const { return mThreadsCount; }
+
+    private:
+        DataProvider& mProvider;
+        DataWriter& mWriter;
+        size_t mThreadsCount;
+    };
+}
+
+#endif //_TableFileImporter_
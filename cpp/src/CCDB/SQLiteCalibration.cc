@@ -4,6 +4,7 @@
 #include "CCDB/SQLiteCalibration.h"
 #include "CCDB/Providers/SQLiteDataProvider.h"
 #include "CCDB/Helpers/PathUtils.h"
+#include "CCDB/CalibrationOptions.h"
 
 namespace ccdb
 {
@@ -48,7 +49,9 @@ bool SQLiteCalibration::Connect( std::string connectionString )
 	 * @param connectionString the Connection String
 	 * @return true if connected
 	 */
-    std::lock_guard<std::mutex> lock(mReadMutex);
+    connectionString = ApplyConnectionOptions(connectionString);     // ?name=value options are not a part of the provider connection string
+
+    std::unique_lock<std::mutex> lock(mReadMutex);
 
     UpdateActivityTime();
 
@@ -88,8 +91,13 @@ bool SQLiteCalibration::Connect( std::string connectionString )
         throw std::logic_error(ERRMSG_CONNECT_LOCKED);
     }
 
+    // Open mode from options. A provider of other type could be given by UseProvider
+    SQLiteDataProvider* sqliteProvider = dynamic_cast<SQLiteDataProvider*>(mProvider);
+    if(sqliteProvider) sqliteProvider->SetOpenMode(mOptions->IsSQLiteImmutable ? SQLiteDataProvider::cImmutableMode : SQLiteDataProvider::cReadOnlyMode);
     mProvider->Connect(connectionString);
+    lock.unlock();
 
+    if(mIsPreloadEnabled) Preload();
     return true; // If we get here, it is 'true'. It is an old API issue to have 'bool' here at all
 }
 
@@ -0,0 +1,191 @@
+#pragma warning(disable:4800)
+#include "Tests/catch.hpp"
+#include "Tests/tests.h"
+
+#include "CCDB/Providers/SQLiteDataProvider.h"
+#include "CCDB/Providers/AssignmentHistory.h"
+#include "CCDB/Providers/EpochCalculator.h"
+#include "CCDB/Providers/AssignmentHistoryStream.h"
+
+using namespace std;
+using namespace ccdb;
+
+
+/********************************************************************* **
+ * @brief History gives the same assignments as the database queries
+ */
+TEST_CASE("CCDB/AssignmentHistory/AsOf","As-of requests in memory")
+{
+    SQLiteDataProvider provider;
+    provider.Connect(TESTS_SQLITE_STRING);
+    const string path = "/test/test_vars/test_table";
+
+    AssignmentHistory subtest(provider, path, "subtest");
+    REQUIRE(subtest.GetEntriesCount() == 4);      // subtest 1, test 1, default 2
+
+    // Own variation wins, then parents
+    REQUIRE(subtest.Find(100)->AssignmentId == 5);
+    REQUIRE(subtest.Find(100)->VariationLevel == 0);
+    REQUIRE(subtest.Find(100)->Vault->GetValues()[0] == "10");
+
+    AssignmentHistory test(provider, path, "test");
+    REQUIRE(test.Find(1000)->AssignmentId == 2);
+    REQUIRE(test.Find(100)->AssignmentId == 4);
+    REQUIRE(test.Find(100)->VariationLevel == 1);
+    REQUIRE(test.Find(100, 1343692122)->AssignmentId == 1);   // the time of the first assignment
+    REQUIRE(test.Find(100, 1343692121) == nullptr);             // before anything
+
+    // Compare with the provider for a grid of requests
+    vector<int> runs = {0, 100, 499, 500, 1000, 3000, 3001, INFINITE_RUN};
+    vector<time_t> times = {0, 1343692121, 1343692122, 1346370522, 1349048922, 1351640922, 1351640923, 2000000000};
+    for(const string variation: {"default", "test", "subtest", "mc"}) {
+        AssignmentHistory history(provider, path, variation);
+        for(int run: runs) {
+            for(time_t time: times) {
+                Assignment* assignment = provider.GetAssignmentShort(run, path, time, variation, false);
+                const AssignmentHistoryEntry* entry = history.Find(run, time);
+                INFO("variation " << variation << " run " << run << " time " << time);
+                if(!assignment) {
+                    REQUIRE(entry == nullptr);
+                    continue;
+                }
+                REQUIRE(entry != nullptr);
+                REQUIRE(entry->AssignmentId == assignment->GetId());
+                REQUIRE(entry->Vault->GetRawData() == assignment->GetRawData());
+                delete assignment;
+            }
+        }
+    }
+
+    // Without vaults and for a part of runs: the same answers, only ids are read
+    AssignmentHistory partial(provider, path, "test", false, 600, 1000);
+    REQUIRE(partial.GetEntriesCount() == 3);        // 500-3000 of test and 0-INFINITE_RUN of default
+    REQUIRE(partial.Find(1000)->AssignmentId == 2);
+    REQUIRE(partial.Find(1000)->Vault == nullptr);
+    REQUIRE(partial.Find(1000)->ConstantSetId == test.Find(1000)->ConstantSetId);
+    REQUIRE(provider.GetConstantSetVault(partial.Find(1000)->ConstantSetId)->GetRawData() == test.Find(1000)->Vault->GetRawData());
+    REQUIRE(partial.GetRunRanges().size() == 2);
+
+    // "test" has only 500-3000 run range
+    auto records = provider.GetAssignmentRecords(path, "test", 499, 500);
+    REQUIRE(records.size() == 1);
+    REQUIRE(records[0].AssignmentId == 2);
+    REQUIRE(records[0].RunMin == 500);
+    REQUIRE(records[0].RunMax == 3000);
+    REQUIRE(records[0].Variation == "test");
+    REQUIRE(provider.GetAssignmentRecords(path, "test", 0, 499).empty());
+    REQUIRE(provider.GetAssignmentRecords(path, "test", 3001, 4000).empty());
+    REQUIRE(provider.GetAssignmentRecords(path, "default", 3001, 4000).size() == 2);
+
+    REQUIRE_THROWS(AssignmentHistory(provider, path, "no_such_variation"));
+    REQUIRE_THROWS(AssignmentHistory(provider, "/test/test_vars/no_such_table", "default"));
+}
+
+
+/********************************************************************* **
+ * @brief Epochs have the same assignments as the database gives for their runs
+ */
+TEST_CASE("CCDB/EpochCalculator","Run intervals with the same assignments")
+{
+    SQLiteDataProvider provider;
+    provider.Connect(TESTS_SQLITE_STRING);
+    vector<string> paths = {"/test/test_vars/test_table", "/test/test_vars/test_table2"};
+
+    for(const string variation: {"default", "test", "subtest"}) {
+        for(time_t time: {time_t(0), time_t(1346370522)}) {
+            EpochCalculator calculator(provider, paths, variation, time);
+            auto epochs = calculator.GetEpochs(0, 5000);
+            REQUIRE_FALSE(epochs.empty());
+            REQUIRE(epochs.front().RunMin == 0);
+            REQUIRE(epochs.back().RunMax == 5000);
+
+            for(size_t i = 0; i < epochs.size(); i++) {
+                const CalibrationEpoch& epoch = epochs[i];
+                REQUIRE(epoch.RunMin <= epoch.RunMax);
+                REQUIRE(epoch.AssignmentIds.size() == paths.size());
+                if(i > 0) {
+                    REQUIRE(epochs[i - 1].RunMax + 1 == epoch.RunMin);
+                    REQUIRE(epochs[i - 1].AssignmentIds != epoch.AssignmentIds);
+                }
+
+                for(int run: {epoch.RunMin, (epoch.RunMin + epoch.RunMax) / 2, epoch.RunMax}) {
+                    for(size_t j = 0; j < paths.size(); j++) {
+                        Assignment* assignment = provider.GetAssignmentShort(run, paths[j], time, variation, false);
+                        INFO("variation " << variation << " time " << time << " run " << run << " table " << paths[j]);
+                        REQUIRE(epoch.AssignmentIds[j] == (assignment ? assignment->GetId() : 0));
+                        delete assignment;
+                    }
+                }
+            }
+        }
+    }
+
+    // One run, and the whole range in one epoch when the tables have one assignment for all runs
+    EpochCalculator calculator(provider, {"/test/test_vars/test_table"}, "default");
+    REQUIRE(calculator.GetEpochs(1000, 1000).size() == 1);
+    REQUIRE_THROWS(calculator.GetEpochs(10, 5));
+
+    EpochCalculator partial(provider, paths, "test", 0, 400, 600);
+    REQUIRE(partial.GetEpochs(400, 600).size() == 2);
+    REQUIRE_THROWS_AS(partial.GetEpochs(0, 600), std::logic_error);
+    REQUIRE_THROWS(EpochCalculator(provider, {"/test/test_vars/no_such_table"}, "default"));
+}
+
+
+/********************************************************************* **
+ * @brief Paged history gives the same records as one page, vaults are loaded on demand
+ */
+TEST_CASE("CCDB/AssignmentHistoryStream","Assignment history by pages")
+{
+	SQLiteDataProvider prov;
+	prov.Connect(TESTS_SQLITE_STRING);
+	const string path = "/test/test_vars/test_table";
+
+	//The whole history of all variations in one page
+	auto all = prov.GetAssignmentHistoryPage(path, "", -1, AssignmentHistoryCursor(), 1000);
+	REQUIRE(all.size() >= 3);
+	for(size_t i = 1; i < all.size(); i++) {
+		bool isOrdered = all[i-1].Created < all[i].Created ||
+		                 (all[i-1].Created == all[i].Created && all[i-1].AssignmentId < all[i].AssignmentId);
+		REQUIRE(isOrdered);
+	}
+
+	//Page by page, one record each
+	AssignmentHistoryStream stream(prov, path, "", -1, 1);
+	vector<dbkey_t> ids;
+	while(stream.Next()) ids.push_back(stream.Get().AssignmentId);
+	REQUIRE(ids.size() == all.size());
+	for(size_t i = 0; i < all.size(); i++) REQUIRE(ids[i] == all[i].AssignmentId);
+	REQUIRE(stream.GetPageCount() == all.size() + 1);
+	REQUIRE_FALSE(stream.Next());
+	REQUIRE_THROWS_AS(stream.Get(), std::logic_error);
+
+	//Resume from the middle
+	AssignmentHistoryStream resumed(prov, path, "", -1, 2);
+	resumed.Seek(all[0].GetCursor());
+	REQUIRE(resumed.Next());
+	REQUIRE(resumed.Get().AssignmentId == all[1].AssignmentId);
+
+	//Variation and run filters match VisitAssignments. Vaults are the same as assignments have
+	map<dbkey_t, string> visited;
+	prov.VisitAssignments(path, "default", 100, 0, [&visited](Assignment& assignment) {
+		visited[assignment.GetId()] = assignment.GetRawData();
+		return true;
+	});
+	AssignmentHistoryStream filtered(prov, path, "default", 100);
+	size_t count = 0;
+	while(filtered.Next()) {
+		REQUIRE(filtered.Get().Variation == "default");
+		REQUIRE(filtered.Get().RunMin <= 100);
+		REQUIRE(filtered.Get().RunMax >= 100);
+		REQUIRE(visited.count(filtered.Get().AssignmentId) == 1);
+		REQUIRE(filtered.LoadVault()->GetRawData() == visited[filtered.Get().AssignmentId]);
+		count++;
+	}
+	REQUIRE(count == visited.size());
+
+	REQUIRE(prov.GetConstantSetVault(0) == nullptr);
+	REQUIRE_THROWS(AssignmentHistoryStream(prov, path, "", -1, 0));
+	AssignmentHistoryStream missing(prov, "/test/test_vars/no_such_table");
+	REQUIRE_THROWS(missing.Next());
+}
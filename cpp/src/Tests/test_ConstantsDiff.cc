@@ -0,0 +1,179 @@
+#pragma warning(disable:4800)
+#include "Tests/catch.hpp"
+#include "Tests/tests.h"
+
+#include <memory>
+
+#include "CCDB/Providers/SQLiteDataProvider.h"
+#include "CCDB/Providers/ConstantsDiff.h"
+
+using namespace std;
+using namespace ccdb;
+
+
+/********************************************************************* **
+ * @brief Cell differences of two vaults with numeric and text columns
+ */
+TEST_CASE("CCDB/ConstantsDiff/Values","Differences of values")
+{
+	ConstantsTypeColumn value, count, name;
+	value.SetName("value");
+	value.SetType(ConstantsTypeColumn::cDoubleColumn);
+	count.SetName("count");
+	count.SetType(ConstantsTypeColumn::cIntColumn);
+	name.SetName("name");
+	name.SetType(ConstantsTypeColumn::cStringColumn);
+	TableDescriptor columns({&value, &count, &name});
+
+	VaultData base("1.0|10|a|2.0|20|b|nan|30|c");
+	VaultData same("1.0|10|a|2.0|20|b|nan|30|c");
+	VaultData sameNumbers("1|10|a|2.000|20|b|nan|30|c");
+	VaultData changed("1.001|10|a|2.0|21|x|5|30|c");
+
+	ConstantsDiff diff;
+	REQUIRE(diff.Compare(columns, base, same).Result == TableDiff::cIdentical);
+
+	//Different text of the same numbers
+	TableDiff result = diff.Compare(columns, base, sameNumbers);
+	REQUIRE(result.Result == TableDiff::cIdentical);
+	REQUIRE(result.ComparedCells == 9);
+	REQUIRE(result.ChangedCells == 0);
+
+	result = diff.Compare(columns, base, changed);
+	REQUIRE(result.Result == TableDiff::cDifferent);
+	REQUIRE(result.IsDifferent());
+	REQUIRE(result.ChangedCells == 4);
+	REQUIRE(result.DifferentCells == 4);
+	REQUIRE(result.MaxAbsolute == Approx(1.0));
+	REQUIRE(result.Details.size() == 4);
+	REQUIRE(result.Details[0].Row == 0);
+	REQUIRE(result.Details[0].Column == 0);
+	REQUIRE(result.Details[0].IsNumeric);
+	REQUIRE(result.Details[0].Absolute == Approx(0.001));
+	REQUIRE(result.Details[0].Relative == Approx(0.001 / 1.001));
+	REQUIRE(result.Details[1].Column == 1);
+	REQUIRE(result.Details[2].Column == 2);
+	REQUIRE_FALSE(result.Details[2].IsNumeric);
+	REQUIRE(result.Details[2].Right == "x");
+	REQUIRE(result.Details[3].Row == 2);
+	REQUIRE(result.Details[3].Right == "5");
+
+	//The tolerance hides small changes but they are counted
+	ConstantsDiffOptions options;
+	options.RelativeTolerance = 0.01;
+	options.MaxDetails = 1;
+	result = ConstantsDiff(options).Compare(columns, base, changed);
+	REQUIRE(result.ChangedCells == 4);
+	REQUIRE(result.DifferentCells == 3);
+	REQUIRE(result.Details.size() == 1);
+	REQUIRE(result.Details[0].Row == 1);
+
+	VaultData smallChange("1.001|10|a|2.0|20|b|nan|30|c");
+	REQUIRE(ConstantsDiff(options).Compare(columns, base, smallChange).Result == TableDiff::cWithinTolerance);
+
+	VaultData shorter("1.0|10|a");
+	REQUIRE(diff.Compare(columns, base, shorter).Result == TableDiff::cIncompatible);
+}
+
+
+/********************************************************************* **
+ * @brief 64 bit integers are compared exactly, not as doubles
+ */
+TEST_CASE("CCDB/ConstantsDiff/Integers","Differences of 64 bit integers")
+{
+	ConstantsTypeColumn id, mask;
+	id.SetName("id");
+	id.SetType(ConstantsTypeColumn::cLongColumn);
+	mask.SetName("mask");
+	mask.SetType(ConstantsTypeColumn::cULongColumn);
+	TableDescriptor columns({&id, &mask});
+
+	// 2^53 + 1 and 2^53 are the same double
+	VaultData base("9007199254740993|18446744073709551615|-9007199254740993|1");
+	VaultData changed("9007199254740992|18446744073709551614|-9007199254740993|1");
+
+	ConstantsDiff diff;
+	TableDiff result = diff.Compare(columns, base, changed);
+	REQUIRE(result.Result == TableDiff::cDifferent);
+	REQUIRE(result.ChangedCells == 2);
+	REQUIRE(result.MaxAbsolute == 1.0);
+	REQUIRE(result.Details.size() == 2);
+	REQUIRE(result.Details[0].Right == "9007199254740992");
+	REQUIRE(result.Details[1].Left == "18446744073709551615");
+
+	// The whole range of signed values
+	VaultData minimum("-9223372036854775808|0");
+	VaultData maximum("9223372036854775807|0");
+	result = diff.Compare(TableDescriptor({&id, &mask}), minimum, maximum);
+	REQUIRE(result.ChangedCells == 1);
+	REQUIRE(result.MaxAbsolute == Approx(18446744073709551615.0));
+
+	// Tolerance applies to integers as to doubles
+	ConstantsDiffOptions options;
+	options.AbsoluteTolerance = 1;
+	REQUIRE(ConstantsDiff(options).Compare(columns, base, changed).Result == TableDiff::cWithinTolerance);
+}
+
+
+/********************************************************************* **
+ * @brief Assignments and whole run snapshots from the database
+ */
+TEST_CASE("CCDB/ConstantsDiff/Snapshots","Differences of variations")
+{
+	SQLiteDataProvider prov;
+	prov.Connect(TESTS_SQLITE_STRING);
+	const string path = "/test/test_vars/test_table";
+
+	//Run 100 has the same assignment in "test" and "default", run 1000 has another one in "test"
+	unique_ptr<Assignment> defaultAssignment(prov.GetAssignmentShort(1000, path, 0, "default", true));
+	unique_ptr<Assignment> testAssignment(prov.GetAssignmentShort(1000, path, 0, "test", true));
+	REQUIRE(defaultAssignment);
+	REQUIRE(testAssignment);
+
+	ConstantsDiff diff;
+	TableDiff table = diff.Compare(*defaultAssignment, *defaultAssignment);
+	REQUIRE(table.Result == TableDiff::cIdentical);
+	REQUIRE(table.Path == path);
+	REQUIRE(table.Left == defaultAssignment->GetIdentity());
+
+	table = diff.Compare(*defaultAssignment, *testAssignment);
+	REQUIRE(table.Path == path);
+	REQUIRE(table.Right.AssignmentId == testAssignment->GetId());
+	REQUIRE(table.ComparedCells == defaultAssignment->GetVault()->GetValues().size());
+
+	CalibrationSnapshotKey left, right;
+	left.Run = 1000;
+	right.Run = 1000;
+	right.Variation = "test";
+
+	vector<TableDiff> tables;
+	SnapshotDiffSummary summary = diff.CompareSnapshots(prov, left, right, [&tables](const TableDiff& result) {
+		tables.push_back(result);
+	});
+	REQUIRE(summary.Tables == tables.size());
+	REQUIRE(summary.Tables == summary.IdenticalTables + summary.WithinToleranceTables + summary.DifferentTables);
+	for(size_t i = 1; i < tables.size(); i++) REQUIRE(tables[i-1].Path < tables[i].Path);
+
+	bool isTableFound = false;
+	bool isOnlyRightFound = false;
+	for(const auto& result: tables) {
+		if(result.Path == path) {
+			isTableFound = true;
+			REQUIRE(result.Left.AssignmentId == defaultAssignment->GetId());
+			REQUIRE(result.Right.AssignmentId == testAssignment->GetId());
+		}
+		//test_table2 has data only in "test" variation
+		if(result.Path == "/test/test_vars/test_table2") {
+			isOnlyRightFound = true;
+			REQUIRE(result.Result == TableDiff::cOnlyRight);
+		}
+	}
+	REQUIRE(isTableFound);
+	REQUIRE(isOnlyRightFound);
+
+	//The same snapshot has no differences
+	summary = diff.CompareSnapshots(prov, left, left, [](const TableDiff& result) {
+		REQUIRE(result.Result == TableDiff::cIdentical);
+	});
+	REQUIRE(summary.DifferentTables == 0);
+}
@@ -0,0 +1,125 @@
+#pragma warning(disable:4800)
+#ifdef CCDB_MYSQL
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "Tests/catch.hpp"
+#include "Tests/tests.h"
+
+#include "CCDB/Providers/MySQLDataProvider.h"
+#include "CCDB/Providers/MySQLConnectionPool.h"
+#include "CCDB/Model/Variation.h"
+
+using namespace std;
+using namespace ccdb;
+
+/********************************************************************* **
+ * @brief Backoff delays grow, are capped and respect jitter bounds
+ */
+TEST_CASE("CCDB/MySQLConnectionPool/Backoff","Reconnection backoff delays")
+{
+    MySQLConnectionPoolOptions options;
+    options.BackoffInitialMs = 100;
+    options.BackoffMaxMs = 1000;
+
+    // No jitter gives half of the exponential value, full jitter gives the whole value
+    REQUIRE(MySQLConnectionPool::GetBackoffDelay(0, options, 0.0).count() == 50);
+    REQUIRE(MySQLConnectionPool::GetBackoffDelay(0, options, 1.0).count() == 100);
+    REQUIRE(MySQLConnectionPool::GetBackoffDelay(2, options, 1.0).count() == 400);
+
+    // The delay is capped by BackoffMaxMs
+    REQUIRE(MySQLConnectionPool::GetBackoffDelay(10, options, 1.0).count() == 1000);
+    REQUIRE(MySQLConnectionPool::GetBackoffDelay(100, options, 0.0).count() == 500);
+
+    // Jitter out of [0, 1] is clamped
+    REQUIRE(MySQLConnectionPool::GetBackoffDelay(1, options, 5.0).count() == 200);
+    REQUIRE(MySQLConnectionPool::GetBackoffDelay(1, options, -1.0).count() == 100);
+}
+
+
+/********************************************************************* **
+ * @brief Each thread gets own connection, nested acquires reuse it
+ */
+TEST_CASE("CCDB/MySQLConnectionPool/Leases","Pool leases [mysql]")
+{
+    MySQLConnectionInfo info;
+    REQUIRE(MySQLDataProvider::ParseConnectionString(TESTS_CONENCTION_STRING, info));
+
+    MySQLConnectionPoolOptions options;
+    options.MinSize = 1;
+    options.MaxSize = 2;
+    MySQLConnectionPool pool(info, options);
+    REQUIRE(pool.GetStats().OpenedNow == 1);
+
+    {
+        auto lease = pool.Acquire();
+        auto nested = pool.Acquire();
+        REQUIRE(&*lease == &*nested);
+        REQUIRE(lease->IsOpened());
+
+        // Another thread gets another connection
+        MySQLConnection* otherConnection = nullptr;
+        std::thread other([&pool, &otherConnection](){
+            auto otherLease = pool.Acquire();
+            otherConnection = &*otherLease;
+        });
+        other.join();
+        REQUIRE(otherConnection != nullptr);
+        REQUIRE(otherConnection != &*lease);
+    }
+
+    auto stats = pool.GetStats();
+    REQUIRE(stats.OpenedNow == 2);
+    REQUIRE(stats.IdleNow == 2);
+    REQUIRE(stats.Acquires == 2);
+
+    // A broken connection is dropped when the lease ends and is reopened by the next Acquire
+    {
+        auto lease = pool.Acquire();
+        lease->MarkBroken();
+    }
+    stats = pool.GetStats();
+    REQUIRE(stats.DroppedConnections == 1);
+    REQUIRE(stats.OpenedNow == 1);
+    REQUIRE(stats.Reconnects == 0);
+
+    std::thread first([&pool](){
+        auto firstLease = pool.Acquire();
+        std::thread second([&pool](){ auto secondLease = pool.Acquire(); });
+        second.join();
+    });
+    first.join();
+    stats = pool.GetStats();
+    REQUIRE(stats.OpenedNow == 2);
+    REQUIRE(stats.Reconnects == 1);
+}
+
+
+/********************************************************************* **
+ * @brief Provider requests from many threads with a small pool
+ */
+TEST_CASE("CCDB/MySQLConnectionPool/ProviderThreads","Provider with connection pool [mysql]")
+{
+    MySQLDataProvider prov;
+    MySQLConnectionPoolOptions options;
+    options.MaxSize = 2;
+    prov.SetPoolOptions(options);
+    REQUIRE_NOTHROW(prov.Connect(TESTS_CONENCTION_STRING));
+    REQUIRE_THROWS(prov.SetPoolOptions(options));
+
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 6; i++) {
+        threads.emplace_back([&prov, &failures](){
+            for(int j = 0; j < 20; j++) {
+                if(prov.GetVariation("default") == nullptr) failures++;
+            }
+        });
+    }
+    for(auto& thread: threads) thread.join();
+
+    REQUIRE(failures == 0);
+    REQUIRE(prov.GetPoolStats().OpenedNow <= 2);
+}
+#endif //ifdef CCDB_MYSQL
@@ -3,7 +3,6 @@
 #include "Tests/tests.h"
 #include "Tests/catch.hpp"
 
-#include "CCDB/Console.h"
 #include "CCDB/Helpers/StringUtils.h"
 #include "CCDB/Providers/MySQLDataProvider.h"
 #include "CCDB/Model/Variation.h"
@@ -17,27 +16,24 @@ using namespace ccdb;
  *
  * @return true if test passed
  */
-TEST_CASE("CCDB/MySQLDataProvider/Assignments","Assignments tests")
+TEST_CASE("CCDB/MySQLDataProvider/Assignments","Assignments tests [mysql]")
 {
-	bool result;
-	
 	DataProvider *prov = new MySQLDataProvider();
-	if(!prov->Connect(TESTS_CONENCTION_STRING)) return;
+	prov->Connect(TESTS_CONENCTION_STRING);
 
 	//GET ASSIGNMENTS TESTS
 	//----------------------------------------------------
 	//lets start with simple cases. 
-	//Get FULL assignment by table and name
+	//Get assignment by table and name
 	
-	Assignment * assignment = prov->GetAssignmentFull(100,"/test/test_vars/test_table");
+	Assignment * assignment = prov->GetAssignmentShort(100,"/test/test_vars/test_table", 0, "default", true);
 	
 	REQUIRE(assignment!=NULL);
 
 	//Check that everything is loaded
 	REQUIRE(assignment->GetVariation() != NULL);
-	REQUIRE(assignment->GetRunRange()  != NULL);
 	REQUIRE(assignment->GetTypeTable() != NULL);	
-	REQUIRE(assignment->GetTypeTable()->GetColumns().size()>0);
+	REQUIRE(!assignment->GetTypeTable()->GetColumns().empty());
 	vector<vector<string> > tabeled_values = assignment->GetData();
 	REQUIRE(tabeled_values.size()==2);	
 	REQUIRE(tabeled_values[0].size()==3);	
@@ -47,30 +43,132 @@ TEST_CASE("CCDB/MySQLDataProvider/Assignments","Assignments tests")
 	REQUIRE(tabeled_values[1][0] == "2.5");
 	REQUIRE(tabeled_values[1][1] == "2.6");
 	REQUIRE(tabeled_values[1][2] == "2.7");
-	
-	//Ok! Lets get all assignments for current table types
-	vector<Assignment *> assignments;
-	result = prov->GetAssignments(assignments, "/test/test_vars/test_table", 100);
-	
-	REQUIRE(result);	
-	REQUIRE(assignments.size()>0);
-	
-	//save number of asignments
-	int selectedAssignments = assignments.size();
-	dbkey_t lastId = assignment->GetId();
-	dbkey_t lastDataVaultId = assignment->GetDataVaultId();
+	delete assignment;
 
-    //Variations work test
-    delete assignment;
+	//The same prepared statement with the time parameter
+	assignment = prov->GetAssignmentShort(100,"/test/test_vars/test_table", 2147483647, "default", false);
+	REQUIRE(assignment!=NULL);
+	delete assignment;
 
     //variation hierarchy is
     // default -> test -> subtest
-    // There are /test/test_vars/test_table for variation subtest. 
     // But  /test/test_vars/test_table2 has only default variation
+    assignment = prov->GetAssignmentShort(100,"/test/test_vars/test_table2", 0, "subtest", false);
+    REQUIRE(assignment!=NULL);
+    REQUIRE(assignment->GetVariation()->GetName() == "default");
+    delete assignment;
+
+    delete prov;
+}
+
+
+/********************************************************************* **
+ * @brief Streamed listing of assignments
+ */
+TEST_CASE("CCDB/MySQLDataProvider/VisitAssignments","Assignments listing [mysql]")
+{
+	MySQLDataProvider prov;
+	prov.Connect(TESTS_CONENCTION_STRING);
+
+	vector<int> ids;
+	auto visited = prov.VisitAssignments("/test/test_vars/test_table", "default", -1, 0, [&ids](Assignment& assignment) {
+		REQUIRE(assignment.GetRunRange() != NULL);
+		REQUIRE(assignment.GetData().size() == 2);
+		REQUIRE(assignment.GetDataVaultId() > 0);
+		ids.push_back(assignment.GetId());
+		return true;
+	});
+	REQUIRE(visited == ids.size());
+	REQUIRE(visited >= 1);
 
-    assignment = prov->GetAssignmentShort(100,"/test/test_vars/test_table2", "subtest");
+	//The same assignments without vaults
+	auto records = prov.GetAssignmentRecords("/test/test_vars/test_table", "default", 0, INFINITE_RUN);
+	REQUIRE(records.size() == ids.size());
+	REQUIRE(prov.GetConstantSetVault(records[0].ConstantSetId) != nullptr);
+	REQUIRE(prov.GetAssignmentRecords("/test/test_vars/test_table", "test", 0, 499).empty());
+
+	//Stop after the first row. Unread rows are dropped and the connection stays usable
+	visited = prov.VisitAssignments("/test/test_vars/test_table", "default", 100, 0, [](Assignment&) { return false; });
+	REQUIRE(visited == 1);
+	REQUIRE(prov.GetAssignmentShort(100, "/test/test_vars/test_table", 0, "default", false) != NULL);
+
+	//No connection is held while the callback runs, so it may use the provider
+	size_t nestedCount = 0;
+	REQUIRE_NOTHROW(prov.VisitAssignments("/test/test_vars/test_table", "default", -1, 0, [&prov, &nestedCount](Assignment&) {
+		std::unique_ptr<Assignment> nested(prov.GetAssignmentShort(100, "/test/test_vars/test_table", 0, "default", false));
+		if(nested && prov.GetVariation("test")) nestedCount++;
+		return true;
+	}));
+	REQUIRE(nestedCount == ids.size());
+}
+
+/********************************************************************* **
+ * @brief Latest assignments of all tables in one query
+ */
+TEST_CASE("CCDB/MySQLDataProvider/GetLatestAssignments","Latest assignments of all tables [mysql]")
+{
+	MySQLDataProvider prov;
+	prov.Connect(TESTS_CONENCTION_STRING);
+
+	//The result is the same as GetAssignmentShort for each table
+	auto assignments = prov.GetLatestAssignments(100, 0, "subtest", true);
+	REQUIRE(!assignments.empty());
+	for(auto assignment: assignments) {
+		REQUIRE(assignment->GetTypeTable() != NULL);
+		REQUIRE(!assignment->GetTypeTable()->GetColumns().empty());
+
+		Assignment* single = prov.GetAssignmentShort(100, assignment->GetTypeTable()->GetFullPath(), 0, "subtest", false);
+		REQUIRE(single != NULL);
+		REQUIRE(single->GetId() == assignment->GetId());
+		REQUIRE(single->GetDataVaultId() == assignment->GetDataVaultId());
+		REQUIRE(single->GetVariation()->GetName() == assignment->GetVariation()->GetName());
+		REQUIRE(single->GetVariation()->GetId() == assignment->GetVariationId());
+		REQUIRE(single->GetRunRangeId() == assignment->GetRunRangeId());
+		REQUIRE(single->GetRunRange() == assignment->GetRunRange());      // one cached object for each run range
+		delete single;
+		delete assignment;
+	}
+
+	//Tables come from the provider cache, the same objects on the next call
+	auto again = prov.GetLatestAssignments(100, 0, "subtest", false);
+	REQUIRE(again.size() == assignments.size());
+	for(size_t i = 0; i < again.size(); i++) {
+		REQUIRE(again[i]->GetTypeTable() == prov.DataProvider::GetConstantsTypeTable(again[i]->GetTypeTable()->GetFullPath(), false));
+		delete again[i];
+	}
+}
+
+/********************************************************************* **
+ * @brief Many asynchronous requests at once
+ */
+TEST_CASE("CCDB/MySQLDataProvider/GetAssignmentShortAsync","Asynchronous assignments [mysql]")
+{
+	MySQLDataProvider prov;
+	prov.Connect(TESTS_CONENCTION_STRING);
 
+	vector<std::future<Assignment*>> requests;
+	for(int i = 0; i < 20; i++) {
+		requests.push_back(prov.GetAssignmentShortAsync(100, "/test/test_vars/test_table", 0, i%2 ? "subtest" : "default", false));
+	}
 
+	//the same as synchronous requests, including the variation fallback
+	for(int i = 0; i < 20; i++) {
+		Assignment* asyncAssignment = requests[i].get();
+		Assignment* syncAssignment = prov.GetAssignmentShort(100, "/test/test_vars/test_table", 0, i%2 ? "subtest" : "default", false);
+		REQUIRE(asyncAssignment != NULL);
+		REQUIRE(syncAssignment != NULL);
+		REQUIRE(asyncAssignment->GetId() == syncAssignment->GetId());
+		REQUIRE(asyncAssignment->GetDataVaultId() == syncAssignment->GetDataVaultId());
+		REQUIRE(asyncAssignment->GetVariation() == syncAssignment->GetVariation());
+		REQUIRE(asyncAssignment->GetVariationId() == asyncAssignment->GetVariation()->GetId());
+		REQUIRE(asyncAssignment->GetRunRangeId() == syncAssignment->GetRunRangeId());
+		REQUIRE(asyncAssignment->GetRunRange() == syncAssignment->GetRunRange());
+		REQUIRE(asyncAssignment->GetRawData() == syncAssignment->GetRawData());
+		delete asyncAssignment;
+		delete syncAssignment;
+	}
 
+	//Nothing for a run that doesn't exist in run ranges
+	REQUIRE(prov.GetAssignmentShortAsync(-5, "/test/test_vars/test_table", 0, "default", false).get() == NULL);
 }
 #endif //ifdef CCDB_MYSQL
@@ -3,21 +3,18 @@
 #include "Tests/catch.hpp"
 #include "Tests/tests.h"
 
-#include "CCDB/Console.h"
 #include "CCDB/Providers/MySQLDataProvider.h"
 #include "CCDB/Model/Directory.h"
 
 using namespace std;
 using namespace ccdb;
 
-bool test_DMySQLDataProviderConnection();  //Test basic connection
-
 /********************************************************************* ** 
  * @brief Test basic connection
  *
  * @return true if test passed
  */
-TEST_CASE("CCDB/MySQLDataProvider/Connection","Connection tests")
+TEST_CASE("CCDB/MySQLDataProvider/Connection","Connection tests [mysql]")
 {
 	MySQLDataProvider *prov = new MySQLDataProvider();
 
@@ -25,7 +22,7 @@ TEST_CASE("CCDB/MySQLDataProvider/Connection","Connection tests")
 	REQUIRE_FALSE(prov->IsConnected());
     
     //Connection
-	REQUIRE(prov->Connect(TESTS_CONENCTION_STRING));
+	REQUIRE_NOTHROW(prov->Connect(TESTS_CONENCTION_STRING));
 	REQUIRE(prov->IsConnected());
     REQUIRE(prov->GetConnectionString() == TESTS_CONENCTION_STRING);
 
@@ -34,7 +31,10 @@ TEST_CASE("CCDB/MySQLDataProvider/Connection","Connection tests")
 	REQUIRE_FALSE(prov->IsConnected());
 
 	//reconnect
-	REQUIRE(prov->Connect(TESTS_CONENCTION_STRING));
+	REQUIRE_NOTHROW(prov->Connect(TESTS_CONENCTION_STRING));
+
+	//prepared statements are reopened after reconnection
+	REQUIRE(prov->GetVariation("default") != NULL);
 
 	//cleanup
 	prov->Disconnect();
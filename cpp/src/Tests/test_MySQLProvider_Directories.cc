@@ -5,7 +5,6 @@
 
 #include "CCDB/Providers/MySQLDataProvider.h"
 #include "CCDB/Model/Directory.h"
-#include "CCDB/Log.h"
 
 #include <iostream>
 
@@ -17,25 +16,19 @@ using namespace ccdb;
  *
  * @return true if test passed
  */
-TEST_CASE("CCDB/MySQLDataProvider/Directories","Directories tests")
+TEST_CASE("CCDB/MySQLDataProvider/Directories","Directories tests [mysql]")
 {	
 	MySQLDataProvider *prov = new MySQLDataProvider();
-	if(!prov->Connect(TESTS_CONENCTION_STRING)) return;
+	prov->Connect(TESTS_CONENCTION_STRING);
 	
 	//get directory by path
 	Directory *dir=prov->GetDirectory("/test/subtest");
 	REQUIRE(dir!=NULL);
-	
-
-	//Search directories by pattern	
-	vector<Directory *> dirs = prov->SearchDirectories(static_cast<string>("t??t_va*"), "/test");
-	REQUIRE(dirs.size()>0);
+	REQUIRE(dir->GetName() == "subtest");
+	REQUIRE(dir->GetFullPath() == "/test/subtest");
+	REQUIRE(dir->GetParentDirectory() != NULL);
+	REQUIRE(dir->GetParentDirectory()->GetName() == "test");
 
-	dirs = prov->SearchDirectories("t??t_va*");
-	REQUIRE(dirs.size()>0);
-		
-	//Search directories by pattern
-	dirs = prov->SearchDirectories(static_cast<string>("*"), "/");
-	REQUIRE(dirs.size()>0);
+	delete prov;
 }
 #endif //ifdef CCDB_MYSQL
@@ -16,20 +16,18 @@ using namespace ccdb;
  *
  * @return true if test passed
  */
-TEST_CASE("CCDB/MySQLDataProvider/TypeTables","TypeTables tests")
+TEST_CASE("CCDB/MySQLDataProvider/TypeTables","TypeTables tests [mysql]")
 {
 	
 	MySQLDataProvider *prov = new MySQLDataProvider();
-	if(!prov->Connect(TESTS_CONENCTION_STRING)) return;
+	prov->Connect(TESTS_CONENCTION_STRING);
 
-    bool result;
-	
     //TYPE TABLE BASICS
     //======================================================
     //basic get type table functional
 
     //get type table from DB
-	ConstantsTypeTable *table = prov->GetConstantsTypeTable("/test/test_vars/test_table", true);
+	ConstantsTypeTable *table = ((DataProvider*)prov)->GetConstantsTypeTable("/test/test_vars/test_table", true);
     REQUIRE(table!=NULL);
 	REQUIRE(table->GetColumns().size() == 3);
 	REQUIRE(table->GetColumnsCount() == 3);
@@ -39,38 +37,18 @@ TEST_CASE("CCDB/MySQLDataProvider/TypeTables","TypeTables tests")
 	REQUIRE(table->GetDirectory()->GetName() == "test_vars");
 	REQUIRE(table->GetColumns()[0]->GetName() == string("x"));
 
-	//print type table
-	delete table; //cleanup
-	
-	//get all tables from the directory.
-    vector<ConstantsTypeTable *> tables;
-    result = prov->GetConstantsTypeTables(tables, "/test/test_vars", false); //we dont need to load colums for each table, so we place last argument "false"
-	
-    //test we've got
-	REQUIRE(result);
-	REQUIRE(tables.size()>0);
-
-	//second implementation of getting type tables from the directory	
-	tables = prov->GetConstantsTypeTables("/test/test_vars", false);
-
-	REQUIRE(tables.size());
-
-
-    //SEARCH TYPE TABLES
-    //======================================================
-    //basic get type table functional
-
-	
-    //search tables are good too
-    //now lets get all tables from the directory.
-	result = prov->SearchConstantsTypeTables(tables, "t??t_tab*");
+	//Same request goes through the same prepared statement
+	table = ((DataProvider*)prov)->GetConstantsTypeTable("/test/test_vars/test_table2", false);
+	REQUIRE(table!=NULL);
+	REQUIRE(table->GetName() == "test_table2");
 
-	REQUIRE(result);
-	REQUIRE(tables.size()>0);
+	//Not existing table
+	table = ((DataProvider*)prov)->GetConstantsTypeTable("/test/test_vars/this_table_doesnt_exist", false);
+	REQUIRE(table==NULL);
 
-    //Search table in the specified path
-    tables = prov->SearchConstantsTypeTables("*", "/test/test_vars",true);
-    REQUIRE(tables.size()>0);
+	//get all tables
+	vector<ConstantsTypeTable *> tables = prov->GetAllConstantsTypeTables(true);
+	REQUIRE(tables.size()>=2);
 
 	delete prov;//with all objects...
 }
@@ -14,16 +14,15 @@ using namespace ccdb;
  *
  * @return true if test passed
  */
-TEST_CASE("CCDB/MySQLDataProvider/Variations","Variations/tests")
+TEST_CASE("CCDB/MySQLDataProvider/Variations","Variations/tests [mysql]")
 {	
 	DataProvider *prov = new MySQLDataProvider();
-	if(!prov->Connect(TESTS_CONENCTION_STRING)) return;
+	prov->Connect(TESTS_CONENCTION_STRING);
 
 	//lets try to get default variation
 	Variation *variation = prov->GetVariation("subtest");
 	REQUIRE(variation!=NULL);
     REQUIRE(variation->GetName()=="subtest");
-    REQUIRE(variation->GetComment().length()>0);
     REQUIRE(variation->GetParentDbId()==3);
     REQUIRE(variation->GetParent()!=NULL);
     
@@ -42,12 +41,8 @@ TEST_CASE("CCDB/MySQLDataProvider/Variations","Variations/tests")
     //lets try to get default variation
     variation = prov->GetVariation("default");
     REQUIRE(variation!=NULL);
-	
-	//lets get all variations for table 
-	vector<Variation *> variations;
-	bool result = prov->GetVariations(variations, "/test/test_vars/test_table");
-	
-	REQUIRE(result);
-	REQUIRE(variations.size()>0);
+
+    //not existing variation
+    REQUIRE(prov->GetVariation("this_variation_doesnt_exist")==NULL);
 }
 #endif //ifdef CCDB_MYSQL
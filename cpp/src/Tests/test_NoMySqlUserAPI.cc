@@ -3,11 +3,20 @@
 #include "tests.h"
 #include <stdlib.h>
 #include <memory>
+#include <sstream>
+#include <thread>
 
 #include "CCDB/SQLiteCalibration.h"
 #include "CCDB/Providers/SQLiteDataProvider.h"
 #include "CCDB/Helpers/PathUtils.h"
 #include "CCDB/CalibrationGenerator.h"
+#include "CCDB/CalibrationOptions.h"
+#include "CCDB/Helpers/VaultHash.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 
 using namespace std;
@@ -195,3 +204,394 @@ TEST_CASE("CCDB/UserAPI/SQLite_CalibrationGenerator","Use universal generator to
         }
 	}
 }
+
+
+/** *********************************************************************
+ * @brief Asynchronous requests through the user API
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/Async","Asynchronous requests")
+{
+    SQLiteCalibration calib(100);
+    REQUIRE(calib.Connect(TESTS_SQLITE_STRING));
+    calib.EnableCache(true);
+
+    //start both, then wait
+    auto first = calib.GetAssignmentAsync("/test/test_vars/test_table");
+    auto second = calib.GetAssignmentAsync("/test/test_vars/test_table:100:subtest");
+    Assignment* assignment = first.get();
+    REQUIRE(assignment != NULL);
+    REQUIRE(assignment->GetData().size() == 2);
+    REQUIRE(second.get() != NULL);
+
+    //cached value is the same object
+    REQUIRE(calib.GetAssignmentAsync("/test/test_vars/test_table").get() == assignment);
+    REQUIRE(calib.GetAssignment("/test/test_vars/test_table") == assignment);
+
+    //errors come out of get()
+    auto missing = calib.GetAssignmentAsync("/test/test_vars/no_such_table");
+    REQUIRE_THROWS(missing.get());
+
+    //a dropped future still gives its result to the cache
+    calib.GetAssignmentAsync("/test/test_vars/test_table2:100:test");
+    Assignment* dropped = calib.GetAssignment("/test/test_vars/test_table2:100:test");
+    REQUIRE(dropped != NULL);
+    REQUIRE(calib.GetAssignmentAsync("/test/test_vars/test_table2:100:test").get() == dropped);
+
+    //a future could be got after the Calibration is destroyed
+    std::future<Assignment*> late;
+    {
+        SQLiteCalibration other(100);
+        REQUIRE(other.Connect(TESTS_SQLITE_STRING));
+        other.EnableCache(true);
+        late = other.GetAssignmentAsync("/test/test_vars/test_table");
+    }
+    REQUIRE(late.get() != NULL);
+}
+
+
+/** *********************************************************************
+ * @brief Repeated request strings are parsed once per thread. Defaults are taken from each Calibration
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/RepeatedRequests","Parsed requests are remembered")
+{
+    SQLiteCalibration calib(100);
+    REQUIRE(calib.Connect(TESTS_SQLITE_STRING));
+    calib.EnableCache(true);
+
+    Assignment* assignment = calib.GetAssignment("/test/test_vars/test_table");
+    REQUIRE(calib.GetAssignment("/test/test_vars/test_table") == assignment);
+    REQUIRE(calib.GetAssignment("test/test_vars/test_table") == assignment);     // made absolute
+    REQUIRE(calib.GetAssignment("/test/test_vars/test_table:100:default") == assignment);
+    REQUIRE(calib.GetAssignment("/test/test_vars/test_table::test") != assignment);
+
+    // The same string in another Calibration gets its default variation
+    SQLiteCalibration testCalib(100, "test");
+    REQUIRE(testCalib.Connect(TESTS_SQLITE_STRING));
+    vector<vector<int>> values;
+    REQUIRE(testCalib.GetCalib(values, "/test/test_vars/test_table2"));
+    REQUIRE_FALSE(calib.GetCalib(values, "/test/test_vars/test_table2"));
+
+    // and the same in another thread
+    Assignment* otherThreadAssignment = nullptr;
+    std::thread worker([&]() { otherThreadAssignment = calib.GetAssignment("/test/test_vars/test_table"); });
+    worker.join();
+    REQUIRE(otherThreadAssignment == assignment);
+}
+
+
+/** *********************************************************************
+ * @brief Assignment identity and changes of constants between runs
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/ChangedBetween","Changes between runs without constants")
+{
+    SQLiteCalibration calib(100, "test");
+    REQUIRE(calib.Connect(TESTS_SQLITE_STRING));
+    const string path = "/test/test_vars/test_table";
+    const string path2 = "/test/test_vars/test_table2";
+
+    // Nothing is cached, the provider is asked for ids
+    REQUIRE_FALSE(calib.ChangedBetween(path, 100, 200));
+    REQUIRE(calib.ChangedBetween(path, 100, 1000));
+    REQUIRE_FALSE(calib.ChangedBetween(path, 100, 3001));
+    REQUIRE_FALSE(calib.ChangedBetween(path + ":5", 100, 200));      // the run of the request is not used
+    REQUIRE_FALSE(calib.ChangedBetween(path2, 100, 1000));
+    REQUIRE_FALSE(calib.ChangedBetween(path2 + "::default", 100, 1000));    // no assignments at all
+
+    calib.EnableCache(true);
+    AssignmentIdentity identity = calib.GetAssignmentIdentity(path);
+    Assignment* assignment = calib.GetAssignment(path);
+    REQUIRE(identity.AssignmentId == assignment->GetId());
+    REQUIRE(identity.ConstantSetId != 0);
+    REQUIRE(identity.VaultHash == HashVault(assignment->GetRawData()));
+    REQUIRE(identity == calib.GetAssignmentIdentity(path + ":200"));
+    REQUIRE(identity != calib.GetAssignmentIdentity(path + ":1000"));
+    REQUIRE(calib.GetAssignmentIdentity(path2 + "::default").AssignmentId == 0);
+
+    // Both are cached now and are compared by hashes
+    REQUIRE(calib.ChangedBetween(path, 100, 1000));
+    REQUIRE_FALSE(calib.ChangedBetween(path, 100, 200));
+
+    // The same constant set is the same data
+    AssignmentIdentity other = identity;
+    other.AssignmentId++;
+    other.VaultHash = 0;
+    REQUIRE(identity.HasSameData(other));
+    other.ConstantSetId = 0;
+    REQUIRE_FALSE(identity.HasSameData(other));
+}
+
+
+/** *********************************************************************
+ * @brief Constants over a run range at once are the same as GetCalib gives for each run
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/OverRuns","Constants of many runs in one call")
+{
+    SQLiteCalibration calib(100, "test");
+    REQUIRE(calib.Connect(TESTS_SQLITE_STRING));
+    calib.EnableCache(true);
+    const string path = "/test/test_vars/test_table";
+    Assignment* cached = calib.GetAssignment(path);
+
+    auto spans = calib.GetCalibOverRuns(path, 0, 5000);
+    REQUIRE(spans.size() == 3);
+    REQUIRE(spans[0].RunMin == 0);
+    REQUIRE(spans[0].RunMax == 499);
+    REQUIRE(spans[1].RunMin == 500);
+    REQUIRE(spans[1].RunMax == 3000);
+    REQUIRE(spans[2].RunMin == 3001);
+    REQUIRE(spans[2].RunMax == 5000);
+
+    // The same assignment wins before and after run range 500-3000. Its vault is the cached one
+    REQUIRE(spans[0].Identity == spans[2].Identity);
+    REQUIRE(spans[0].Vault == spans[2].Vault);
+    REQUIRE(spans[0].Vault == cached->GetVault());
+    REQUIRE(spans[0].Identity == calib.GetAssignmentIdentity(path));
+
+    for(const auto& span: spans) {
+        for(int run: {span.RunMin, span.RunMax}) {
+            Assignment* assignment = calib.GetAssignment(path + ":" + std::to_string(run));
+            REQUIRE(assignment->GetId() == span.Identity.AssignmentId);
+            REQUIRE(assignment->GetVault()->GetValues() == span.Vault->GetValues());
+        }
+    }
+
+    // The run of the request is not used. Runs without constants are not covered
+    REQUIRE(calib.GetCalibOverRuns(path + ":1000", 10, 20).size() == 1);
+    REQUIRE(calib.GetCalibOverRuns("/test/test_vars/test_table2::default", 0, 5000).empty());
+    REQUIRE_THROWS_AS(calib.GetCalibOverRuns(path, 20, 10), std::logic_error);
+
+    // Other threads read and fill the cache while runs are scanned
+    size_t spansCount = 0;
+    std::thread scanner([&calib, &path, &spansCount]() {
+        for(int i = 0; i < 20; i++) spansCount += calib.GetCalibOverRuns(path, 0, 5000).size();
+    });
+    bool isSame = true;
+    for(int run = 0; run < 5000; run += 25) {
+        const CalibrationRunSpan& span = spans[run < 500 ? 0 : (run <= 3000 ? 1 : 2)];
+        isSame = isSame && calib.GetAssignment(path) == cached;
+        isSame = isSame && calib.GetAssignment(path + ":" + std::to_string(run))->GetVault() == span.Vault;
+    }
+    scanner.join();
+    REQUIRE(isSame);
+    REQUIRE(spansCount == 20 * spans.size());
+}
+
+
+/** *********************************************************************
+ * @brief Typed GetCalib fill containers from the vault values. Value returning versions give the same
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/TypedValues","Typed and value returning GetCalib")
+{
+    SQLiteCalibration calib(100);
+    REQUIRE(calib.Connect(TESTS_SQLITE_STRING));
+
+    vector<vector<string> > rawTable;
+    REQUIRE(calib.GetCalib(rawTable, "/test/test_vars/test_table"));
+    vector<vector<double> > table;
+    REQUIRE(calib.GetCalib(table, "/test/test_vars/test_table"));
+    REQUIRE(table.size() == rawTable.size());
+    for(size_t row = 0; row < table.size(); row++) {
+        REQUIRE(table[row].size() == 3);
+        for(size_t column = 0; column < 3; column++) {
+            REQUIRE(table[row][column] == StringUtils::ParseDouble(rawTable[row][column]));
+        }
+    }
+    REQUIRE(calib.GetCalibTable<double>("/test/test_vars/test_table") == table);
+    REQUIRE(calib.GetCalibTable<string>("/test/test_vars/test_table") == rawTable);
+
+    //the output is refilled, not appended
+    REQUIRE(calib.GetCalib(table, "/test/test_vars/test_table"));
+    REQUIRE(table.size() == rawTable.size());
+
+    vector<map<string, double> > rows;
+    REQUIRE(calib.GetCalib(rows, "/test/test_vars/test_table"));
+    REQUIRE(rows.size() == table.size());
+    REQUIRE(rows[1]["y"] == table[1][1]);
+    REQUIRE(calib.GetCalib(rows, "/test/test_vars/test_table"));
+    REQUIRE(rows.size() == table.size());
+    vector<map<string, string> > rawRows(5);
+    REQUIRE(calib.GetCalib(rawRows, "/test/test_vars/test_table"));
+    REQUIRE(rawRows.size() == table.size());
+
+    //one row table: vector, map and value returning vector agree
+    vector<int> line = calib.GetCalibVector<int>("/test/test_vars/test_table2::test");
+    REQUIRE(line.size() == 3);
+    map<string, int> named;
+    REQUIRE(calib.GetCalib(named, "/test/test_vars/test_table2::test"));
+    REQUIRE(named.size() == 3);
+    REQUIRE(named["c1"] == line[0]);
+    REQUIRE(named["c3"] == line[2]);
+    named["stale"] = 1;
+    REQUIRE(calib.GetCalib(named, "/test/test_vars/test_table2::test"));
+    REQUIRE(named.size() == 3);
+    vector<string> rawLine = calib.GetCalibVector<string>("/test/test_vars/test_table2::test");
+    REQUIRE(StringUtils::ParseInt(rawLine[1]) == line[1]);
+
+    //test_table2 has no data in the default variation
+    REQUIRE(calib.GetCalibVector<int>("/test/test_vars/test_table2").empty());
+
+    //table asked as one row
+    REQUIRE_THROWS_AS(calib.GetCalibVector<double>("/test/test_vars/test_table"), std::logic_error);
+}
+
+
+/** *********************************************************************
+ * @brief Cache reports its memory. The memory policy drops blobs and mapped rows, but not the values
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/CacheMemory","Cache memory usage and policy")
+{
+    SQLiteCalibration calib(100);
+    REQUIRE(calib.Connect(TESTS_SQLITE_STRING));
+    calib.EnableCache(true);
+    REQUIRE(calib.GetCacheMemoryUsage().GetTotal() == 0);
+    REQUIRE(calib.GetCacheMemoryPolicy() == Calibration::cKeepAllData);
+
+    Assignment* assignment = calib.GetAssignment("/test/test_vars/test_table");
+    REQUIRE(assignment != NULL);
+    MemoryUsage usage = calib.GetCacheMemoryUsage();
+    REQUIRE(usage.RawBytes + usage.ObjectBytes > 0);
+    REQUIRE(usage.MappedBytes == 0);
+
+    //mapped rows are kept by GetValue
+    string x = assignment->GetValue("x");
+    REQUIRE(calib.GetCacheMemoryUsage().MappedBytes > 0);
+    REQUIRE(calib.GetCacheMemoryUsage().SplitBytes > 0);
+
+    auto byTable = calib.GetCacheMemoryUsageByTable();
+    REQUIRE(byTable.size() == 1);
+    REQUIRE(byTable["/test/test_vars/test_table"].GetTotal() == calib.GetCacheMemoryUsage().GetTotal());
+    REQUIRE(byTable["/test/test_vars/test_table"].GetTotal() == assignment->GetMemoryUsage().GetTotal());
+
+    //the same data without blob and mapped rows
+    SQLiteCalibration lean(100);
+    REQUIRE(lean.Connect(TESTS_SQLITE_STRING));
+    lean.EnableCache(true);
+    lean.SetCacheMemoryPolicy(Calibration::cDropRawAndMappedData);
+    Assignment* leanAssignment = lean.GetAssignment("/test/test_vars/test_table");
+    REQUIRE(leanAssignment->GetValue("x") == x);
+    REQUIRE(leanAssignment->GetValue("no_such_column") == "");
+    REQUIRE(leanAssignment->GetRawData() == assignment->GetRawData());
+    REQUIRE(lean.GetCalibTable<double>("/test/test_vars/test_table") == calib.GetCalibTable<double>("/test/test_vars/test_table"));
+    MemoryUsage leanUsage = lean.GetCacheMemoryUsage();
+    REQUIRE(leanUsage.RawBytes == 0);
+    REQUIRE(leanUsage.MappedBytes == 0);
+    REQUIRE(leanUsage.SplitBytes > 0);
+}
+
+
+
+/** *********************************************************************
+ * @brief Options from the environment, the connection string and the code
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/Options","Run time options")
+{
+    string query;
+    REQUIRE(CalibrationOptions::SplitConnectionString("sqlite:///a/b.sqlite?cache=on&preload=off", query) == "sqlite:///a/b.sqlite");
+    REQUIRE(query == "cache=on&preload=off");
+    REQUIRE(CalibrationOptions::SplitConnectionString("sqlite:///a?b/c.sqlite", query) == "sqlite:///a?b/c.sqlite");
+    REQUIRE(query.empty());
+
+    CalibrationOptions options;
+    REQUIRE_THROWS_AS(options.Set("no_such_option", "1"), std::logic_error);
+    REQUIRE_THROWS_AS(options.Set("cache", "maybe"), std::logic_error);
+    REQUIRE_THROWS_AS(options.Set("negative_cache_ttl", "-2"), std::logic_error);
+    REQUIRE_THROWS_AS(options.SetFromQuery("cache"), std::logic_error);
+    options.SetFromQuery("cache_policy=drop_raw&pool_size=3&trace=off");
+    REQUIRE(options.CacheMemoryPolicy == Calibration::cDropRawData);
+    REQUIRE(options.PoolSize == 3);
+
+    setenv("CCDB_NEGATIVE_CACHE_TTL", "15", 1);
+    REQUIRE(CalibrationOptions::FromEnvironment().NegativeCacheTtl == 15);
+    setenv("CCDB_NEGATIVE_CACHE_TTL", "soon", 1);
+    try {
+        CalibrationOptions::FromEnvironment();
+        FAIL("A wrong environment value must throw");
+    }
+    catch (std::logic_error& error) {
+        REQUIRE(string(error.what()).find("CCDB_NEGATIVE_CACHE_TTL='soon'") != string::npos);
+    }
+    unsetenv("CCDB_NEGATIVE_CACHE_TTL");
+
+    //equal options give equal queries
+    CalibrationOptions first, second;
+    first.SetFromQuery("cache=on&preload=off&pool_size=2");
+    second.SetFromQuery("pool_size=2&cache=1&preload=no");
+    REQUIRE(first.ToQuery() == second.ToQuery());
+    REQUIRE(first.ToQuery().find("cache=on&cache_policy=keep_all&") == 0);
+
+    //the generator gives the same Calibration for the same options in other order
+    CalibrationGenerator generator;
+    Calibration* withOptions = generator.MakeCalibration(string(TESTS_SQLITE_STRING) + "?cache=on&negative_cache_ttl=5", 100, "default");
+    REQUIRE(generator.MakeCalibration(string(TESTS_SQLITE_STRING) + "?negative_cache_ttl=5&cache=true", 100, "default") == withOptions);
+    REQUIRE(generator.MakeCalibration(string(TESTS_SQLITE_STRING) + "?negative_cache_ttl=6&cache=true", 100, "default") != withOptions);
+
+    //connection string options are applied and are not given to the provider
+    SQLiteCalibration calib(100);
+    REQUIRE(calib.Connect(string(TESTS_SQLITE_STRING) + "?cache=on&negative_cache_ttl=0&sqlite_mode=immutable"));
+    REQUIRE(calib.GetConnectionString() == TESTS_SQLITE_STRING);
+    REQUIRE(calib.IsCacheEnabled());
+    REQUIRE(calib.GetOptions().IsSQLiteImmutable);
+    REQUIRE(calib.GetOptions().NegativeCacheTtl == 0);
+    REQUIRE(calib.GetCalibTable<double>("/test/test_vars/test_table").size() == 2);
+    REQUIRE(calib.GetCalibVector<int>("/test/test_vars/test_table2").empty());     //not found requests aren't cached
+    REQUIRE(calib.GetCacheMemoryUsageByTable().size() == 1);
+
+    std::ostringstream metrics;
+    calib.WriteMetrics(metrics);
+    REQUIRE(metrics.str().find("CCDB_METRICS:{\"cache_entries\":1,") == 0);
+
+    //preload loads everything for the default run
+    CalibrationOptions preloadOptions;
+    preloadOptions.IsPreloadEnabled = true;
+    SQLiteCalibration preloaded(100);
+    preloaded.SetOptions(preloadOptions);
+    REQUIRE(preloaded.Connect(TESTS_SQLITE_STRING));
+    REQUIRE(preloaded.IsCacheEnabled());
+    REQUIRE(preloaded.GetCacheMemoryUsageByTable().size() > 0);
+    preloaded.Disconnect();
+    REQUIRE(preloaded.GetCalibTable<double>("/test/test_vars/test_table").size() == 2);
+    REQUIRE_FALSE(preloaded.IsConnected());
+}
+
+#ifndef _WIN32
+/** *********************************************************************
+ * @brief Forked workers read constants loaded by the parent without connecting
+ */
+TEST_CASE("CCDB/UserAPI/SQLite/Fork","Cache prepared for fork")
+{
+    CalibrationGenerator generator;
+    Calibration* calib = generator.MakeCalibration(TESTS_SQLITE_STRING, 100, "default");
+    generator.PrepareForFork({"/test/test_vars/test_table", "/test/test_vars/test_table2::test"});
+    REQUIRE_FALSE(calib->IsConnected());
+    REQUIRE(calib->GetCachedVaultsCount() == 2);
+
+    pid_t pid = fork();
+    REQUIRE(pid >= 0);
+    if(pid == 0) {
+        // No Catch macros in the child: the exit code tells the parent what failed
+        int code = 0;
+        try {
+            generator.AfterForkChild();
+            if(calib->GetCalibTable<double>("/test/test_vars/test_table").size() != 2) code = 1;
+            else if(calib->GetCalibVector<int>("/test/test_vars/test_table2::test") != vector<int>({10, 20, 30})) code = 2;
+            else if(calib->IsConnected()) code = 3;
+        }
+        catch (...) {
+            code = 4;
+        }
+        _exit(code);
+    }
+
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    //the parent connects again on the first request that is not cached
+    REQUIRE(calib->GetCalibTable<double>("/test/test_vars/test_table").size() == 2);
+    REQUIRE_FALSE(calib->IsConnected());
+    REQUIRE(calib->GetCalibVector<int>("/test/test_vars/test_table2:0:test").size() == 3);
+    REQUIRE(calib->IsConnected());
+    REQUIRE_THROWS_AS(generator.AfterForkChild(), std::logic_error);
+}
+#endif
@@ -8,6 +8,9 @@
 
 #include <vector>
 #include <string>
+#include <random>
+#include <thread>
+#include <cstdlib>
 #include <time.h>
 
 using namespace std;
@@ -166,4 +169,244 @@ TEST_CASE("CCDB/PathUtils/Context", "Context parse")
 	REQUIRE(result.Variation == "james");
 	REQUIRE(result.RunNumber == 123);
 }
+
+
+/** ParseTime as it was written with mktime. Compared with the calendar arithmetic one */
+static time_t ReferenceParseTime(const string& timeStr, bool* success)
+{
+    tm time = tm();
+    time.tm_hour = 23;
+    time.tm_mday = 31;
+    time.tm_min = 59;
+    time.tm_mon = 11;
+    time.tm_sec = 59;
+    time.tm_isdst = -1;
+    *success = true;
+
+    string tmpStr;
+    int delimCount = 0;
+    string workStr(timeStr + " ");
+    bool lastIsDigit = false;
+    for (size_t i = 0; i < workStr.size(); i++) {
+        char symbol = workStr[i];
+        if (symbol >= '0' && symbol <= '9') {
+            tmpStr.push_back(symbol);
+            lastIsDigit = true;
+            continue;
+        }
+        if (!lastIsDigit) continue;
+
+        delimCount++;
+        if (delimCount <= 6 && tmpStr.length() != (delimCount == 1 ? 4u : 2u)) {
+            *success = false;
+            return 0;
+        }
+        int value = atoi(tmpStr.c_str());
+        if (delimCount == 1) time.tm_year = value - 1900;
+        if (delimCount == 2) {
+            time.tm_mon = value - 1;
+            if ((time.tm_mon == 9) || (time.tm_mon == 10) || (time.tm_mon == 4) || (time.tm_mon == 6)) time.tm_mday = 30;
+            if (time.tm_mon == 2) {
+                bool isLeap = (time.tm_year % 4 == 0 && time.tm_year % 100 != 0) || time.tm_year % 400 == 0;
+                time.tm_mday = isLeap ? 29 : 28;
+            }
+        }
+        if (delimCount == 3) time.tm_mday = value;
+        if (delimCount == 4) time.tm_hour = value;
+        if (delimCount == 5) time.tm_min = value;
+        if (delimCount == 6) time.tm_sec = value;
+        tmpStr.clear();
+    }
+    time_t result = mktime(&time);
+    if (result == -1) *success = false;
+    return result;
+}
+
+
+/** Random time strings: mostly YYYY-MM-DD hh:mm:ss parts with various delimiters and out of range values */
+static string MakeRandomTimeString(std::mt19937& random)
+{
+    const char delimiters[] = "-: T/";
+    string result;
+    if (random() % 10 == 0) {
+        // noise
+        const char symbols[] = "0123456789-: x";
+        size_t length = random() % 14;
+        for (size_t i = 0; i < length; i++) result.push_back(symbols[random() % (sizeof(symbols) - 1)]);
+        return result;
+    }
+
+    if (random() % 10 == 0) result.push_back(' ');
+    result += std::to_string(1902 + random() % 136);
+    size_t parts = random() % 8;
+    for (size_t i = 0; i < parts; i++) {
+        result.push_back(delimiters[random() % (sizeof(delimiters) - 1)]);
+        unsigned maxValue = random() % 4 == 0 ? 100 : (i == 0 ? 13 : i == 1 ? 32 : i == 2 ? 24 : 60);
+        unsigned value = random() % maxValue;
+        if (random() % 30 == 0) value = random() % 1000;     // wrong length
+        if (value < 10) result.push_back('0');
+        result += std::to_string(value);
+    }
+    if (random() % 10 == 0) result.push_back(delimiters[random() % (sizeof(delimiters) - 1)]);
+    return result;
+}
+
+
+/** true if the UTC offset is not the same around the time. mktime result there depends on its internal guesses */
+static bool IsNearOffsetChange(time_t time)
+{
+    time_t before = time - 7200;
+    time_t after = time + 7200;
+    tm beforeTm = tm();
+    tm afterTm = tm();
+    localtime_r(&before, &beforeTm);
+    localtime_r(&after, &afterTm);
+    return beforeTm.tm_isdst != afterTm.tm_isdst;
+}
+
+
+/** Compares ParseTime with ReferenceParseTime on random strings. Returns the number of mismatches */
+static int CountParseTimeMismatches(unsigned seed, int count, vector<string>& mismatches)
+{
+    std::mt19937 random(seed);
+    int mismatchesCount = 0;
+    for (int i = 0; i < count; i++) {
+        string timeStr = MakeRandomTimeString(random);
+        bool expectedSuccess = false;
+        bool success = false;
+        time_t expected = ReferenceParseTime(timeStr, &expectedSuccess);
+        time_t result = PathUtils::ParseTime(timeStr, &success);
+
+        // The old code read an uninitialized year if there were no digits. Now it is an error
+        if (timeStr.find_first_of("0123456789") == string::npos) {
+            if (success) { mismatchesCount++; mismatches.push_back(timeStr); }
+            continue;
+        }
+        if (expectedSuccess && IsNearOffsetChange(expected)) continue;
+
+        if (success != expectedSuccess || (success && result != expected)) {
+            mismatchesCount++;
+            if (mismatches.size() < 10) mismatches.push_back(timeStr);
+        }
+    }
+    return mismatchesCount;
+}
+
+
+TEST_CASE("CCDB/PathUtils/TimeFuzz", "ParseTime gives the same as mktime")
+{
+    vector<string> mismatches;
+    int mismatchesCount = CountParseTimeMismatches(2011, 20000, mismatches);
+    INFO("First mismatched strings: " << (mismatches.empty() ? string() : mismatches[0]));
+    REQUIRE(mismatchesCount == 0);
+
+    // Partial dates give the latest time of the period
+    bool success = false;
+    time_t endOf2011 = PathUtils::ParseTime("2011", &success);
+    REQUIRE(success);
+    REQUIRE(PathUtils::ParseTime("2011-12-31 23:59:59", &success) == endOf2011);
+    REQUIRE(PathUtils::ParseTime("2012-01-01 00:00:00", &success) == endOf2011 + 1);
+
+    string request("2011-08-17 14:30:20 trailing");
+    REQUIRE(PathUtils::ParseTime(request.data(), 10, &success) == PathUtils::ParseTime("2011-08-17", &success));
+
+#ifndef _WIN32
+    // A time zone with daylight saving. A new thread doesn't have cached offsets of the current zone
+    const char* oldZone = getenv("TZ");
+    string savedZone = oldZone ? oldZone : "";
+    setenv("TZ", "America/New_York", 1);
+    tzset();
+
+    int zoneMismatchesCount = 0;
+    vector<string> zoneMismatches;
+    std::thread worker([&]() { zoneMismatchesCount = CountParseTimeMismatches(2012, 20000, zoneMismatches); });
+    worker.join();
+
+    if (oldZone) setenv("TZ", savedZone.c_str(), 1);
+    else unsetenv("TZ");
+    tzset();
+
+    INFO("First mismatched strings: " << (zoneMismatches.empty() ? string() : zoneMismatches[0]));
+    REQUIRE(zoneMismatchesCount == 0);
+#endif
+}
+
+
+/** ParseRequest as it was written: symbol by symbol */
+static RequestParseResult ReferenceParseRequest(const string& requestStr)
+{
+    RequestParseResult result;
+    result.RunNumber = 0;
+    result.WasParsedRunNumber = result.IsInvalidRunNumber = result.WasParsedPath = false;
+    result.WasParsedVariation = result.WasParsedTime = false;
+    result.Time = 0;
+
+    int colonCount = 0;
+    string runStr;
+    for (size_t i = 0; i < requestStr.size(); i++) {
+        char symbol = requestStr[i];
+        if (symbol == ':') {
+            colonCount++;
+            if (colonCount > 3) result.TimeString.push_back(':');
+            continue;
+        }
+        switch (colonCount) {
+            case 0: result.Path.push_back(symbol); result.WasParsedPath = true; break;
+            case 1: runStr.push_back(symbol); result.WasParsedRunNumber = true; break;
+            case 2: result.Variation.push_back(symbol); result.WasParsedVariation = true; break;
+            default: result.TimeString.push_back(symbol); result.WasParsedTime = true; break;
+        }
+    }
+    if (result.WasParsedRunNumber) {
+        result.RunNumber = atoi(runStr.c_str());
+        result.IsInvalidRunNumber = result.RunNumber < 0;
+    }
+    if (result.WasParsedTime) {
+        bool success = true;
+        result.Time = PathUtils::ParseTime(result.TimeString, &success);
+    }
+    return result;
+}
+
+
+TEST_CASE("CCDB/PathUtils/RequestView", "Request parse without copies")
+{
+    string request("/my/value:100:mc:2029-01:10");
+    RequestParseView view = PathUtils::ParseRequestView(request);
+    REQUIRE(view.Path == "/my/value");
+    REQUIRE(view.Path.Data == request.data());
+    REQUIRE(view.RunNumber == 100);
+    REQUIRE(view.Variation == "mc");
+    REQUIRE(view.TimeString == "2029-01:10");
+    REQUIRE(view.WasParsedTime);
+
+    // Random requests are parsed the same as they were parsed symbol by symbol
+    const char symbols[] = "/ab:-1209";
+    std::mt19937 random(2013);
+    for (int i = 0; i < 5000; i++) {
+        string randomRequest;
+        size_t length = random() % 24;
+        for (size_t j = 0; j < length; j++) randomRequest.push_back(symbols[random() % (sizeof(symbols) - 1)]);
+
+        RequestParseResult result = ReferenceParseRequest(randomRequest);
+        view = PathUtils::ParseRequestView(randomRequest);
+
+        INFO("Request: " << randomRequest);
+        REQUIRE(view.Path == result.Path);
+        REQUIRE(view.WasParsedPath == result.WasParsedPath);
+        REQUIRE(view.RunNumber == result.RunNumber);
+        REQUIRE(view.WasParsedRunNumber == result.WasParsedRunNumber);
+        REQUIRE(view.IsInvalidRunNumber == result.IsInvalidRunNumber);
+        REQUIRE(view.Variation == result.Variation);
+        REQUIRE(view.WasParsedVariation == result.WasParsedVariation);
+        REQUIRE(view.Time == result.Time);
+        REQUIRE(view.WasParsedTime == result.WasParsedTime);
+        REQUIRE(view.TimeString == result.TimeString);
+
+        RequestParseResult copied = PathUtils::ParseRequest(randomRequest);
+        REQUIRE(copied.Path == result.Path);
+        REQUIRE(copied.Variation == result.Variation);
+        REQUIRE(copied.TimeString == result.TimeString);
+    }
+}
 #endif //test_StringUtils_h
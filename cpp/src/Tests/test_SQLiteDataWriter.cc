@@ -0,0 +1,246 @@
+#pragma warning(disable:4800)
+#include <cstdlib>
+
+#include "Tests/tests.h"
+#include "Tests/catch.hpp"
+
+#include "CCDB/Providers/SQLiteDataWriter.h"
+#include "CCDB/Providers/SQLiteDataProvider.h"
+#include "CCDB/Helpers/VaultHash.h"
+#include "CCDB/SQLiteCalibration.h"
+
+using namespace std;
+using namespace ccdb;
+
+namespace {
+    vector<string> ReadVault(DataProvider& provider, int run, const string& variation)
+    {
+        Assignment* assignment = provider.GetAssignmentShort(run, "/test/test_vars/test_table", 0, variation, false);
+        REQUIRE(assignment != nullptr);
+        vector<string> values = assignment->GetVectorData();
+        delete assignment;
+        return values;
+    }
+}
+
+
+/********************************************************************* **
+ * @brief Vault text is built from typed values
+ */
+TEST_CASE("CCDB/SQLiteDataWriter/BuildVault","Vault from typed arrays")
+{
+    REQUIRE(DataWriter::BuildVault(vector<int>{1, -2, 3}) == "1|-2|3");
+    REQUIRE(DataWriter::BuildVault(vector<double>{1.5, 0.25}) == "1.5|0.25");
+    REQUIRE(DataWriter::BuildVault(vector<bool>{true, false}) == "1|0");
+    REQUIRE(DataWriter::BuildVault(vector<string>{"a", "with|surprise"}) == "a|with&delimiter;surprise");
+    REQUIRE(DataWriter::BuildVault(vector<int>{}).empty());
+
+    // Doubles are written with enough digits to be read back exactly
+    double value = 0.1 + 0.2;
+    REQUIRE(atof(DataWriter::BuildVault(vector<double>{value}).c_str()) == value);
+}
+
+
+/********************************************************************* **
+ * @brief Batched writes to a copy of the test database
+ */
+TEST_CASE("CCDB/SQLiteDataWriter/Write","Write assignments in batches")
+{
+    TestDirectory directory;
+    string connectionString = directory.CopyTestDatabase();
+
+    SQLiteDataWriter writer;
+    REQUIRE_NOTHROW(writer.Connect(connectionString));
+    writer.SetCommitEvery(2);
+
+    // Existing run range is reused
+    REQUIRE(writer.GetOrCreateRunRange(500, 3000) == 2);
+
+    // test_table has 2 rows and 3 columns
+    for(int i = 0; i < 5; i++) {
+        vector<double> values = {1.0 * i, 2.0, 3.0, 4.0, 5.0, 6.5};
+        REQUIRE(writer.CreateAssignment("/test/test_vars/test_table", "test", 10000 + i, 10000 + i, values, "writer test") > 5);
+    }
+    REQUIRE(writer.GetStats().Assignments == 5);
+    REQUIRE(writer.GetStats().ConstantSets == 5);
+    REQUIRE(writer.GetStats().RunRanges == 5);
+    REQUIRE(writer.GetStats().Commits == 2);
+    REQUIRE(writer.GetUncommittedCount() == 1);
+
+    writer.Commit();
+    REQUIRE(writer.GetStats().Commits == 3);
+    REQUIRE(writer.GetStats().GetAssignmentsPerSecond() > 0);
+
+    // Wrong data, table or variation
+    REQUIRE_THROWS(writer.CreateAssignment("/test/test_vars/test_table", "test", 1, 1, vector<int>{1, 2, 3}));
+    REQUIRE_THROWS(writer.CreateAssignment("/test/test_vars/no_such_table", "test", 1, 1, vector<int>{1}));
+    REQUIRE_THROWS(writer.CreateAssignment("/test/test_vars/test_table", "no_such_variation", 1, 1, vector<int>{1, 2, 3, 4, 5, 6}));
+    REQUIRE_THROWS(writer.GetOrCreateRunRange(10, 1));
+
+    // Rolled back assignment is not seen
+    writer.SetCommitEvery(0);
+    writer.CreateAssignment("/test/test_vars/test_table", "test", 10003, 10003, vector<int>{0, 0, 0, 0, 0, 0});
+    writer.Rollback();
+    REQUIRE(writer.GetUncommittedCount() == 0);
+
+    SQLiteDataProvider provider;
+    provider.Connect(connectionString);
+
+    vector<string> values = ReadVault(provider, 10003, "test");
+    REQUIRE(values.size() == 6);
+    REQUIRE(values[0] == "3.0");     // Like python repr
+    REQUIRE(values[5] == "6.5");
+
+    // Own assignments of sub variation are still preferred, other runs are not changed
+    REQUIRE(ReadVault(provider, 10004, "subtest")[0] == "10");
+    REQUIRE(ReadVault(provider, 1000, "test")[0] == "1.0");
+
+    provider.Disconnect();
+    writer.Disconnect();
+}
+
+
+/********************************************************************* **
+ * @brief Vault hash values are stored in databases and must not change
+ */
+TEST_CASE("CCDB/SQLiteDataWriter/VaultHash","FNV-1a hash of vaults")
+{
+    REQUIRE(VaultHashToString(HashVault("")) == "cbf29ce484222325");
+    REQUIRE(VaultHashToString(HashVault("a")) == "af63dc4c8601ec8c");
+    REQUIRE(HashVault("1.0|2.0") != HashVault("1.0|2.1"));
+}
+
+
+/********************************************************************* **
+ * @brief Constant sets with the same vault are shared after vaultHash column is added
+ */
+TEST_CASE("CCDB/SQLiteDataWriter/ReuseConstantSets","Deduplication of constant sets")
+{
+    TestDirectory directory;
+    string connectionString = directory.CopyTestDatabase();
+
+    SQLiteDataWriter writer;
+    REQUIRE_NOTHROW(writer.Connect(connectionString));
+
+    // Without the column every assignment gets own constant set
+    REQUIRE_FALSE(writer.HasVaultHash());
+    writer.CreateAssignment("/test/test_vars/test_table", "test", 20000, 20000, vector<double>{1, 2, 3, 4, 5, 6});
+    REQUIRE(writer.GetStats().ConstantSets == 1);
+    REQUIRE(writer.GetStats().ReusedConstantSets == 0);
+
+    // Existing 5 constant sets and the new one get hashes
+    REQUIRE(writer.BackfillVaultHashes(4) == 6);
+    REQUIRE(writer.HasVaultHash());
+    REQUIRE(writer.BackfillVaultHashes() == 0);
+
+    // The same vault as constant set 2 of the test database
+    writer.ResetStats();
+    writer.CreateAssignment("/test/test_vars/test_table", "test", 20001, 20001, vector<double>{1, 2, 3, 4, 5, 6});
+    writer.CreateAssignment("/test/test_vars/test_table", "test", 20002, 20002, vector<double>{7, 8, 9, 10, 11, 12});
+    writer.CreateAssignment("/test/test_vars/test_table", "test", 20003, 20003, vector<double>{7, 8, 9, 10, 11, 12});
+    REQUIRE(writer.GetStats().Assignments == 3);
+    REQUIRE(writer.GetStats().ConstantSets == 1);
+    REQUIRE(writer.GetStats().ReusedConstantSets == 2);
+
+    // Same values of the other table are not mixed
+    writer.CreateAssignment("/test/test_vars/test_table2", "test", 20002, 20002, vector<int>{10, 20, 30});
+    REQUIRE(writer.GetStats().ReusedConstantSets == 3);
+    writer.CreateAssignment("/test/test_vars/test_table2", "test", 20003, 20003, vector<int>{1, 2, 3});
+    REQUIRE(writer.GetStats().ConstantSets == 2);
+
+    // Could be switched off
+    writer.SetReuseConstantSets(false);
+    writer.CreateAssignment("/test/test_vars/test_table", "test", 20004, 20004, vector<double>{7, 8, 9, 10, 11, 12});
+    REQUIRE(writer.GetStats().ConstantSets == 3);
+    writer.Disconnect();
+
+    // Reconnected writer sees the column
+    SQLiteDataWriter secondWriter;
+    secondWriter.Connect(connectionString);
+    REQUIRE(secondWriter.HasVaultHash());
+    secondWriter.Disconnect();
+
+    // Calibration keeps one copy of equal vaults
+    SQLiteCalibration calib(100);
+    REQUIRE(calib.Connect(connectionString));
+    calib.EnableCache(true);
+    Assignment* first = calib.GetAssignment("/test/test_vars/test_table:20002:test");
+    Assignment* second = calib.GetAssignment("/test/test_vars/test_table:20003:test");
+    Assignment* third = calib.GetAssignment("/test/test_vars/test_table:20004:test");
+    REQUIRE(first != second);
+    REQUIRE(first->GetVault() == second->GetVault());
+    REQUIRE(first->GetVault() == third->GetVault());       // the same text from different constant sets
+    REQUIRE(calib.GetCachedVaultsCount() == 1);
+    REQUIRE(third->GetData().size() == 2);
+    REQUIRE(third->GetValueDouble(1, 2) == 12.0);
+
+    calib.GetAssignment("/test/test_vars/test_table:20000:test");
+    REQUIRE(calib.GetCachedVaultsCount() == 2);
+
+    calib.Disconnect();
+}
+
+
+/********************************************************************* **
+ * @brief Calibration finds written assignments and drops only outdated cache entries
+ */
+TEST_CASE("CCDB/SQLiteDataWriter/ChangeDetection","Cache invalidation by new assignments")
+{
+    TestDirectory directory;
+    string connectionString = directory.CopyTestDatabase();
+
+    SQLiteCalibration calib(100);
+    REQUIRE(calib.Connect(connectionString));
+    calib.EnableCache(true);
+    calib.SetChangeCheckInterval(3600);     // only the first request checks by itself
+
+    vector<AssignmentChange> lastChanges;
+    int listenerCalls = 0;
+    int listenerId = calib.AddChangeListener([&](const vector<AssignmentChange>& changes) {
+        lastChanges = changes;
+        listenerCalls++;
+    });
+
+    Assignment* inherited = calib.GetAssignment("/test/test_vars/test_table:100:test");     // from default variation
+    Assignment* otherRun = calib.GetAssignment("/test/test_vars/test_table:1000:test");
+    Assignment* otherTable = calib.GetAssignment("/test/test_vars/test_table2:100:test");
+    REQUIRE(inherited->GetValue(0, 0) == "2.2");
+    REQUIRE(calib.CheckForChanges() == 0);
+    REQUIRE(listenerCalls == 0);
+
+    SQLiteDataWriter writer;
+    writer.Connect(connectionString);
+    writer.CreateAssignment("/test/test_vars/test_table", "default", 0, 500, vector<double>{7, 8, 9, 10, 11, 12});
+    writer.Commit();
+
+    // Parent variation assignment outdates the cached one of the same run and table only
+    REQUIRE(calib.CheckForChanges() == 1);
+    REQUIRE(listenerCalls == 1);
+    REQUIRE(lastChanges.size() == 1);
+    REQUIRE(lastChanges[0].TablePath == "/test/test_vars/test_table");
+    REQUIRE(lastChanges[0].Variation == "default");
+    REQUIRE(lastChanges[0].RunMin == 0);
+    REQUIRE(lastChanges[0].RunMax == 500);
+
+    Assignment* updated = calib.GetAssignment("/test/test_vars/test_table:100:test");
+    REQUIRE(updated != inherited);
+    REQUIRE(updated->GetValue(0, 0) == "7.0");
+    REQUIRE(inherited->GetValue(0, 0) == "2.2");       // what users have is not deleted
+    REQUIRE(calib.GetAssignment("/test/test_vars/test_table:1000:test") == otherRun);
+    REQUIRE(calib.GetAssignment("/test/test_vars/test_table2:100:test") == otherTable);
+
+    // Nothing new
+    REQUIRE(calib.CheckForChanges() == 0);
+    REQUIRE(listenerCalls == 1);
+
+    // Removed listener is not called
+    calib.RemoveChangeListener(listenerId);
+    writer.CreateAssignment("/test/test_vars/test_table", "test", 1000, 1000, vector<double>{1, 1, 1, 1, 1, 1});
+    writer.Commit();
+    REQUIRE(calib.CheckForChanges() == 1);
+    REQUIRE(listenerCalls == 1);
+    REQUIRE(calib.GetAssignment("/test/test_vars/test_table:1000:test")->GetValue(0, 0) == "1.0");
+    writer.Disconnect();
+
+    calib.Disconnect();
+}
@@ -27,13 +27,17 @@ TEST_CASE("CCDB/SQLiteDataProvider/Assignments","Assignments tests")
 	//lets start with simple cases. 
 	//Get FULL assignment by table and name
 	
-	Assignment * assignment = prov->GetAssignmentShort(100,"/test/test_vars/test_table", 0, "default", false);
+	//Columns are asked for: with loadColumns=false the table is read without them, and GetData below needs them
+	Assignment * assignment = prov->GetAssignmentShort(100,"/test/test_vars/test_table", 0, "default", true);
 	
 	REQUIRE(assignment!=NULL);
 
 	//Check that everything is loaded
 	REQUIRE(assignment->GetVariation() != NULL);
 	REQUIRE(assignment->GetRunRange()  != NULL);
+	REQUIRE(assignment->GetRunRange()->GetMin() <= 100);
+	REQUIRE(assignment->GetRunRange()->GetMax() >= 100);
+	REQUIRE(assignment->GetRunRange()->GetId() == (int)assignment->GetRunRangeId());
 	REQUIRE(assignment->GetTypeTable() != NULL);	
 	REQUIRE(!assignment->GetTypeTable()->GetColumns().empty());
 	vector<vector<string> > tabeled_values = assignment->GetData();
@@ -46,3 +50,62 @@ TEST_CASE("CCDB/SQLiteDataProvider/Assignments","Assignments tests")
 	REQUIRE(tabeled_values[1][1] == "2.6");
 	REQUIRE(tabeled_values[1][2] == "2.7");
 }
+
+
+/********************************************************************* **
+ * @brief Streamed listing of assignments
+ */
+TEST_CASE("CCDB/SQLiteDataProvider/VisitAssignments","Assignments listing")
+{
+	SQLiteDataProvider prov;
+	prov.Connect(TESTS_SQLITE_STRING);
+
+	//All assignments of the table in default variation, newest first
+	vector<int> ids;
+	auto visited = prov.VisitAssignments("/test/test_vars/test_table", "default", -1, 0, [&ids](Assignment& assignment) {
+		REQUIRE(assignment.GetRunRange() != NULL);
+		REQUIRE(assignment.GetTypeTable() != NULL);
+		REQUIRE(assignment.GetData().size() == 2);
+		ids.push_back(assignment.GetId());
+		return true;
+	});
+	REQUIRE(visited == 2);
+	REQUIRE(ids.size() == 2);
+	REQUIRE(ids[0] > ids[1]);
+
+	//Stop after the first row
+	visited = prov.VisitAssignments("/test/test_vars/test_table", "default", 100, 0, [](Assignment&) { return false; });
+	REQUIRE(visited == 1);
+
+	//Nothing was created before 1970
+	visited = prov.VisitAssignments("/test/test_vars/test_table", "default", -1, 1, [](Assignment&) { return true; });
+	REQUIRE(visited == 0);
+
+	REQUIRE_THROWS(prov.VisitAssignments("/test/test_vars/no_such_table", "default", -1, 0, [](Assignment&) { return true; }));
+}
+
+
+/********************************************************************* **
+ * @brief Latest assignments of all tables for the run
+ */
+TEST_CASE("CCDB/SQLiteDataProvider/GetLatestAssignments","Latest assignments of all tables")
+{
+	SQLiteDataProvider prov;
+	prov.Connect(TESTS_SQLITE_STRING);
+
+	//The result is the same as GetAssignmentShort for each table
+	auto assignments = prov.GetLatestAssignments(100, 0, "subtest", true);
+	REQUIRE(assignments.size() == 2);
+	for(auto assignment: assignments) {
+		REQUIRE(assignment->GetTypeTable() != NULL);
+		REQUIRE(!assignment->GetTypeTable()->GetColumns().empty());
+
+		Assignment* single = prov.GetAssignmentShort(100, assignment->GetTypeTable()->GetFullPath(), 0, "subtest", false);
+		REQUIRE(single != NULL);
+		REQUIRE(single->GetId() == assignment->GetId());
+		REQUIRE(single->GetDataVaultId() == assignment->GetDataVaultId());
+		REQUIRE(single->GetVariation()->GetName() == assignment->GetVariation()->GetName());
+		delete single;
+		delete assignment;
+	}
+}
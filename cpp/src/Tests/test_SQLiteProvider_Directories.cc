@@ -23,6 +23,35 @@ TEST_CASE("CCDB/SQLiteDataProvider/Directories","Directories tests")
 	//get directory by path
 	Directory *dir=prov->GetDirectory("/test/subtest");
 	REQUIRE(dir!=NULL);
+	REQUIRE(dir->GetFullPath() == "/test/subtest");
+	REQUIRE(dir->GetParentDirectory()->GetFullPath() == "/test");
+	REQUIRE(prov->GetRootDirectory()->GetFullPath() == "/");
+	REQUIRE(prov->GetDirectory("/test/no_such_dir") == NULL);
+
+	//full paths of the subtree follow the directory when it is attached or renamed
+	Directory parent;
+	parent.SetName("parent");
+	Directory* child = new Directory();
+	child->SetName("child");
+	Directory* grandchild = new Directory();
+	grandchild->SetName("grandchild");
+	child->AddSubdirectory(grandchild);
+	REQUIRE(grandchild->GetFullPath() == "/child/grandchild");
+	parent.AddSubdirectory(child);
+	REQUIRE(grandchild->GetFullPath() == "/parent/child/grandchild");
+	child->SetName("renamed");
+	REQUIRE(grandchild->GetFullPath() == "/parent/renamed/grandchild");
+	parent.DisposeSubdirectories();
+
+	//directories of tables read before a reload stay valid
+	ConstantsTypeTable* table = prov->DataProvider::GetConstantsTypeTable("/test/test_vars/test_table", false);
+	REQUIRE(table != NULL);
+	Directory* oldDir = table->GetDirectory();
+	prov->LoadDirectories();
+	REQUIRE(oldDir->GetFullPath() == "/test/test_vars");
+	REQUIRE(oldDir->GetParentDirectory()->GetFullPath() == "/test");
+	REQUIRE(prov->GetDirectory("/test/test_vars") != oldDir);
+	REQUIRE(prov->DataProvider::GetConstantsTypeTable("/test/test_vars/test_table", false)->GetDirectory() == prov->GetDirectory("/test/test_vars"));
 	
 
 	//Search directories by pattern	
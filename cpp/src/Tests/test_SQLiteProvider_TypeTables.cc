@@ -6,6 +6,7 @@
 #include "CCDB/Model/Directory.h"
 #include "CCDB/Model/ConstantsTypeColumn.h"
 #include "CCDB/Model/ConstantsTypeTable.h"
+#include "CCDB/Model/Assignment.h"
 
 using namespace std;
 using namespace ccdb;
@@ -38,8 +39,8 @@ TEST_CASE("CCDB/SQLiteDataProvider/TypeTables","TypeTables tests")
 	REQUIRE(table->GetDirectory()->GetName() == "test_vars");
 	REQUIRE(table->GetColumns()[0]->GetName() == string("x"));
 	
-	//print type table
-	delete table; //cleanup
+	//The table is owned by the provider, the same object is returned for the same path
+	REQUIRE(((DataProvider*)prov)->GetConstantsTypeTable("/test/test_vars/test_table", false) == table);
 	
 	//get all tables from the directory.
     vector<ConstantsTypeTable *> tables;
@@ -156,3 +157,63 @@ TEST_CASE("CCDB/SQLiteDataProvider/TypeTables","TypeTables tests")
 
 	delete prov;//with all objects...
 }
+
+
+/********************************************************************* **
+ * @brief Catalog objects are owned by the provider and are not read twice
+ */
+TEST_CASE("CCDB/SQLiteDataProvider/CatalogObjects","Provider owned type tables, columns and variations")
+{
+	SQLiteDataProvider prov;
+	DataProvider& provider = prov;
+	provider.Connect(TESTS_SQLITE_STRING);
+
+	//Columns are loaded before the table is cached, so a cached table is never changed
+	ConstantsTypeTable *table = provider.GetConstantsTypeTable("/test/test_vars/test_table", false);
+	REQUIRE(table != NULL);
+	REQUIRE(table->GetColumns().size() == 3);
+	auto descriptor = table->GetDescriptor();
+	REQUIRE(provider.GetConstantsTypeTable("/test/test_vars/test_table", true) == table);
+	REQUIRE(table->GetDescriptor() == descriptor);
+	REQUIRE(descriptor->GetColumnsCount() == 3);
+	REQUIRE(descriptor->GetColumnNames()[0] == "x");
+	REQUIRE(descriptor->GetColumnTypeStrings()[0] == "double");
+	REQUIRE(descriptor->FindColumn("y") == 1);
+	REQUIRE(descriptor->FindColumn("no_such_column") == -1);
+	REQUIRE(descriptor->GetColumn("z").Type == ConstantsTypeColumn::cDoubleColumn);
+	REQUIRE(&table->GetColumnNames() == &descriptor->GetColumnNames());
+	REQUIRE(table->GetColumnsByName().size() == 3);
+
+	//All tables list gives the same objects
+	bool isFound = false;
+	for(auto t: provider.GetAllConstantsTypeTables(false)) isFound = isFound || t == table;
+	REQUIRE(isFound);
+
+	//Tables read all at once get their columns too
+	SQLiteDataProvider otherProvider;
+	otherProvider.Connect(TESTS_SQLITE_STRING);
+	for(auto t: otherProvider.GetAllConstantsTypeTables(false)) {
+		REQUIRE(t->GetColumns().size() == static_cast<size_t>(t->GetNColumnsFromDB()));
+		if(t->GetFullPath() == "/test/test_vars/test_table") REQUIRE(t->GetColumnNames()[2] == "z");
+	}
+
+	//Repeated requests don't create new catalog objects
+	Assignment *assignment = provider.GetAssignmentShort(100, "/test/test_vars/test_table", 0, "subtest", true);
+	REQUIRE(assignment != NULL);
+	REQUIRE(assignment->GetTypeTable() == table);
+	REQUIRE(assignment->GetTableDescriptor() == descriptor);
+	REQUIRE(assignment->GetValueType("y") == ConstantsTypeColumn::cDoubleColumn);
+	delete assignment;
+	size_t count = provider.GetCatalogObjectsCount();
+	for(int i = 0; i < 10; i++) {
+		delete provider.GetAssignmentShort(100, "/test/test_vars/test_table", 0, "subtest", true);
+		delete provider.GetAssignmentShort(100, "/test/test_vars/test_table2", 0, "default", true);
+	}
+	REQUIRE(provider.GetCatalogObjectsCount() <= count + 4);		//test_table2 and its 3 columns
+	count = provider.GetCatalogObjectsCount();
+	size_t bytes = provider.GetCatalogRetainedBytes();
+	REQUIRE(bytes > count * sizeof(Variation));
+	delete provider.GetAssignmentShort(100, "/test/test_vars/test_table2", 0, "default", true);
+	REQUIRE(provider.GetCatalogObjectsCount() == count);
+	REQUIRE(provider.GetCatalogRetainedBytes() == bytes);
+}
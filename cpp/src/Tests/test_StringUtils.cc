@@ -4,6 +4,7 @@
 #include "catch.hpp"
 
 #include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Helpers/StringPool.h"
 
 
 using namespace std;
@@ -51,4 +52,25 @@ TEST_CASE("CCDB/StringUtils/Split", "Test of lexical splittiong string to tokens
 	REQUIRE(outArray[5] == "30e-2");
 }
 
+TEST_CASE("CCDB/StringUtils/StringPool", "Interned strings are shared")
+{
+	InternedString first("/test/test_vars/test_table");
+	InternedString second(string("/test/test_vars/") + "test_table");
+	REQUIRE(first == second);
+	REQUIRE(&first.str() == &second.str());
+	REQUIRE(first.str() == "/test/test_vars/test_table");
+
+	InternedString other("/test/test_vars/test_table2");
+	REQUIRE(first != other);
+
+	size_t count = StringPool::Global().GetCount();
+	InternedString again("/test/test_vars/test_table2");
+	REQUIRE(StringPool::Global().GetCount() == count);
+	REQUIRE(again == other);
+
+	InternedString empty;
+	REQUIRE(empty.empty());
+	REQUIRE(empty == InternedString(""));
+}
+
 #endif //test_StringUtils_h
@@ -0,0 +1,131 @@
+#pragma warning(disable:4800)
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "Tests/tests.h"
+#include "Tests/catch.hpp"
+
+#include "CCDB/Helpers/TableFile.h"
+#include "CCDB/Providers/TableFileImporter.h"
+#include "CCDB/Providers/SQLiteDataWriter.h"
+#include "CCDB/Providers/SQLiteDataProvider.h"
+
+using namespace std;
+using namespace ccdb;
+
+/********************************************************************* **
+ * @brief Table file format is read like python table_file.py does
+ */
+TEST_CASE("CCDB/TableFile/Parse","Parse and validate table file")
+{
+    std::istringstream text(
+        "# Some comment\n"
+        "#meta variation: default\n"
+        "#meta hand made\n"
+        "#& x y \"z value\"\n"
+        "\n"
+        "  1 2.5 3   # row comment\n"
+        "4 \"5\" 6e2\n");
+
+    TableFile file = TableFile::Parse(text);
+    REQUIRE(file.CommentLines.size() == 1);
+    REQUIRE(file.CommentLines[0] == " Some comment");
+    REQUIRE(file.Metas["variation"] == "default");
+    REQUIRE(file.Metas.count("hand made") == 1);
+    REQUIRE(file.ColumnNames.size() == 3);
+    REQUIRE(file.ColumnNames[2] == "z value");
+    REQUIRE(file.Rows.size() == 2);
+    REQUIRE(file.Rows[0].size() == 3);
+    REQUIRE(file.Rows[1][1] == "5");
+
+    SQLiteDataProvider sqliteProvider;
+    DataProvider& provider = sqliteProvider;
+    provider.Connect(TESTS_SQLITE_STRING);
+
+    // test_table: 2 rows, double columns x y z
+    ConstantsTypeTable* doubles = provider.GetConstantsTypeTable("/test/test_vars/test_table", true);
+    REQUIRE(doubles);
+    vector<string> values = file.Validate(*doubles);
+    REQUIRE(values.size() == 6);
+    REQUIRE(values[5] == "6e2");
+
+    // test_table2: 1 row, int columns c1 c2 c3
+    ConstantsTypeTable* ints = provider.GetConstantsTypeTable("/test/test_vars/test_table2", true);
+    REQUIRE(ints);
+    REQUIRE_THROWS(file.Validate(*ints));           // rows count
+
+    std::istringstream badInt("1 2.5 3\n");
+    REQUIRE_THROWS(TableFile::Parse(badInt).Validate(*ints));
+
+    std::istringstream shortRow("1 2 3\n4 5\n");
+    REQUIRE_THROWS(TableFile::Parse(shortRow).Validate(*doubles));
+
+    std::istringstream empty("# nothing\n");
+    REQUIRE_THROWS(TableFile::Parse(empty).Validate(*doubles));
+}
+
+
+/********************************************************************* **
+ * @brief Files are parsed in parallel and written in order by one writer
+ */
+TEST_CASE("CCDB/TableFileImporter/Import","Parallel import of table files")
+{
+    TestDirectory directory;
+    string connectionString = directory.CopyTestDatabase();
+
+    // 20 good files for runs 20000..20019, the last one for run 20005 wins
+    vector<TableImportJob> jobs;
+    for(int i = 0; i <= 20; i++) {
+        string fileName = directory.GetPath("table_" + std::to_string(i) + ".txt");
+        std::ofstream file(fileName);
+        file << "#& x y z\n" << i << " 1 2\n3 4 5\n";
+
+        TableImportJob job;
+        job.FileName = fileName;
+        job.TablePath = "/test/test_vars/test_table";
+        job.RunMin = job.RunMax = (i < 20) ? 20000 + i : 20005;
+        jobs.push_back(job);
+    }
+
+    // Bad files are reported, but don't stop the import
+    {
+        std::ofstream file(directory.GetPath("bad.txt"));
+        file << "1 2\n";
+    }
+    TableImportJob badJob = jobs[0];
+    badJob.FileName = directory.GetPath("bad.txt");
+    jobs.push_back(badJob);
+    TableImportJob missingJob = jobs[0];
+    missingJob.FileName = directory.GetPath("no_such_file.txt");
+    jobs.push_back(missingJob);
+    TableImportJob noTableJob = jobs[0];
+    noTableJob.TablePath = "/test/test_vars/no_such_table";
+    jobs.push_back(noTableJob);
+
+    SQLiteDataProvider provider;
+    provider.Connect(connectionString);
+    SQLiteDataWriter writer;
+    writer.Connect(connectionString);
+    writer.SetCommitEvery(7);
+
+    TableFileImporter importer(provider, writer, 4);
+    TableImportResult result = importer.Import(jobs);
+    REQUIRE(result.Imported == 21);
+    REQUIRE(result.Errors.size() == 3);
+    REQUIRE(writer.GetUncommittedCount() == 0);
+    REQUIRE(writer.GetStats().Assignments == 21);
+
+    Assignment* assignment = provider.GetAssignmentShort(20005, "/test/test_vars/test_table", 0, "default", false);
+    REQUIRE(assignment != nullptr);
+    REQUIRE(assignment->GetVectorData()[0] == "20");
+    delete assignment;
+
+    assignment = provider.GetAssignmentShort(20019, "/test/test_vars/test_table", 0, "default", false);
+    REQUIRE(assignment != nullptr);
+    REQUIRE(assignment->GetVectorData()[0] == "19");
+    delete assignment;
+
+    provider.Disconnect();
+    writer.Disconnect();
+}
@@ -8,6 +8,7 @@
 ///==========================================================================================================
 
 #define CATCH_CONFIG_MAIN  // This tell CATCH to provide a main() - only do this in one cpp file
+#define CATCH_CONFIG_NO_POSIX_SIGNALS  // catch.hpp signal handlers don't compile with glibc>=2.34 (SIGSTKSZ is not constant)
 //#define CATCH_CONFIG_RUNNER
 
 #include "catch.hpp"
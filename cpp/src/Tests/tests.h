@@ -3,6 +3,12 @@
 #define tests_h__
 
 #include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <dirent.h>
+#include <unistd.h>
 
 
 
@@ -16,4 +22,49 @@
 #endif
 
 
+/** Temporary directory for files a test creates. It is removed with its files when it goes out of scope,
+ *  so files are not left when a test fails. Declare it before objects that use the files */
+class TestDirectory
+{
+public:
+    TestDirectory()
+    {
+        const char* tempRoot = getenv("TMPDIR");
+        std::string path = std::string(tempRoot && *tempRoot ? tempRoot : "/tmp") + "/ccdb_test_XXXXXX";
+        if(!mkdtemp(&path[0])) throw std::runtime_error("TestDirectory => Can't create directory " + path);
+        mPath = path;
+    }
+
+    ~TestDirectory()
+    {
+        if(DIR* dir = opendir(mPath.c_str())) {
+            while(dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if(name != "." && name != "..") std::remove(GetPath(name).c_str());
+            }
+            closedir(dir);
+        }
+        rmdir(mPath.c_str());
+    }
+
+    /** Path of the file in the directory */
+    std::string GetPath(const std::string& fileName) const { return mPath + "/" + fileName; }
+
+    /** Copies sql/ccdb.sqlite to the directory, so tests that write don't change it. Returns connection string of the copy */
+    std::string CopyTestDatabase(const std::string& fileName = "ccdb.sqlite") const
+    {
+        std::ifstream source(std::string(getenv("CCDB_HOME")) + "/sql/ccdb.sqlite", std::ios::binary);
+        std::ofstream destination(GetPath(fileName), std::ios::binary | std::ios::trunc);
+        destination << source.rdbuf();
+        return "sqlite://" + GetPath(fileName);
+    }
+
+private:
+    std::string mPath;
+
+    TestDirectory(const TestDirectory&) = delete;
+    TestDirectory& operator=(const TestDirectory&) = delete;
+};
+
+
 #endif // tests_h__
@@ -0,0 +1,147 @@
+//
+// Compares constants of all tables between two runs, variations or times
+//
+//    ccdb_diff -c sqlite:///path/ccdb.sqlite -r 1000 -v default -v2 mc --rel 1e-6
+//
+// Each side is a run, a variation and a time. Options ending with 2 set the right side,
+// the rest set both sides. Prints a line for each table that is not identical:
+//    <result> <path> <changed cells> <different cells> <max absolute> <max relative>
+// with different cells below it:
+//        <row> <column> <left value> <right value> <absolute> <relative>
+// and a summary line at the end. Exit code is 2 if some tables differ more than the tolerance.
+//
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <cstdlib>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Helpers/PathUtils.h"
+#include "CCDB/Providers/SQLiteDataProvider.h"
+#include "CCDB/Providers/ConstantsDiff.h"
+#ifdef CCDB_MYSQL
+#include "CCDB/Providers/MySQLDataProvider.h"
+#endif
+
+using namespace std;
+using namespace ccdb;
+
+namespace {
+    void PrintUsage(const char* program)
+    {
+        cout << "Usage: " << program << " -c <connection> [options]" << endl
+             << "Options:" << endl
+             << "  -c <connection>      sqlite://<path> or mysql://... (CCDB_CONNECTION is used if not given)" << endl
+             << "  -r <run>, -r2 <run>  Run of both sides, of the right side. Default: 0" << endl
+             << "  -v <name>, -v2 <name> Variation of both sides, of the right side. Default: default" << endl
+             << "  -t <time>, -t2 <time> Constants as of YYYY-MM-DD-hh-mm-ss (or its beginning). Default: the latest" << endl
+             << "  --abs <tolerance>    Absolute tolerance of numeric cells. Default: 0" << endl
+             << "  --rel <tolerance>    Relative tolerance of numeric cells. Default: 0" << endl
+             << "  -d <count>           Different cells printed for each table. Default: 20" << endl
+             << "  -a                   Print identical tables too" << endl;
+    }
+
+    const char* ResultToString(TableDiff::Results result)
+    {
+        switch(result) {
+            case TableDiff::cIdentical:       return "identical";
+            case TableDiff::cWithinTolerance: return "tolerated";
+            case TableDiff::cDifferent:       return "different";
+            case TableDiff::cIncompatible:    return "incompatible";
+            case TableDiff::cOnlyLeft:        return "only_left";
+            case TableDiff::cOnlyRight:       return "only_right";
+        }
+        return "unknown";
+    }
+
+    bool ParseTimeArgument(const char* text, time_t& time)
+    {
+        bool isParsed = false;
+        time = PathUtils::ParseTime(text, &isParsed);
+        if(!isParsed) cerr << "Invalid time '" << text << "'" << endl;
+        return isParsed;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    string connectionString = getenv("CCDB_CONNECTION") ? getenv("CCDB_CONNECTION") : "";
+    CalibrationSnapshotKey left, right;
+    ConstantsDiffOptions options;
+    options.MaxDetails = 20;
+    bool isAllPrinted = false;
+
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "-h" || arg == "--help") { PrintUsage(argv[0]); return 0; }
+        else if(arg == "-a") isAllPrinted = true;
+        else if(arg == "-c" && hasValue) connectionString = argv[++i];
+        else if(arg == "-r" && hasValue) left.Run = right.Run = StringUtils::ParseInt(argv[++i]);
+        else if(arg == "-r2" && hasValue) right.Run = StringUtils::ParseInt(argv[++i]);
+        else if(arg == "-v" && hasValue) left.Variation = right.Variation = argv[++i];
+        else if(arg == "-v2" && hasValue) right.Variation = argv[++i];
+        else if(arg == "-t" && hasValue) {
+            if(!ParseTimeArgument(argv[++i], left.Time)) return 1;
+            right.Time = left.Time;
+        }
+        else if(arg == "-t2" && hasValue) {
+            if(!ParseTimeArgument(argv[++i], right.Time)) return 1;
+        }
+        else if(arg == "--abs" && hasValue) options.AbsoluteTolerance = StringUtils::ParseDouble(argv[++i]);
+        else if(arg == "--rel" && hasValue) options.RelativeTolerance = StringUtils::ParseDouble(argv[++i]);
+        else if(arg == "-d" && hasValue) options.MaxDetails = static_cast<size_t>(StringUtils::ParseULong(argv[++i]));
+        else {
+            cerr << "Unknown argument '" << arg << "'" << endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(connectionString.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::unique_ptr<DataProvider> provider;
+        if(connectionString.find("sqlite://") == 0) {
+            provider.reset(new SQLiteDataProvider());
+        }
+#ifdef CCDB_MYSQL
+        else if(connectionString.find("mysql://") == 0) {
+            provider.reset(new MySQLDataProvider());
+        }
+#endif
+        else {
+            cerr << "Unsupported connection string '" << connectionString << "'" << endl;
+            return 1;
+        }
+
+        provider->Connect(connectionString);
+        ConstantsDiff diff(options);
+        SnapshotDiffSummary summary = diff.CompareSnapshots(*provider, left, right, [isAllPrinted](const TableDiff& table) {
+            if(table.Result == TableDiff::cIdentical && !isAllPrinted) return;
+
+            cout << ResultToString(table.Result) << " " << table.Path << " " << table.ChangedCells << " "
+                 << table.DifferentCells << " " << table.MaxAbsolute << " " << table.MaxRelative << endl;
+            for(const auto& cell: table.Details) {
+                cout << "    " << cell.Row << " " << cell.Column << " " << cell.Left << " " << cell.Right;
+                if(cell.IsNumeric) cout << " " << cell.Absolute << " " << cell.Relative;
+                cout << endl;
+            }
+        });
+
+        cout << "tables " << summary.Tables << " identical " << summary.IdenticalTables
+             << " tolerated " << summary.WithinToleranceTables << " different " << summary.DifferentTables
+             << " cells " << summary.DifferentCells << endl;
+        return summary.DifferentTables > 0 ? 2 : 0;
+    }
+    catch (std::exception& ex) {
+        cerr << "Comparison failed: " << ex.what() << endl;
+        return 1;
+    }
+}
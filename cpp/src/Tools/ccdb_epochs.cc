@@ -0,0 +1,120 @@
+//
+// Splits a run range into calibration epochs: run intervals in which all given tables have the same assignments
+//
+//    ccdb_epochs -c sqlite:///path/ccdb.sqlite -r 1000-2000 -v default /test/test_vars/test_table /test/test_vars/test_table2
+//
+// Prints a line for each epoch:
+//    <run min> <run max> <assignment id of each table>
+// Assignment id is 0 if the table has no data for these runs. A job scheduler may split jobs
+// along epochs, a framework doesn't need to reinitialize within one.
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Helpers/PathUtils.h"
+#include "CCDB/Providers/SQLiteDataProvider.h"
+#include "CCDB/Providers/EpochCalculator.h"
+#ifdef CCDB_MYSQL
+#include "CCDB/Providers/MySQLDataProvider.h"
+#endif
+
+using namespace std;
+using namespace ccdb;
+
+namespace {
+    void PrintUsage(const char* program)
+    {
+        cout << "Usage: " << program << " -c <connection> [options] <type table path> [<type table path> ...]" << endl
+             << "Options:" << endl
+             << "  -c <connection>      sqlite://<path> or mysql://... (CCDB_CONNECTION is used if not given)" << endl
+             << "  -r <run range>       min-max, min- or -max. Default: all runs" << endl
+             << "  -v <variation>       Default: default" << endl
+             << "  -t <time>            Constants as of YYYY-MM-DD-hh-mm-ss (or its beginning). Default: the latest" << endl;
+    }
+
+    bool ParseRunRange(const string& text, int& runMin, int& runMax)
+    {
+        size_t dashPos = text.find('-');
+        if(dashPos == string::npos) return false;
+
+        string minText = text.substr(0, dashPos);
+        string maxText = text.substr(dashPos + 1);
+        runMin = minText.empty() ? 0 : StringUtils::ParseInt(minText);
+        runMax = maxText.empty() ? INFINITE_RUN : StringUtils::ParseInt(maxText);
+        return runMin <= runMax;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    string connectionString = getenv("CCDB_CONNECTION") ? getenv("CCDB_CONNECTION") : "";
+    string variation = "default";
+    int runMin = 0;
+    int runMax = INFINITE_RUN;
+    time_t time = 0;
+    vector<string> paths;
+
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "-h" || arg == "--help") { PrintUsage(argv[0]); return 0; }
+        else if(arg == "-c" && hasValue) connectionString = argv[++i];
+        else if(arg == "-v" && hasValue) variation = argv[++i];
+        else if(arg == "-r" && hasValue) {
+            if(!ParseRunRange(argv[++i], runMin, runMax)) {
+                cerr << "Invalid run range '" << argv[i] << "'" << endl;
+                return 1;
+            }
+        }
+        else if(arg == "-t" && hasValue) {
+            bool isParsed = false;
+            time = PathUtils::ParseTime(argv[++i], &isParsed);
+            if(!isParsed) {
+                cerr << "Invalid time '" << argv[i] << "'" << endl;
+                return 1;
+            }
+        }
+        else paths.push_back(arg);
+    }
+
+    if(connectionString.empty() || paths.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::unique_ptr<DataProvider> provider;
+        if(connectionString.find("sqlite://") == 0) {
+            provider.reset(new SQLiteDataProvider());
+        }
+#ifdef CCDB_MYSQL
+        else if(connectionString.find("mysql://") == 0) {
+            provider.reset(new MySQLDataProvider());
+        }
+#endif
+        else {
+            cerr << "Unsupported connection string '" << connectionString << "'" << endl;
+            return 1;
+        }
+
+        provider->Connect(connectionString);
+        EpochCalculator calculator(*provider, paths, variation, time);
+        for(const auto& epoch: calculator.GetEpochs(runMin, runMax)) {
+            cout << epoch.RunMin << " " << epoch.RunMax;
+            for(auto id: epoch.AssignmentIds) cout << " " << id;
+            cout << endl;
+        }
+        return 0;
+    }
+    catch (std::exception& ex) {
+        cerr << "Epochs calculation failed: " << ex.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,171 @@
+//
+// Imports many CCDB table files at once
+//
+//    ccdb_import -c sqlite:///path/ccdb.sqlite -r 1000-2000 -v default /test/test_vars/test_table file1.txt file2.txt
+//    ccdb_import -c sqlite:///path/ccdb.sqlite -l import_list.txt
+//
+// The list file has one file per line:
+//    <file> <type table path> [<run range>] [<variation>] [# comment]
+//
+// Run range is given as in 'ccdb add': 'min-max', 'min-' (to the infinite run) or '-max'.
+// Files are parsed on several threads, assignments are written by one thread in batched transactions.
+//
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+
+#include "CCDB/Globals.h"
+#include "CCDB/Helpers/StringUtils.h"
+#include "CCDB/Providers/SQLiteDataProvider.h"
+#include "CCDB/Providers/SQLiteDataWriter.h"
+#include "CCDB/Providers/TableFileImporter.h"
+#ifdef CCDB_MYSQL
+#include "CCDB/Providers/MySQLDataProvider.h"
+#include "CCDB/Providers/MySQLDataWriter.h"
+#endif
+
+using namespace std;
+using namespace ccdb;
+
+namespace {
+    void PrintUsage(const char* program)
+    {
+        cout << "Usage: " << program << " -c <connection> [options] <type table path> <file> [<file> ...]" << endl
+             << "       " << program << " -c <connection> [options] -l <list file>" << endl
+             << "Options:" << endl
+             << "  -c <connection>      sqlite://<path> or mysql://... (CCDB_CONNECTION is used if not given)" << endl
+             << "  -r <run range>       min-max, min- or -max. Default: all runs" << endl
+             << "  -v <variation>       Default: default" << endl
+             << "  -m <comment>         Assignments comment" << endl
+             << "  -t <threads>         Parsing threads. Default: number of cores" << endl
+             << "  -b <count>           Assignments per transaction. Default: 1000" << endl
+             << "  -l <list file>       Lines: <file> <type table path> [<run range>] [<variation>]" << endl;
+    }
+
+    bool ParseRunRange(const string& text, int& runMin, int& runMax)
+    {
+        size_t dashPos = text.find('-');
+        if(dashPos == string::npos) return false;
+
+        string minText = text.substr(0, dashPos);
+        string maxText = text.substr(dashPos + 1);
+        runMin = minText.empty() ? 0 : StringUtils::ParseInt(minText);
+        runMax = maxText.empty() ? INFINITE_RUN : StringUtils::ParseInt(maxText);
+        return runMin <= runMax;
+    }
+
+    vector<TableImportJob> ReadListFile(const string& fileName, const TableImportJob& defaults)
+    {
+        std::ifstream stream(fileName);
+        if(!stream) throw std::runtime_error("Can't open list file '" + fileName + "'");
+
+        vector<TableImportJob> jobs;
+        string line;
+        vector<string> tokens;
+        while(std::getline(stream, line)) {
+            StringUtils::LexicalSplit(tokens, line);
+            if(!tokens.empty() && tokens.back()[0] == '#') tokens.pop_back();
+            if(tokens.empty()) continue;
+            if(tokens.size() < 2) throw std::runtime_error("List file line '" + line + "' has no type table path");
+
+            TableImportJob job = defaults;
+            job.FileName = tokens[0];
+            job.TablePath = tokens[1];
+            if(tokens.size() > 2 && !ParseRunRange(tokens[2], job.RunMin, job.RunMax)) {
+                throw std::runtime_error("List file line '" + line + "' has invalid run range");
+            }
+            if(tokens.size() > 3) job.Variation = tokens[3];
+            jobs.push_back(job);
+        }
+        return jobs;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    string connectionString = getenv("CCDB_CONNECTION") ? getenv("CCDB_CONNECTION") : "";
+    string listFile;
+    size_t threadsCount = 0;
+    size_t commitEvery = 1000;
+    TableImportJob defaults;
+    vector<string> positional;
+
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "-h" || arg == "--help") { PrintUsage(argv[0]); return 0; }
+        else if(arg == "-c" && hasValue) connectionString = argv[++i];
+        else if(arg == "-v" && hasValue) defaults.Variation = argv[++i];
+        else if(arg == "-m" && hasValue) defaults.Comment = argv[++i];
+        else if(arg == "-t" && hasValue) threadsCount = static_cast<size_t>(atoi(argv[++i]));
+        else if(arg == "-b" && hasValue) commitEvery = static_cast<size_t>(atoi(argv[++i]));
+        else if(arg == "-l" && hasValue) listFile = argv[++i];
+        else if(arg == "-r" && hasValue) {
+            if(!ParseRunRange(argv[++i], defaults.RunMin, defaults.RunMax)) {
+                cerr << "Invalid run range '" << argv[i] << "'" << endl;
+                return 1;
+            }
+        }
+        else positional.push_back(arg);
+    }
+
+    if(connectionString.empty() || (listFile.empty() && positional.size() < 2)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        vector<TableImportJob> jobs;
+        if(!listFile.empty()) {
+            jobs = ReadListFile(listFile, defaults);
+        }
+        else {
+            for(size_t i = 1; i < positional.size(); i++) {
+                TableImportJob job = defaults;
+                job.TablePath = positional[0];
+                job.FileName = positional[i];
+                jobs.push_back(job);
+            }
+        }
+
+        std::unique_ptr<DataProvider> provider;
+        std::unique_ptr<DataWriter> writer;
+        if(connectionString.find("sqlite://") == 0) {
+            provider.reset(new SQLiteDataProvider());
+            writer.reset(new SQLiteDataWriter());
+        }
+#ifdef CCDB_MYSQL
+        else if(connectionString.find("mysql://") == 0) {
+            provider.reset(new MySQLDataProvider());
+            writer.reset(new MySQLDataWriter());
+        }
+#endif
+        else {
+            cerr << "Unsupported connection string '" << connectionString << "'" << endl;
+            return 1;
+        }
+
+        provider->Connect(connectionString);
+        writer->Connect(connectionString);
+        writer->SetCommitEvery(commitEvery);
+
+        TableFileImporter importer(*provider, *writer, threadsCount);
+        TableImportResult result = importer.Import(jobs);
+
+        for(const auto& error: result.Errors) cerr << "ERROR " << error << endl;
+        cout << "Imported " << result.Imported << " of " << jobs.size() << " files in "
+             << result.ElapsedUs / 1000 << " ms using " << importer.GetThreadsCount() << " parsing threads. "
+             << "Writer: " << writer->GetStats().GetAssignmentsPerSecond() << " assignments/s, "
+             << writer->GetStats().Commits << " commits" << endl;
+        return result.Errors.empty() ? 0 : 2;
+    }
+    catch (std::exception& ex) {
+        cerr << "Import failed: " << ex.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,87 @@
+//
+// Fills constantSets.vaultHash column for existing constant sets
+//
+//    ccdb_vault_hash -c sqlite:///path/ccdb.sqlite
+//    ccdb_vault_hash -c mysql://ccdb_user@localhost/ccdb -b 5000
+//
+// The column and its index are created if the database doesn't have them yet
+// (the same as sql/update_vault_hash.*.sql). Can be run again at any time: only
+// constant sets without hash are updated. After that DataWriter reuses existing
+// constant sets with the same vault instead of creating new ones.
+//
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <cstdlib>
+
+#include "CCDB/Providers/SQLiteDataWriter.h"
+#ifdef CCDB_MYSQL
+#include "CCDB/Providers/MySQLDataWriter.h"
+#endif
+
+using namespace std;
+using namespace ccdb;
+
+namespace {
+    void PrintUsage(const char* program)
+    {
+        cout << "Usage: " << program << " -c <connection> [-b <count>]" << endl
+             << "Options:" << endl
+             << "  -c <connection>      sqlite://<path> or mysql://... (CCDB_CONNECTION is used if not given)" << endl
+             << "  -b <count>           Constant sets updated in one transaction. Default: 1000" << endl;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    string connectionString = getenv("CCDB_CONNECTION") ? getenv("CCDB_CONNECTION") : "";
+    size_t batchSize = 1000;
+
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "-h" || arg == "--help") { PrintUsage(argv[0]); return 0; }
+        else if(arg == "-c" && hasValue) connectionString = argv[++i];
+        else if(arg == "-b" && hasValue) batchSize = static_cast<size_t>(atoi(argv[++i]));
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(connectionString.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::unique_ptr<DataWriter> writer;
+        if(connectionString.find("sqlite://") == 0) {
+            writer.reset(new SQLiteDataWriter());
+        }
+#ifdef CCDB_MYSQL
+        else if(connectionString.find("mysql://") == 0) {
+            writer.reset(new MySQLDataWriter());
+        }
+#endif
+        else {
+            cerr << "Unsupported connection string '" << connectionString << "'" << endl;
+            return 1;
+        }
+
+        writer->Connect(connectionString);
+        bool hadColumn = writer->HasVaultHash();
+        uint64_t updated = writer->BackfillVaultHashes(batchSize);
+        writer->Disconnect();
+
+        if(!hadColumn) cout << "Added constantSets.vaultHash column" << endl;
+        cout << "Updated " << updated << " constant sets" << endl;
+        return 0;
+    }
+    catch (std::exception& ex) {
+        cerr << "Vault hash update failed: " << ex.what() << endl;
+        return 1;
+    }
+}
@@ -1360,7 +1360,13 @@ class AlchemyProvider(object):
         comment = assignment.comment
 
         # delete it
-        self.session.delete(assignment)
+        if len(assignment.constant_set.assignments) > 1:
+            # The constant set is shared with other assignments (writers deduplicate identical vaults).
+            # Delete only the assignment row, so the cascade doesn't remove the shared data
+            self.session.query(Assignment).filter(Assignment.id == assignment.id).delete(synchronize_session=False)
+            self.session.expire_all()
+        else:
+            self.session.delete(assignment)
         self.session.commit()
 
         # Log
@@ -1,10 +1,10 @@
 """
 ccdb_cpp_perf allows to evaluate performance of C++ CCDB API on live applications
 
-To use this file one has to compile CCDB C++ API with `with-perflog=true` (it defines `CCDB_PERFLOG_ON` in C++):
+To use this file one has to compile CCDB C++ API with `CCDB_PERFLOG_ON` CMake option (it defines `CCDB_PERFLOG_ON` in C++):
 
 ```
-> scons with-perflog=true
+> cmake -S cpp -B cpp/build -DCCDB_PERFLOG_ON=ON
 ```
 
 After this, when any constant is requested, CCDB spams performance info to std::cout like:
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+
+# Prints rows of a CCDB SQLite database as MySQL INSERT statements.
+# The MySQL schema is created by sql/ccdb.mysql.sql first, the script gives only the data:
+#
+#    mysql -u root -e "CREATE DATABASE ccdb_test"
+#    sed 's/`ccdb`/`ccdb_test`/g' sql/ccdb.mysql.sql | mysql -u root
+#    python3 sqlite2mysql_data.py sql/ccdb.sqlite | mysql -u root ccdb_test
+#
+# Table and column names of both schemas are the same. It is used to fill the MySQL test database
+# with the same data as sql/ccdb.sqlite has, so C++ MySQL tests check the same things as SQLite tests.
+
+import sqlite3
+import sys
+
+
+def to_mysql_value(value):
+    if value is None:
+        return "NULL"
+    if isinstance(value, (int, float)):
+        return repr(value)
+    if isinstance(value, bytes):
+        value = value.decode("utf-8")
+    return "'" + value.replace("\\", "\\\\").replace("'", "\\'") + "'"
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: sqlite2mysql_data.py <ccdb.sqlite>", file=sys.stderr)
+        return 1
+
+    connection = sqlite3.connect(sys.argv[1])
+    tables = [row[0] for row in connection.execute(
+        "SELECT name FROM sqlite_master WHERE type='table' AND name NOT LIKE 'sqlite_%' ORDER BY name")]
+
+    print("SET FOREIGN_KEY_CHECKS=0;")
+    for table in tables:
+        columns = [row[1] for row in connection.execute("PRAGMA table_info(`%s`)" % table)]
+        column_list = ", ".join("`%s`" % column for column in columns)
+        for row in connection.execute("SELECT %s FROM `%s`" % (column_list, table)):
+            values = ", ".join(to_mysql_value(value) for value in row)
+            print("INSERT INTO `%s` (%s) VALUES (%s);" % (table, column_list, values))
+    print("SET FOREIGN_KEY_CHECKS=1;")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,8 @@
+-- Content hash of constant set vaults (64 bit FNV-1a as 16 hex digits, see cpp/src/CCDB/Helpers/VaultHash.h)
+-- C++ DataWriter reuses constant sets with the same table and vault when the column exists.
+-- The column is optional, so the schema version stays 5.
+-- Hashes of existing rows are filled by: ccdb_vault_hash -c mysql://...  (which also applies this script)
+
+ALTER TABLE `constantSets`
+    ADD COLUMN `vaultHash` CHAR(16) NULL DEFAULT NULL AFTER `constantTypeId`,
+    ADD INDEX `constantSets_vaultHash_idx` (`vaultHash` ASC, `constantTypeId` ASC);
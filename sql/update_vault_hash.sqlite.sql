@@ -0,0 +1,7 @@
+-- Content hash of constant set vaults (64 bit FNV-1a as 16 hex digits, see cpp/src/CCDB/Helpers/VaultHash.h)
+-- C++ DataWriter reuses constant sets with the same table and vault when the column exists.
+-- The column is optional, so the schema version stays 5.
+-- Hashes of existing rows are filled by: ccdb_vault_hash -c sqlite://<file>  (which also applies this script)
+
+ALTER TABLE constantSets ADD COLUMN vaultHash CHAR(16) NULL DEFAULT NULL;
+CREATE INDEX constantSets_vaultHash_idx ON constantSets (vaultHash, constantTypeId);